@@ -28,6 +28,7 @@
 
 #include "llvm/Support/Atomic.h"
 #include "llvm/Support/Valgrind.h"
+#include <vector>
 
 namespace llvm {
 class raw_ostream;
@@ -170,6 +171,14 @@ void EnableStatistics();
 /// \brief Check if statistics are enabled.
 bool AreStatisticsEnabled();
 
+/// \brief Keep track of statistics when they are first bumped, so that
+/// GetStatistics() can return them even if they are not printed.
+void TrackStatistics();
+
+/// \brief Get all statistics that have been bumped since statistics have
+/// been enabled or tracked, in the order in which they were first bumped.
+void GetStatistics(std::vector<const Statistic*> &Stats);
+
 /// \brief Print statistics to the file returned by CreateInfoOutputFile().
 void PrintStatistics();
 
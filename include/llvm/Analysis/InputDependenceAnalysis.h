@@ -56,7 +56,9 @@
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/SparseBitVector.h"
 #include "llvm/ADT/Statistic.h"
 
 #include "llvm/Analysis/Dominators.h"
@@ -181,34 +183,24 @@ inline raw_ostream& operator<<(raw_ostream &O, const PHINodeList &L) {
     return osAppendList(O,L);
 }
 
-// InputDependenceAnalysis
+// InputDependenceInfo
 // - Identifiy mu nodes and eta dependencies, and compute eta/gamma decision DAGs
-class InputDependenceAnalysis : public FunctionPass {
+//   for one function. Loops are identified by their header blocks, so the
+//   results stay valid when the LoopInfo of the function is released.
+class InputDependenceInfo {
 
 public:
 
-    typedef DenseMap<const Loop*, BlockList> LoopBlocksMap;
+    typedef DenseMap<const BasicBlock*, BlockList> LoopBlocksMap;
     typedef DenseMap<const PHINode*, BlockList> PHIBlocksMap;
     typedef DenseMap<const BasicBlock*, PHIDecisionNode::Ptr > PHIDecisionMap;
+    typedef SparseBitVector<> ValueSet;
 
 private:
-    // FIXME: Relies on the knowledge that the po_end() ctor does not touch its argument
-    inline po_iterator< Loop* > loop_po_begin(LoopInfo* LI) {
-      if(LI->begin() == LI->end()) {
-        return po_end((Loop*)0);
-      } else {
-        return po_begin(*(LI->begin()));
-      }
-    }
-    inline po_iterator< Loop* > loop_po_end(LoopInfo* LI) {
-      if(LI->begin() == LI->end()) {
-        return po_end((Loop*)0);
-      } else {
-        return po_end(*(LI->begin()));
-      }
-    }
+    // The analyzed function
+    Function &F;
 
-    // Cached analysis information for the current function.
+    // Analysis information, only available while the function is analyzed
     LoopInfo      *LI;
     DominatorTree *DT;
 
@@ -229,71 +221,32 @@ private:
     DenseMap<const PHINode*, PHIDecisionNode::Ptr > Selectors;
     
     // DecisionGraphs for all loops in the function
-    DenseMap<const Loop*, PHIDecisionNode::Ptr > LoopSelectors;
+    PHIDecisionMap LoopSelectors;
 
-public:
+    // Values depending on input data (see computeInputDependence)
+    DenseSet<const Value*> InputDependentValues;
 
-    static char ID; // Pass identification, replacement for typeid
-    InputDependenceAnalysis() : FunctionPass(ID) {}
+    // Dense numbering of the instructions, arguments and operands of the
+    // function, used as indices into the dependency closure sets
+    DenseMap<const Value*, unsigned> ValueNumbers;
+    std::vector<const Value*> NumberedValues;
 
-    /// This transformation requires natural loop information & requires that
-    /// loop preheaders be inserted into the CFG.  It maintains both of these,
-    /// as well as the CFG.  It also requires dominator information.
-    /// (taken from LCSSA)
-    virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+    // Dependency closure, shared by all values of an SCC of the dependence
+    // graph (see computeDependencyClosure)
+    std::vector<unsigned> ValueSCCs;
+    std::vector<ValueSet> SCCClosures;
+    bool HasClosure;
 
-        AU.addRequired<DominatorTree>();
-        AU.addRequired<LoopInfo>();
-        // We need those passes, but they are loop passes, so we cannot directly depend on them?
-        // AU.addRequiredID(LoopSimplifyID);
-        // AU.addRequiredID(LCSSAID);
-        AU.setPreservesAll();
-    }
+public:
 
     // Iterate through all phi nodes, classify them as eta, mu or gamma.
     // Then add the corresponding dependency edges (eta/mu edge from decision branch,
     // or gamma edge from control flow decisions which control the selection)
-    virtual bool runOnFunction(Function &F) {
-      DEBUG(dbgs() <<"InputDependenceAnalysis for " << F.getName() << '\n');
-      // Clear
-      ExitBlocks.clear();
-      LoopDecisionBlocks.clear();
-      EtaDeps.clear();
-      Selectors.clear();
-      
-      // Get analysis data
-      LI = &getAnalysis<LoopInfo>();
-      DT = &getAnalysis<DominatorTree>();
-
-      bool WellFormed = true;
-
-      // For all loops, process loop headers (MU deps) and compute decision blocks
-      for(po_iterator< Loop* > SubLoopI = loop_po_begin(LI), SubLoopE = loop_po_end(LI);
-	  SubLoopI != SubLoopE; ++SubLoopI) {
-	WellFormed &= processLoop(*SubLoopI);
-      }
-      assert(WellFormed && "Not all loops are in canonical form. Aborting");
-
-      for(Function::iterator BBI = F.begin(), BBE = F.end(); BBI != BBE; ++BBI) {
-	BasicBlock* BB = BBI;
-	// We already processed loop headers
-	if(LI->isLoopHeader(BB)) continue;
-
-	// Process each phi node
-	for (BasicBlock::iterator I = BB->begin(), E = BB->end(); I != E; ++I) {
-	  if (PHINode *PN = dyn_cast<PHINode>(I)) {
-	    processPHINode(PN,BB);
-	  } else {
-	    break; // no more phi nodes
-	  }
-	}
+    InputDependenceInfo(Function &F, LoopInfo &LI, DominatorTree &DT);
 
-      }
-      DEBUG(dump(F,dbgs()));
-      return false;
-    }
+    Function &getFunction() const { return F; }
 
-    virtual void dump(const Function& F, raw_ostream& O);
+    void dump(raw_ostream& O);
 
     // return MU nodes
     void getLoopVariantVars(Loop* Loop, PHINodeList& List) {
@@ -307,7 +260,7 @@ public:
     // get loop control conditions (terminators of loop control blocks)
     // FIXME: build loop decision dag
     BlockList& getLoopControlBlocks(Loop* Loop) {
-        return LoopDecisionBlocks[Loop];
+        return LoopDecisionBlocks[Loop->getHeader()];
     }
 
     // get loop exit dependencies
@@ -321,22 +274,55 @@ public:
     }
 
     bool isExitBlock(Loop* L, BasicBlock* BB) {
-        return std::binary_search(ExitBlocks[L].begin(), ExitBlocks[L].end(), BB);
+        BlockList &Exits = ExitBlocks[L->getHeader()];
+        return std::binary_search(Exits.begin(), Exits.end(), BB);
+    }
+    // Returns true if the value depends on input data, i.e., on the arguments
+    // of the function, values loaded from memory or results of calls. The
+    // dependency may be a data dependency or a gamma/eta control dependency.
+    bool isInputDependent(const Value *V) const {
+        return InputDependentValues.count(V);
+    }
+    // Returns true if the successor of BB is selected depending on input data
+    bool isInputDependentBranch(const BasicBlock *BB) const {
+        return isInputDependent(BB->getTerminator());
+    }
+
+    // Get the transitive data, gamma and eta dependencies of an instruction
+    // of the function, as set of value numbers. Terminators only contribute
+    // their dependencies, not themselves. The closure is computed on the
+    // first query.
+    const ValueSet &getDependencyClosure(const Instruction *I);
+
+    // Get the value for a value number in a dependency closure
+    const Value *getNumberedValue(unsigned N) const {
+        assert(N < NumberedValues.size() && "Invalid value number");
+        return NumberedValues[N];
     }
 
 
 private:
+    bool isLoopHeader(const BasicBlock *BB) const {
+        return LoopDecisionBlocks.count(BB);
+    }
+
     // Process Loops and mu nodes
     // The Loop L has to be in canonical form (preheader, header, latch)
     // Compute exit decision blocks, exit blocks and mu nodes
     bool processLoop(Loop *L);
+    // Compute the set of values depending on input data
+    void computeInputDependence();
+
+    // Number all values of the function and get their direct dependencies
+    unsigned getValueNumber(const Value *V);
+    void getDirectDependencies(const Instruction *I,
+                               SmallVectorImpl<unsigned> &Deps);
+    // Compute the dependency closure for the SCCs of the dependence graph
+    void computeDependencyClosure();
 
     // Process eta/gamma PHI nodes 
     bool processPHINode(PHINode* PN, BasicBlock* BB);
 
-    // Build list of all loops
-    void buildLoopList(LoopInfo* LI, std::vector<Loop*> &loopList);
-
     // Get exit decision blocks of a loop (at least successor outside the loop,
     // but not all of them)
     void getLoopDecisionBlocks(Loop *L, BlockList& DecisionBlocks);
@@ -350,11 +336,6 @@ private:
     // Build decision DAG for eta or gamma node
     void buildDecisionDAG(BlockList& WorkList, BasicBlock *IDOM, PHIDecisionMap& SelectorMap);
 
-    virtual void verifyAnalysis() const {
-        // Check the special guarantees that TGSA makes
-        assert(true && "TGSA preconditions not preserved!");
-    }
-
     bool loopError(BasicBlock* Header, const char Msg[]) {
       errs() << "InputDependenceAnalysis: Error analyzing loop '" << Header->getName();
       errs() << ": " << Msg << " (did you run -loop-simplify and -lcssa ?)\n";
@@ -363,6 +344,56 @@ private:
 
 };
 
+// InputDependenceAnalysis
+// - Module-level analysis providing the InputDependenceInfo of the functions.
+//   The information of a function is computed on the first query and kept
+//   until the analysis is invalidated, so module passes can query functions
+//   repeatedly (e.g., callees) without analyzing them again.
+class InputDependenceAnalysis : public ModulePass {
+
+    typedef DenseMap<const Function*, InputDependenceInfo*> InfoMap;
+
+    InfoMap Infos;
+
+public:
+
+    static char ID; // Pass identification, replacement for typeid
+    InputDependenceAnalysis() : ModulePass(ID) {}
+
+    ~InputDependenceAnalysis() { releaseMemory(); }
+
+    /// The functions have to be in LoopSimplify and LCSSA form. We cannot
+    /// depend on these passes, as they transform the function.
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+        AU.addRequired<DominatorTree>();
+        AU.addRequired<LoopInfo>();
+        AU.setPreservesAll();
+    }
+
+    // The functions are analyzed on demand
+    virtual bool runOnModule(Module &M) {
+      return false;
+    }
+
+    virtual void releaseMemory() {
+      DeleteContainerSeconds(Infos);
+    }
+
+    virtual void print(raw_ostream &O, const Module *M) const;
+
+    // Get the input dependence information of a function
+    InputDependenceInfo &getInfo(Function &F);
+
+    // Returns true if the value of an instruction or argument depends on
+    // input data (see InputDependenceInfo::isInputDependent)
+    bool isInputDependent(const Value *V);
+
+    // Returns true if the successor of BB is selected depending on input data
+    bool isInputDependentBranch(const BasicBlock *BB) {
+        return isInputDependent(BB->getTerminator());
+    }
+};
+
 
 } /* end namespace llvm */
 
@@ -222,6 +222,15 @@ public:
   /// target-independent defaults.
   virtual void getUnrollingPreferences(Loop *L, UnrollingPreferences &UP) const;
 
+  /// \brief Return the size in bytes of the code cache that has to hold a
+  /// loop or function as a whole to avoid cache misses in every iteration,
+  /// e.g., a method cache. Zero if the target has no such cache.
+  virtual unsigned getCodeCacheSize() const;
+
+  /// \brief Estimate the size in bytes of the machine code generated for the
+  /// user \p U.
+  virtual unsigned getCodeSize(const User *U) const;
+
   /// @}
 
   /// \name Scalar Target Information
@@ -412,6 +412,29 @@ class Archive {
     /// @brief Determine whether the archive is a proper llvm bitcode archive.
     bool isBitcodeArchive();
 
+    /// Archives written by tools that do not know about bitcode have no LLVM
+    /// symbol table. Looking up a symbol in such an archive requires reading
+    /// every bitcode member. To avoid doing this for every link, the symbol
+    /// table can be stored in a symbol index file next to the archive. The
+    /// index is used by OpenAndLoadSymbols as long as the size and the
+    /// modification time of the archive match the recorded values.
+    /// @returns the path of the symbol index file of \p ArchivePath.
+    /// @brief Get the path of the symbol index of an archive.
+    static std::string getSymbolIndexPath(const std::string& ArchivePath);
+
+    /// @returns true if the symbol table was built by reading the bitcode
+    /// members, i.e., if there was neither an LLVM symbol table in the archive
+    /// nor a valid symbol index.
+    /// @brief Check if the symbol table could be saved in a symbol index.
+    bool hasScannedSymbolTable() const { return symTabScanned; }
+
+    /// This method builds the symbol table if necessary and writes it to the
+    /// symbol index file of the archive. The file is replaced atomically, so
+    /// concurrent readers either see the old or the new index.
+    /// @returns true if an error occurred
+    /// @brief Write the symbol table to the symbol index file.
+    bool writeSymbolIndex(std::string* ErrMessage);
+
   /// @}
   /// @name Implementation
   /// @{
@@ -450,6 +473,15 @@ class Archive {
     /// @brief Load just the symbol table.
     bool loadSymbolTable(std::string* ErrMessage);
 
+    /// @returns false if there is no valid symbol index for the archive
+    /// @brief Load the symbol table from the symbol index file.
+    bool loadSymbolIndex();
+
+    /// @param ErrMessage Set to address of a std::string to get error messages
+    /// @returns false on error
+    /// @brief Build the symbol table by reading all bitcode members.
+    bool scanSymbolTable(std::string* ErrMessage);
+
     /// @brief Maps archive into memory
     bool mapToMemory(std::string* ErrMsg);
 
@@ -476,6 +508,7 @@ class Archive {
     std::string strtab;       ///< The string table for long file names
     unsigned symTabSize;      ///< Size in bytes of symbol table
     unsigned firstFileOffset; ///< Offset to first normal file.
+    bool symTabScanned;       ///< The symbol table was built from the members
     ModuleMap modules;        ///< The modules loaded via symbol lookup.
     ArchiveMember* foreignST; ///< This holds the foreign symbol table.
     LLVMContext& Context;     ///< This holds global data.
@@ -21,6 +21,7 @@
 #include "llvm/Support/YAMLTraits.h"
 
 #include <list>
+#include <map>
 
 /////////////////
 /// PML Export //
@@ -28,7 +29,9 @@
 
 namespace llvm {
 
+  class CallInst;
   class MachineLoop;
+  class SymbolicBound;
 
   /// Provides information about machine instructions, can be overloaded for
   /// specific targets.
@@ -97,16 +100,31 @@ namespace llvm {
   private:
 
     yaml::PMLDoc YDoc;
+    const TargetMachine &TM;
     Pass &P;
 
+    typedef std::vector<std::pair<const BasicBlock*, SymbolicBound*> >
+      SymbolicBoundList;
+
+    /// Loop header bounds over the formal arguments of the exported
+    /// functions, instantiated for calls with constant arguments.
+    std::map<const Function*, SymbolicBoundList> SymbolicBounds;
+
+    /// Direct calls in the exported functions.
+    std::vector<const CallInst*> Calls;
+
     yaml::FlowFact *createLoopFact(const BasicBlock *BB, yaml::Name RHS,
                                    bool UserAnnot = false) const;
 
+    /// Export the symbolic loop bounds evaluated for the arguments of the
+    /// calls with constant arguments, in the context of the call site.
+    void instantiateLoopBounds();
+
   public:
-    PMLBitcodeExport(TargetMachine &TM, ModulePass &mp)
-    : YDoc(TM.getTargetTriple()), P(mp) {}
+    PMLBitcodeExport(TargetMachine &tm, ModulePass &mp)
+    : YDoc(tm.getTargetTriple()), TM(tm), P(mp) {}
 
-    virtual ~PMLBitcodeExport() { }
+    virtual ~PMLBitcodeExport();
 
     // initialize module-level information
     virtual void initialize(const Module &M) { }
@@ -115,7 +133,7 @@ namespace llvm {
     virtual void serialize(MachineFunction &MF);
 
     // export module-level information during finalize()
-    virtual void finalize(const Module &M) { }
+    virtual void finalize(const Module &M) { instantiateLoopBounds(); }
 
     virtual void writeOutput(yaml::Output *Output) {
       yaml::PMLDoc *DocPtr = &YDoc; *Output << DocPtr;
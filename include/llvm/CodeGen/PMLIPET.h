@@ -0,0 +1,252 @@
+//==- PMLIPET.h - IPET based WCET calculation on PML ----------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Implicit Path Enumeration (IPET) on the machine-code level of a PML
+// document. The builder follows the model of platin's IPETBuilder: edge
+// frequencies are the ILP variables, flow conservation, call edges and flow
+// facts are the constraints, and the sum of the edge costs is maximized.
+// The resulting ILP is solved in-process, without an external solver.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_PMLIPET_H
+#define LLVM_CODEGEN_PMLIPET_H
+
+#include "llvm/PML.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+  //===--------------------------------------------------------------------===//
+  /// PMLLinearProgram - A small integer linear program solver.
+  ///
+  /// Solves max c^T x subject to A x (<=,=,>=) b, x >= 0, x integer, using a
+  /// two-phase simplex on a sparse tableau for the LP relaxation and
+  /// depth-first branch and bound for fractional solutions. IPET problems
+  /// are mostly network flow problems, so the relaxation is usually integral
+  /// already. Each branch and bound node solves its relaxation from scratch,
+  /// so only one tableau is alive at a time; its size is limited by the
+  /// number of non-zero entries (see setMaxEntries).
+  ///
+  class PMLLinearProgram {
+  public:
+    enum CmpOp { LessEqual, Equal, GreaterEqual };
+    enum Status { Optimal, Infeasible, Unbounded, Aborted, TooLarge };
+
+    typedef std::vector<std::pair<unsigned, double> > TermList;
+
+  private:
+    struct Constraint {
+      TermList Terms;
+      CmpOp Op;
+      double RHS;
+    };
+
+    std::vector<std::string> VarNames;
+    std::vector<double> Objective;
+    std::vector<Constraint> Constraints;
+
+    unsigned MaxNodes;
+    uint64_t MaxEntries;
+
+    /// Statistics of the last solve() run.
+    unsigned NumPivots;
+    unsigned NumNodes;
+
+    Status solveRelaxation(const std::vector<Constraint> &Rows,
+                           std::vector<double> &X, double &Obj);
+
+    Status branchAndBound(std::vector<Constraint> &Rows,
+                          std::vector<double> &Best, double &BestObj,
+                          bool &Found);
+
+  public:
+    PMLLinearProgram()
+    : MaxNodes(10000), MaxEntries(1 << 25), NumPivots(0), NumNodes(0) {}
+
+    /// Add a new variable, with a cost coefficient in the objective function.
+    unsigned addVariable(const std::string &Name, double Cost = 0.0) {
+      VarNames.push_back(Name);
+      Objective.push_back(Cost);
+      return VarNames.size() - 1;
+    }
+
+    void addCost(unsigned Var, double Cost) { Objective[Var] += Cost; }
+
+    double getCost(unsigned Var) const { return Objective[Var]; }
+
+    const std::string &getName(unsigned Var) const { return VarNames[Var]; }
+
+    unsigned getNumVariables() const { return VarNames.size(); }
+
+    unsigned getNumConstraints() const { return Constraints.size(); }
+
+    /// Add a constraint sum(Terms) Op RHS. Terms referring to the same
+    /// variable are merged.
+    void addConstraint(const TermList &Terms, CmpOp Op, double RHS);
+
+    /// Limit the number of branch and bound nodes (0 = solve the LP
+    /// relaxation only).
+    void setMaxNodes(unsigned N) { MaxNodes = N; }
+
+    /// Limit the number of non-zero entries of the simplex tableau, which
+    /// bounds the memory used by the solver (about 16 bytes per entry).
+    void setMaxEntries(uint64_t N) { MaxEntries = N; }
+    uint64_t getMaxEntries() const { return MaxEntries; }
+
+    /// Maximize the objective function. On success, Obj holds the optimal
+    /// value and X the value of each variable. If no integral solution
+    /// was found within the node or entry limit, Aborted is returned and Obj
+    /// and X hold the (fractional) optimum of the LP relaxation. TooLarge is
+    /// returned if the relaxation itself exceeds the entry limit.
+    Status solve(double &Obj, std::vector<double> &X);
+
+    unsigned getNumPivots() const { return NumPivots; }
+    unsigned getNumNodes() const { return NumNodes; }
+  };
+
+
+  //===--------------------------------------------------------------------===//
+  /// PMLIPETCostModel - Provides execution times of machine code.
+  ///
+  /// The default model assumes single-cycle instructions, where instructions
+  /// bundled with their predecessor are issued in the same cycle. Targets
+  /// can subclass this to add stall cycles, branch penalties or cache costs.
+  ///
+  class PMLIPETCostModel {
+  public:
+    /// Additional cycles of loads and stores (memmode set)
+    unsigned MemAccessCycles;
+
+    /// Additional cycles of a call or return instruction
+    unsigned CallReturnCycles;
+
+    PMLIPETCostModel() : MemAccessCycles(0), CallReturnCycles(0) {}
+    virtual ~PMLIPETCostModel() {}
+
+    /// Get the cycles of a single instruction.
+    virtual uint64_t getInstructionCycles(const yaml::MachineInstruction &I);
+
+    /// Get the cycles of executing a block along one of its outgoing edges.
+    /// Instrs are the instructions executed on the edge, Branch is the index
+    /// of the branch taken (or -1 for fallthrough).
+    virtual uint64_t getEdgeCycles(const yaml::MachineBlock &Block,
+                 ArrayRef<const yaml::MachineInstruction*> Instrs, int Branch);
+  };
+
+
+  //===--------------------------------------------------------------------===//
+  /// PMLIPETBuilder - Builds and solves the IPET problem of a PML document.
+  ///
+  class PMLIPETBuilder {
+  public:
+    /// A CFG edge, or a return edge if Target is null.
+    struct Edge {
+      unsigned Function;
+      const yaml::MachineBlock *Source;
+      const yaml::MachineBlock *Target;
+      uint64_t Cycles;
+      unsigned Var;
+    };
+
+    typedef std::vector<std::string> OriginList;
+
+  private:
+    struct FunctionInfo {
+      yaml::MachineFunction *MF;
+      StringMap<unsigned> BlockIndex;
+      /// Outgoing and incoming edges of each block, by block index.
+      std::vector<SmallVector<unsigned, 2> > Out;
+      std::vector<SmallVector<unsigned, 2> > In;
+      /// Blocks marked infeasible by flow facts or propagation.
+      std::vector<bool> Infeasible;
+      /// Call edges targeting this function.
+      SmallVector<unsigned, 4> Callers;
+      bool Reachable;
+    };
+
+    yaml::PMLDoc &Doc;
+    PMLIPETCostModel &CM;
+
+    /// Flow fact origins to use; empty to use all machine-code facts.
+    OriginList Origins;
+
+    std::vector<FunctionInfo> Functions;
+    StringMap<unsigned> FunctionByName;
+    StringMap<unsigned> FunctionByLabel;
+
+    std::vector<Edge> Edges;
+    PMLLinearProgram LP;
+
+    /// Call targets refined by flow facts, key is 'function/block/index'.
+    StringMap<SmallVector<unsigned, 2> > CallTargets;
+
+    unsigned Entry;
+    unsigned NumFlowFacts;
+    unsigned NumSkippedFlowFacts;
+
+    bool useFlowFact(const yaml::FlowFact &FF) const;
+
+    bool isGlobalScope(const yaml::Scope *S) const;
+
+    void buildRefinement();
+    void setInfeasible(unsigned F, unsigned B);
+    bool getCallTargets(unsigned F, const yaml::MachineBlock &B,
+                        const yaml::MachineInstruction &I,
+                        SmallVectorImpl<unsigned> &Targets);
+
+    void addEdges(unsigned F);
+    void addConstraints(unsigned F);
+    bool addFlowFact(const yaml::FlowFact &FF);
+
+    void blockFrequency(unsigned F, unsigned B, double Factor,
+                        PMLLinearProgram::TermList &Terms) const;
+    void functionFrequency(unsigned F, double Factor,
+                           PMLLinearProgram::TermList &Terms) const {
+      blockFrequency(F, 0, Factor, Terms);
+    }
+    bool isBackedge(unsigned F, const Edge &E) const;
+
+    int findBlock(unsigned F, const yaml::Name &Name) const;
+    int findFunction(const yaml::Name &Name) const;
+
+  public:
+    PMLIPETBuilder(yaml::PMLDoc &doc, PMLIPETCostModel &cm)
+    : Doc(doc), CM(cm), Entry(0), NumFlowFacts(0), NumSkippedFlowFacts(0) {}
+
+    /// Only use flow facts from the given origins.
+    void setFlowFactOrigins(const OriginList &O) { Origins = O; }
+
+    /// Build the IPET problem for the given entry function (label or name).
+    /// Returns false and sets Error if the model cannot be built.
+    bool build(StringRef EntryLabel, std::string &Error);
+
+    /// Solve the IPET problem and return the WCET bound, or -1 on failure.
+    int64_t solve(std::vector<uint64_t> &Frequencies, std::string &Error);
+
+    /// Solve the problem and add a timing entry with the WCET bound and the
+    /// worst-case edge profile to the PML document.
+    bool addTiming(StringRef Origin, std::string &Error);
+
+    const std::vector<Edge> &getEdges() const { return Edges; }
+
+    PMLLinearProgram &getLinearProgram() { return LP; }
+
+    unsigned getNumFlowFacts() const { return NumFlowFacts; }
+    unsigned getNumSkippedFlowFacts() const { return NumSkippedFlowFacts; }
+  };
+
+}
+
+#endif
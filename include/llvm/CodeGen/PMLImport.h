@@ -19,6 +19,8 @@
 #include "llvm/PML.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/ValueMap.h"
+#include <map>
+#include <string>
 
 namespace llvm {
 
@@ -289,6 +291,9 @@ namespace llvm {
     PMLLevelInfo &SrcLevel;
     PMLFunctionInfo &FI;
 
+    /// Name of the function, also if there is no function info in the doc.
+    yaml::Name FunctionName;
+
     Pass &AnalysisProvider;
 
     MachineDominatorTree *MDom;
@@ -297,7 +302,7 @@ namespace llvm {
     PMLQuery(yaml::PMLDoc &doc, const yaml::Name &Function, PMLLevelInfo &lvl,
              Pass &ap)
     : IgnoreTraces(true), YDoc(doc), SrcLevel(lvl),
-      FI(lvl.getFunctionInfo(Function)),
+      FI(lvl.getFunctionInfo(Function)), FunctionName(Function),
       AnalysisProvider(ap), MDom(0), MPostDom(0)
     {}
     virtual ~PMLQuery() {}
@@ -320,11 +325,23 @@ namespace llvm {
     /// Map Block name to value
     typedef StringMap<double>   BlockDoubleMap;
     typedef StringMap<uint64_t> BlockUIntMap;
+    /// Map (source, target) block names of an edge to value
+    typedef std::map<std::pair<std::string, std::string>, uint64_t>
+                                EdgeUIntMap;
 
     /// Get a map of all criticality values for all MBBs for which a block
     /// mapping exists.
     bool getBlockCriticalityMap(BlockDoubleMap &Criticalities);
 
+    /// Get the observed execution frequencies of all blocks and edges of the
+    /// function, e.g., from edge profiling.
+    bool getFrequencyMaps(BlockUIntMap &Blocks, EdgeUIntMap &Edges);
+
+    /// Get the frequencies of all blocks and edges of the function on the
+    /// worst-case path. Blocks that are only referenced by edges get the
+    /// larger one of their incoming and outgoing frequency.
+    bool getWCETFrequencyMaps(BlockUIntMap &Blocks, EdgeUIntMap &Edges);
+
     // Get a memory instruction label for a given program point.
     // Returns an empty label if the value fact is not a mem instruction.
     yaml::Name getMemInstrLabel(const yaml::ProgramPoint *PP) const {
@@ -385,6 +402,13 @@ namespace llvm {
     double getCriticality(BlockDoubleMap &Criticalities,
                           MachineBasicBlock &MBB, double Default = 1.0);
 
+    /// Get the observed frequency of a block, or of the edge from FromMBB to
+    /// ToMBB if ToMBB is given. Edges between blocks mapping to the same
+    /// block get the frequency of that block.
+    int64_t getFrequency(BlockUIntMap &Blocks, EdgeUIntMap &Edges,
+                         MachineBasicBlock &FromMBB, MachineBasicBlock *ToMBB,
+                         int64_t Default = -1);
+
     /// return value facts referring to memory access information
     /// in a map BBName -> ValueFact
     bool getMemFacts(const MachineFunction &MF, ValueFactsMap &MemFacts) const;
@@ -402,20 +426,27 @@ namespace llvm {
 
     PMLMCQuery *PQ;
 
+    /// Query for bitcode level information, e.g., profiles.
+    PMLMCQuery *BQ;
+
     PMLQuery::BlockDoubleMap Criticalities;
     PMLQuery::BlockUIntMap Frequencies;
+    PMLQuery::EdgeUIntMap EdgeFrequencies;
+    PMLQuery::BlockUIntMap WCETFrequencies;
+    PMLQuery::EdgeUIntMap WCETEdgeFrequencies;
 
   public:
     static char ID;
 
     PMLMachineFunctionImport()
-    : MachineFunctionPass(ID), MF(0), PQ(0)
+    : MachineFunctionPass(ID), MF(0), PQ(0), BQ(0)
     {
       initializePMLMachineFunctionImportPass(*PassRegistry::getPassRegistry());
     }
 
     virtual ~PMLMachineFunctionImport() {
       if (PQ) delete PQ;
+      if (BQ) delete BQ;
     }
 
 
@@ -443,9 +474,18 @@ namespace llvm {
                          MachineBasicBlock *ToBB = NULL,
                          double DefaultCrit = -1.0, int64_t DefaultFreq = -1);
 
+    /// Get the frequency of a block or an edge on the worst-case path.
     int64_t getWCETFrequency(MachineBasicBlock *FromBB,
                              MachineBasicBlock *ToBB = NULL,
                              int64_t Default = -1);
+
+    /// check if observed frequencies have been loaded by loadFrequencyMap.
+    bool hasFrequencies() const { return !Frequencies.empty(); }
+
+    /// Get the observed frequency of a block or an edge.
+    int64_t getFrequency(MachineBasicBlock *FromBB,
+                         MachineBasicBlock *ToBB = NULL,
+                         int64_t Default = -1);
   };
 
 }
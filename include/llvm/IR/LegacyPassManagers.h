@@ -19,6 +19,7 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/Timer.h"
 #include <map>
 #include <vector>
 
@@ -98,6 +99,7 @@ namespace llvm {
   class Value;
   class Timer;
   class PMDataManager;
+  class Statistic;
 
 // enums for debugging strings
 enum PassDebuggingString {
@@ -478,6 +480,32 @@ public:
 
 Timer *getPassTimer(Pass *);
 
+/// PassReportRegion - Record the execution of a pass in the -pass-report
+/// report during the lifetime of this object, if a report is requested.
+class PassReportRegion {
+public:
+  /// The kind of IR unit a pass runs on.
+  enum UnitKind { FunctionUnit, SCCUnit, ModuleUnit };
+
+private:
+  Pass *P;
+  std::string Unit;
+  UnitKind Kind;
+  TimeRecord Start;
+  uint64_t StartPeakRSS;
+  std::vector<std::pair<const Statistic*, unsigned> > StartStats;
+
+  PassReportRegion(const PassReportRegion &) LLVM_DELETED_FUNCTION;
+  void operator=(const PassReportRegion &) LLVM_DELETED_FUNCTION;
+public:
+  PassReportRegion(Pass *p, StringRef unit, UnitKind kind);
+  ~PassReportRegion();
+
+  /// isEnabled - Return true if a pass report is being recorded, so callers
+  /// only compute unit names that are expensive to build when needed.
+  static bool isEnabled();
+};
+
 }
 
 #endif
@@ -207,6 +207,9 @@ namespace llvm {
     /// symbol names.
     unsigned getUniqueSymbolID() { return NextUniqueID++; }
 
+    /// setNextUniqueID - Set the ID of the next assembler temporary.
+    void setNextUniqueID(unsigned ID) { NextUniqueID = ID; }
+
     /// CreateDirectionalLocalSymbol - Create the definition of a directional
     /// local symbol for numbered label (used for "1:" definitions).
     MCSymbol *CreateDirectionalLocalSymbol(int64_t LocalLabelVal);
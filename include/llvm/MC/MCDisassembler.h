@@ -11,13 +11,14 @@
 
 #include "llvm-c/Disassembler.h"
 #include "llvm/ADT/OwningPtr.h"
+#include "llvm/MC/MCInst.h"
 #include "llvm/MC/MCSymbolizer.h"
 #include "llvm/MC/MCRelocationInfo.h"
 #include "llvm/Support/DataTypes.h"
+#include <vector>
 
 namespace llvm {
 
-class MCInst;
 class MCSubtargetInfo;
 class MemoryObject;
 class raw_ostream;
@@ -85,6 +86,30 @@ public:
                                        uint64_t address,
                                        raw_ostream &vStream,
                                        raw_ostream &cStream) const = 0;
+
+  /// DecodedInst - An entry of the instruction array built by decodeRegion.
+  struct DecodedInst {
+    MCInst Inst;
+    uint64_t Address;
+    uint64_t Size;
+    DecodeStatus Status;
+  };
+
+  /// decodeRegion - Decode all instructions in [start, end) of a region into
+  /// a flat array, e.g. to map the addresses of a trace to instructions.
+  /// Invalid encodings are recorded with status Fail and decoding resumes
+  /// after the consumed bytes, or after one byte if none were consumed. The
+  /// default implementation calls getInstruction for each instruction; no
+  /// comments are emitted.
+  ///
+  /// @param region   - The memory object to use as a source for machine code.
+  /// @param start    - The address of the first instruction to decode.
+  /// @param end      - The address after the last byte to decode.
+  /// @param insts    - The decoded instructions are appended to this array.
+  /// @return         - The number of invalid encodings found.
+  virtual unsigned decodeRegion(const MemoryObject &region,
+                                uint64_t start, uint64_t end,
+                                std::vector<DecodedInst> &insts) const;
 private:
   //
   // Hooks for symbolic disassembly via the public 'C' interface.
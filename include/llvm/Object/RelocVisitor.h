@@ -103,6 +103,14 @@ public:
         HasError = true;
         return RelocToApply();
       }
+    } else if (FileFormat == "ELF32-patmos") {
+      switch (RelocType) {
+      case llvm::ELF::R_PATMOS_ABS_32:
+        return visitELF_PATMOS_ABS_32(R, Value);
+      default:
+        HasError = true;
+        return RelocToApply();
+      }
     } else if (FileFormat == "ELF64-aarch64") {
       switch (RelocType) {
       case llvm::ELF::R_AARCH64_ABS32:
@@ -239,6 +247,14 @@ private:
     return RelocToApply(Res, 4);
   }
 
+  /// Patmos ELF
+  RelocToApply visitELF_PATMOS_ABS_32(RelocationRef R, uint64_t Value) {
+    int64_t Addend;
+    getELFRelocationAddend(R, Addend);
+    uint32_t Res = (Value + Addend) & 0xFFFFFFFF;
+    return RelocToApply(Res, 4);
+  }
+
   // AArch64 ELF
   RelocToApply visitELF_AARCH64_ABS32(RelocationRef R, uint64_t Value) {
     int64_t Addend = getAddend64LE(R);
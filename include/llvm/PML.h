@@ -272,13 +272,16 @@ struct MachineInstruction : Instruction {
   unsigned StackCacheFill;
   unsigned StackCacheSpill;
   Name MemType;
+  /// Guard - the predicate of a conditionally executed instruction, e.g.
+  /// "p1" or "!p1", empty if the instruction is always executed.
+  Name Guard;
 
   bool Bundled;
 
   MachineInstruction(uint64_t Index)
   : Instruction(Index), Size(0), Address(-1), BranchType(branch_none),
     BranchDelaySlots(0), StackCacheArg(0), StackCacheFill(0), StackCacheSpill(0),
-    MemType(Name("")), Bundled(false) {}
+    MemType(Name("")), Guard(Name("")), Bundled(false) {}
 };
 template <>
 struct MappingTraits<MachineInstruction*> {
@@ -299,6 +302,7 @@ struct MappingTraits<MachineInstruction*> {
     io.mapOptional("stack-cache-spill", Ins->StackCacheSpill, 0U);
     io.mapOptional("memmode",   Ins->MemMode, memmode_none);
     io.mapOptional("memtype",   Ins->MemType, Name(""));
+    io.mapOptional("guard",     Ins->Guard, Name(""));
     io.mapOptional("bundled",       Ins->Bundled, false);
   }
   static const bool flow = true;
@@ -621,9 +625,9 @@ struct ContextEntry {
   uint64_t Step;  // only meaningful if Loop is defined
 
   ContextEntry(Name loop, uint64_t offset, uint64_t step) : Loop(loop), Offset(offset), Step(step)  {}
-  ContextEntry(Name callsite)                             : Callsite(callsite)                      {}
+  ContextEntry(Name callsite) : Callsite(callsite), Offset(0), Step(0) {}
   // for YAML I/O
-  ContextEntry() {}
+  ContextEntry() : Offset(0), Step(0) {}
 };
 template <>
 struct MappingTraits< ContextEntry* > {
@@ -906,11 +910,13 @@ struct ProfileEntry {
   uint64_t WCETFrequency;
   double   Criticality;
   uint64_t CritFrequency;
+  /// Observed execution count, e.g., from edge profiling. -1 if unknown.
+  int64_t  Frequency;
 
   // only for yaml import.
   ProfileEntry()
   : Reference(0), Cycles(0), WCETContribution(0), WCETFrequency(0),
-    Criticality(-1.0), CritFrequency(0)
+    Criticality(-1.0), CritFrequency(0), Frequency(-1)
   {
   }
   ~ProfileEntry() {
@@ -925,6 +931,10 @@ struct ProfileEntry {
   bool hasCriticality() const {
     return Criticality >= 0.0;
   }
+
+  bool hasFrequency() const {
+    return Frequency >= 0;
+  }
 private:
   ProfileEntry(const ProfileEntry&);            // Disable copy constructor
   ProfileEntry* operator=(const ProfileEntry&); // Disable assignment
@@ -939,6 +949,7 @@ struct MappingTraits< ProfileEntry* > {
     io.mapOptional("wcet-frequency",    P->WCETFrequency);
     io.mapOptional("criticality",       P->Criticality, -1.0);
     io.mapOptional("crit-frequency",    P->CritFrequency);
+    io.mapOptional("frequency",         P->Frequency, (int64_t)-1);
   }
 };
 
@@ -1100,6 +1111,117 @@ struct PMLDocList {
   }
 };
 
+/// Merges each parsed document into a target document (see readPMLStream).
+struct PMLDocMerger {
+  PMLDoc &Target;
+  PMLDocMerger(PMLDoc &target) : Target(target) {}
+  void operator()(PMLDoc *&Doc) {
+    Target.mergePML(*Doc);
+    delete Doc;
+    Doc = 0;
+  }
+};
+
+/// Read all documents of a PML stream into YDoc. In contrast to reading into
+/// a PMLDocList, each document is merged as soon as it is parsed, so only a
+/// single document is kept in addition to YDoc. Returns false on errors.
+inline bool readPMLStream(Input &YIn, PMLDoc &YDoc) {
+  return mapDocuments<PMLDoc*>(YIn, PMLDocMerger(YDoc));
+}
+
+// Edge Profile Notes
+//////////////////////////////////////////////////////////////////////////////
+
+/// An edge of the CFG of a function instrumented for edge profiling. An empty
+/// source denotes the virtual edge entering the function, an empty target the
+/// virtual edge leaving the function at a return. Counter is the index of the
+/// counter of the edge, or -1 if the edge count is derived from the counts of
+/// the other edges.
+struct EdgeProfileEdge {
+  Name Source;
+  Name Target;
+  int64_t Counter;
+
+  EdgeProfileEdge() : Counter(-1) {}
+  EdgeProfileEdge(const Name &Src, const Name &Dst)
+  : Source(Src), Target(Dst), Counter(-1) {}
+
+  bool hasCounter() const { return Counter >= 0; }
+};
+template <>
+struct MappingTraits< EdgeProfileEdge* > {
+  static void mapping(IO &io, EdgeProfileEdge *&E) {
+    if (!E) E = new EdgeProfileEdge();
+    io.mapOptional("source",  E->Source, Name(""));
+    io.mapOptional("target",  E->Target, Name(""));
+    io.mapOptional("counter", E->Counter, (int64_t)-1);
+  }
+};
+
+YAML_IS_PTR_SEQUENCE_VECTOR(EdgeProfileEdge)
+
+struct EdgeProfileFunction {
+  Name FunctionName;
+  std::vector<EdgeProfileEdge*> Edges;
+
+  EdgeProfileFunction(const Name &Fn) : FunctionName(Fn) {}
+  ~EdgeProfileFunction() {
+    DELETE_PTR_VEC(Edges);
+  }
+  /// Add an edge, which is owned by the function afterwards
+  EdgeProfileEdge *addEdge(EdgeProfileEdge *E) {
+    Edges.push_back(E);
+    return E;
+  }
+private:
+  EdgeProfileFunction(const EdgeProfileFunction&);            // Disable copy
+  EdgeProfileFunction* operator=(const EdgeProfileFunction&); // Disable assign
+};
+template <>
+struct MappingTraits< EdgeProfileFunction* > {
+  static void mapping(IO &io, EdgeProfileFunction *&F) {
+    if (!F) F = new EdgeProfileFunction(Name(""));
+    io.mapRequired("name",  F->FunctionName);
+    io.mapRequired("edges", F->Edges);
+  }
+};
+
+YAML_IS_PTR_SEQUENCE_VECTOR(EdgeProfileFunction)
+
+/// The notes written by the edge profiling instrumentation, describing the
+/// layout of the counter block and the edges the counters belong to.
+struct EdgeProfileNotes {
+  StringRef FormatVersion;
+  StringRef TargetTriple;
+  /// Size of a single counter in bytes.
+  uint32_t CounterSize;
+  bool BigEndian;
+  uint64_t NumCounters;
+  std::vector<EdgeProfileFunction*> Functions;
+
+  EdgeProfileNotes()
+  : FormatVersion("pml-edge-profile-0.1"), TargetTriple(""), CounterSize(4),
+    BigEndian(true), NumCounters(0) {}
+
+  ~EdgeProfileNotes() {
+    DELETE_PTR_VEC(Functions);
+  }
+private:
+  EdgeProfileNotes(const EdgeProfileNotes&);            // Disable copy
+  EdgeProfileNotes* operator=(const EdgeProfileNotes&); // Disable assignment
+};
+template <>
+struct MappingTraits< EdgeProfileNotes > {
+  static void mapping(IO &io, EdgeProfileNotes &N) {
+    io.mapRequired("format",       N.FormatVersion);
+    io.mapRequired("triple",       N.TargetTriple);
+    io.mapRequired("counter-size", N.CounterSize);
+    io.mapRequired("big-endian",   N.BigEndian);
+    io.mapRequired("counters",     N.NumCounters);
+    io.mapOptional("functions",    N.Functions);
+  }
+};
+
 } // end namespace yaml
 } // end namespace llvm
 
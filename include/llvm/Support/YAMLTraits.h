@@ -683,6 +683,10 @@ private:
 /// the mapRequired() method calls may not be in the same order
 /// as the keys in the document.
 ///
+/// Only the HNodes of the current document are kept. They are allocated
+/// from an arena which is reset for every document, so a stream of
+/// documents can be mapped one at a time (see mapDocuments()).
+///
 class Input : public IO {
 public:
   // Construct a yaml Input object from a StringRef and optional
@@ -759,35 +763,45 @@ private:
     StringRef _value;
   };
 
+  // MapHNode and SequenceHNode live in the HNode arena and are never
+  // destroyed, so their entries are stored in arena-allocated arrays.
   class MapHNode : public HNode {
+    virtual void anchor();
   public:
-    MapHNode(Node *n) : HNode(n) { }
-    virtual ~MapHNode();
+    struct Entry {
+      StringRef Key;
+      HNode    *Value;
+      bool      Used;
+    };
+
+    MapHNode(Node *n) : HNode(n), Entries(0), NumEntries(0) { }
 
     static inline bool classof(const HNode *n) {
       return MappingNode::classof(n->_node);
     }
     static inline bool classof(const MapHNode *) { return true; }
 
-    typedef llvm::StringMap<HNode*> NameToNode;
+    /// Find the value of a key and mark the key as used. Mappings are small,
+    /// a linear search is faster than hashing here. As with duplicate keys
+    /// in a StringMap, the last entry wins.
+    HNode *lookup(StringRef Key);
 
-    bool isValidKey(StringRef key);
-
-    NameToNode                        Mapping;
-    llvm::SmallVector<const char*, 6> ValidKeys;
+    Entry   *Entries;
+    unsigned NumEntries;
   };
 
   class SequenceHNode : public HNode {
+    virtual void anchor();
   public:
-    SequenceHNode(Node *n) : HNode(n) { }
-    virtual ~SequenceHNode();
+    SequenceHNode(Node *n) : HNode(n), Entries(0), NumEntries(0) { }
 
     static inline bool classof(const HNode *n) {
       return SequenceNode::classof(n->_node);
     }
     static inline bool classof(const SequenceHNode *) { return true; }
 
-    std::vector<HNode*> Entries;
+    HNode  **Entries;
+    unsigned NumEntries;
   };
 
   Input::HNode *createHNodes(Node *node);
@@ -804,9 +818,10 @@ public:
 private:
   llvm::SourceMgr                  SrcMgr; // must be before Strm
   OwningPtr<llvm::yaml::Stream>    Strm;
-  OwningPtr<HNode>                 TopNode;
+  HNode                           *TopNode;
   llvm::error_code                 EC;
   llvm::BumpPtrAllocator           StringAllocator;
+  llvm::BumpPtrAllocator           HNodeAllocator;
   llvm::yaml::document_iterator    DocIterator;
   std::vector<bool>                BitValuesUsed;
   HNode                           *CurrentNode;
@@ -955,6 +970,24 @@ operator>>(Input &yin, T &docList) {
   return yin;
 }
 
+// Map the documents of a stream one at a time. Each document is mapped into a
+// fresh object, which is passed to Handler(T&) before the next document is
+// parsed. Returns false if there was an error.
+template <typename T, typename HandlerT>
+inline
+typename llvm::enable_if_c<has_MappingTraits<T>::value,bool>::type
+mapDocuments(Input &yin, HandlerT Handler) {
+  while ( yin.setCurrentDocument() ) {
+    T Doc = T();
+    yamlize(yin, Doc, true);
+    if ( yin.error() )
+      return false;
+    Handler(Doc);
+    yin.nextDocument();
+  }
+  return !yin.error();
+}
+
 // Define non-member operator>> so that Input can stream in a map as a document.
 template <typename T>
 inline
@@ -89,6 +89,17 @@ protected: // Can only create subclasses.
   unsigned MCUseCFI : 1;
   unsigned MCUseDwarfDirectory : 1;
 
+  /// ModulePartition - Set if the module is a partition of a larger module,
+  /// i.e., if the other functions of the module are compiled elsewhere.
+  unsigned ModulePartition : 1;
+
+  /// FirstFunctionNumber, FirstTempSymbolID - Numbers of the first machine
+  /// function and the first assembler temporary. Only differ from zero if
+  /// the module is a partition of a larger module whose partitions are
+  /// compiled separately and emitted into a single assembly file.
+  unsigned FirstFunctionNumber;
+  unsigned FirstTempSymbolID;
+
 public:
   virtual ~TargetMachine();
 
@@ -198,6 +209,36 @@ public:
   /// with explicit directories.
   void setMCUseDwarfDirectory(bool Value) { MCUseDwarfDirectory = Value; }
 
+  /// getFirstFunctionNumber - Get the number of the first machine function.
+  unsigned getFirstFunctionNumber() const { return FirstFunctionNumber; }
+
+  /// getFirstTempSymbolID - Get the ID of the first assembler temporary.
+  unsigned getFirstTempSymbolID() const { return FirstTempSymbolID; }
+
+  /// setPartitionNumbering - Set the numbers of the first machine function
+  /// and the first assembler temporary, so that the labels of separately
+  /// compiled partitions of a module do not clash.
+  void setPartitionNumbering(unsigned FunctionNumber, unsigned TempSymbolID) {
+    ModulePartition = true;
+    FirstFunctionNumber = FunctionNumber;
+    FirstTempSymbolID = TempSymbolID;
+  }
+
+  /// isModulePartition - Return true if the module is compiled in partitions
+  /// and this is one of them, so not all uses of a global are visible.
+  bool isModulePartition() const { return ModulePartition; }
+
+  /// supportsModulePartitioning - Return true if the functions of a module
+  /// can be compiled in separate partitions, i.e., if the code generator
+  /// does not contain passes that require the whole module.
+  virtual bool supportsModulePartitioning() const { return true; }
+
+  /// supportsFunctionAtATimeCodeGen - Return true if the code generator only
+  /// consists of function passes, so that it can be run with a
+  /// FunctionPassManager one function at a time and the IR of a function
+  /// can be released once its code has been emitted.
+  virtual bool supportsFunctionAtATimeCodeGen() const { return true; }
+
   /// getRelocationModel - Returns the code generation relocation model. The
   /// choices are static, PIC, and dynamic-no-pic, and target default.
   Reloc::Model getRelocationModel() const;
@@ -15,6 +15,7 @@
 #ifndef LLVM_TRANSFORMS_IPO_PASSMANAGERBUILDER_H
 #define LLVM_TRANSFORMS_IPO_PASSMANAGERBUILDER_H
 
+#include <string>
 #include <vector>
 
 namespace llvm {
@@ -114,6 +115,10 @@ public:
   bool LateVectorize;
   bool RerollLoops;
 
+  /// SampleProfileFile - If non-empty, branch weights are loaded from this
+  /// sample profile before any other transformation.
+  std::string SampleProfileFile;
+
 private:
   /// ExtensionList - This is list of all of the extensions that are registered.
   std::vector<std::pair<ExtensionPointTy, ExtensionFn> > Extensions;
@@ -142,6 +147,12 @@ public:
   /// Used by the Clang frontend during Patmos builds
   void populateFPMBaseline(FunctionPassManager &FPM);
 
+  /// populateFPMAnalyzable - add the baseline optimizations and loop
+  /// optimizations that keep the loops and their llvm.loopbound annotations
+  /// intact, so that flow facts can still be related to the machine code.
+  /// Used for optimized Patmos builds that are WCET analyzed.
+  void populateFPMAnalyzable(FunctionPassManager &FPM);
+
   /// populateModulePassManager - This sets up the primary pass manager.
   void populateModulePassManager(PassManagerBase &MPM);
   void populateLTOPassManager(PassManagerBase &PM, bool Internalize,
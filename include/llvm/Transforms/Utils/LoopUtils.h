@@ -14,13 +14,32 @@
 #ifndef LLVM_TRANSFORMS_UTILS_LOOPUTILS_H
 #define LLVM_TRANSFORMS_UTILS_LOOPUTILS_H
 
+#include "llvm/ADT/SmallVector.h"
+
 namespace llvm {
 
+class BasicBlock;
+class IntrinsicInst;
 class Loop;
+class LoopInfo;
 class Pass;
 
 BasicBlock *InsertPreheaderForLoop(Loop *L, Pass *P);
 
+/// getLoopBounds - Collect the llvm.loopbound annotations bounding L, i.e.
+/// those in blocks of L that are not part of a subloop of L.
+void getLoopBounds(Loop *L, LoopInfo *LI,
+                   SmallVectorImpl<IntrinsicInst*> &Bounds);
+
+/// unrollLoopBound - Update a loop bound of a loop that has been unrolled
+/// Count times, so that every iteration executes up to Count iterations of
+/// the original loop.
+void unrollLoopBound(IntrinsicInst *Bound, unsigned Count);
+
+/// peelLoopBound - Update a loop bound of a loop whose first header
+/// execution has been moved in front of the loop, as done by loop rotation.
+void peelLoopBound(IntrinsicInst *Bound);
+
 }
 
 #endif
@@ -105,6 +105,19 @@ private:
 
 char CGPassManager::ID = 0;
 
+/// getSCCName - Name an SCC in the pass report by the functions it contains.
+static std::string getSCCName(const CallGraphSCC &SCC) {
+  std::string Name;
+  for (CallGraphSCC::iterator I = SCC.begin(), E = SCC.end(); I != E; ++I) {
+    if (!Name.empty())
+      Name += ", ";
+    if (Function *F = (*I)->getFunction())
+      Name += F->getName();
+    else
+      Name += "<<null function>>";
+  }
+  return Name;
+}
 
 bool CGPassManager::RunPassOnSCC(Pass *P, CallGraphSCC &CurSCC,
                                  CallGraph &CG, bool &CallGraphUpToDate,
@@ -121,6 +134,9 @@ bool CGPassManager::RunPassOnSCC(Pass *P, CallGraphSCC &CurSCC,
 
     {
       TimeRegion PassTimer(getPassTimer(CGSP));
+      PassReportRegion PassReport(CGSP, PassReportRegion::isEnabled() ?
+                                          getSCCName(CurSCC) : std::string(),
+                                  PassReportRegion::SCCUnit);
       Changed = CGSP->runOnSCC(CurSCC);
     }
     
@@ -13,6 +13,7 @@
 
 #define DEBUG_TYPE "inline-cost"
 #include "llvm/Analysis/InlineCost.h"
+#include "llvm/ADT/SCCIterator.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
@@ -27,6 +28,7 @@
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Operator.h"
 #include "llvm/InstVisitor.h"
+#include "llvm/Support/CFG.h"
 #include "llvm/Support/CallSite.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/GetElementPtrTypeIterator.h"
@@ -35,6 +37,8 @@
 using namespace llvm;
 
 STATISTIC(NumCallsAnalyzed, "Number of call sites analyzed");
+STATISTIC(NumCodeCacheLimited, "Number of call sites not inlined to keep a "
+                               "loop inside the code cache");
 
 namespace {
 
@@ -1226,6 +1230,51 @@ static bool functionsHaveCompatibleAttributes(Function *Caller,
          attributeMatches(Caller, Callee, Attribute::SanitizeThread);
 }
 
+/// \brief Test if inlining the callee would grow the cycle of the caller's
+///        CFG containing the call site beyond the code cache of the target,
+///        while the cycle fits into the code cache without inlining.
+static bool exceedsCodeCache(const TargetTransformInfo &TTI, CallSite CS,
+                             Function *Callee) {
+  unsigned CacheSize = TTI.getCodeCacheSize();
+  if (!CacheSize)
+    return false;
+
+  // Inlining does not grow the caller if the callee is not larger than the
+  // call itself.
+  unsigned CallSize = TTI.getCodeSize(CS.getInstruction());
+  unsigned CalleeSize = 0;
+  for (Function::const_iterator BI = Callee->begin(), BE = Callee->end();
+       BI != BE && CalleeSize <= CallSize + CacheSize; ++BI)
+    for (BasicBlock::const_iterator II = BI->begin(), IE = BI->end();
+         II != IE; ++II)
+      CalleeSize += TTI.getCodeSize(II);
+  if (CalleeSize <= CallSize)
+    return false;
+
+  // The strongly connected component of the CFG containing the call contains
+  // all loops around the call site.
+  BasicBlock *CallBB = CS.getInstruction()->getParent();
+  Function *Caller = CS.getCaller();
+  for (scc_iterator<Function*> I = scc_begin(Caller), E = scc_end(Caller);
+       I != E; ++I) {
+    std::vector<BasicBlock*> &SCC = *I;
+    if (std::find(SCC.begin(), SCC.end(), CallBB) == SCC.end())
+      continue;
+    if (!I.hasLoop())
+      return false;
+
+    unsigned LoopSize = 0;
+    for (std::vector<BasicBlock*>::iterator BI = SCC.begin(), BE = SCC.end();
+         BI != BE; ++BI)
+      for (BasicBlock::iterator II = (*BI)->begin(), IE = (*BI)->end();
+           II != IE; ++II)
+        LoopSize += TTI.getCodeSize(II);
+    return LoopSize <= CacheSize &&
+           LoopSize - CallSize + CalleeSize > CacheSize;
+  }
+  return false;
+}
+
 InlineCost InlineCostAnalysis::getInlineCost(CallSite CS, Function *Callee,
                                              int Threshold) {
   // Cannot inline indirect calls.
@@ -1256,6 +1305,14 @@ InlineCost InlineCostAnalysis::getInlineCost(CallSite CS, Function *Callee,
       Callee->hasFnAttribute(Attribute::NoInline) || CS.isNoInline())
     return llvm::InlineCost::getNever();
 
+  // Keep loops inside the code cache of the target, if there is one.
+  if (exceedsCodeCache(*TTI, CS, Callee)) {
+    DEBUG(llvm::dbgs() << "      Not inlining " << Callee->getName()
+          << ", the enclosing loop would exceed the code cache\n");
+    ++NumCodeCacheLimited;
+    return llvm::InlineCost::getNever();
+  }
+
   DEBUG(llvm::dbgs() << "      Analyzing call of " << Callee->getName()
         << "...\n");
 
@@ -13,19 +13,23 @@
 #include "llvm/Analysis/InputDependenceAnalysis.h"
 #include "llvm/Analysis/ScalarEvolution.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Module.h"
-#include <set>
+#include "llvm/Support/InstIterator.h"
 
 using namespace llvm;
 
 STATISTIC(MuNodes,  "Number of MU nodes identified");
 STATISTIC(EtaNodes,  "Number of ETA nodes identified");
 STATISTIC(NumGammaDeps,  "Number of GAMMA dependencies identified");
+STATISTIC(NumDepSCCs,  "Number of SCCs in the dependence graphs");
+STATISTIC(NumFunctions,  "Number of functions analyzed");
 
 char InputDependenceAnalysis::ID = 0;
 
 INITIALIZE_PASS_BEGIN(InputDependenceAnalysis, "pidda",
                       "Input Data Dependence Analysis Pass", true, true)
+INITIALIZE_PASS_DEPENDENCY(DominatorTree)
 INITIALIZE_PASS_DEPENDENCY(LoopInfo)
 INITIALIZE_PASS_DEPENDENCY(ScalarEvolution)
 INITIALIZE_AG_DEPENDENCY(AliasAnalysis)
@@ -58,8 +62,89 @@ unsigned getSuccessorIndex(BasicBlock* BB, BasicBlock* Succ) {
 
 }
 
+InputDependenceInfo &InputDependenceAnalysis::getInfo(Function &F) {
+  InputDependenceInfo *&Info = Infos[&F];
+  if (!Info) {
+    assert(!F.isDeclaration() && "Cannot analyze a function declaration");
+    // The LoopInfo and DominatorTree are only used while analyzing F, they
+    // are released when the next function is analyzed.
+    Info = new InputDependenceInfo(F, getAnalysis<LoopInfo>(F),
+                                   getAnalysis<DominatorTree>(F));
+  }
+  return *Info;
+}
+
+bool InputDependenceAnalysis::isInputDependent(const Value *V) {
+  const Function *F = 0;
+  if (const Instruction *I = dyn_cast<Instruction>(V))
+    F = I->getParent()->getParent();
+  else if (const Argument *A = dyn_cast<Argument>(V))
+    F = A->getParent();
+  // Constants and globals do not depend on input data
+  if (!F) return false;
+  return getInfo(const_cast<Function&>(*F)).isInputDependent(V);
+}
+
+void InputDependenceAnalysis::print(raw_ostream &O, const Module *M) const {
+  for(Module::const_iterator F = M->begin(), FE = M->end(); F != FE; ++F) {
+    if (F->isDeclaration()) continue;
+    // Printing analyzes the functions not queried so far
+    InputDependenceInfo &Info = const_cast<InputDependenceAnalysis*>(this)->
+      getInfo(const_cast<Function&>(*F));
+
+    O << "Input dependence of function '" << F->getName() << "':\n";
+    for(Function::const_iterator BB = F->begin(), BE = F->end(); BB != BE;
+        ++BB) {
+      if (BB->getTerminator()->getNumSuccessors() < 2) continue;
+      O << "  branch '" << BB->getName() << "': "
+        << (Info.isInputDependentBranch(BB) ? "input-dependent"
+                                            : "input-independent") << "\n";
+    }
+  }
+}
+
+InputDependenceInfo::InputDependenceInfo(Function &F, LoopInfo &LI,
+                                         DominatorTree &DT)
+: F(F), LI(&LI), DT(&DT), HasClosure(false) {
+  DEBUG(dbgs() <<"InputDependenceAnalysis for " << F.getName() << '\n');
+  ++NumFunctions;
+
+  bool WellFormed = true;
+
+  // For all loops, process loop headers (MU deps) and compute decision blocks,
+  // inner loops first
+  for(LoopInfo::iterator LoopI = LI.begin(), LoopE = LI.end(); LoopI != LoopE;
+      ++LoopI) {
+    for(po_iterator< Loop* > SubLoopI = po_begin(*LoopI),
+          SubLoopE = po_end(*LoopI); SubLoopI != SubLoopE; ++SubLoopI) {
+      WellFormed &= processLoop(*SubLoopI);
+    }
+  }
+  assert(WellFormed && "Not all loops are in canonical form. Aborting");
+
+  for(Function::iterator BBI = F.begin(), BBE = F.end(); BBI != BBE; ++BBI) {
+    BasicBlock* BB = BBI;
+    // We already processed loop headers
+    if(LI.isLoopHeader(BB)) continue;
+
+    // Process each phi node
+    for (BasicBlock::iterator I = BB->begin(), E = BB->end(); I != E; ++I) {
+      if (PHINode *PN = dyn_cast<PHINode>(I)) {
+        processPHINode(PN,BB);
+      } else {
+        break; // no more phi nodes
+      }
+    }
+  }
+  computeInputDependence();
+  DEBUG(dump(dbgs()));
+
+  this->LI = 0;
+  this->DT = 0;
+}
+
 // Process Header, adding MU dependencies
-bool InputDependenceAnalysis::processLoop(Loop *L) {
+bool InputDependenceInfo::processLoop(Loop *L) {
   BasicBlock* Header = L->getHeader();
 
   // Check canonical form of reducible loop
@@ -68,19 +153,21 @@ bool InputDependenceAnalysis::processLoop(Loop *L) {
   else if(! L->getLoopLatch()) return loopError(Header,"No latch block");
   else if(! L->hasDedicatedExits()) return loopError(Header, "No dedicated exit blocks");
 
-  ExitBlocks.insert(LoopBlocksMap::value_type(L, BlockList()));
-  L->getUniqueExitBlocks(ExitBlocks[L]);
-  array_pod_sort(ExitBlocks[L].begin(), ExitBlocks[L].end());
+  BlockList &Exits = ExitBlocks[Header];
+  L->getUniqueExitBlocks(Exits);
+  array_pod_sort(Exits.begin(), Exits.end());
 
-  LoopDecisionBlocks.insert(LoopBlocksMap::value_type(L, BlockList()));
-  getLoopDecisionBlocks(L, LoopDecisionBlocks[L]);
-  array_pod_sort(LoopDecisionBlocks[L].begin(), LoopDecisionBlocks[L].end());
+  // The map may grow while the decision blocks are computed
+  BlockList DecisionBlocks;
+  getLoopDecisionBlocks(L, DecisionBlocks);
+  array_pod_sort(DecisionBlocks.begin(), DecisionBlocks.end());
+  LoopDecisionBlocks[Header].swap(DecisionBlocks);
 
   // Dump Exit Blocks and DecisionBlocks
-  DEBUG(dbgs() << "Exit Blocks of " << L->getHeader()->getName() << ": "
-        << ExitBlocks[L] << "\n");
-  DEBUG(dbgs() << "Decision Blocks of " << L->getHeader()->getName() << ": "
-        << LoopDecisionBlocks[L] << "\n");
+  DEBUG(dbgs() << "Exit Blocks of " << Header->getName() << ": "
+        << ExitBlocks[Header] << "\n");
+  DEBUG(dbgs() << "Decision Blocks of " << Header->getName() << ": "
+        << LoopDecisionBlocks[Header] << "\n");
 
   // Count Mu Nodes
   PHINodeList LoopVars;
@@ -92,10 +179,10 @@ bool InputDependenceAnalysis::processLoop(Loop *L) {
 
 // Get loop decision blocks (branches that decide whether the loop is exited, or another
 // loop iteration is executed)
-void InputDependenceAnalysis::getLoopDecisionBlocks(Loop *L, BlockList& DecisionBlocks) {
+void InputDependenceInfo::getLoopDecisionBlocks(Loop *L, BlockList& DecisionBlocks) {
   PHIDecisionMap DecisionMap;
   computeLoopDecision(L, DecisionMap);
-  LoopSelectors[L]->getControlDependencies(DecisionBlocks);
+  LoopSelectors[L->getHeader()]->getControlDependencies(DecisionBlocks);
 }
 
 // First, add eta deps.
@@ -103,7 +190,7 @@ void InputDependenceAnalysis::getLoopDecisionBlocks(Loop *L, BlockList& Decision
 // propagate phi selectors along edges.
 // Compute phi selector from the propagated reaching def info
 // Add GAMMA dependencies extracted from the phi selector
-bool InputDependenceAnalysis::processPHINode(PHINode* PN, BasicBlock* BB)  {
+bool InputDependenceInfo::processPHINode(PHINode* PN, BasicBlock* BB)  {
 
   assert(!LI->isLoopHeader(BB) && "processPHINode called on a loop header block");
 
@@ -121,7 +208,8 @@ bool InputDependenceAnalysis::processPHINode(PHINode* PN, BasicBlock* BB)  {
     }
     if(PredLoop && ! PredLoop->contains(BB)) { // Exit node, eta dep
       HasEtaDep = true;
-      EtaDeps[PN].insert(EtaDeps[PN].begin(), LoopDecisionBlocks[PredLoop].begin(), LoopDecisionBlocks[PredLoop].end());
+      BlockList &Decisions = LoopDecisionBlocks[PredLoop->getHeader()];
+      EtaDeps[PN].insert(EtaDeps[PN].begin(), Decisions.begin(), Decisions.end());
     }
   }
   if(HasEtaDep) ++EtaNodes;
@@ -146,7 +234,7 @@ bool InputDependenceAnalysis::processPHINode(PHINode* PN, BasicBlock* BB)  {
 // SelectorMap
 //
 // TODO: getSuccessorIndex could become a performance bottleneck
-void InputDependenceAnalysis::computePHIDecision(PHINode *PN, BasicBlock *IDOM, PHIDecisionMap& SelectorMap) {
+void InputDependenceInfo::computePHIDecision(PHINode *PN, BasicBlock *IDOM, PHIDecisionMap& SelectorMap) {
   BlockList Worklist;
   
   // DEBUG(dbgs() << "Compute PHI selector for ");
@@ -181,7 +269,7 @@ void InputDependenceAnalysis::computePHIDecision(PHINode *PN, BasicBlock *IDOM,
 }
 
 // compute loop decision diagram
-void InputDependenceAnalysis::computeLoopDecision(Loop *L, PHIDecisionMap& SelectorMap) {
+void InputDependenceInfo::computeLoopDecision(Loop *L, PHIDecisionMap& SelectorMap) {
   BlockList Worklist;
   
   // DEBUG(dbgs() << "Compute loop selector for ");
@@ -189,17 +277,16 @@ void InputDependenceAnalysis::computeLoopDecision(Loop *L, PHIDecisionMap& Selec
   // DEBUG(dbgs() << "\n");
   
   // Initialize phi selectors for exit blocks
-  for(BlockList::iterator I = ExitBlocks[L].begin(), E = ExitBlocks[L].end();
-      I!=E; ++I) {
+  BlockList &Exits = ExitBlocks[L->getHeader()];
+  for(BlockList::iterator I = Exits.begin(), E = Exits.end(); I!=E; ++I) {
     BasicBlock* BB = *I;
     Worklist.push_back(BB);
 
-    PHIDecisionNode::Ptr NewNode(new PHIDecisionNode(BB));
-    SelectorMap.insert(PHIDecisionMap::value_type(BB, NewNode));
-
+    // Exit blocks may have no successors (e.g., return blocks), so use the
+    // leaf directly; a node with a single child would be simplified to it
     ConstantInt *TrueValue = ConstantInt::getTrue(BB->getContext());
     PHIDecisionNode::Ptr ExitLeaf(new PHIDecisionNode(TrueValue,true));
-    SelectorMap[BB]->setChildSelector(0,ExitLeaf);
+    SelectorMap.insert(PHIDecisionMap::value_type(BB, ExitLeaf));
 
     // DEBUG(dbgs() << "Initial Decision DAG at Exit Block:\n");
     // DEBUG(SelectorMap[BB]->print(dbgs(),2));
@@ -216,17 +303,17 @@ void InputDependenceAnalysis::computeLoopDecision(Loop *L, PHIDecisionMap& Selec
 
   buildDecisionDAG(Worklist, L->getHeader(), SelectorMap);
 
-  LoopSelectors[L] = SelectorMap[L->getHeader()];
+  LoopSelectors[L->getHeader()] = SelectorMap[L->getHeader()];
 
   DEBUG(dbgs() << "Loop selector for ");
   DEBUG(L->print(dbgs()));
   DEBUG(dbgs() << "\n");
-  DEBUG(LoopSelectors[L]->print(dbgs(),0));
+  DEBUG(LoopSelectors[L->getHeader()]->print(dbgs(),0));
   DEBUG(dbgs() << "\n");
 }
 
 
-void InputDependenceAnalysis::buildDecisionDAG(BlockList& Worklist, BasicBlock *IDOM,
+void InputDependenceInfo::buildDecisionDAG(BlockList& Worklist, BasicBlock *IDOM,
 					       PHIDecisionMap& SelectorMap) {
   BlockList Topolist;
   DenseSet<BasicBlock*> Visited, Finished;
@@ -313,7 +400,199 @@ void InputDependenceAnalysis::buildDecisionDAG(BlockList& Worklist, BasicBlock *
   }
 }
 
-void InputDependenceAnalysis::dump(const Function& F, raw_ostream& O) {
+// Returns true if the instruction introduces input data into the function
+static bool isInputSource(const Instruction *I) {
+  if (const LoadInst *LI = dyn_cast<LoadInst>(I)) {
+    // Loading from constant globals does not depend on input data
+    const GlobalVariable *GV =
+      dyn_cast<GlobalVariable>(LI->getPointerOperand()->stripPointerCasts());
+    return !GV || !GV->isConstant() || !GV->hasDefinitiveInitializer();
+  }
+  if (isa<IntrinsicInst>(I))
+    return false;
+  return isa<CallInst>(I) || isa<InvokeInst>(I) || isa<VAArgInst>(I) ||
+         isa<AtomicRMWInst>(I) || isa<AtomicCmpXchgInst>(I) ||
+         isa<LandingPadInst>(I);
+}
+
+// Forward propagation of input dependence, starting at the arguments and
+// input sources, along data dependencies and gamma/eta control dependencies.
+// As in the dependency closure, mu dependencies are ignored: the value of a
+// loop-carried variable only depends on its reaching definitions.
+void InputDependenceInfo::computeInputDependence() {
+  // The phi nodes depending on the decision at the end of a block
+  DenseMap<const BasicBlock*, PHINodeList> ControlUsers;
+  for(Function::iterator BBI = F.begin(), BBE = F.end(); BBI != BBE; ++BBI) {
+    BasicBlock *BB = BBI;
+    if(isLoopHeader(BB)) continue;
+    for (BasicBlock::iterator I = BB->begin(), E = BB->end(); I != E; ++I) {
+      PHINode *PN = dyn_cast<PHINode>(I);
+      if (!PN) break;
+      BlockList Deps(EtaDeps[PN]);
+      if (Selectors[PN])
+        Selectors[PN]->getControlDependencies(Deps);
+      for(BlockList::iterator DI = Deps.begin(), DE = Deps.end(); DI != DE; ++DI)
+        ControlUsers[*DI].push_back(PN);
+    }
+  }
+
+  SmallVector<const Value*, 32> Worklist;
+  for(Function::arg_iterator AI = F.arg_begin(), AE = F.arg_end(); AI != AE;
+      ++AI) {
+    InputDependentValues.insert(AI);
+    Worklist.push_back(AI);
+  }
+  for(Function::iterator BBI = F.begin(), BBE = F.end(); BBI != BBE; ++BBI) {
+    for (BasicBlock::iterator I = BBI->begin(), E = BBI->end(); I != E; ++I) {
+      if (isInputSource(I) && InputDependentValues.insert(I).second)
+        Worklist.push_back(I);
+    }
+  }
+
+  while (!Worklist.empty()) {
+    const Value *V = Worklist.pop_back_val();
+    for (Value::const_use_iterator UI = V->use_begin(), UE = V->use_end();
+         UI != UE; ++UI) {
+      const Instruction *U = dyn_cast<Instruction>(*UI);
+      if (U && InputDependentValues.insert(U).second)
+        Worklist.push_back(U);
+    }
+    if (const TerminatorInst *T = dyn_cast<TerminatorInst>(V)) {
+      PHINodeList &PNs = ControlUsers[T->getParent()];
+      for(PHINodeList::iterator PI = PNs.begin(), PE = PNs.end(); PI != PE;
+          ++PI) {
+        if (InputDependentValues.insert(*PI).second)
+          Worklist.push_back(*PI);
+      }
+    }
+  }
+}
+
+unsigned InputDependenceInfo::getValueNumber(const Value *V) {
+  std::pair<DenseMap<const Value*, unsigned>::iterator, bool> Entry =
+    ValueNumbers.insert(std::make_pair(V, (unsigned)NumberedValues.size()));
+  if (Entry.second)
+    NumberedValues.push_back(V);
+  return Entry.first->second;
+}
+
+// Direct data dependencies, and gamma and eta control dependencies on the
+// terminators of the decision blocks. Mu dependencies are ignored.
+void InputDependenceInfo::getDirectDependencies(const Instruction *I,
+                                          SmallVectorImpl<unsigned> &Deps) {
+  for(Instruction::const_op_iterator OI = I->op_begin(), OE = I->op_end();
+      OI != OE; ++OI) {
+    if(! isa<BasicBlock>(OI) && ! isa<ConstantInt>(OI))
+      Deps.push_back(getValueNumber(*OI));
+  }
+  const PHINode *PN = dyn_cast<PHINode>(I);
+  if(! PN || isLoopHeader(PN->getParent())) return;
+
+  BlockList &Etas = EtaDeps[PN];
+  for(BlockList::iterator DI = Etas.begin(), DE = Etas.end(); DI != DE; ++DI)
+    Deps.push_back(getValueNumber((*DI)->getTerminator()));
+  BlockList Gammas;
+  if(Selectors[PN])
+    Selectors[PN]->getControlDependencies(Gammas);
+  for(BlockList::iterator DI = Gammas.begin(), DE = Gammas.end(); DI != DE; ++DI)
+    Deps.push_back(getValueNumber((*DI)->getTerminator()));
+}
+
+// Compute the transitive dependencies of all instructions of the function.
+// All values of a strongly connected component of the dependence graph have
+// the same dependencies, so we only compute one set per SCC. Tarjan's
+// algorithm finishes the SCCs in reverse topological order, i.e., the
+// closures of all SCCs an SCC depends on are available when it is finished.
+void InputDependenceInfo::computeDependencyClosure() {
+  // Number the values and collect the edges of the dependence graph
+  std::vector<SmallVector<unsigned, 4> > Succs;
+  for(Function::iterator BBI = F.begin(), BBE = F.end(); BBI != BBE; ++BBI) {
+    for (BasicBlock::iterator I = BBI->begin(), E = BBI->end(); I != E; ++I) {
+      unsigned N = getValueNumber(I);
+      if (Succs.size() <= N) Succs.resize(N + 1);
+      SmallVector<unsigned, 4> Deps;
+      getDirectDependencies(I, Deps);
+      Succs[N].swap(Deps);
+    }
+  }
+  unsigned NumValues = NumberedValues.size();
+  Succs.resize(NumValues);
+
+  const unsigned NoSCC = ~0U;
+  std::vector<unsigned> Index(NumValues, 0), LowLink(NumValues, 0);
+  std::vector<unsigned> SCCStack;
+  std::vector<std::pair<unsigned, unsigned> > DFSStack;
+  unsigned NextIndex = 1;
+  ValueSCCs.assign(NumValues, NoSCC);
+  SCCClosures.clear();
+
+  for (unsigned Root = 0; Root < NumValues; ++Root) {
+    if (Index[Root]) continue;
+    Index[Root] = LowLink[Root] = NextIndex++;
+    SCCStack.push_back(Root);
+    DFSStack.push_back(std::make_pair(Root, 0U));
+
+    while (!DFSStack.empty()) {
+      unsigned V = DFSStack.back().first;
+      if (DFSStack.back().second < Succs[V].size()) {
+        unsigned W = Succs[V][DFSStack.back().second++];
+        if (!Index[W]) {
+          Index[W] = LowLink[W] = NextIndex++;
+          SCCStack.push_back(W);
+          DFSStack.push_back(std::make_pair(W, 0U));
+        } else if (ValueSCCs[W] == NoSCC) {
+          LowLink[V] = std::min(LowLink[V], Index[W]);
+        }
+        continue;
+      }
+
+      DFSStack.pop_back();
+      if (!DFSStack.empty()) {
+        unsigned &ParentLow = LowLink[DFSStack.back().first];
+        ParentLow = std::min(ParentLow, LowLink[V]);
+      }
+      if (LowLink[V] != Index[V]) continue;
+
+      // V is the root of an SCC, collect its members and their dependencies
+      unsigned SCC = SCCClosures.size();
+      SCCClosures.push_back(ValueSet());
+      ValueSet &Closure = SCCClosures.back();
+      SmallVector<unsigned, 4> Members;
+      unsigned M;
+      do {
+        M = SCCStack.back();
+        SCCStack.pop_back();
+        ValueSCCs[M] = SCC;
+        Members.push_back(M);
+      } while (M != V);
+
+      for (unsigned i = 0, e = Members.size(); i != e; ++i) {
+        SmallVectorImpl<unsigned> &Deps = Succs[Members[i]];
+        for (unsigned j = 0, je = Deps.size(); j != je; ++j) {
+          unsigned D = Deps[j];
+          // just add conditions/targets, not the terminator itself
+          if (!isa<TerminatorInst>(NumberedValues[D]))
+            Closure.set(D);
+          if (ValueSCCs[D] != SCC)
+            Closure |= SCCClosures[ValueSCCs[D]];
+        }
+      }
+    }
+  }
+  NumDepSCCs += SCCClosures.size();
+  HasClosure = true;
+}
+
+const InputDependenceInfo::ValueSet &
+InputDependenceInfo::getDependencyClosure(const Instruction *I) {
+  assert(I->getParent()->getParent() == &F &&
+         "Instruction is not part of the analyzed function");
+  if (!HasClosure)
+    computeDependencyClosure();
+  return SCCClosures[ValueSCCs[ValueNumbers.lookup(I)]];
+}
+
+void InputDependenceInfo::dump(raw_ostream& O) {
   for(Function::const_iterator BBI = F.begin(); BBI != F.end(); ++BBI) {
     const BasicBlock* _BB = BBI;
     BasicBlock* BB = const_cast<BasicBlock*>(_BB);
@@ -321,11 +600,10 @@ void InputDependenceAnalysis::dump(const Function& F, raw_ostream& O) {
       if (PHINode *PN = dyn_cast<PHINode>(I)) {
         O << "Dependencies for "; PN->dump();
 
-        Loop *L = LI->getLoopFor(BB);
-
         // If the block is a header, print MU deps
-        if(LI->isLoopHeader(BB)) {
-          for(BlockList::iterator DBI = LoopDecisionBlocks[L].begin(), DBE = LoopDecisionBlocks[L].end();
+        if(isLoopHeader(BB)) {
+          BlockList &Decisions = LoopDecisionBlocks[BB];
+          for(BlockList::iterator DBI = Decisions.begin(), DBE = Decisions.end();
               DBI != DBE; ++DBI) {
             O << "  (mu)  " << (*DBI)->getName() << " : ";
             getBranchCondition((*DBI)->getTerminator())->dump();
@@ -391,59 +669,20 @@ namespace {
         dbgs() << "= FUNCTION " << F->getName() << "\n";
         dbgs() <<   "=================================\n\n";
 
-        InputDependenceAnalysis* IdDeps = &getAnalysis<InputDependenceAnalysis>(*F);
-        LoopInfo* LI = &getAnalysis<LoopInfo>(*F);
+        InputDependenceInfo* IdDeps = &getAnalysis<InputDependenceAnalysis>().getInfo(*F);
         ScalarEvolution* SE = &getAnalysis<ScalarEvolution>(*F);
 
-        IdDeps->dump(*F, dbgs());
-
-        std::map<Value*, std::set<Value*> > DepClosure;
-
-        // Compute direct data, gamma and eta dependencies for all variables
-        for(Function::iterator BI = F->begin(), BE = F->end(); BI != BE; ++BI) {
-            for(BasicBlock::iterator II = BI->begin(), IE = BI->end(); II != IE; ++II) {
-                Instruction* Ins = &*II;
-                std::set<Value*> Dependencies;
-
-                // Add data dependencies
-                for(Instruction::op_iterator OI = Ins->op_begin(), OE = Ins->op_end(); OI != OE; ++OI) {
-                    if(! isa<BasicBlock>(OI) && ! isa<ConstantInt>(OI)) {
-                        Dependencies.insert(*OI);
-                    }
-                }
-
-                // Add gamma and eta control dependencies, ignore mu nodes
-                PHINode* PN;
-                if ((PN = dyn_cast<PHINode>(Ins)) && !LI->isLoopHeader(&*BI)) {
-                  BlockList EtaDeps = IdDeps->getEtaDeps(PN);
-                  for(BlockList::iterator EDI = EtaDeps.begin(), EDE = EtaDeps.end(); EDI != EDE; ++EDI) {
-                      dbgs () << "[pidda] Adding eta dependency to " << Ins->getName() << ": ";
-                      (*EDI)->getTerminator()->print(dbgs()); dbgs() << "\n";
-                      Dependencies.insert((*EDI)->getTerminator());
-                  }
-                  BlockList GammaDeps;
-                  IdDeps->getGammaDeps(PN, GammaDeps);
-                  for(BlockList::iterator GDI = GammaDeps.begin(), GDE = GammaDeps.end(); GDI != GDE; ++GDI) {
-                      dbgs () << "[pidda] Adding gamma dependency to " << Ins->getName() << ": ";
-                      (*GDI)->getTerminator()->print(dbgs()); dbgs() << "\n";
-                      Dependencies.insert((*GDI)->getTerminator());
-                  }
-                } else {
-
-                }
-                DepClosure.insert(std::make_pair(Ins, Dependencies));
-            }
-        }
-	
-	dependencyClosure(F, DepClosure);
+        IdDeps->dump(dbgs());
+
         dbgs () << "------------------------------------\n";
         dbgs () << "- Intraprocedural dependency closure\n";
         dbgs () << "------------------------------------\n";
-        for(std::map<Value*, std::set<Value*> >::iterator DI = DepClosure.begin(), DE = DepClosure.end(); DI != DE; ++DI) {
-            dbgs() << "  * Dependencies of " << valueToString(DI->first, true) << "\n";
-            std::set<Value*> Deps = DI->second;
-            for(std::set<Value*>::iterator SI = Deps.begin(), SE = Deps.end(); SI != SE; ++SI) {
-                dbgs() << "    - " << valueToString(*SI, true) << "\n";
+        for(inst_iterator II = inst_begin(*F), IE = inst_end(*F); II != IE; ++II) {
+            Instruction* Ins = &*II;
+            dbgs() << "  * Dependencies of " << valueToString(Ins, true) << "\n";
+            const InputDependenceInfo::ValueSet &Deps = IdDeps->getDependencyClosure(Ins);
+            for(InputDependenceInfo::ValueSet::iterator DI = Deps.begin(), DE = Deps.end(); DI != DE; ++DI) {
+                dbgs() << "    - " << valueToString(IdDeps->getNumberedValue(*DI), true) << "\n";
             }
         }
       }
@@ -452,37 +691,6 @@ namespace {
     }
 
   private:
-    void dependencyClosure(Function *F, std::map<Value*, std::set<Value*> > &DepClosure) {
-      // Compute dependency closure for all variables
-      for(Function::iterator BI = F->begin(), BE = F->end(); BI != BE; ++BI) {
-	for(BasicBlock::iterator II = BI->begin(), IE = BI->end(); II != IE; ++II) {
-	  Instruction* Ins = &*II;
-	  std::deque<Value*> Worklist;
-	  for(std::set<Value*>::iterator DI = DepClosure[Ins].begin(), DE = DepClosure[Ins].end(); DI != DE; ++DI) {
-	    Worklist.push_back(*DI);
-	  }
-	  std::set<Value*> Deps;
-	  while (!Worklist.empty())
-	    {
-	      Value* Dep = Worklist.front();
-	      Worklist.pop_front();
-	      // if(DepClosure.count(Dep) == 0) continue; // not a known instruction
-	      if(Deps.count(Dep) == 0) {
-		if(! isa<TerminatorInst>(Dep)) // just add conditions/targets, not the instruction itself
-		  Deps.insert(Dep);
-		for(std::set<Value*>::iterator DI = DepClosure[Dep].begin(), DE = DepClosure[Dep].end(); DI != DE; ++DI) {
-		  Value* DepOfDep = *DI;
-		  if(! Deps.count(DepOfDep)) {
-		    Worklist.push_back(DepOfDep);
-		  }
-		}
-	      }
-	    }
-	  DepClosure[Ins] = Deps;
-	}
-      }
-    }
-
     inline std::string valueToString(const Value* V, bool LongDescr = false) {
         std::string s;
         raw_string_ostream os(s);
@@ -101,6 +101,14 @@ void TargetTransformInfo::getUnrollingPreferences(Loop *L,
   PrevTTI->getUnrollingPreferences(L, UP);
 }
 
+unsigned TargetTransformInfo::getCodeCacheSize() const {
+  return PrevTTI->getCodeCacheSize();
+}
+
+unsigned TargetTransformInfo::getCodeSize(const User *U) const {
+  return PrevTTI->getCodeSize(U);
+}
+
 bool TargetTransformInfo::isLegalAddImmediate(int64_t Imm) const {
   return PrevTTI->isLegalAddImmediate(Imm);
 }
@@ -481,6 +489,15 @@ struct NoTTI : ImmutablePass, TargetTransformInfo {
 
   void getUnrollingPreferences(Loop *, UnrollingPreferences &) const { }
 
+  unsigned getCodeCacheSize() const {
+    return 0;
+  }
+
+  unsigned getCodeSize(const User *U) const {
+    // Assume a 4 byte instruction for every basic cost unit.
+    return TopTTI->getUserCost(U) * 4;
+  }
+
   bool isLegalAddImmediate(int64_t Imm) const {
     return false;
   }
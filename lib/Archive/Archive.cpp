@@ -150,7 +150,8 @@ bool ArchiveMember::replaceWith(const std::string& newFile, std::string* ErrMsg)
 // initializes and maps the file into memory, if requested.
 Archive::Archive(const std::string& filename, LLVMContext& C)
   : archPath(filename), members(), mapfile(0), base(0), symTab(), strtab(),
-    symTabSize(0), firstFileOffset(0), modules(), foreignST(0), Context(C) {
+    symTabSize(0), firstFileOffset(0), symTabScanned(false), modules(),
+    foreignST(0), Context(C) {
 }
 
 bool
@@ -175,6 +176,7 @@ void Archive::cleanUpMemory() {
   // Forget the entire symbol table
   symTab.clear();
   symTabSize = 0;
+  symTabScanned = false;
 
   firstFileOffset = 0;
 
@@ -206,9 +208,11 @@ static void getSymbols(Module*M, std::vector<std::string>& symbols) {
       if (!GI->getName().empty())
         symbols.push_back(GI->getName());
 
-  // Loop over functions
+  // Loop over functions, the bodies of lazily loaded modules are not
+  // materialized yet.
   for (Module::iterator FI = M->begin(), FE = M->end(); FI != FE; ++FI)
-    if (!FI->isDeclaration() && !FI->hasLocalLinkage())
+    if ((!FI->isDeclaration() || FI->isMaterializable()) &&
+        !FI->hasLocalLinkage())
       if (!FI->getName().empty())
         symbols.push_back(FI->getName());
 
@@ -250,13 +254,15 @@ llvm::GetBitcodeSymbols(const char *BufPtr, unsigned Length,
                         LLVMContext& Context,
                         std::vector<std::string>& symbols,
                         std::string* ErrMsg) {
-  // Get the module.
+  // Get the module. Only the symbols are needed, so the function bodies are
+  // loaded lazily. The module takes ownership of the buffer.
   OwningPtr<MemoryBuffer> Buffer(
     MemoryBuffer::getMemBufferCopy(StringRef(BufPtr, Length),ModuleID.c_str()));
 
-  Module *M = ParseBitcodeFile(Buffer.get(), Context, ErrMsg);
+  Module *M = getLazyBitcodeModule(Buffer.get(), Context, ErrMsg);
   if (!M)
     return 0;
+  Buffer.take();
 
   // Get the symbols
   getSymbols(M, symbols);
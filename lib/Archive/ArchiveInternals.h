@@ -27,6 +27,9 @@
 #define ARFILE_STRTAB_NAME      "//              " ///< Name of string table
 #define ARFILE_PAD "\n"                            ///< inter-file align padding
 #define ARFILE_MEMBER_MAGIC "`\n"                  ///< fmag field magic #
+#define ARFILE_SYMIDX_MAGIC "!<llvm-symidx>\n"     ///< symbol index magic
+#define ARFILE_SYMIDX_MAGIC_LEN (sizeof(ARFILE_SYMIDX_MAGIC)-1) ///< its length
+#define ARFILE_SYMIDX_SUFFIX ".symidx"             ///< symbol index suffix
 
 namespace llvm {
 
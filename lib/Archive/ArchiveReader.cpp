@@ -18,6 +18,7 @@
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FileUtilities.h"
 #include <cstdio>
 #include <cstdlib>
@@ -438,6 +439,56 @@ Archive::loadSymbolTable(std::string* ErrorMsg) {
   }
 
   firstFileOffset = FirstFile - base;
+
+  // Use the symbol index written by a previous link, if there is one.
+  if (symTab.empty())
+    loadSymbolIndex();
+
+  return true;
+}
+
+// Load the symbol table from the symbol index file of the archive, if it is
+// still up to date.
+bool
+Archive::loadSymbolIndex() {
+  std::string IndexPath = getSymbolIndexPath(archPath);
+
+  sys::fs::file_status ArchiveStatus;
+  if (sys::fs::status(archPath, ArchiveStatus))
+    return false;
+
+  OwningPtr<MemoryBuffer> Index;
+  if (MemoryBuffer::getFile(IndexPath, Index))
+    return false;
+
+  const char *At = Index->getBufferStart();
+  const char *End = Index->getBufferEnd();
+  if (unsigned(End - At) < ARFILE_SYMIDX_MAGIC_LEN ||
+      memcmp(At, ARFILE_SYMIDX_MAGIC, ARFILE_SYMIDX_MAGIC_LEN))
+    return false;
+  At += ARFILE_SYMIDX_MAGIC_LEN;
+
+  // The header records the archive size, modification time and offset of the
+  // first member the index was built for.
+  const char *EndOfHeader = (const char*) memchr(At, '\n', End - At);
+  if (!EndOfHeader)
+    return false;
+  std::string Header(At, EndOfHeader);
+  unsigned long long Size, ModTime;
+  unsigned FirstFile;
+  if (sscanf(Header.c_str(), "%llu %llu %u", &Size, &ModTime, &FirstFile) != 3)
+    return false;
+  if (Size != ArchiveStatus.getSize() ||
+      ModTime != ArchiveStatus.getLastModificationTime().toEpochTime() ||
+      FirstFile != firstFileOffset)
+    return false;
+  At = EndOfHeader + 1;
+
+  if (!parseSymbolTable(At, End - At, 0)) {
+    symTab.clear();
+    symTabSize = 0;
+    return false;
+  }
   return true;
 }
 
@@ -501,72 +552,83 @@ Archive::findModuleDefiningSymbol(const std::string& symbol,
   return m;
 }
 
-// Look up multiple symbols in the symbol table and return a set of
-// Modules that define those symbols.
+// Build the symbol table by reading the symbols of all bitcode members. The
+// modules table is populated as we do this to ensure that we don't load the
+// modules twice when findModuleDefiningSymbol is called.
 bool
-Archive::findModulesDefiningSymbols(std::set<std::string>& symbols,
-                                    SmallVectorImpl<Module*>& result,
-                                    std::string* error) {
+Archive::scanSymbolTable(std::string* error) {
   if (!mapfile || !base) {
     if (error)
-      *error = "Empty archive invalid for finding modules defining symbols";
+      *error = "Empty archive invalid for building the symbol table";
     return false;
   }
 
-  if (symTab.empty()) {
-    // We don't have a symbol table, so we must build it now but lets also
-    // make sure that we populate the modules table as we do this to ensure
-    // that we don't load them twice when findModuleDefiningSymbol is called
-    // below.
-
-    // Get a pointer to the first file
-    const char* At  = base + firstFileOffset;
-    const char* End = mapfile->getBufferEnd();
+  // Get a pointer to the first file
+  const char* At  = base + firstFileOffset;
+  const char* End = mapfile->getBufferEnd();
 
-    while ( At < End) {
-      // Compute the offset to be put in the symbol table
-      unsigned offset = At - base - firstFileOffset;
+  while ( At < End) {
+    // Compute the offset to be put in the symbol table
+    unsigned offset = At - base - firstFileOffset;
 
-      // Parse the file's header
-      ArchiveMember* mbr = parseMemberHeader(At, End, error);
-      if (!mbr)
-        return false;
+    // Parse the file's header
+    ArchiveMember* mbr = parseMemberHeader(At, End, error);
+    if (!mbr)
+      return false;
 
-      // If it contains symbols
-      if (mbr->isBitcode()) {
-        // Get the symbols
-        std::vector<std::string> symbols;
-        std::string FullMemberName = archPath + "(" +
-          mbr->getPath() + ")";
-        Module* M = 
-          GetBitcodeSymbols(At, mbr->getSize(), FullMemberName, Context,
-                            symbols, error);
-
-        if (M) {
-          // Insert the module's symbols into the symbol table
-          for (std::vector<std::string>::iterator I = symbols.begin(),
-               E=symbols.end(); I != E; ++I ) {
-            symTab.insert(std::make_pair(*I, offset));
-          }
-          // Insert the Module and the ArchiveMember into the table of
-          // modules.
-          modules.insert(std::make_pair(offset, std::make_pair(M, mbr)));
-        } else {
-          if (error)
-            *error = "Can't parse bitcode member: " + 
-              mbr->getPath() + ": " + *error;
-          delete mbr;
-          return false;
+    // If it contains symbols
+    if (mbr->isBitcode()) {
+      // Get the symbols
+      std::vector<std::string> symbols;
+      std::string FullMemberName = archPath + "(" +
+        mbr->getPath() + ")";
+      Module* M =
+        GetBitcodeSymbols(At, mbr->getSize(), FullMemberName, Context,
+                          symbols, error);
+
+      if (M) {
+        // Insert the module's symbols into the symbol table
+        for (std::vector<std::string>::iterator I = symbols.begin(),
+             E=symbols.end(); I != E; ++I ) {
+          symTab.insert(std::make_pair(*I, offset));
         }
+        // Insert the Module and the ArchiveMember into the table of
+        // modules.
+        modules.insert(std::make_pair(offset, std::make_pair(M, mbr)));
+      } else {
+        if (error)
+          *error = "Can't parse bitcode member: " +
+            mbr->getPath() + ": " + *error;
+        delete mbr;
+        return false;
       }
-
-      // Go to the next file location
-      At += mbr->getSize();
-      if ((intptr_t(At) & 1) == 1)
-        At++;
     }
+
+    // Go to the next file location
+    At += mbr->getSize();
+    if ((intptr_t(At) & 1) == 1)
+      At++;
+  }
+  symTabScanned = true;
+  return true;
+}
+
+// Look up multiple symbols in the symbol table and return a set of
+// Modules that define those symbols.
+bool
+Archive::findModulesDefiningSymbols(std::set<std::string>& symbols,
+                                    SmallVectorImpl<Module*>& result,
+                                    std::string* error) {
+  if (!mapfile || !base) {
+    if (error)
+      *error = "Empty archive invalid for finding modules defining symbols";
+    return false;
   }
 
+  // We don't have a symbol table, so we must build it now.
+  if (symTab.empty() && !symTabScanned && !scanSymbolTable(error))
+    return false;
+
   // At this point we have a valid symbol table (one way or another) so we
   // just use it to quickly find the symbols requested.
 
@@ -13,10 +13,92 @@
 
 #include "llvm/Bitcode/Archive.h"
 #include "ArchiveInternals.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
 using namespace llvm;
 
+/// Write a variable-bit-rate encoded unsigned integer
+static inline void writeInteger(unsigned num, raw_ostream& ARFile) {
+  while (true) {
+    if (num < 0x80) { // done?
+      ARFile << (unsigned char)num;
+      return;
+    }
+
+    // Nope, we are bigger than a character, output the next 7 bits and set the
+    // high bit to say that there is more coming...
+    ARFile << (unsigned char)(0x80 | ((unsigned char)num & 0x7F));
+    num >>= 7;  // Shift out 7 bits now...
+  }
+}
+
 // Create an empty archive.
 Archive* Archive::CreateEmpty(const std::string& FilePath, LLVMContext& C) {
   Archive* result = new Archive(FilePath, C);
   return result;
 }
+
+std::string Archive::getSymbolIndexPath(const std::string& ArchivePath) {
+  return ArchivePath + ARFILE_SYMIDX_SUFFIX;
+}
+
+// Write the symbol table to the symbol index file. The index is written to a
+// temporary file first and then renamed, so that concurrent links never read
+// a partially written index.
+bool Archive::writeSymbolIndex(std::string* ErrMsg) {
+  if (symTab.empty() && !scanSymbolTable(ErrMsg))
+    return true;
+
+  sys::fs::file_status ArchiveStatus;
+  if (error_code ec = sys::fs::status(archPath, ArchiveStatus)) {
+    if (ErrMsg)
+      *ErrMsg = "Could not stat archive '" + archPath + "': " + ec.message();
+    return true;
+  }
+
+  std::string IndexPath = getSymbolIndexPath(archPath);
+  SmallString<128> TmpPath;
+  int FD;
+  if (error_code ec = sys::fs::createUniqueFile(IndexPath + "-%%%%%%", FD,
+                                                TmpPath)) {
+    if (ErrMsg)
+      *ErrMsg = "Could not create symbol index for '" + archPath + "': " +
+                ec.message();
+    return true;
+  }
+
+  {
+    raw_fd_ostream Out(FD, true);
+    Out << ARFILE_SYMIDX_MAGIC
+        << ArchiveStatus.getSize() << ' '
+        << ArchiveStatus.getLastModificationTime().toEpochTime() << ' '
+        << firstFileOffset << '\n';
+
+    // Use the encoding of the LLVM symbol table of the archive
+    for (SymTabType::const_iterator I = symTab.begin(), E = symTab.end();
+         I != E; ++I) {
+      writeInteger(I->second, Out);
+      writeInteger(I->first.length(), Out);
+      Out << I->first;
+    }
+
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      if (ErrMsg)
+        *ErrMsg = "Could not write symbol index '" + IndexPath + "'";
+      sys::fs::remove(TmpPath.str());
+      return true;
+    }
+  }
+
+  if (error_code ec = sys::fs::rename(TmpPath.str(), IndexPath)) {
+    if (ErrMsg)
+      *ErrMsg = "Could not write symbol index '" + IndexPath + "': " +
+                ec.message();
+    sys::fs::remove(TmpPath.str());
+    return true;
+  }
+  return false;
+}
@@ -112,6 +112,7 @@ static MCContext *addPassesToGenerateCode(LLVMTargetMachine *TM,
   // Install a MachineModuleInfo class, which is an immutable pass that holds
   // all the per-module stuff we're generating, including MCContext.
   MachineModuleInfo *MMI = new MachineModuleInfo(*TM);
+  MMI->getContext().setNextUniqueID(TM->getFirstTempSymbolID());
   PM.add(MMI);
 
   // Set up a MachineFunction for the rest of CodeGen to work on.
@@ -53,7 +53,7 @@ bool MachineFunctionAnalysis::doInitialization(Module &M) {
   MachineModuleInfo *MMI = getAnalysisIfAvailable<MachineModuleInfo>();
   assert(MMI && "MMI not around yet??");
   MMI->setModule(&M);
-  NextFnNum = 0;
+  NextFnNum = TM ? TM->getFirstFunctionNumber() : 0;
   return false;
 }
 
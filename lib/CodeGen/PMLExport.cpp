@@ -18,6 +18,7 @@
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/ADT/APInt.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/LoopInfo.h"
 #include "llvm/Analysis/ScalarEvolution.h"
@@ -37,6 +38,7 @@
 #include "llvm/Support/YAMLTraits.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Target/TargetInstrInfo.h"
+#include <algorithm>
 
 
 using namespace llvm;
@@ -46,6 +48,8 @@ STATISTIC( NumConstantBounds, "Number of constant header bounds exported");
 STATISTIC( NumSymbolicBounds, "Number of symbolic header bounds exported");
 STATISTIC( NumSymbolicBoundsNonArg,
            "Number of symbolic header bounds NOT exported (non-arguments)");
+STATISTIC( NumInstantiatedBounds,
+           "Number of symbolic header bounds instantiated for call sites");
 STATISTIC( NumAnnotatedBounds,
            "Number of user-annotated header bounds exported");
 
@@ -181,23 +185,218 @@ int PMLInstrInfo::getSize(const MachineInstr *Instr)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-namespace {
-  // Check whether all LLVM values are function formal arguments.
-  // Implements SCEVTraversal::Visitor.
-  struct SCEVCheckFormalArgs {
-    bool OnlyArg;
+/// A loop header bound given as an expression over the formal arguments of
+/// a function, built from the SCEV of the backedge-taken count.
+///
+/// It is printed like the SCEV without casts, e.g. "(1 + %n)" or
+/// "(%n /u 2)", using the argument names of the argument-register mapping
+/// of the machine function. For calls with constant arguments, it can be
+/// evaluated to a constant bound. Like the SCEV, every node is evaluated
+/// modulo the width of its type.
+class SymbolicBound {
+  enum KindTy { Constant, Arg, ZeroExtend, SignExtend, Add, Mul, UDiv, SMax,
+                UMax };
+
+  struct Node {
+    KindTy Kind;
+    /// Width of the type of the node, in bits.
+    unsigned Width;
+    /// Value of a constant.
+    APInt Value;
+    /// Argument number and name of an argument.
+    unsigned ArgNo;
+    std::string Name;
+    std::vector<unsigned> Ops;
+  };
 
-    SCEVCheckFormalArgs() : OnlyArg(true) {}
+  /// The nodes of the expression, the root is the last node.
+  std::vector<Node> Nodes;
 
-    bool follow(const SCEV *S) {
-      if(const SCEVUnknown *Val = dyn_cast<SCEVUnknown>(S)) {
-        OnlyArg = isa<Argument>(Val->getValue());
-      }
-      return OnlyArg;
+  /// Add the nodes of S, returns false if S is not supported.
+  bool addNodes(const SCEV *S);
+
+  void print(raw_ostream &OS, unsigned N) const;
+
+  bool evaluate(const CallInst *CI, unsigned N, APInt &Result) const;
+
+public:
+  /// Create a bound from S, or return null if S does not only depend on
+  /// named formal arguments.
+  static SymbolicBound *create(const SCEV *S);
+
+  void print(raw_ostream &OS) const { print(OS, Nodes.size() - 1); }
+
+  /// Evaluate the header bound for the arguments of a call. Returns false if
+  /// an argument used by the bound is not constant, or if the bound does not
+  /// fit into 64 bits.
+  bool evaluate(const CallInst *CI, uint64_t &Result) const;
+};
+
+SymbolicBound *SymbolicBound::create(const SCEV *S) {
+  SymbolicBound *SB = new SymbolicBound();
+  if (SB->addNodes(S))
+    return SB;
+  delete SB;
+  return 0;
+}
+
+bool SymbolicBound::addNodes(const SCEV *S) {
+  if (!S->getType()->isIntegerTy())
+    return false;
+
+  Node N;
+  N.Width = S->getType()->getIntegerBitWidth();
+  N.ArgNo = 0;
+  switch (S->getSCEVType()) {
+  case scConstant:
+    N.Kind = Constant;
+    N.Value = cast<SCEVConstant>(S)->getValue()->getValue();
+    if (N.Value.getMinSignedBits() > 64)
+      return false;
+    break;
+  case scUnknown: {
+    const Argument *A = dyn_cast<Argument>(cast<SCEVUnknown>(S)->getValue());
+    if (!A || !A->hasName())
+      return false;
+    N.Kind = Arg;
+    N.ArgNo = A->getArgNo();
+    N.Name = A->getName();
+    break;
+  }
+  case scZeroExtend:
+  case scSignExtend: {
+    const SCEV *Op = cast<SCEVCastExpr>(S)->getOperand();
+    if (!addNodes(Op))
+      return false;
+    N.Kind = S->getSCEVType() == scZeroExtend ? ZeroExtend : SignExtend;
+    N.Ops.push_back(Nodes.size() - 1);
+    break;
+  }
+  case scUDivExpr: {
+    const SCEVUDivExpr *D = cast<SCEVUDivExpr>(S);
+    if (!addNodes(D->getLHS()))
+      return false;
+    N.Ops.push_back(Nodes.size() - 1);
+    if (!addNodes(D->getRHS()))
+      return false;
+    N.Ops.push_back(Nodes.size() - 1);
+    N.Kind = UDiv;
+    break;
+  }
+  case scAddExpr:
+  case scMulExpr:
+  case scSMaxExpr:
+  case scUMaxExpr: {
+    const SCEVNAryExpr *NAry = cast<SCEVNAryExpr>(S);
+    for (SCEVNAryExpr::op_iterator I = NAry->op_begin(), E = NAry->op_end();
+         I != E; ++I) {
+      if (!addNodes(*I))
+        return false;
+      N.Ops.push_back(Nodes.size() - 1);
     }
+    N.Kind = S->getSCEVType() == scAddExpr ? Add :
+             S->getSCEVType() == scMulExpr ? Mul :
+             S->getSCEVType() == scSMaxExpr ? SMax : UMax;
+    break;
+  }
+  default:
+    // Truncation and recurrences are not supported.
+    return false;
+  }
+  Nodes.push_back(N);
+  return true;
+}
 
-    bool isDone() const { return !OnlyArg; }
-  };
+void SymbolicBound::print(raw_ostream &OS, unsigned N) const {
+  const Node &Nd = Nodes[N];
+  const char *OpStr = "";
+  switch (Nd.Kind) {
+  case Constant:   OS << Nd.Value.getSExtValue(); return;
+  case Arg:        OS << "%" << Nd.Name; return;
+  case ZeroExtend:
+  case SignExtend: print(OS, Nd.Ops[0]); return;
+  case Add:        OpStr = " + "; break;
+  case Mul:        OpStr = " * "; break;
+  case UDiv:       OpStr = " /u "; break;
+  case SMax:       OpStr = " smax "; break;
+  case UMax:       OpStr = " umax "; break;
+  }
+  OS << "(";
+  for (unsigned i = 0, e = Nd.Ops.size(); i != e; ++i) {
+    if (i) OS << OpStr;
+    print(OS, Nd.Ops[i]);
+  }
+  OS << ")";
+}
+
+bool SymbolicBound::evaluate(const CallInst *CI, uint64_t &Result) const {
+  APInt Bound;
+  if (!evaluate(CI, Nodes.size() - 1, Bound))
+    return false;
+
+  // The header bound is the backedge-taken count plus one, so it is at least
+  // one. Zero is the result of 2^Width wrapping around.
+  if (Bound == 0) {
+    if (Bound.getBitWidth() >= 64)
+      return false;
+    Result = UINT64_C(1) << Bound.getBitWidth();
+    return true;
+  }
+  if (Bound.getActiveBits() > 64)
+    return false;
+  Result = Bound.getZExtValue();
+  return true;
+}
+
+bool SymbolicBound::evaluate(const CallInst *CI, unsigned N,
+                             APInt &Result) const {
+  const Node &Nd = Nodes[N];
+  switch (Nd.Kind) {
+  case Constant:
+    Result = Nd.Value;
+    return true;
+  case Arg: {
+    const ConstantInt *C = dyn_cast<ConstantInt>(CI->getArgOperand(Nd.ArgNo));
+    if (!C)
+      return false;
+    Result = C->getValue();
+    return Result.getBitWidth() == Nd.Width;
+  }
+  case ZeroExtend:
+    if (!evaluate(CI, Nd.Ops[0], Result))
+      return false;
+    Result = Result.zext(Nd.Width);
+    return true;
+  case SignExtend:
+    if (!evaluate(CI, Nd.Ops[0], Result))
+      return false;
+    Result = Result.sext(Nd.Width);
+    return true;
+  default:
+    break;
+  }
+
+  if (!evaluate(CI, Nd.Ops[0], Result))
+    return false;
+  for (unsigned i = 1, e = Nd.Ops.size(); i != e; ++i) {
+    APInt Op;
+    if (!evaluate(CI, Nd.Ops[i], Op))
+      return false;
+    switch (Nd.Kind) {
+    case Add:  Result += Op; break;
+    case Mul:  Result *= Op; break;
+    case SMax: if (Op.sgt(Result)) Result = Op; break;
+    case UMax: if (Op.ugt(Result)) Result = Op; break;
+    case UDiv:
+      if (Op == 0)
+        return false;
+      Result = Result.udiv(Op);
+      break;
+    default:
+      llvm_unreachable("unexpected symbolic bound node");
+    }
+  }
+  return true;
 }
 
 
@@ -259,22 +458,19 @@ void PMLBitcodeExport::serialize(MachineFunction &MF)
         }
         // check for non-constant, symbolic loop bound
         const SCEV *BECount = SE.getBackedgeTakenCount(Loop);
-        if (!isa<SCEVCouldNotCompute>(BECount) || !isa<SCEVConstant>(BECount)) {
-          // check for Arguments using visitor
-          SCEVCheckFormalArgs CheckFA;
-          visitAll(BECount, CheckFA);
-          if (CheckFA.OnlyArg) {
-            // add 1 to get header bound from backedge count
-            const SCEV *SymbolicHeaderBound = SE.getAddExpr(BECount,
-                SE.getConstant(BECount->getType(), (uint64_t)1));
-
-            // FIXME maybe we want something more structured/processed
-            // than a dump
+        if (!isa<SCEVConstant>(BECount)) {
+          // add 1 to get header bound from backedge count
+          const SCEV *SymbolicHeaderBound = SE.getAddExpr(BECount,
+              SE.getConstant(BECount->getType(), (uint64_t)1));
+
+          // export bounds over formal arguments as parametric flow facts
+          if (SymbolicBound *SB = SymbolicBound::create(SymbolicHeaderBound)) {
             std::string s;
             raw_string_ostream os(s);
-            os << *SymbolicHeaderBound;
+            SB->print(os);
 
             YDoc.addFlowFact(createLoopFact(BI, StringRef(os.str())));
+            SymbolicBounds[Fn].push_back(std::make_pair(&*BI, SB));
             // bump statistic counter
             NumSymbolicBounds++;
           } else {
@@ -312,6 +508,11 @@ void PMLBitcodeExport::serialize(MachineFunction &MF)
       yaml::Instruction *I = B->addInstruction(
           new yaml::Instruction(Index++));
       exportInstruction(I, II);
+
+      // remember calls to instantiate the loop bounds of the callee
+      if (const CallInst *CI = dyn_cast<CallInst>(II))
+        if (CI->getCalledFunction() && !isa<IntrinsicInst>(CI))
+          Calls.push_back(CI);
     }
 
   }
@@ -320,6 +521,78 @@ void PMLBitcodeExport::serialize(MachineFunction &MF)
   YDoc.addFunction(F);
 }
 
+PMLBitcodeExport::~PMLBitcodeExport() {
+  for (std::map<const Function*, SymbolicBoundList>::iterator
+       I = SymbolicBounds.begin(), E = SymbolicBounds.end(); I != E; ++I) {
+    for (unsigned i = 0, e = I->second.size(); i != e; ++i)
+      delete I->second[i].second;
+  }
+}
+
+/// getCallSiteName - Name a call site as function/block/instruction index.
+static std::string getCallSiteName(const CallInst *CI) {
+  const BasicBlock *BB = CI->getParent();
+  unsigned Index = 0;
+  for (BasicBlock::const_iterator I = BB->begin(); &*I != CI; ++I)
+    Index++;
+  return (BB->getParent()->getName() + "/" + BB->getName() + "/" +
+          Twine(Index)).str();
+}
+
+void PMLBitcodeExport::instantiateLoopBounds() {
+  // The largest bound of all calls of a function, and the number of calls
+  // all bounds of the function could be instantiated for.
+  std::map<const Function*, std::vector<uint64_t> > MaxBounds;
+  std::map<const Function*, unsigned> NumInstantiatedCalls;
+
+  for (unsigned c = 0, ce = Calls.size(); c != ce; ++c) {
+    const CallInst *CI = Calls[c];
+    const Function *Callee = CI->getCalledFunction();
+    std::map<const Function*, SymbolicBoundList>::iterator SBs =
+      SymbolicBounds.find(Callee);
+    if (SBs == SymbolicBounds.end())
+      continue;
+
+    std::vector<uint64_t> &Max = MaxBounds[Callee];
+    Max.resize(SBs->second.size(), 0);
+    bool AllInstantiated = true;
+
+    for (unsigned i = 0, e = SBs->second.size(); i != e; ++i) {
+      uint64_t Bound;
+      if (!SBs->second[i].second->evaluate(CI, Bound)) {
+        AllInstantiated = false;
+        continue;
+      }
+      Max[i] = std::max(Max[i], Bound);
+
+      yaml::FlowFact *FF = createLoopFact(SBs->second[i].first, Bound);
+      FF->ScopeRef->Context.push_back(
+        new yaml::ContextEntry(yaml::Name(getCallSiteName(CI))));
+      YDoc.addFlowFact(FF);
+      NumInstantiatedBounds++;
+    }
+    if (AllInstantiated)
+      NumInstantiatedCalls[Callee]++;
+  }
+
+  // If a function can only be called by the calls seen, the largest bound
+  // of the calls holds in all contexts. If the module is compiled in
+  // partitions, calls in the other partitions are not seen.
+  if (TM.isModulePartition())
+    return;
+
+  for (std::map<const Function*, unsigned>::iterator
+       I = NumInstantiatedCalls.begin(), E = NumInstantiatedCalls.end();
+       I != E; ++I) {
+    const Function *F = I->first;
+    if (!F->hasLocalLinkage() || F->getNumUses() != I->second)
+      continue;
+    SymbolicBoundList &SBs = SymbolicBounds[F];
+    for (unsigned i = 0, e = SBs.size(); i != e; ++i)
+      YDoc.addFlowFact(createLoopFact(SBs[i].first, MaxBounds[F][i]));
+  }
+}
+
 
 yaml::Name PMLBitcodeExport::getOpcode(const Instruction *Instr)
 {
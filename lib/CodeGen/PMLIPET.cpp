@@ -0,0 +1,1030 @@
+//===-- PMLIPET.cpp -------------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// IPET based WCET calculation on the machine-code level of PML documents.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "pml-ipet"
+
+#include "llvm/CodeGen/PMLIPET.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace llvm;
+
+STATISTIC(NumIPETVariables,   "Number of IPET variables");
+STATISTIC(NumIPETConstraints, "Number of IPET constraints");
+STATISTIC(NumSimplexPivots,   "Number of simplex pivot operations");
+STATISTIC(NumBranchNodes,     "Number of branch and bound nodes");
+
+/// Tolerance for floating point comparisons in the simplex
+static const double Eps = 1e-9;
+
+/// Tolerance to decide if a value is integral
+static const double IntEps = 1e-6;
+
+//===----------------------------------------------------------------------===//
+// Simplex
+//===----------------------------------------------------------------------===//
+
+namespace {
+  /// Sparse simplex tableau. Each constraint row keeps its non-zero entries
+  /// sorted by column, so the memory grows with the number of non-zeros
+  /// instead of rows * columns. The reduced costs of the current objective
+  /// are kept in a dense row, whose last entry is the objective value.
+  class SimplexTableau {
+  public:
+    typedef std::vector<std::pair<unsigned, double> > Row;
+
+  private:
+    unsigned Rows, Cols;
+    std::vector<Row> A;
+    std::vector<double> RHS;
+    std::vector<double> Cost;
+    std::vector<unsigned> Basis;
+    uint64_t NumEntries, MaxEntries;
+    unsigned &NumPivots;
+    Row Tmp;
+
+  public:
+    SimplexTableau(unsigned rows, unsigned cols, uint64_t maxEntries,
+                   unsigned &numPivots)
+    : Rows(rows), Cols(cols), A(rows), RHS(rows, 0.0), Cost(cols + 1, 0.0),
+      Basis(rows), NumEntries(0), MaxEntries(maxEntries),
+      NumPivots(numPivots) {}
+
+    /// Set row r to the (sorted, duplicate free) entries R.
+    void setRow(unsigned r, Row &R, double rhs, unsigned basic) {
+      NumEntries += R.size();
+      A[r].swap(R);
+      RHS[r] = rhs;
+      Basis[r] = basic;
+    }
+
+    const Row &getRow(unsigned r) const { return A[r]; }
+    double get(unsigned r, unsigned c) const;
+    double &rhs(unsigned r) { return RHS[r]; }
+    double &cost(unsigned c) { return Cost[c]; }
+    double &objective() { return Cost[Cols]; }
+
+    unsigned getBasic(unsigned r) const { return Basis[r]; }
+
+    /// Pivot on (pr, pc). Returns false if the tableau grew beyond the
+    /// entry limit.
+    bool pivot(unsigned pr, unsigned pc);
+
+    /// Run the simplex on the columns [0, Limit). Returns Unbounded if the
+    /// problem is unbounded, TooLarge if the entry limit was exceeded.
+    PMLLinearProgram::Status optimize(unsigned Limit);
+  };
+
+  struct EntryColumnLess {
+    bool operator()(const std::pair<unsigned, double> &E, unsigned C) const {
+      return E.first < C;
+    }
+  };
+}
+
+double SimplexTableau::get(unsigned r, unsigned c) const {
+  const Row &R = A[r];
+  Row::const_iterator i = std::lower_bound(R.begin(), R.end(), c,
+                                           EntryColumnLess());
+  return (i != R.end() && i->first == c) ? i->second : 0.0;
+}
+
+bool SimplexTableau::pivot(unsigned pr, unsigned pc) {
+  NumPivots++;
+  Row &P = A[pr];
+  double Inv = 1.0 / get(pr, pc);
+
+  Tmp.clear();
+  for (Row::iterator i = P.begin(), ie = P.end(); i != ie; ++i) {
+    double V = i->first == pc ? 1.0 : i->second * Inv;
+    if (std::fabs(V) >= Eps) Tmp.push_back(std::make_pair(i->first, V));
+  }
+  NumEntries += Tmp.size();
+  NumEntries -= P.size();
+  P.swap(Tmp);
+  RHS[pr] *= Inv;
+  if (std::fabs(RHS[pr]) < Eps) RHS[pr] = 0.0;
+
+  // Only the rows with a non-zero in the pivot column change. IPET
+  // tableaus are sparse, so this saves most of the work.
+  for (unsigned r = 0; r < Rows; r++) {
+    if (r == pr) continue;
+    double F = get(r, pc);
+    if (F == 0.0) continue;
+
+    // Merge R - F * P, dropping the pivot column and cancelled entries
+    Row &R = A[r];
+    Tmp.clear();
+    Row::const_iterator i = R.begin(), ie = R.end();
+    Row::const_iterator j = P.begin(), je = P.end();
+    while (i != ie || j != je) {
+      unsigned C;
+      double V;
+      if (j == je || (i != ie && i->first < j->first)) {
+        C = i->first; V = i->second; ++i;
+      } else if (i == ie || j->first < i->first) {
+        C = j->first; V = -F * j->second; ++j;
+      } else {
+        C = i->first; V = i->second - F * j->second; ++i; ++j;
+      }
+      if (C != pc && std::fabs(V) >= Eps) Tmp.push_back(std::make_pair(C, V));
+    }
+    NumEntries += Tmp.size();
+    NumEntries -= R.size();
+    R.swap(Tmp);
+    RHS[r] -= F * RHS[pr];
+    if (std::fabs(RHS[r]) < Eps) RHS[r] = 0.0;
+  }
+
+  double F = Cost[pc];
+  if (F != 0.0) {
+    for (Row::const_iterator j = P.begin(), je = P.end(); j != je; ++j) {
+      double &C = Cost[j->first];
+      C -= F * j->second;
+      if (std::fabs(C) < Eps) C = 0.0;
+    }
+    Cost[Cols] -= F * RHS[pr];
+    if (std::fabs(Cost[Cols]) < Eps) Cost[Cols] = 0.0;
+    Cost[pc] = 0.0;
+  }
+  Basis[pr] = pc;
+  return NumEntries <= MaxEntries;
+}
+
+PMLLinearProgram::Status SimplexTableau::optimize(unsigned Limit) {
+  // Use Dantzig's rule, but fall back to Bland's rule after a number of
+  // degenerate pivots to avoid cycling (IPET problems are highly degenerate).
+  unsigned Degenerate = 0;
+  while (true) {
+    bool Bland = Degenerate > 50;
+    int pc = -1;
+    double Best = -Eps;
+    for (unsigned c = 0; c < Limit; c++) {
+      double RC = cost(c);
+      if (RC < Best) {
+        pc = c;
+        if (Bland) break;
+        Best = RC;
+      }
+    }
+    if (pc < 0) return PMLLinearProgram::Optimal;
+
+    int pr = -1;
+    double MinRatio = 0.0;
+    for (unsigned r = 0; r < Rows; r++) {
+      double Val = get(r, pc);
+      if (Val <= Eps) continue;
+      double Ratio = rhs(r) / Val;
+      if (pr < 0 || Ratio < MinRatio - Eps ||
+          (Ratio < MinRatio + Eps && Basis[r] < Basis[pr])) {
+        pr = r;
+        MinRatio = Ratio;
+      }
+    }
+    if (pr < 0) return PMLLinearProgram::Unbounded;
+
+    if (MinRatio < Eps) Degenerate++;
+    else Degenerate = 0;
+
+    if (!pivot(pr, pc)) return PMLLinearProgram::TooLarge;
+  }
+}
+
+void PMLLinearProgram::addConstraint(const TermList &Terms, CmpOp Op,
+                                     double RHS) {
+  Constraint C;
+  C.Op = Op;
+  C.RHS = RHS;
+  for (TermList::const_iterator i = Terms.begin(), ie = Terms.end(); i != ie;
+       ++i) {
+    assert(i->first < VarNames.size() && "Unknown variable in constraint");
+    TermList::iterator t = C.Terms.begin(), te = C.Terms.end();
+    for (; t != te; ++t) {
+      if (t->first == i->first) break;
+    }
+    if (t != te) t->second += i->second;
+    else C.Terms.push_back(*i);
+  }
+  Constraints.push_back(C);
+}
+
+PMLLinearProgram::Status
+PMLLinearProgram::solveRelaxation(const std::vector<Constraint> &Rows,
+                                  std::vector<double> &X, double &Obj)
+{
+  unsigned N = VarNames.size();
+  unsigned M = Rows.size();
+
+  // Count slack and artificial columns, and the initial tableau entries
+  unsigned NumSlack = 0, NumArtificial = 0;
+  uint64_t NumEntries = 0;
+  for (unsigned r = 0; r < M; r++) {
+    CmpOp Op = Rows[r].Op;
+    // normalize to a non-negative RHS
+    if (Rows[r].RHS < 0) {
+      if (Op == LessEqual) Op = GreaterEqual;
+      else if (Op == GreaterEqual) Op = LessEqual;
+    }
+    if (Op != Equal) NumSlack++;
+    if (Op != LessEqual) NumArtificial++;
+    NumEntries += Rows[r].Terms.size() + (Op != Equal) + (Op != LessEqual);
+  }
+
+  unsigned FirstSlack = N;
+  unsigned FirstArtificial = N + NumSlack;
+  unsigned Cols = FirstArtificial + NumArtificial;
+
+  // Refuse problems whose initial tableau already exceeds the limit, instead
+  // of running out of memory.
+  if (NumEntries > MaxEntries) return TooLarge;
+
+  SimplexTableau Tab(M, Cols, MaxEntries, NumPivots);
+
+  unsigned Slack = FirstSlack, Artificial = FirstArtificial;
+  SimplexTableau::Row R;
+  for (unsigned r = 0; r < M; r++) {
+    const Constraint &C = Rows[r];
+    double Sign = C.RHS < 0 ? -1.0 : 1.0;
+    CmpOp Op = C.Op;
+    if (Sign < 0) {
+      if (Op == LessEqual) Op = GreaterEqual;
+      else if (Op == GreaterEqual) Op = LessEqual;
+    }
+    R.clear();
+    for (TermList::const_iterator t = C.Terms.begin(), te = C.Terms.end();
+         t != te; ++t) {
+      if (t->second != 0.0)
+        R.push_back(std::make_pair(t->first, Sign * t->second));
+    }
+    std::sort(R.begin(), R.end());
+
+    unsigned Basic;
+    if (Op == LessEqual) {
+      R.push_back(std::make_pair(Slack, 1.0));
+      Basic = Slack++;
+    } else {
+      if (Op == GreaterEqual) R.push_back(std::make_pair(Slack++, -1.0));
+      R.push_back(std::make_pair(Artificial, 1.0));
+      Basic = Artificial++;
+    }
+    Tab.setRow(r, R, Sign * C.RHS, Basic);
+  }
+
+  // Phase 1: minimize the sum of the artificial variables
+  if (NumArtificial) {
+    for (unsigned r = 0; r < M; r++) {
+      if (Tab.getBasic(r) < FirstArtificial) continue;
+      const SimplexTableau::Row &Row = Tab.getRow(r);
+      for (unsigned i = 0, e = Row.size(); i != e; i++) {
+        if (Row[i].first < FirstArtificial)
+          Tab.cost(Row[i].first) -= Row[i].second;
+      }
+      Tab.objective() -= Tab.rhs(r);
+    }
+    if (Tab.optimize(Cols) == TooLarge) return TooLarge;
+    if (Tab.objective() < -IntEps) return Infeasible;
+
+    // Drive remaining (zero) artificial variables out of the basis
+    for (unsigned r = 0; r < M; r++) {
+      if (Tab.getBasic(r) < FirstArtificial) continue;
+      const SimplexTableau::Row &Row = Tab.getRow(r);
+      for (unsigned i = 0, e = Row.size(); i != e; i++) {
+        if (Row[i].first >= FirstArtificial) break;
+        if (std::fabs(Row[i].second) > Eps) {
+          if (!Tab.pivot(r, Row[i].first)) return TooLarge;
+          break;
+        }
+      }
+      // Otherwise the row is redundant, the artificial stays at zero.
+    }
+  }
+
+  // Phase 2: maximize the objective, artificial columns must not enter
+  for (unsigned c = 0; c <= Cols; c++) Tab.cost(c) = 0.0;
+  for (unsigned c = 0; c < N; c++) Tab.cost(c) = -Objective[c];
+  for (unsigned r = 0; r < M; r++) {
+    unsigned B = Tab.getBasic(r);
+    if (B >= N || Objective[B] == 0.0) continue;
+    double F = Objective[B];
+    const SimplexTableau::Row &Row = Tab.getRow(r);
+    for (unsigned i = 0, e = Row.size(); i != e; i++)
+      Tab.cost(Row[i].first) += F * Row[i].second;
+    Tab.objective() += F * Tab.rhs(r);
+  }
+  Status S = Tab.optimize(FirstArtificial);
+  if (S != Optimal) return S;
+
+  X.assign(N, 0.0);
+  for (unsigned r = 0; r < M; r++) {
+    unsigned B = Tab.getBasic(r);
+    if (B < N) X[B] = Tab.rhs(r);
+  }
+  Obj = Tab.objective();
+  return Optimal;
+}
+
+PMLLinearProgram::Status
+PMLLinearProgram::branchAndBound(std::vector<Constraint> &Rows,
+                                 std::vector<double> &Best, double &BestObj,
+                                 bool &Found)
+{
+  if (NumNodes >= MaxNodes) return Aborted;
+  NumNodes++;
+
+  std::vector<double> X;
+  double Obj;
+  Status S = solveRelaxation(Rows, X, Obj);
+  if (S != Optimal) return S;
+
+  // With integral costs, the objective of an integral solution is integral
+  // too, so we can prune all nodes that cannot improve by at least one.
+  if (Found && Obj < BestObj + 1.0 - IntEps) return Optimal;
+
+  // Branch on the first fractional variable
+  unsigned FracVar = X.size();
+  for (unsigned v = 0, e = X.size(); v != e; v++) {
+    if (std::fabs(X[v] - std::floor(X[v] + 0.5)) > IntEps) {
+      FracVar = v;
+      break;
+    }
+  }
+  if (FracVar == X.size()) {
+    Best = X;
+    BestObj = Obj;
+    Found = true;
+    return Optimal;
+  }
+
+  Constraint Bound;
+  Bound.Terms.push_back(std::make_pair(FracVar, 1.0));
+
+  // Upper branch first, to find a good (large) solution quickly
+  Bound.Op = GreaterEqual;
+  Bound.RHS = std::ceil(X[FracVar]);
+  Rows.push_back(Bound);
+  Status Up = branchAndBound(Rows, Best, BestObj, Found);
+  Rows.pop_back();
+  if (Up != Optimal && Up != Infeasible) return Up;
+
+  Bound.Op = LessEqual;
+  Bound.RHS = std::floor(X[FracVar]);
+  Rows.push_back(Bound);
+  Status Down = branchAndBound(Rows, Best, BestObj, Found);
+  Rows.pop_back();
+  if (Down != Optimal && Down != Infeasible) return Down;
+
+  return Optimal;
+}
+
+PMLLinearProgram::Status PMLLinearProgram::solve(double &Obj,
+                                                 std::vector<double> &X)
+{
+  NumPivots = 0;
+  NumNodes = 0;
+
+  Status S = solveRelaxation(Constraints, X, Obj);
+  NumSimplexPivots += NumPivots;
+  if (S != Optimal) return S;
+
+  bool Integral = true;
+  for (unsigned v = 0, e = X.size(); v != e; v++) {
+    if (std::fabs(X[v] - std::floor(X[v] + 0.5)) > IntEps) {
+      Integral = false;
+      break;
+    }
+  }
+  if (Integral) return Optimal;
+
+  // A fractional optimum of the relaxation is only an upper bound
+  if (MaxNodes == 0) return Aborted;
+
+  // Keep the relaxation: its objective is a safe upper bound if branch and
+  // bound does not finish.
+  std::vector<double> RelaxedX = X;
+  double RelaxedObj = Obj;
+
+  std::vector<Constraint> Rows(Constraints);
+  std::vector<double> Best;
+  double BestObj = 0.0;
+  bool Found = false;
+  S = branchAndBound(Rows, Best, BestObj, Found);
+  NumSimplexPivots += NumPivots;
+  NumBranchNodes += NumNodes;
+
+  if (S == Optimal && Found) {
+    X = Best;
+    Obj = BestObj;
+    return Optimal;
+  }
+  if (S == Optimal) return Infeasible;
+
+  // Out of nodes or tableau entries
+  X = RelaxedX;
+  Obj = RelaxedObj;
+  return Aborted;
+}
+
+//===----------------------------------------------------------------------===//
+// Cost Model
+//===----------------------------------------------------------------------===//
+
+uint64_t PMLIPETCostModel::
+getInstructionCycles(const yaml::MachineInstruction &I)
+{
+  // Bundled instructions are issued together with their predecessor.
+  uint64_t Cycles = I.Bundled ? 0 : 1;
+  if (I.MemMode != yaml::memmode_none) Cycles += MemAccessCycles;
+  if (I.BranchType == yaml::branch_call || I.BranchType == yaml::branch_return)
+    Cycles += CallReturnCycles;
+  return Cycles;
+}
+
+uint64_t PMLIPETCostModel::
+getEdgeCycles(const yaml::MachineBlock &Block,
+              ArrayRef<const yaml::MachineInstruction*> Instrs, int Branch)
+{
+  uint64_t Cycles = 0;
+  for (unsigned i = 0, e = Instrs.size(); i != e; i++) {
+    Cycles += getInstructionCycles(*Instrs[i]);
+  }
+  return Cycles;
+}
+
+//===----------------------------------------------------------------------===//
+// IPET Builder
+//===----------------------------------------------------------------------===//
+
+/// Get the integer value of a flow fact RHS, return false if it is symbolic.
+static bool getConstantRHS(const yaml::Name &RHS, int64_t &Value) {
+  StringRef S = RHS.getName();
+  return !S.empty() && !S.getAsInteger(10, Value);
+}
+
+static bool isLoopHeader(const yaml::MachineBlock &B) {
+  return !B.Loops.empty() && B.Loops.front() == B.BlockName;
+}
+
+static bool isInLoop(const yaml::MachineBlock &B, const yaml::Name &Header) {
+  return std::find(B.Loops.begin(), B.Loops.end(), Header) != B.Loops.end();
+}
+
+static bool mayReturn(const yaml::MachineBlock &B) {
+  for (unsigned i = 0, e = B.Instructions.size(); i != e; i++) {
+    if (B.Instructions[i]->BranchType == yaml::branch_return) return true;
+  }
+  return false;
+}
+
+int PMLIPETBuilder::findFunction(const yaml::Name &Name) const {
+  StringMap<unsigned>::const_iterator it =
+                                        FunctionByName.find(Name.getName());
+  if (it != FunctionByName.end()) return it->second;
+  it = FunctionByLabel.find(Name.getName());
+  if (it != FunctionByLabel.end()) return it->second;
+  return -1;
+}
+
+int PMLIPETBuilder::findBlock(unsigned F, const yaml::Name &Name) const {
+  const StringMap<unsigned> &BI = Functions[F].BlockIndex;
+  StringMap<unsigned>::const_iterator it = BI.find(Name.getName());
+  return it == BI.end() ? -1 : (int)it->second;
+}
+
+bool PMLIPETBuilder::useFlowFact(const yaml::FlowFact &FF) const {
+  if (FF.Level != yaml::level_machinecode) return false;
+  if (Origins.empty()) return true;
+  return std::find(Origins.begin(), Origins.end(),
+                   FF.Origin.getName().str()) != Origins.end();
+}
+
+bool PMLIPETBuilder::isGlobalScope(const yaml::Scope *S) const {
+  if (!S || !S->Loop.empty() || !S->Context.empty()) return false;
+  int F = findFunction(S->Function);
+  return F >= 0 && (unsigned)F == Entry;
+}
+
+/// Mark a block as infeasible and propagate to blocks that can only be
+/// reached through (or only continue to) infeasible blocks.
+void PMLIPETBuilder::setInfeasible(unsigned F, unsigned B) {
+  FunctionInfo &FI = Functions[F];
+  std::vector<yaml::MachineBlock*> &Blocks = FI.MF->Blocks;
+
+  SmallVector<unsigned, 8> Worklist;
+  Worklist.push_back(B);
+  while (!Worklist.empty()) {
+    unsigned Cur = Worklist.pop_back_val();
+    if (FI.Infeasible[Cur]) continue;
+    FI.Infeasible[Cur] = true;
+    yaml::MachineBlock *MB = Blocks[Cur];
+
+    for (unsigned s = 0, se = MB->Successors.size(); s != se; s++) {
+      int Succ = findBlock(F, MB->Successors[s]);
+      if (Succ < 0 || FI.Infeasible[Succ]) continue;
+      yaml::MachineBlock *SB = Blocks[Succ];
+      bool AllPredsInfeasible = true;
+      for (unsigned p = 0, pe = SB->Predecessors.size(); p != pe; p++) {
+        int Pred = findBlock(F, SB->Predecessors[p]);
+        if (Pred < 0 || FI.Infeasible[Pred]) continue;
+        // back edges do not make a block feasible
+        if (isLoopHeader(*SB) && isInLoop(*Blocks[Pred], SB->BlockName))
+          continue;
+        AllPredsInfeasible = false;
+        break;
+      }
+      if (AllPredsInfeasible) Worklist.push_back(Succ);
+    }
+
+    for (unsigned p = 0, pe = MB->Predecessors.size(); p != pe; p++) {
+      int Pred = findBlock(F, MB->Predecessors[p]);
+      if (Pred < 0 || FI.Infeasible[Pred]) continue;
+      yaml::MachineBlock *PB = Blocks[Pred];
+      bool AllSuccsInfeasible = !mayReturn(*PB);
+      for (unsigned s = 0, se = PB->Successors.size(); s != se; s++) {
+        int Succ = findBlock(F, PB->Successors[s]);
+        if (Succ >= 0 && !FI.Infeasible[Succ]) {
+          AllSuccsInfeasible = false;
+          break;
+        }
+      }
+      if (AllSuccsInfeasible) Worklist.push_back(Pred);
+    }
+  }
+}
+
+static std::string getCallSiteKey(const yaml::Name &Function,
+                                  const yaml::Name &Block,
+                                  const yaml::Name &Instr) {
+  return (Function.getName() + "/" + Block.getName() + "/" +
+          Instr.getName()).str();
+}
+
+/// Collect infeasible blocks and call targets from globally valid flow facts,
+/// like platin's ControlFlowRefinement.
+void PMLIPETBuilder::buildRefinement() {
+  for (std::vector<yaml::FlowFact*>::iterator i = Doc.FlowFacts.begin(),
+       ie = Doc.FlowFacts.end(); i != ie; ++i) {
+    yaml::FlowFact &FF = **i;
+    if (!useFlowFact(FF) || FF.TermsLHS.empty()) continue;
+
+    int64_t RHS;
+    if (!getConstantRHS(FF.RHS, RHS) || RHS != 0) continue;
+    if (!FF.ScopeRef || !FF.ScopeRef->Context.empty()) continue;
+
+    int ScopeFn = findFunction(FF.ScopeRef->Function);
+    if (ScopeFn < 0) continue;
+    // Local facts with a zero RHS are globally valid as well
+    bool Global = isGlobalScope(FF.ScopeRef);
+
+    const yaml::Term &First = FF.TermsLHS.front();
+    if (!First.PP || !First.PP->Context.empty()) continue;
+    int F = findFunction(First.PP->Function);
+    if (F < 0) continue;
+    if (!Global && F != ScopeFn) continue;
+
+    // infeasible block: block <= 0
+    if (FF.TermsLHS.size() == 1 && !First.PP->Block.empty() &&
+        First.PP->Instruction.empty() && First.Factor > 0 &&
+        First.PP->EdgeSource.empty()) {
+      int B = findBlock(F, First.PP->Block);
+      if (B >= 0) setInfeasible(F, B);
+      continue;
+    }
+
+    // call targets: callsite - sum(targets) <= 0
+    if (First.PP->Instruction.empty() || First.Factor != 1 ||
+        FF.Comparison != yaml::cmp_less_equal)
+      continue;
+
+    SmallVector<unsigned, 2> Targets;
+    bool Valid = true;
+    for (unsigned t = 1, te = FF.TermsLHS.size(); t != te; t++) {
+      const yaml::Term &T = FF.TermsLHS[t];
+      int Callee = T.PP ? findFunction(T.PP->Function) : -1;
+      if (Callee < 0 || T.Factor != -1 || !T.PP->Block.empty()) {
+        Valid = false;
+        break;
+      }
+      Targets.push_back(Callee);
+    }
+    if (!Valid) continue;
+
+    std::string Key = getCallSiteKey(Functions[F].MF->FunctionName,
+                                     First.PP->Block, First.PP->Instruction);
+    StringMap<SmallVector<unsigned, 2> >::iterator it = CallTargets.find(Key);
+    if (it == CallTargets.end()) {
+      CallTargets[Key] = Targets;
+    } else {
+      // intersect with known targets
+      SmallVector<unsigned, 2> Common;
+      for (unsigned t = 0, te = Targets.size(); t != te; t++) {
+        if (std::find(it->second.begin(), it->second.end(), Targets[t]) !=
+            it->second.end())
+          Common.push_back(Targets[t]);
+      }
+      it->second = Common;
+    }
+  }
+}
+
+bool PMLIPETBuilder::getCallTargets(unsigned F, const yaml::MachineBlock &B,
+                                    const yaml::MachineInstruction &I,
+                                    SmallVectorImpl<unsigned> &Targets)
+{
+  bool Unresolved = false;
+  SmallVector<unsigned, 2> Static;
+  for (unsigned c = 0, ce = I.Callees.size(); c != ce; c++) {
+    StringRef Callee = I.Callees[c].getName();
+    if (Callee == "__any__") {
+      Unresolved = true;
+      continue;
+    }
+    // pseudo functions on bitcode
+    if (Callee.startswith("llvm.")) continue;
+    int CF = findFunction(I.Callees[c]);
+    if (CF < 0) return false;
+    Static.push_back(CF);
+  }
+
+  std::string Key = getCallSiteKey(Functions[F].MF->FunctionName,
+                                   B.BlockName, I.Index);
+  StringMap<SmallVector<unsigned, 2> >::iterator it = CallTargets.find(Key);
+  if (it == CallTargets.end()) {
+    if (Unresolved) return false;
+    Targets.append(Static.begin(), Static.end());
+    return true;
+  }
+  for (unsigned t = 0, te = it->second.size(); t != te; t++) {
+    if (Unresolved || std::find(Static.begin(), Static.end(), it->second[t])
+                      != Static.end())
+      Targets.push_back(it->second[t]);
+  }
+  return true;
+}
+
+void PMLIPETBuilder::addEdges(unsigned F) {
+  FunctionInfo &FI = Functions[F];
+  std::vector<yaml::MachineBlock*> &Blocks = FI.MF->Blocks;
+
+  for (unsigned b = 0, be = Blocks.size(); b != be; b++) {
+    yaml::MachineBlock *MB = Blocks[b];
+    // skip data blocks
+    if (b != 0 && MB->Predecessors.empty()) continue;
+
+    SmallVector<const yaml::MachineBlock*, 2> Targets;
+    for (unsigned s = 0, se = MB->Successors.size(); s != se; s++) {
+      int Succ = findBlock(F, MB->Successors[s]);
+      if (Succ < 0 || std::find(Targets.begin(), Targets.end(), Blocks[Succ])
+                      != Targets.end())
+        continue;
+      Targets.push_back(Blocks[Succ]);
+    }
+    if (mayReturn(*MB)) Targets.push_back(0);
+
+    for (unsigned t = 0, te = Targets.size(); t != te; t++) {
+      const yaml::MachineBlock *Target = Targets[t];
+
+      // Find the last instruction that branches to the target, the
+      // instructions after its delay slots are not executed on this edge.
+      int Branch = -1;
+      for (unsigned i = 0, ie = MB->Instructions.size(); i != ie; i++) {
+        yaml::MachineInstruction *MI = MB->Instructions[i];
+        if (!Target) {
+          if (MI->BranchType == yaml::branch_return) Branch = i;
+        } else if (std::find(MI->BranchTargets.begin(),
+                             MI->BranchTargets.end(), Target->BlockName) !=
+                   MI->BranchTargets.end()) {
+          Branch = i;
+        }
+      }
+      unsigned End = MB->Instructions.size();
+      if (Branch >= 0) {
+        unsigned Slots = MB->Instructions[Branch]->BranchDelaySlots;
+        End = Branch + 1;
+        while (End < MB->Instructions.size() &&
+               (Slots > 0 || MB->Instructions[End]->Bundled)) {
+          if (!MB->Instructions[End]->Bundled) Slots--;
+          End++;
+        }
+      }
+      SmallVector<const yaml::MachineInstruction*, 16> Instrs(
+                         MB->Instructions.begin(),
+                         MB->Instructions.begin() + End);
+
+      Edge E;
+      E.Function = F;
+      E.Source = MB;
+      E.Target = Target;
+      E.Cycles = CM.getEdgeCycles(*MB, Instrs, Branch);
+      E.Var = LP.addVariable((FI.MF->FunctionName.getName() + ":" +
+                              MB->BlockName.getName() + "->" +
+                              (Target ? Target->BlockName.getName()
+                                      : StringRef("exit"))).str(),
+                             E.Cycles);
+
+      FI.Out[b].push_back(Edges.size());
+      if (Target) FI.In[FI.BlockIndex[Target->BlockName.getName()]]
+                    .push_back(Edges.size());
+      Edges.push_back(E);
+    }
+  }
+}
+
+void PMLIPETBuilder::blockFrequency(unsigned F, unsigned B, double Factor,
+                                    PMLLinearProgram::TermList &Terms) const
+{
+  const SmallVector<unsigned, 2> &Out = Functions[F].Out[B];
+  for (unsigned i = 0, e = Out.size(); i != e; i++) {
+    Terms.push_back(std::make_pair(Edges[Out[i]].Var, Factor));
+  }
+}
+
+bool PMLIPETBuilder::isBackedge(unsigned F, const Edge &E) const {
+  return E.Target && isLoopHeader(*E.Target) &&
+         isInLoop(*E.Source, E.Target->BlockName);
+}
+
+void PMLIPETBuilder::addConstraints(unsigned F) {
+  FunctionInfo &FI = Functions[F];
+  std::vector<yaml::MachineBlock*> &Blocks = FI.MF->Blocks;
+
+  for (unsigned b = 0, be = Blocks.size(); b != be; b++) {
+    yaml::MachineBlock *MB = Blocks[b];
+    if (b != 0 && MB->Predecessors.empty()) continue;
+
+    // flow conservation: incoming = outgoing (incl. return)
+    if (!FI.In[b].empty()) {
+      PMLLinearProgram::TermList Terms;
+      for (unsigned i = 0, e = FI.In[b].size(); i != e; i++)
+        Terms.push_back(std::make_pair(Edges[FI.In[b][i]].Var, -1.0));
+      blockFrequency(F, b, 1.0, Terms);
+      LP.addConstraint(Terms, PMLLinearProgram::Equal, 0);
+    }
+
+    if (FI.Infeasible[b]) {
+      PMLLinearProgram::TermList Terms;
+      blockFrequency(F, b, 1.0, Terms);
+      if (!Terms.empty())
+        LP.addConstraint(Terms, PMLLinearProgram::Equal, 0);
+      continue;
+    }
+
+    // call sites: sum of call edges <= block frequency (predicated calls)
+    for (unsigned i = 0, ie = MB->Instructions.size(); i != ie; i++) {
+      yaml::MachineInstruction *MI = MB->Instructions[i];
+      if (!MI->hasCallees()) continue;
+
+      SmallVector<unsigned, 2> Targets;
+      getCallTargets(F, *MB, *MI, Targets);
+
+      PMLLinearProgram::TermList Terms;
+      blockFrequency(F, b, -1.0, Terms);
+      for (unsigned t = 0, te = Targets.size(); t != te; t++) {
+        unsigned CallEdge = LP.addVariable(
+          (FI.MF->FunctionName.getName() + ":" + MB->BlockName.getName() +
+           ":" + MI->Index.getName() + "->" +
+           Functions[Targets[t]].MF->FunctionName.getName()).str());
+        Functions[Targets[t]].Callers.push_back(CallEdge);
+        Terms.push_back(std::make_pair(CallEdge, 1.0));
+      }
+      LP.addConstraint(Terms, PMLLinearProgram::LessEqual, 0);
+    }
+  }
+}
+
+bool PMLIPETBuilder::addFlowFact(const yaml::FlowFact &FF) {
+  int64_t RHS;
+  if (!getConstantRHS(FF.RHS, RHS)) return false;
+  if (!FF.ScopeRef || !FF.ScopeRef->Context.empty()) return false;
+
+  int ScopeFn = findFunction(FF.ScopeRef->Function);
+  if (ScopeFn < 0 || !Functions[ScopeFn].Reachable) return false;
+
+  PMLLinearProgram::TermList Terms;
+  for (unsigned t = 0, te = FF.TermsLHS.size(); t != te; t++) {
+    const yaml::Term &T = FF.TermsLHS[t];
+    const yaml::ProgramPoint *PP = T.PP;
+    if (!PP || !PP->Context.empty() || !PP->Marker.empty()) return false;
+
+    int F = findFunction(PP->Function);
+    if (F < 0 || !Functions[F].Reachable) return false;
+
+    if (!PP->EdgeSource.empty()) {
+      int Src = findBlock(F, PP->EdgeSource);
+      if (Src < 0) return false;
+      int Tgt = PP->EdgeTarget.empty() ? -1 : findBlock(F, PP->EdgeTarget);
+      bool Found = false;
+      const SmallVector<unsigned, 2> &Out = Functions[F].Out[Src];
+      for (unsigned i = 0, e = Out.size(); i != e; i++) {
+        const Edge &E = Edges[Out[i]];
+        if ((Tgt < 0 && !E.Target) ||
+            (Tgt >= 0 && E.Target == Functions[F].MF->Blocks[Tgt])) {
+          Terms.push_back(std::make_pair(E.Var, (double)T.Factor));
+          Found = true;
+        }
+      }
+      if (!Found) return false;
+    } else if (!PP->Instruction.empty()) {
+      // instructions are only used for refinement
+      return false;
+    } else if (!PP->Block.empty()) {
+      int B = findBlock(F, PP->Block);
+      if (B < 0) return false;
+      blockFrequency(F, B, T.Factor, Terms);
+    } else {
+      functionFrequency(F, T.Factor, Terms);
+    }
+  }
+
+  if (FF.ScopeRef->Loop.empty()) {
+    functionFrequency(ScopeFn, -RHS, Terms);
+  } else {
+    int H = findBlock(ScopeFn, FF.ScopeRef->Loop);
+    if (H < 0) return false;
+    // loop entry edges
+    const SmallVector<unsigned, 2> &In = Functions[ScopeFn].In[H];
+    for (unsigned i = 0, e = In.size(); i != e; i++) {
+      if (isBackedge(ScopeFn, Edges[In[i]])) continue;
+      Terms.push_back(std::make_pair(Edges[In[i]].Var, (double)-RHS));
+    }
+  }
+
+  LP.addConstraint(Terms, FF.Comparison == yaml::cmp_equal ?
+                          PMLLinearProgram::Equal : PMLLinearProgram::LessEqual,
+                   0);
+  return true;
+}
+
+bool PMLIPETBuilder::build(StringRef EntryLabel, std::string &Error) {
+  // index functions and blocks
+  // FunctionInfo holds a StringMap, which must not be copied once filled
+  Functions.resize(Doc.MachineFunctions.size());
+  for (unsigned f = 0, fe = Doc.MachineFunctions.size(); f != fe; f++) {
+    yaml::MachineFunction *MF = Doc.MachineFunctions[f];
+    FunctionInfo &FI = Functions[f];
+    FI.MF = MF;
+    FI.Reachable = false;
+    FI.Out.resize(MF->Blocks.size());
+    FI.In.resize(MF->Blocks.size());
+    FI.Infeasible.assign(MF->Blocks.size(), false);
+    for (unsigned b = 0, be = MF->Blocks.size(); b != be; b++) {
+      FI.BlockIndex[MF->Blocks[b]->BlockName.getName()] = b;
+    }
+    FunctionByName[MF->FunctionName.getName()] = f;
+    if (!MF->MapsTo.empty()) FunctionByLabel[MF->MapsTo.getName()] = f;
+  }
+
+  int E = findFunction(EntryLabel);
+  if (E < 0 || Functions[E].MF->Blocks.empty()) {
+    Error = ("analysis entry '" + EntryLabel + "' not found").str();
+    return false;
+  }
+  Entry = E;
+
+  buildRefinement();
+
+  // Compute the reachable functions
+  std::vector<unsigned> Worklist;
+  Worklist.push_back(Entry);
+  Functions[Entry].Reachable = true;
+  while (!Worklist.empty()) {
+    unsigned F = Worklist.back();
+    Worklist.pop_back();
+    FunctionInfo &FI = Functions[F];
+    for (unsigned b = 0, be = FI.MF->Blocks.size(); b != be; b++) {
+      if (FI.Infeasible[b]) continue;
+      yaml::MachineBlock *MB = FI.MF->Blocks[b];
+      for (unsigned i = 0, ie = MB->Instructions.size(); i != ie; i++) {
+        yaml::MachineInstruction *MI = MB->Instructions[i];
+        if (!MI->hasCallees()) continue;
+        SmallVector<unsigned, 2> Targets;
+        if (!getCallTargets(F, *MB, *MI, Targets)) {
+          Error = ("unresolved call at " + FI.MF->MapsTo.getName() + "/" +
+                   MB->BlockName.getName() + "/" + MI->Index.getName()).str();
+          return false;
+        }
+        for (unsigned t = 0, te = Targets.size(); t != te; t++) {
+          if (Functions[Targets[t]].Reachable) continue;
+          Functions[Targets[t]].Reachable = true;
+          Worklist.push_back(Targets[t]);
+        }
+      }
+    }
+  }
+
+  for (unsigned f = 0, fe = Functions.size(); f != fe; f++) {
+    if (Functions[f].Reachable) addEdges(f);
+  }
+  for (unsigned f = 0, fe = Functions.size(); f != fe; f++) {
+    if (Functions[f].Reachable) addConstraints(f);
+  }
+
+  // the entry is executed once, all other functions as often as called
+  PMLLinearProgram::TermList EntryTerms;
+  functionFrequency(Entry, 1.0, EntryTerms);
+  LP.addConstraint(EntryTerms, PMLLinearProgram::Equal, 1);
+
+  for (unsigned f = 0, fe = Functions.size(); f != fe; f++) {
+    FunctionInfo &FI = Functions[f];
+    if (!FI.Reachable || f == Entry) continue;
+    PMLLinearProgram::TermList Terms;
+    functionFrequency(f, 1.0, Terms);
+    for (unsigned c = 0, ce = FI.Callers.size(); c != ce; c++)
+      Terms.push_back(std::make_pair(FI.Callers[c], -1.0));
+    LP.addConstraint(Terms, PMLLinearProgram::Equal, 0);
+  }
+
+  for (std::vector<yaml::FlowFact*>::iterator i = Doc.FlowFacts.begin(),
+       ie = Doc.FlowFacts.end(); i != ie; ++i) {
+    if (!useFlowFact(**i)) continue;
+    if (addFlowFact(**i)) {
+      NumFlowFacts++;
+    } else {
+      DEBUG(dbgs() << "[pml-ipet] Skipping flow fact with RHS "
+                   << (*i)->RHS.getName() << "\n");
+      NumSkippedFlowFacts++;
+    }
+  }
+
+  NumIPETVariables += LP.getNumVariables();
+  NumIPETConstraints += LP.getNumConstraints();
+  return true;
+}
+
+int64_t PMLIPETBuilder::solve(std::vector<uint64_t> &Frequencies,
+                              std::string &Error)
+{
+  double Obj;
+  std::vector<double> X;
+  switch (LP.solve(Obj, X)) {
+  case PMLLinearProgram::Infeasible:
+    Error = "IPET problem is infeasible (contradicting flow facts?)";
+    return -1;
+  case PMLLinearProgram::Unbounded:
+    Error = "IPET problem is unbounded (missing loop bounds?)";
+    return -1;
+  case PMLLinearProgram::TooLarge:
+    Error = "IPET problem is too large: the simplex tableau exceeds " +
+            utostr(LP.getMaxEntries()) + " non-zero entries";
+    return -1;
+  case PMLLinearProgram::Aborted:
+    // The relaxation is a safe over-approximation
+    DEBUG(dbgs() << "[pml-ipet] Branch and bound aborted, using the LP "
+                    "relaxation\n");
+    break;
+  case PMLLinearProgram::Optimal:
+    break;
+  }
+
+  // Never round down: integral solutions are only off by the solver's
+  // tolerance, everything else must be over-approximated.
+  Frequencies.assign(Edges.size(), 0);
+  for (unsigned i = 0, e = Edges.size(); i != e; i++) {
+    Frequencies[i] = (uint64_t)std::ceil(X[Edges[i].Var] - IntEps);
+  }
+  return (int64_t)std::ceil(Obj - IntEps);
+}
+
+bool PMLIPETBuilder::addTiming(StringRef Origin, std::string &Error) {
+  std::vector<uint64_t> Freqs;
+  int64_t WCET = solve(Freqs, Error);
+  if (WCET < 0) return false;
+
+  yaml::Timing *T = new yaml::Timing(yaml::level_machinecode);
+  T->Origin = yaml::Name(Origin);
+  T->ScopeRef = new yaml::Scope(Functions[Entry].MF->FunctionName);
+  T->Cycles = WCET;
+
+  for (unsigned i = 0, e = Edges.size(); i != e; i++) {
+    const Edge &E = Edges[i];
+    yaml::ProgramPoint *PP = yaml::ProgramPoint::CreateFunction(
+                                   Functions[E.Function].MF->FunctionName);
+    PP->EdgeSource = E.Source->BlockName;
+    if (E.Target) PP->EdgeTarget = E.Target->BlockName;
+
+    yaml::ProfileEntry *P = new yaml::ProfileEntry();
+    P->setReference(PP);
+    P->Cycles = E.Cycles;
+    P->WCETFrequency = Freqs[i];
+    P->WCETContribution = Freqs[i] * E.Cycles;
+    T->Profile.push_back(P);
+  }
+
+  Doc.Timings.push_back(T);
+  return true;
+}
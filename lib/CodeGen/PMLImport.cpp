@@ -73,15 +73,9 @@ void PMLImport::initializePass()
 
     yaml::Input Input(Buf->getBuffer(), NULL, printErrorMessages);
 
-    yaml::PMLDocList Docs;
-
-    Input >> Docs.YDocs;
-
-    if (Input.error()) {
+    if (!yaml::readPMLStream(Input, YDoc)) {
       report_fatal_error("PMLImport: error parsing yaml.");
     }
-
-    Docs.mergeInto(YDoc);
   }
 
   rebuildPMLIndex();
@@ -429,14 +423,14 @@ bool PMLQuery::matches(const yaml::ProgramPoint *PP) const
 {
   if (!PP) return false;
   // TODO check for context
-  return PP->Function == FI.getName();
+  return PP->Function == FunctionName;
 }
 
 bool PMLQuery::matches(const yaml::Scope *S) const
 {
   if (!S) return false;
   // TODO check for context
-  return S->Function == FI.getName();
+  return S->Function == FunctionName;
 }
 
 template<typename T>
@@ -552,6 +546,84 @@ bool PMLQuery::getBlockCriticalityMap(BlockDoubleMap &Criticalitites)
   return found;
 }
 
+bool PMLQuery::getFrequencyMaps(BlockUIntMap &Blocks, EdgeUIntMap &Edges)
+{
+  bool found = false;
+  for (std::vector<yaml::Timing*>::const_iterator i = YDoc.Timings.begin(),
+       ie = YDoc.Timings.end(); i != ie; i++)
+  {
+    const yaml::Timing *T = *i;
+    if (!matches(T->Origin, T->Level)) continue;
+
+    for (std::vector<yaml::ProfileEntry*>::const_iterator
+         pi = T->Profile.begin(), pie = T->Profile.end(); pi != pie; pi++)
+    {
+      const yaml::ProfileEntry *P = *pi;
+      if (!P->hasFrequency()) continue;
+      if (!matches(P->Reference)) continue;
+
+      const yaml::ProgramPoint *PP = P->Reference;
+      if (!PP->Block.empty()) {
+        Blocks[PP->Block.getName()] += P->Frequency;
+      } else if (!PP->EdgeSource.empty() && !PP->EdgeTarget.empty()) {
+        Edges[std::make_pair(PP->EdgeSource.NameStr,
+                             PP->EdgeTarget.NameStr)] += P->Frequency;
+      } else {
+        continue;
+      }
+      found = true;
+    }
+  }
+
+  return found;
+}
+
+bool PMLQuery::getWCETFrequencyMaps(BlockUIntMap &Blocks, EdgeUIntMap &Edges)
+{
+  BlockUIntMap In, Out;
+  bool found = false;
+  for (std::vector<yaml::Timing*>::const_iterator i = YDoc.Timings.begin(),
+       ie = YDoc.Timings.end(); i != ie; i++)
+  {
+    const yaml::Timing *T = *i;
+    if (!matches(T->Origin, T->Level)) continue;
+
+    for (std::vector<yaml::ProfileEntry*>::const_iterator
+         pi = T->Profile.begin(), pie = T->Profile.end(); pi != pie; pi++)
+    {
+      const yaml::ProfileEntry *P = *pi;
+      if (!matches(P->Reference)) continue;
+
+      // Entries of different contexts are summed up.
+      const yaml::ProgramPoint *PP = P->Reference;
+      if (!PP->Block.empty()) {
+        Blocks[PP->Block.getName()] += P->WCETFrequency;
+      } else if (!PP->EdgeSource.empty()) {
+        Out[PP->EdgeSource.getName()] += P->WCETFrequency;
+        if (!PP->EdgeTarget.empty()) {
+          In[PP->EdgeTarget.getName()] += P->WCETFrequency;
+          Edges[std::make_pair(PP->EdgeSource.NameStr,
+                               PP->EdgeTarget.NameStr)] += P->WCETFrequency;
+        }
+      } else {
+        continue;
+      }
+      found = true;
+    }
+  }
+
+  for (BlockUIntMap::iterator i = Out.begin(), ie = Out.end(); i != ie; ++i) {
+    if (!Blocks.count(i->getKey()))
+      Blocks[i->getKey()] = std::max(i->getValue(), In.lookup(i->getKey()));
+  }
+  for (BlockUIntMap::iterator i = In.begin(), ie = In.end(); i != ie; ++i) {
+    if (!Blocks.count(i->getKey()))
+      Blocks[i->getKey()] = i->getValue();
+  }
+
+  return found;
+}
+
 bool PMLMCQuery::
 getMemFacts(const MachineFunction &MF, ValueFactsMap &MemFacts) const
 {
@@ -592,6 +664,30 @@ double PMLMCQuery::getCriticality(BlockDoubleMap &Criticalities,
   return getMaxDominatorValue(Criticalities, MBB, Default);
 }
 
+int64_t PMLMCQuery::getFrequency(BlockUIntMap &Blocks, EdgeUIntMap &Edges,
+                                 MachineBasicBlock &FromMBB,
+                                 MachineBasicBlock *ToMBB, int64_t Default)
+{
+  yaml::Name From = FI.getBlockName(FromMBB);
+  if (From.empty()) return Default;
+
+  if (ToMBB) {
+    yaml::Name To = FI.getBlockName(*ToMBB);
+    if (To.empty()) return Default;
+
+    EdgeUIntMap::iterator it = Edges.find(std::make_pair(From.NameStr,
+                                                         To.NameStr));
+    if (it != Edges.end()) return it->second;
+
+    // Edges between blocks created by splitting a single block are executed
+    // as often as the block itself.
+    if (From != To) return Default;
+  }
+
+  BlockUIntMap::iterator it = Blocks.find(From.getName());
+  return it != Blocks.end() ? (int64_t)it->second : Default;
+}
+
 
 
 INITIALIZE_PASS_BEGIN(PMLMachineFunctionImport, "pml-mf-import",
@@ -605,9 +701,14 @@ char PMLMachineFunctionImport::ID = 0;
 void PMLMachineFunctionImport::reset() {
   if (PQ) delete PQ;
   PQ = 0;
+  if (BQ) delete BQ;
+  BQ = 0;
 
   Criticalities.clear();
   Frequencies.clear();
+  EdgeFrequencies.clear();
+  WCETFrequencies.clear();
+  WCETEdgeFrequencies.clear();
 }
 
 void PMLMachineFunctionImport::getAnalysisUsage(AnalysisUsage &AU) const {
@@ -628,6 +729,9 @@ bool PMLMachineFunctionImport::runOnMachineFunction(MachineFunction &mf)
   // create a new query for this machine function.
   PMLImport &PI = getAnalysis<PMLImport>();
   PQ = PI.createMCQuery(*this, mf);
+  // Profiles are given on bitcode level, machine blocks are mapped to them
+  // by their labels.
+  BQ = PI.createMCQuery(*this, mf, yaml::level_bitcode);
 
   return false;
 }
@@ -639,7 +743,18 @@ void PMLMachineFunctionImport::loadCriticalityMap()
 
 void PMLMachineFunctionImport::loadFrequencyMap()
 {
+  Frequencies.clear();
+  EdgeFrequencies.clear();
+
+  WCETFrequencies.clear();
+  WCETEdgeFrequencies.clear();
+
+  if (PQ)
+    PQ->getWCETFrequencyMaps(WCETFrequencies, WCETEdgeFrequencies);
+
+  if (!BQ) return;
 
+  BQ->getFrequencyMaps(Frequencies, EdgeFrequencies);
 }
 
 double PMLMachineFunctionImport::getCriticalty(MachineBasicBlock *FromBB,
@@ -659,7 +774,18 @@ int64_t PMLMachineFunctionImport::getWCETFrequency(MachineBasicBlock *FromBB,
 {
   if (!PQ) return Default;
 
-  return Default;
+  return PQ->getFrequency(WCETFrequencies, WCETEdgeFrequencies, *FromBB, ToBB,
+                          Default);
+}
+
+int64_t PMLMachineFunctionImport::getFrequency(MachineBasicBlock *FromBB,
+                                               MachineBasicBlock *ToBB,
+                                               int64_t Default)
+{
+  if (!BQ) return Default;
+
+  return BQ->getFrequency(Frequencies, EdgeFrequencies, *FromBB, ToBB,
+                          Default);
 }
 
 
@@ -421,6 +421,7 @@ DILineInfo DWARFContext::getLineInfoForAddress(uint64_t Address,
   std::string FunctionName = "<invalid>";
   uint32_t Line = 0;
   uint32_t Column = 0;
+  uint32_t StartLine = 0;
   if (Specifier.needs(DILineInfoSpecifier::FunctionName)) {
     // The address may correspond to instruction in some inlined function,
     // so we have to build the chain of inlined functions and take the
@@ -431,6 +432,7 @@ DILineInfo DWARFContext::getLineInfoForAddress(uint64_t Address,
       const DWARFDebugInfoEntryMinimal &TopFunctionDIE = InlinedChain.DIEs[0];
       if (const char *Name = TopFunctionDIE.getSubroutineName(InlinedChain.U))
         FunctionName = Name;
+      StartLine = TopFunctionDIE.getDeclLine(InlinedChain.U);
     }
   }
   if (Specifier.needs(DILineInfoSpecifier::FileLineInfo)) {
@@ -442,7 +444,7 @@ DILineInfo DWARFContext::getLineInfoForAddress(uint64_t Address,
                                   FileName, Line, Column);
   }
   return DILineInfo(StringRef(FileName), StringRef(FunctionName),
-                    Line, Column);
+                    Line, Column, StartLine);
 }
 
 DILineInfoTable DWARFContext::getLineInfoForAddressRange(uint64_t Address,
@@ -454,6 +456,7 @@ DILineInfoTable DWARFContext::getLineInfoForAddressRange(uint64_t Address,
     return Lines;
 
   std::string FunctionName = "<invalid>";
+  uint32_t StartLine = 0;
   if (Specifier.needs(DILineInfoSpecifier::FunctionName)) {
     // The address may correspond to instruction in some inlined function,
     // so we have to build the chain of inlined functions and take the
@@ -464,6 +467,7 @@ DILineInfoTable DWARFContext::getLineInfoForAddressRange(uint64_t Address,
       const DWARFDebugInfoEntryMinimal &TopFunctionDIE = InlinedChain.DIEs[0];
       if (const char *Name = TopFunctionDIE.getSubroutineName(InlinedChain.U))
         FunctionName = Name;
+      StartLine = TopFunctionDIE.getDeclLine(InlinedChain.U);
     }
   }
 
@@ -471,7 +475,8 @@ DILineInfoTable DWARFContext::getLineInfoForAddressRange(uint64_t Address,
   // return the top-most function at the starting address.
   if (!Specifier.needs(DILineInfoSpecifier::FileLineInfo)) {
     Lines.push_back(
-        std::make_pair(Address, DILineInfo("<invalid>", FunctionName, 0, 0)));
+        std::make_pair(Address, DILineInfo("<invalid>", FunctionName, 0, 0,
+                                           StartLine)));
     return Lines;
   }
 
@@ -493,7 +498,8 @@ DILineInfoTable DWARFContext::getLineInfoForAddressRange(uint64_t Address,
     getFileNameForCompileUnit(CU, LineTable, Row.File,
                               NeedsAbsoluteFilePath, FileName);
     Lines.push_back(std::make_pair(
-        Row.Address, DILineInfo(FileName, FunctionName, Row.Line, Row.Column)));
+        Row.Address, DILineInfo(FileName, FunctionName, Row.Line, Row.Column,
+                                StartLine)));
   }
 
   return Lines;
@@ -519,10 +525,12 @@ DIInliningInfo DWARFContext::getInliningInfoForAddress(uint64_t Address,
     std::string FunctionName = "<invalid>";
     uint32_t Line = 0;
     uint32_t Column = 0;
+    uint32_t StartLine = 0;
     // Get function name if necessary.
     if (Specifier.needs(DILineInfoSpecifier::FunctionName)) {
       if (const char *Name = FunctionDIE.getSubroutineName(InlinedChain.U))
         FunctionName = Name;
+      StartLine = FunctionDIE.getDeclLine(InlinedChain.U);
     }
     if (Specifier.needs(DILineInfoSpecifier::FileLineInfo)) {
       const bool NeedsAbsoluteFilePath =
@@ -550,7 +558,7 @@ DIInliningInfo DWARFContext::getInliningInfoForAddress(uint64_t Address,
       }
     }
     DILineInfo Frame(StringRef(FileName), StringRef(FunctionName),
-                     Line, Column);
+                     Line, Column, StartLine);
     InliningInfo.addFrame(Frame);
   }
   return InliningInfo;
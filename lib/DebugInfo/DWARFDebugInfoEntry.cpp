@@ -301,6 +301,35 @@ DWARFDebugInfoEntryMinimal::getSubroutineName(const DWARFUnit *U) const {
   return 0;
 }
 
+uint32_t DWARFDebugInfoEntryMinimal::getDeclLine(const DWARFUnit *U) const {
+  if (!isSubroutineDIE())
+    return 0;
+  if (uint64_t Line = getAttributeValueAsUnsignedConstant(U, DW_AT_decl_line,
+                                                          0))
+    return Line;
+  // Try to get the line from the specification DIE.
+  uint32_t spec_ref =
+      getAttributeValueAsReference(U, DW_AT_specification, -1U);
+  if (spec_ref != -1U) {
+    DWARFDebugInfoEntryMinimal spec_die;
+    if (spec_die.extractFast(U, &spec_ref)) {
+      if (uint32_t Line = spec_die.getDeclLine(U))
+        return Line;
+    }
+  }
+  // Try to get the line from the abstract origin DIE.
+  uint32_t abs_origin_ref =
+      getAttributeValueAsReference(U, DW_AT_abstract_origin, -1U);
+  if (abs_origin_ref != -1U) {
+    DWARFDebugInfoEntryMinimal abs_origin_die;
+    if (abs_origin_die.extractFast(U, &abs_origin_ref)) {
+      if (uint32_t Line = abs_origin_die.getDeclLine(U))
+        return Line;
+    }
+  }
+  return 0;
+}
+
 void DWARFDebugInfoEntryMinimal::getCallerFrame(const DWARFUnit *U,
                                                 uint32_t &CallFile,
                                                 uint32_t &CallLine,
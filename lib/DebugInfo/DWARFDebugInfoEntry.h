@@ -151,6 +151,11 @@ public:
   /// for this subprogram. Returns null if no name is found.
   const char *getSubroutineName(const DWARFUnit *U) const;
 
+  /// If a DIE represents a subprogram (or inlined subroutine), returns its
+  /// DW_AT_decl_line, which may be fetched from specification or abstract
+  /// origin for this subprogram. Returns zero if no line is found.
+  uint32_t getDeclLine(const DWARFUnit *U) const;
+
   /// Retrieves values of DW_AT_call_file, DW_AT_call_line and
   /// DW_AT_call_column from DIE (or zeroes if they are missing).
   void getCallerFrame(const DWARFUnit *U, uint32_t &CallFile,
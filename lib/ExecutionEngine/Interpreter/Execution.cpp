@@ -38,7 +38,7 @@ static cl::opt<bool> PrintVolatile("interpreter-print-volatile", cl::Hidden,
 //===----------------------------------------------------------------------===//
 
 static void SetValue(Value *V, GenericValue Val, ExecutionContext &SF) {
-  SF.Values[V] = Val;
+  SF.getValue(V) = Val;
 }
 
 //===----------------------------------------------------------------------===//
@@ -821,6 +821,7 @@ void Interpreter::exitCalled(GenericValue GV) {
   // the stack before interpreting atexit handlers.
   ECStack.clear();
   runAtExitHandlers();
+  writeFlowFacts();
   exit(GV.IntVal.zextOrTrunc(32).getZExtValue());
 }
 
@@ -926,31 +927,37 @@ void Interpreter::visitIndirectBrInst(IndirectBrInst &I) {
 // results can happen.  Thus we use a two phase approach.
 //
 void Interpreter::SwitchToNewBasicBlock(BasicBlock *Dest, ExecutionContext &SF){
+  SwitchToNewBasicBlock(SF.Info->BlockIndex.lookup(Dest), SF);
+}
+
+void Interpreter::SwitchToNewBasicBlock(unsigned Dest, ExecutionContext &SF) {
+  const FunctionInfo &FI = *SF.Info;
+  const DecodedBlock &B = FI.Blocks[Dest];
   BasicBlock *PrevBB = SF.CurBB;      // Remember where we came from...
-  SF.CurBB   = Dest;                  // Update CurBB to branch destination
-  SF.CurInst = SF.CurBB->begin();     // Update new instruction ptr...
+  SF.CurBB = B.BB;                    // Update CurBB to branch destination
+  SF.PC = B.Start;                    // Update new instruction ptr...
 
-  if (!isa<PHINode>(SF.CurInst)) return;  // Nothing fancy to do
+  if (ProfileFunctions)
+    countEdge(PrevBB, B.BB, SF);
+
+  if (B.First == B.Start) return;     // Nothing fancy to do
 
   // Loop over all of the PHI nodes in the current block, reading their inputs.
-  std::vector<GenericValue> ResultValues;
+  SmallVector<GenericValue, 8> ResultValues;
 
-  for (; PHINode *PN = dyn_cast<PHINode>(SF.CurInst); ++SF.CurInst) {
+  for (unsigned i = B.First; i != B.Start; ++i) {
     // Search for the value corresponding to this previous bb...
-    int i = PN->getBasicBlockIndex(PrevBB);
-    assert(i != -1 && "PHINode doesn't contain entry for predecessor??");
-    Value *IncomingValue = PN->getIncomingValue(i);
+    const DecodedInst &DI = FI.Code[i];
+    int Idx = cast<PHINode>(DI.I)->getBasicBlockIndex(PrevBB);
+    assert(Idx != -1 && "PHINode doesn't contain entry for predecessor??");
 
     // Save the incoming value for this PHI node...
-    ResultValues.push_back(getOperandValue(IncomingValue, SF));
+    ResultValues.push_back(SF.getOperand(DI, Idx));
   }
 
   // Now loop over all of the PHI nodes setting their values...
-  SF.CurInst = SF.CurBB->begin();
-  for (unsigned i = 0; isa<PHINode>(SF.CurInst); ++SF.CurInst, ++i) {
-    PHINode *PN = cast<PHINode>(SF.CurInst);
-    SetValue(PN, ResultValues[i], SF);
-  }
+  for (unsigned i = B.First; i != B.Start; ++i)
+    SF.Values[FI.Code[i].Dest] = ResultValues[i - B.First];
 }
 
 //===----------------------------------------------------------------------===//
@@ -1084,21 +1091,21 @@ void Interpreter::visitCallSite(CallSite CS) {
       // If it is an unknown intrinsic function, use the intrinsic lowering
       // class to transform it into hopefully tasty LLVM code.
       //
-      BasicBlock::iterator me(CS.getInstruction());
-      BasicBlock *Parent = CS.getInstruction()->getParent();
+      Instruction *Lowered = CS.getInstruction();
+      BasicBlock::iterator me(Lowered);
+      BasicBlock *Parent = Lowered->getParent();
       bool atBegin(Parent->begin() == me);
       if (!atBegin)
         --me;
-      IL->LowerIntrinsicCall(cast<CallInst>(CS.getInstruction()));
-
-      // Restore the CurInst pointer to the first instruction newly inserted, if
-      // any.
-      if (atBegin) {
-        SF.CurInst = Parent->begin();
-      } else {
-        SF.CurInst = me;
-        ++SF.CurInst;
-      }
+      IL->LowerIntrinsicCall(cast<CallInst>(Lowered));
+
+      // Decode the lowered code and continue at the first instruction newly
+      // inserted, if any.
+      if (atBegin)
+        me = Parent->begin();
+      else
+        ++me;
+      redecodeFunction(SF, Lowered, me);
       return;
     }
 
@@ -2060,7 +2067,7 @@ GenericValue Interpreter::getOperandValue(Value *V, ExecutionContext &SF) {
   } else if (GlobalValue *GV = dyn_cast<GlobalValue>(V)) {
     return PTOGV(getPointerToGlobal(GV));
   } else {
-    return SF.Values[V];
+    return SF.getValue(V);
   }
 }
 
@@ -2090,8 +2097,13 @@ void Interpreter::callFunction(Function *F,
   }
 
   // Get pointers to first LLVM BB & Instruction in function.
+  StackFrame.Info      = getFunctionInfo(F);
   StackFrame.CurBB     = F->begin();
-  StackFrame.CurInst   = StackFrame.CurBB->begin();
+  StackFrame.PC        = StackFrame.Info->Blocks.front().Start;
+  StackFrame.Values.resize(StackFrame.Info->getNumSlots());
+
+  if (ProfileFunctions)
+    countEntry(StackFrame);
 
   // Run through the function arguments and initialize their values...
   assert((ArgVals.size() == F->arg_size() ||
@@ -2109,24 +2121,108 @@ void Interpreter::callFunction(Function *F,
 }
 
 
+//===----------------------------------------------------------------------===//
+// execute - Execute a decoded instruction. Common scalar instructions are
+// executed directly on the resolved operands, all others are dispatched to
+// the visit* methods.
+//
+void Interpreter::execute(const DecodedInst &DI, ExecutionContext &SF) {
+  switch (DI.Kind) {
+  case DecodedInst::Generic:
+    visit(*DI.I);   // Dispatch to one of the visit* methods...
+    return;
+  case DecodedInst::PHI:
+    llvm_unreachable("PHI nodes already handled!");
+  case DecodedInst::IntBinary: {
+    const APInt &Src1 = SF.getOperand(DI, 0).IntVal;
+    const APInt &Src2 = SF.getOperand(DI, 1).IntVal;
+    APInt &R = SF.Values[DI.Dest].IntVal;
+    switch (DI.Opcode) {
+    default: llvm_unreachable("Unexpected integer binary operator!");
+    case Instruction::Add:  R = Src1 + Src2; break;
+    case Instruction::Sub:  R = Src1 - Src2; break;
+    case Instruction::Mul:  R = Src1 * Src2; break;
+    case Instruction::UDiv: R = Src1.udiv(Src2); break;
+    case Instruction::SDiv: R = Src1.sdiv(Src2); break;
+    case Instruction::URem: R = Src1.urem(Src2); break;
+    case Instruction::SRem: R = Src1.srem(Src2); break;
+    case Instruction::And:  R = Src1 & Src2; break;
+    case Instruction::Or:   R = Src1 | Src2; break;
+    case Instruction::Xor:  R = Src1 ^ Src2; break;
+    case Instruction::Shl:
+      R = Src1.shl(getShiftAmount(Src2.getZExtValue(), Src1));
+      break;
+    case Instruction::LShr:
+      R = Src1.lshr(getShiftAmount(Src2.getZExtValue(), Src1));
+      break;
+    case Instruction::AShr:
+      R = Src1.ashr(getShiftAmount(Src2.getZExtValue(), Src1));
+      break;
+    }
+    return;
+  }
+  case DecodedInst::ICmp:
+    SF.Values[DI.Dest] = executeCmpInst(DI.Opcode, SF.getOperand(DI, 0),
+                                        SF.getOperand(DI, 1), DI.Ty);
+    return;
+  case DecodedInst::Select:
+    SF.Values[DI.Dest] = SF.getOperand(DI, 0).IntVal == 0 ?
+                         SF.getOperand(DI, 2) : SF.getOperand(DI, 1);
+    return;
+  case DecodedInst::ZExt:
+    SF.Values[DI.Dest].IntVal = SF.getOperand(DI, 0).IntVal.zext(DI.Imm);
+    return;
+  case DecodedInst::SExt:
+    SF.Values[DI.Dest].IntVal = SF.getOperand(DI, 0).IntVal.sext(DI.Imm);
+    return;
+  case DecodedInst::Trunc:
+    SF.Values[DI.Dest].IntVal = SF.getOperand(DI, 0).IntVal.trunc(DI.Imm);
+    return;
+  case DecodedInst::Br:
+    SwitchToNewBasicBlock(DI.Succs[0], SF);
+    return;
+  case DecodedInst::CondBr:
+    SwitchToNewBasicBlock(SF.getOperand(DI, 0).IntVal == 0 ? DI.Succs[1]
+                                                           : DI.Succs[0], SF);
+    return;
+  case DecodedInst::Load:
+    LoadValueFromMemory(SF.Values[DI.Dest],
+                        (GenericValue*)GVTOP(SF.getOperand(DI, 0)), DI.Ty);
+    return;
+  case DecodedInst::Store:
+    StoreValueToMemory(SF.getOperand(DI, 0),
+                       (GenericValue*)GVTOP(SF.getOperand(DI, 1)), DI.Ty);
+    return;
+  case DecodedInst::GEP: {
+    int64_t Offset = DI.Imm;
+    if (DI.NumOps > 1)
+      Offset += SF.getOperand(DI, 1).IntVal.getSExtValue() * DI.Scale;
+    SF.Values[DI.Dest].PointerVal =
+      (char*)SF.getOperand(DI, 0).PointerVal + Offset;
+    return;
+  }
+  }
+  llvm_unreachable("Unknown decoded instruction kind!");
+}
+
 void Interpreter::run() {
   while (!ECStack.empty()) {
     // Interpret a single instruction & increment the "PC".
     ExecutionContext &SF = ECStack.back();  // Current stack frame
-    Instruction &I = *SF.CurInst++;         // Increment before execute
+    const DecodedInst &DI = SF.Info->Code[SF.PC++]; // Increment before execute
 
     // Track the number of dynamic instructions executed.
     ++NumDynamicInsts;
 
-    DEBUG(dbgs() << "About to interpret: " << I);
-    visit(I);   // Dispatch to one of the visit* methods...
+    DEBUG(dbgs() << "About to interpret: " << *DI.I);
+    execute(DI, SF);
 #if 0
     // This is not safe, as visiting the instruction could lower it and free I.
 DEBUG(
     if (!isa<CallInst>(I) && !isa<InvokeInst>(I) && 
         I.getType() != Type::VoidTy) {
       dbgs() << "  --> ";
-      const GenericValue &Val = SF.Values[&I];
+      const GenericValue &Val = SF.getValue(&I);
       switch (I.getType()->getTypeID()) {
       default: llvm_unreachable("Invalid GenericValue Type");
       case Type::VoidTyID:    dbgs() << "void"; break;
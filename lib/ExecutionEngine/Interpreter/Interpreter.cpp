@@ -11,15 +11,54 @@
 // This interpreter is designed to be a very simple, portable, inefficient
 // interpreter.
 //
+// Before its first execution, each function is decoded into an array of
+// instructions whose operands refer to stack frame slots or to a constant
+// pool. Common scalar instructions are executed directly on the decoded form,
+// all others by the InstVisitor.
+//
+// The interpreter can count the executions of blocks, edges and loops, and
+// write them as flow facts on bitcode level when the program exits. The
+// blocks are referenced by their names, as in the bitcode export of llc, so
+// the facts apply to the bitcode passed to llc. Loop bounds and infeasible
+// blocks observed for a set of test inputs are only hypotheses for the WCET
+// analysis, like the flow facts extracted from simulator traces.
+//
 //===----------------------------------------------------------------------===//
 
 #include "Interpreter.h"
+#include "llvm/PML.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Analysis/Dominators.h"
 #include "llvm/CodeGen/IntrinsicLowering.h"
 #include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Instructions.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/CFG.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/GetElementPtrTypeIterator.h"
+#include "llvm/Support/YAMLTraits.h"
 #include <cstring>
 using namespace llvm;
 
+static cl::opt<std::string>
+FlowFactsFile("interpreter-flow-facts",
+              cl::desc("Write the observed loop bounds, infeasible blocks and "
+                       "block and edge frequencies as bitcode flow facts to "
+                       "the given PML file"),
+              cl::value_desc("filename"), cl::init(""));
+
+static cl::opt<std::string>
+FlowFactsEntry("interpreter-flow-facts-entry",
+               cl::desc("Function used as scope of the flow facts "
+                        "(default: main)"),
+               cl::init("main"));
+
+static cl::opt<std::string>
+FlowFactsOrigin("interpreter-flow-facts-origin",
+                cl::desc("Origin of the flow facts (default: trace.bc)"),
+                cl::init("trace.bc"));
+
 namespace {
 
 static struct RegisterInterp {
@@ -45,7 +84,7 @@ ExecutionEngine *Interpreter::create(Module *M, std::string* ErrStr) {
 // Interpreter ctor - Initialize stuff
 //
 Interpreter::Interpreter(Module *M)
-  : ExecutionEngine(M), TD(M) {
+  : ExecutionEngine(M), TD(M), ProfileFunctions(!FlowFactsFile.empty()) {
       
   memset(&ExitValue.Untyped, 0, sizeof(ExitValue.Untyped));
   setDataLayout(&TD);
@@ -58,6 +97,8 @@ Interpreter::Interpreter(Module *M)
 }
 
 Interpreter::~Interpreter() {
+  writeFlowFacts();
+  DeleteContainerSeconds(FunctionInfos);
   delete IL;
 }
 
@@ -96,3 +137,361 @@ Interpreter::runFunction(Function *F,
 
   return ExitValue;
 }
+
+//===----------------------------------------------------------------------===//
+// Decoding
+//
+
+unsigned Interpreter::decodeOperand(Value *V, FunctionInfo &FI) {
+  if (!isa<Constant>(V))
+    return FI.getSlot(V);
+
+  // Constants do not depend on the stack frame, evaluate them once.
+  ExecutionContext NoFrame;
+  FI.Constants.push_back(getOperandValue(V, NoFrame));
+  return (FI.Constants.size() - 1) | FunctionInfo::ConstantRef;
+}
+
+void Interpreter::decodeInstruction(Instruction &I, FunctionInfo &FI) {
+  DecodedInst DI;
+  DI.I = &I;
+  DI.Ty = I.getType();
+  DI.Kind = DecodedInst::Generic;
+  DI.Opcode = I.getOpcode();
+  DI.Dest = I.getType()->isVoidTy() ? 0 : FI.getSlot(&I);
+  DI.Ops = FI.Operands.size();
+  DI.NumOps = 0;
+  DI.Succs[0] = DI.Succs[1] = 0;
+  DI.Imm = 0;
+  DI.Scale = 0;
+
+  // Operands to resolve, if the instruction has a fast path
+  SmallVector<Value*, 4> Ops;
+
+  switch (I.getOpcode()) {
+  default:
+    break;
+  case Instruction::PHI:
+    DI.Kind = DecodedInst::PHI;
+    Ops.append(I.op_begin(), I.op_end());
+    break;
+  case Instruction::Add:  case Instruction::Sub:  case Instruction::Mul:
+  case Instruction::UDiv: case Instruction::SDiv: case Instruction::URem:
+  case Instruction::SRem: case Instruction::And:  case Instruction::Or:
+  case Instruction::Xor:  case Instruction::Shl:  case Instruction::LShr:
+  case Instruction::AShr:
+    if (!I.getType()->isIntegerTy())
+      break;
+    DI.Kind = DecodedInst::IntBinary;
+    Ops.append(I.op_begin(), I.op_end());
+    break;
+  case Instruction::ICmp:
+    DI.Ty = I.getOperand(0)->getType();
+    if (!DI.Ty->isIntegerTy() && !DI.Ty->isPointerTy())
+      break;
+    DI.Kind = DecodedInst::ICmp;
+    DI.Opcode = cast<ICmpInst>(I).getPredicate();
+    Ops.append(I.op_begin(), I.op_end());
+    break;
+  case Instruction::Select:
+    if (I.getOperand(0)->getType()->isVectorTy())
+      break;
+    DI.Kind = DecodedInst::Select;
+    Ops.append(I.op_begin(), I.op_end());
+    break;
+  case Instruction::ZExt:
+  case Instruction::SExt:
+  case Instruction::Trunc:
+    if (!I.getType()->isIntegerTy())
+      break;
+    DI.Kind = I.getOpcode() == Instruction::ZExt ? DecodedInst::ZExt :
+              I.getOpcode() == Instruction::SExt ? DecodedInst::SExt :
+                                                   DecodedInst::Trunc;
+    DI.Imm = cast<IntegerType>(I.getType())->getBitWidth();
+    Ops.push_back(I.getOperand(0));
+    break;
+  case Instruction::Br: {
+    BranchInst &BI = cast<BranchInst>(I);
+    DI.Succs[0] = FI.BlockIndex.lookup(BI.getSuccessor(0));
+    if (BI.isUnconditional()) {
+      DI.Kind = DecodedInst::Br;
+      break;
+    }
+    DI.Kind = DecodedInst::CondBr;
+    DI.Succs[1] = FI.BlockIndex.lookup(BI.getSuccessor(1));
+    Ops.push_back(BI.getCondition());
+    break;
+  }
+  case Instruction::Load:
+    // Volatile accesses may be printed, leave them to the visitor.
+    if (cast<LoadInst>(I).isVolatile())
+      break;
+    DI.Kind = DecodedInst::Load;
+    Ops.push_back(I.getOperand(0));
+    break;
+  case Instruction::Store:
+    if (cast<StoreInst>(I).isVolatile())
+      break;
+    DI.Kind = DecodedInst::Store;
+    DI.Ty = I.getOperand(0)->getType();
+    Ops.append(I.op_begin(), I.op_end());
+    break;
+  case Instruction::GetElementPtr: {
+    // Fold the constant indices into one offset, at most one index may be
+    // variable.
+    GetElementPtrInst &GEP = cast<GetElementPtrInst>(I);
+    if (!GEP.getType()->isPointerTy())
+      break;
+    Value *Index = 0;
+    bool Simple = true;
+    for (gep_type_iterator GI = gep_type_begin(GEP), GE = gep_type_end(GEP);
+         GI != GE && Simple; ++GI) {
+      if (StructType *STy = dyn_cast<StructType>(*GI)) {
+        unsigned Field = cast<ConstantInt>(GI.getOperand())->getZExtValue();
+        DI.Imm += TD.getStructLayout(STy)->getElementOffset(Field);
+        continue;
+      }
+      int64_t Size =
+        TD.getTypeAllocSize(cast<SequentialType>(*GI)->getElementType());
+      Value *Idx = GI.getOperand();
+      if (ConstantInt *CI = dyn_cast<ConstantInt>(Idx)) {
+        if (CI->getBitWidth() > 64)
+          Simple = false;
+        else
+          DI.Imm += Size * CI->getSExtValue();
+      } else if (!Index && (Idx->getType()->isIntegerTy(32) ||
+                            Idx->getType()->isIntegerTy(64))) {
+        Index = Idx;
+        DI.Scale = Size;
+      } else {
+        Simple = false;
+      }
+    }
+    if (!Simple)
+      break;
+    DI.Kind = DecodedInst::GEP;
+    Ops.push_back(GEP.getPointerOperand());
+    if (Index)
+      Ops.push_back(Index);
+    break;
+  }
+  }
+
+  for (unsigned i = 0, e = Ops.size(); i != e; ++i)
+    FI.Operands.push_back(decodeOperand(Ops[i], FI));
+  DI.NumOps = Ops.size();
+  FI.Code.push_back(DI);
+}
+
+void Interpreter::decodeFunction(Function *F, FunctionInfo &FI) {
+  FI.Code.clear();
+  FI.Operands.clear();
+  FI.Constants.clear();
+  FI.Blocks.clear();
+  FI.BlockIndex.clear();
+
+  for (Function::arg_iterator AI = F->arg_begin(), E = F->arg_end();
+       AI != E; ++AI)
+    FI.getSlot(AI);
+
+  // Number the blocks first, so branches can refer to their targets.
+  for (Function::iterator BB = F->begin(), BE = F->end(); BB != BE; ++BB) {
+    DecodedBlock B = { BB, 0, 0 };
+    FI.BlockIndex[BB] = FI.Blocks.size();
+    FI.Blocks.push_back(B);
+  }
+
+  for (unsigned b = 0, be = FI.Blocks.size(); b != be; ++b) {
+    BasicBlock *BB = FI.Blocks[b].BB;
+    BasicBlock::iterator I = BB->begin(), E = BB->end();
+    FI.Blocks[b].First = FI.Code.size();
+    for (; isa<PHINode>(I); ++I)
+      decodeInstruction(*I, FI);
+    FI.Blocks[b].Start = FI.Code.size();
+    for (; I != E; ++I)
+      decodeInstruction(*I, FI);
+  }
+}
+
+void Interpreter::redecodeFunction(ExecutionContext &SF, Instruction *Lowered,
+                                   Instruction *Next) {
+  FunctionInfo &FI = *SF.Info;
+
+  // Remember where the invocations of the function continue. Frames that
+  // wait for an invoke continue at the normal destination, not at PC.
+  std::vector<Instruction*> Resume(ECStack.size(), 0);
+  for (unsigned i = 0, e = ECStack.size(); i != e; ++i) {
+    ExecutionContext &Frame = ECStack[i];
+    if (Frame.Info != &FI)
+      continue;
+    if (&Frame == &SF)
+      Resume[i] = Next;
+    else if (Frame.PC < FI.Code.size())
+      Resume[i] = FI.Code[Frame.PC].I == Lowered ? Next : FI.Code[Frame.PC].I;
+  }
+
+  decodeFunction(SF.CurFunction, FI);
+
+  DenseMap<const Instruction*, unsigned> Index;
+  for (unsigned i = 0, e = FI.Code.size(); i != e; ++i)
+    Index[FI.Code[i].I] = i;
+  for (unsigned i = 0, e = ECStack.size(); i != e; ++i) {
+    if (ECStack[i].Info != &FI)
+      continue;
+    ECStack[i].Values.resize(FI.getNumSlots());
+    if (Resume[i])
+      ECStack[i].PC = Index.lookup(Resume[i]);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Function information and profiling
+//
+
+FunctionInfo *Interpreter::getFunctionInfo(Function *F) {
+  FunctionInfo *&FI = FunctionInfos[F];
+  if (FI)
+    return FI;
+
+  FI = new FunctionInfo();
+  decodeFunction(F, *FI);
+
+  if (ProfileFunctions) {
+    DominatorTree DT;
+    DT.runOnFunction(*F);
+    FI->LI.Analyze(DT.getBase());
+    for (Function::iterator BB = F->begin(), BE = F->end(); BB != BE; ++BB) {
+      Loop *L = FI->LI.getLoopFor(BB);
+      if (!L || L->getHeader() != BB)
+        continue;
+      FI->LoopIndex[BB] = FI->Loops.size();
+      FI->Loops.push_back(L);
+    }
+    FI->LoopBounds.assign(FI->Loops.size(), 0);
+  }
+  return FI;
+}
+
+void Interpreter::countEntry(ExecutionContext &SF) {
+  SF.Info->BlockCounts[SF.CurBB]++;
+  SF.LoopIters.assign(SF.Info->Loops.size(), 0);
+}
+
+void Interpreter::countEdge(BasicBlock *Src, BasicBlock *Dest,
+                            ExecutionContext &SF) {
+  FunctionInfo &FI = *SF.Info;
+  FI.EdgeCounts[FunctionInfo::Edge(Src, Dest)]++;
+  FI.BlockCounts[Dest]++;
+
+  DenseMap<const BasicBlock*, unsigned>::iterator L = FI.LoopIndex.find(Dest);
+  if (L == FI.LoopIndex.end())
+    return;
+
+  // Back edges continue the current entry of the loop, all other edges into
+  // the header start a new one.
+  unsigned Idx = L->second;
+  uint64_t &Iters = SF.LoopIters[Idx];
+  Iters = FI.Loops[Idx]->contains(Src) ? Iters + 1 : 1;
+  FI.LoopBounds[Idx] = std::max(FI.LoopBounds[Idx], Iters);
+}
+
+/// addProfile - Add a profile entry with the execution count of PP to T.
+static void addProfile(yaml::Timing &T, yaml::ProgramPoint *PP,
+                       uint64_t Count) {
+  yaml::ProfileEntry *P = new yaml::ProfileEntry();
+  P->setReference(PP);
+  P->Frequency = Count;
+  T.Profile.push_back(P);
+}
+
+/// exportFunction - Export the flow facts of an executed function.
+static void exportFunction(const Function &F, const FunctionInfo &FI,
+                           yaml::Timing &T, yaml::PMLDoc &Doc) {
+  for (Function::const_iterator BB = F.begin(), BE = F.end(); BB != BE; ++BB) {
+    if (BB->getName().empty()) {
+      errs() << "warning: unnamed bit-code BB in function '" << F.getName()
+             << "', no flow facts exported\n";
+      return;
+    }
+  }
+
+  for (Function::const_iterator BB = F.begin(), BE = F.end(); BB != BE; ++BB) {
+    uint64_t Count = FI.BlockCounts.lookup(BB);
+    addProfile(T, yaml::ProgramPoint::CreateBlock(F.getName(), BB->getName()),
+               Count);
+
+    SmallPtrSet<const BasicBlock*, 8> Succs;
+    for (succ_const_iterator SI = succ_begin(BB), SE = succ_end(BB); SI != SE;
+         ++SI) {
+      if (!Succs.insert(*SI))
+        continue;
+      yaml::ProgramPoint *PP = yaml::ProgramPoint::CreateFunction(F.getName());
+      PP->EdgeSource = yaml::Name(BB->getName());
+      PP->EdgeTarget = yaml::Name((*SI)->getName());
+      addProfile(T, PP, FI.EdgeCounts.lookup(FunctionInfo::Edge(BB, *SI)));
+    }
+
+    if (Count)
+      continue;
+
+    // Infeasible block of an executed function
+    yaml::FlowFact *FF = new yaml::FlowFact(yaml::level_bitcode);
+    FF->Origin = yaml::Name(FlowFactsOrigin);
+    FF->ScopeRef = new yaml::Scope(yaml::Name(FlowFactsEntry));
+    FF->addTermLHS(yaml::ProgramPoint::CreateBlock(F.getName(),
+                                                   BB->getName()), 1);
+    FF->Comparison = yaml::cmp_less_equal;
+    FF->RHS = yaml::Name(0ULL);
+    Doc.addFlowFact(FF);
+  }
+
+  // Loop header bounds, of the loops that have been entered
+  for (unsigned i = 0, e = FI.Loops.size(); i != e; ++i) {
+    if (!FI.LoopBounds[i])
+      continue;
+    const BasicBlock *Header = FI.Loops[i]->getHeader();
+
+    yaml::FlowFact *FF = new yaml::FlowFact(yaml::level_bitcode);
+    FF->Origin = yaml::Name(FlowFactsOrigin);
+    FF->setLoopScope(yaml::Name(F.getName()), yaml::Name(Header->getName()));
+    FF->addTermLHS(yaml::ProgramPoint::CreateBlock(F.getName(),
+                                                   Header->getName()), 1);
+    FF->Comparison = yaml::cmp_less_equal;
+    FF->RHS = yaml::Name(FI.LoopBounds[i]);
+    Doc.addFlowFact(FF);
+  }
+}
+
+void Interpreter::writeFlowFacts() {
+  if (!ProfileFunctions)
+    return;
+  // Stop profiling, the facts are only written once.
+  ProfileFunctions = false;
+
+  yaml::PMLDoc Doc(Modules[0]->getTargetTriple());
+  yaml::Timing *T = new yaml::Timing(yaml::level_bitcode);
+  T->Origin = yaml::Name(FlowFactsOrigin);
+  T->ScopeRef = new yaml::Scope(yaml::Name(FlowFactsEntry));
+  Doc.Timings.push_back(T);
+
+  // Export in the order of the module, not of the execution.
+  for (unsigned m = 0, e = Modules.size(); m != e; ++m) {
+    for (Module::iterator F = Modules[m]->begin(), FE = Modules[m]->end();
+         F != FE; ++F) {
+      FunctionInfo *FI = FunctionInfos.lookup(F);
+      if (FI)
+        exportFunction(*F, *FI, *T, Doc);
+    }
+  }
+
+  std::string ErrorInfo;
+  raw_fd_ostream OS(FlowFactsFile.c_str(), ErrorInfo);
+  if (!ErrorInfo.empty()) {
+    errs() << "error: could not write flow facts to '" << FlowFactsFile
+           << "': " << ErrorInfo << "\n";
+    return;
+  }
+  yaml::Output YOut(OS);
+  yaml::PMLDoc *DocPtr = &Doc;
+  YOut << DocPtr;
+}
@@ -14,6 +14,8 @@
 #ifndef LLI_INTERPRETER_H
 #define LLI_INTERPRETER_H
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Analysis/LoopInfo.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/GenericValue.h"
 #include "llvm/IR/DataLayout.h"
@@ -26,7 +28,6 @@
 namespace llvm {
 
 class IntrinsicLowering;
-struct FunctionInfo;
 template<typename T> class generic_gep_type_iterator;
 class ConstantExpr;
 typedef generic_gep_type_iterator<User::const_op_iterator> gep_type_iterator;
@@ -64,18 +65,117 @@ public:
 
 typedef std::vector<GenericValue> ValuePlaneTy;
 
+// DecodedInst - An instruction of a function, decoded before the first
+// execution of the function. Its operands are resolved to the slots of the
+// values in the stack frame, or to the constant pool of the function, and
+// branch targets to the index of the target block. Instructions without a
+// fast path are executed by the InstVisitor.
+//
+struct DecodedInst {
+  enum Kind {
+    Generic,    // Executed by the InstVisitor
+    PHI,        // Executed when entering the block
+    IntBinary,  // Scalar integer binary operator, Opcode is the operator
+    ICmp,       // Scalar integer or pointer compare, Opcode is the predicate
+    Select,     // Scalar select
+    ZExt, SExt, Trunc, // Integer casts, Imm is the width of the result
+    Br, CondBr, // Branches, Succs are the target blocks
+    Load, Store,
+    GEP         // Pointer + Imm + (index operand * Scale, if any)
+  };
+
+  Instruction *I;     // The instruction
+  Type *Ty;           // Type of the operation
+  unsigned Kind;
+  unsigned Opcode;
+  unsigned Dest;      // Slot of the result
+  unsigned Ops;       // First operand in FunctionInfo::Operands
+  unsigned NumOps;
+  unsigned Succs[2];
+  int64_t Imm;
+  int64_t Scale;
+};
+
+// DecodedBlock - The decoded instructions of a basic block, starting with
+// its PHI nodes.
+//
+struct DecodedBlock {
+  BasicBlock *BB;
+  unsigned First;     // First instruction (PHI node) of the block
+  unsigned Start;     // First instruction executed after the PHI nodes
+};
+
+// FunctionInfo - Information about a function, computed before its first
+// execution. The arguments and instructions of the function are numbered, so
+// that the values of an invocation are held in a plain vector indexed by the
+// slot of the value, and the function is decoded into an array of
+// instructions. If flow facts are collected, it also holds the loops of the
+// function and the execution counts of its blocks, edges and loops.
+//
+struct FunctionInfo {
+  // Operand references with this bit set index the constant pool, all
+  // other references are slots.
+  static const unsigned ConstantRef = 1U << 31;
+
+  // Slots - The slot of each argument and instruction. Instructions created
+  // by the intrinsic lowering get a slot when the function is decoded again.
+  DenseMap<const Value *, unsigned> Slots;
+
+  // Decoded code, the constants used by it, and the index of each block.
+  std::vector<DecodedInst> Code;
+  std::vector<unsigned> Operands;
+  std::vector<GenericValue> Constants;
+  std::vector<DecodedBlock> Blocks;
+  DenseMap<const BasicBlock *, unsigned> BlockIndex;
+
+  // Profile, only computed if flow facts are collected.
+  typedef std::pair<const BasicBlock *, const BasicBlock *> Edge;
+  LoopInfoBase<BasicBlock, Loop> LI;
+  DenseMap<const BasicBlock *, unsigned> LoopIndex; // Loop of each header
+  std::vector<Loop *> Loops;
+  std::vector<uint64_t> LoopBounds;  // Max. header executions per loop entry
+  DenseMap<const BasicBlock *, uint64_t> BlockCounts;
+  DenseMap<Edge, uint64_t> EdgeCounts;
+
+  unsigned getNumSlots() const { return Slots.size(); }
+
+  unsigned getSlot(const Value *V) {
+    return Slots.insert(std::make_pair(V, getNumSlots())).first->second;
+  }
+};
+
 // ExecutionContext struct - This struct represents one stack frame currently
 // executing.
 //
 struct ExecutionContext {
   Function             *CurFunction;// The currently executing function
+  FunctionInfo         *Info;       // Slots, code and profile of CurFunction
   BasicBlock           *CurBB;      // The currently executing BB
-  BasicBlock::iterator  CurInst;    // The next instruction to execute
-  std::map<Value *, GenericValue> Values; // LLVM values used in this invocation
+  unsigned              PC;         // The next instruction to execute
+  ValuePlaneTy          Values;     // LLVM values used in this invocation
   std::vector<GenericValue>  VarArgs; // Values passed through an ellipsis
+  std::vector<uint64_t> LoopIters;  // Header executions of the current entry
+                                    // of each loop, if profiling
   CallSite             Caller;     // Holds the call that called subframes.
                                    // NULL if main func or debugger invoked fn
   AllocaHolderHandle    Allocas;    // Track memory allocated by alloca
+
+  ExecutionContext() : CurFunction(0), Info(0), CurBB(0), PC(0) {}
+
+  GenericValue &getValue(Value *V) {
+    unsigned Slot = Info->getSlot(V);
+    if (Slot >= Values.size())
+      Values.resize(Info->getNumSlots());
+    return Values[Slot];
+  }
+
+  // getOperand - Get operand Op of the decoded instruction DI.
+  const GenericValue &getOperand(const DecodedInst &DI, unsigned Op) const {
+    unsigned Ref = Info->Operands[DI.Ops + Op];
+    if (Ref & FunctionInfo::ConstantRef)
+      return Info->Constants[Ref & ~FunctionInfo::ConstantRef];
+    return Values[Ref];
+  }
 };
 
 // Interpreter - This class represents the entirety of the interpreter.
@@ -93,6 +193,13 @@ class Interpreter : public ExecutionEngine, public InstVisitor<Interpreter> {
   // registered with the atexit() library function.
   std::vector<Function*> AtExitHandlers;
 
+  // FunctionInfos - Slots and profiles of the functions executed so far.
+  DenseMap<const Function*, FunctionInfo*> FunctionInfos;
+
+  // ProfileFunctions - Count block, edge and loop executions, to emit them
+  // as flow facts when the program exits.
+  bool ProfileFunctions;
+
 public:
   explicit Interpreter(Module *M);
   ~Interpreter();
@@ -102,6 +209,11 @@ public:
   ///
   void runAtExitHandlers();
 
+  /// writeFlowFacts - Write the flow facts observed during execution, if
+  /// requested with -interpreter-flow-facts. The facts are only written once.
+  ///
+  void writeFlowFacts();
+
   static void Register() {
     InterpCtor = create;
   }
@@ -211,6 +323,30 @@ private:  // Helper functions
   // control flow.
   //
   void SwitchToNewBasicBlock(BasicBlock *Dest, ExecutionContext &SF);
+  void SwitchToNewBasicBlock(unsigned Dest, ExecutionContext &SF);
+
+  // execute - Execute a decoded instruction of the current stack frame.
+  void execute(const DecodedInst &DI, ExecutionContext &SF);
+
+  // getFunctionInfo - Get the slots, the code and the profile of the defined
+  // function F.
+  FunctionInfo *getFunctionInfo(Function *F);
+
+  // decodeFunction - (Re-)Decode the instructions of F into FI.
+  void decodeFunction(Function *F, FunctionInfo &FI);
+  unsigned decodeOperand(Value *V, FunctionInfo &FI);
+  void decodeInstruction(Instruction &I, FunctionInfo &FI);
+
+  // redecodeFunction - Decode the function of SF again after the intrinsic
+  // lowering replaced the instruction Lowered, and continue at Next. The
+  // stack frames of all invocations of the function are updated.
+  void redecodeFunction(ExecutionContext &SF, Instruction *Lowered,
+                        Instruction *Next);
+
+  // countEntry, countEdge - Update the profile of the current function for
+  // the entry into the function and for the edge Src -> Dest.
+  void countEntry(ExecutionContext &SF);
+  void countEdge(BasicBlock *Src, BasicBlock *Dest, ExecutionContext &SF);
 
   void *getPointerToFunction(Function *F) { return (void*)F; }
   void *getPointerToBasicBlock(BasicBlock *BB) { return (void*)BB; }
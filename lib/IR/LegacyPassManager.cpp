@@ -18,11 +18,15 @@
 #include "llvm/IR/Module.h"
 #include "llvm/IR/LegacyPassManagers.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/PassNameParser.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
@@ -502,9 +506,60 @@ public:
   }
 };
 
+//===----------------------------------------------------------------------===//
+/// PassReportInfo Class - This class records the time, the growth of the peak
+/// resident set size and the statistics bumped by each execution of a pass,
+/// and writes them as JSON report to the file given by -pass-report on exit.
+/// Executions of the same pass instance on the same unit (function, SCC or
+/// module) are merged. Passes are usually destroyed before the report is
+/// written, so their names are looked up when they are first executed.
+///
+/// The peak RSS growth is how much the pass raised the peak resident set
+/// size of the process. It is not the memory used by the pass: a pass that
+/// stays below an earlier peak reports zero, and memory allocated by an
+/// enclosing or earlier pass is attributed to the pass that touches it.
+///
+class PassReportInfo {
+  struct Entry {
+    std::string PassName;
+    std::string PassArg;
+    unsigned Instance;
+    std::string Unit;
+    PassReportRegion::UnitKind Kind;
+    unsigned Runs;
+    TimeRecord Time;
+    uint64_t PeakRSSGrowth;
+    std::vector<std::pair<const Statistic*, unsigned> > Stats;
+  };
+
+  std::vector<Entry> Entries;
+  // Passes are identified by address and name, as the address of a freed
+  // pass may be reused.
+  std::map<std::pair<Pass*, std::string>, unsigned> Instances;
+  std::map<std::pair<unsigned, std::string>, unsigned> EntryIndex;
+  std::string Filename;
+
+  void writeReport(raw_ostream &OS) const;
+public:
+  // Use 'createThePassReport' to get this.
+  PassReportInfo();
+
+  // Write the report atomically when destroyed.
+  ~PassReportInfo();
+
+  // createThePassReport - Initialize ThePassReport if -pass-report is given.
+  static void createThePassReport();
+
+  void record(Pass *P, StringRef Unit, PassReportRegion::UnitKind Kind,
+              const TimeRecord &Time, uint64_t PeakRSSGrowth,
+              ArrayRef<std::pair<const Statistic*, unsigned> > StatsBefore,
+              ArrayRef<const Statistic*> StatsAfter);
+};
+
 } // End of anon namespace
 
 static TimingInfo *TheTimeInfo;
+static PassReportInfo *ThePassReport;
 
 //===----------------------------------------------------------------------===//
 // PMTopLevelManager implementation
@@ -1335,6 +1390,8 @@ bool BBPassManager::runOnFunction(Function &F) {
         // If the pass crashes, remember this.
         PassManagerPrettyStackEntry X(BP, *I);
         TimeRegion PassTimer(getPassTimer(BP));
+        PassReportRegion PassReport(BP, F.getName(),
+                                    PassReportRegion::FunctionUnit);
 
         LocalChanged |= BP->runOnBasicBlock(*I);
       }
@@ -1511,6 +1568,7 @@ void FunctionPassManagerImpl::releaseMemoryOnTheFly() {
 bool FunctionPassManagerImpl::run(Function &F) {
   bool Changed = false;
   TimingInfo::createTheTimeInfo();
+  PassReportInfo::createThePassReport();
 
   initializeAllAnalysisInfo();
   for (unsigned Index = 0; Index < getNumContainedManagers(); ++Index)
@@ -1562,6 +1620,8 @@ bool FPPassManager::runOnFunction(Function &F) {
     {
       PassManagerPrettyStackEntry X(FP, F);
       TimeRegion PassTimer(getPassTimer(FP));
+      PassReportRegion PassReport(FP, F.getName(),
+                                  PassReportRegion::FunctionUnit);
 
       LocalChanged |= FP->runOnFunction(F);
     }
@@ -1640,6 +1700,8 @@ MPPassManager::runOnModule(Module &M) {
     {
       PassManagerPrettyStackEntry X(MP, M);
       TimeRegion PassTimer(getPassTimer(MP));
+      PassReportRegion PassReport(MP, M.getModuleIdentifier(),
+                                  PassReportRegion::ModuleUnit);
 
       LocalChanged |= MP->runOnModule(M);
     }
@@ -1712,6 +1774,8 @@ Pass* MPPassManager::getOnTheFlyPass(Pass *MP, AnalysisID PI, Function &F){
   assert(FPP && "Unable to find on the fly pass");
 
   FPP->releaseMemoryOnTheFly();
+  // The passes are recorded in the pass report by FPPassManager, their
+  // time is also part of the module pass requiring them.
   FPP->run(F);
   return ((PMTopLevelManager*)FPP)->findAnalysisPass(PI);
 }
@@ -1726,6 +1790,7 @@ Pass* MPPassManager::getOnTheFlyPass(Pass *MP, AnalysisID PI, Function &F){
 bool PassManagerImpl::run(Module &M) {
   bool Changed = false;
   TimingInfo::createTheTimeInfo();
+  PassReportInfo::createThePassReport();
 
   dumpArguments();
   dumpPasses();
@@ -1804,6 +1869,186 @@ Timer *llvm::getPassTimer(Pass *P) {
   return 0;
 }
 
+//===----------------------------------------------------------------------===//
+// PassReportInfo implementation
+
+static cl::opt<std::string>
+PassReportFilename("pass-report", cl::value_desc("filename"),
+                   cl::desc("Write a JSON report of the time, memory and "
+                            "statistics of each pass execution to a file"));
+
+void PassReportInfo::createThePassReport() {
+  if (PassReportFilename.empty() || ThePassReport) return;
+
+  // See createTheTimeInfo for why this is a ManagedStatic.
+  static ManagedStatic<PassReportInfo> TPR;
+  ThePassReport = &*TPR;
+}
+
+PassReportRegion::PassReportRegion(Pass *p, StringRef unit, UnitKind kind)
+  : P(ThePassReport && !p->getAsPMDataManager() ? p : 0), Kind(kind),
+    StartPeakRSS(0) {
+  if (!P) return;
+  Unit = unit;
+  std::vector<const Statistic*> Stats;
+  GetStatistics(Stats);
+  for (unsigned i = 0, e = Stats.size(); i != e; ++i)
+    StartStats.push_back(std::make_pair(Stats[i], Stats[i]->getValue()));
+  StartPeakRSS = sys::Process::GetPeakResidentSetSize();
+  Start = TimeRecord::getCurrentTime(true);
+}
+
+PassReportRegion::~PassReportRegion() {
+  if (!P) return;
+  TimeRecord Time = TimeRecord::getCurrentTime(false);
+  Time -= Start;
+  uint64_t PeakRSS = sys::Process::GetPeakResidentSetSize();
+  std::vector<const Statistic*> Stats;
+  GetStatistics(Stats);
+  ThePassReport->record(P, Unit, Kind, Time, PeakRSS - StartPeakRSS,
+                        StartStats, Stats);
+}
+
+bool PassReportRegion::isEnabled() {
+  return ThePassReport != 0;
+}
+
+PassReportInfo::PassReportInfo() : Filename(PassReportFilename) {
+  TrackStatistics();
+}
+
+void PassReportInfo::record(Pass *P, StringRef Unit,
+                    PassReportRegion::UnitKind Kind,
+                    const TimeRecord &Time, uint64_t PeakRSSGrowth,
+                    ArrayRef<std::pair<const Statistic*, unsigned> > StatsBefore,
+                    ArrayRef<const Statistic*> StatsAfter) {
+  sys::SmartScopedLock<true> Lock(*TimingInfoMutex);
+
+  const char *PassName = P->getPassName();
+  unsigned Instance =
+    Instances.insert(std::make_pair(std::make_pair(P, std::string(PassName)),
+                                    Instances.size())).first->second;
+
+  std::pair<std::map<std::pair<unsigned, std::string>, unsigned>::iterator,
+            bool>
+    Idx = EntryIndex.insert(std::make_pair(std::make_pair(Instance,
+                                                          Unit.str()),
+                                           Entries.size()));
+  if (Idx.second) {
+    const PassInfo *PI =
+      PassRegistry::getPassRegistry()->getPassInfo(P->getPassID());
+    Entry E;
+    E.PassName = PassName;
+    E.PassArg = PI ? PI->getPassArgument() : "";
+    E.Instance = Instance;
+    E.Unit = Unit;
+    E.Kind = Kind;
+    E.Runs = 0;
+    E.PeakRSSGrowth = 0;
+    Entries.push_back(E);
+  }
+  Entry &E = Entries[Idx.first->second];
+  E.Runs++;
+  E.Time += Time;
+  E.PeakRSSGrowth += PeakRSSGrowth;
+
+  // Statistics bumped for the first time during the pass started at zero.
+  DenseMap<const Statistic*, unsigned> Before;
+  for (unsigned i = 0, e = StatsBefore.size(); i != e; ++i)
+    Before[StatsBefore[i].first] = StatsBefore[i].second;
+  for (unsigned i = 0, e = StatsAfter.size(); i != e; ++i) {
+    unsigned Delta = StatsAfter[i]->getValue() - Before.lookup(StatsAfter[i]);
+    if (Delta == 0)
+      continue;
+    unsigned j = 0, je = E.Stats.size();
+    while (j != je && E.Stats[j].first != StatsAfter[i])
+      ++j;
+    if (j == je)
+      E.Stats.push_back(std::make_pair(StatsAfter[i], 0));
+    E.Stats[j].second += Delta;
+  }
+}
+
+/// writeJSONString - Write a string literal, escaped as required by JSON.
+static void writeJSONString(raw_ostream &OS, StringRef S) {
+  OS << '"';
+  for (unsigned i = 0, e = S.size(); i != e; ++i) {
+    unsigned char C = S[i];
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << format("\\u%04x", C);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+void PassReportInfo::writeReport(raw_ostream &OS) const {
+  OS << "{\n  \"passes\": [";
+  for (unsigned i = 0, e = Entries.size(); i != e; ++i) {
+    const Entry &E = Entries[i];
+    OS << (i ? ",\n" : "\n") << "    { \"pass\": ";
+    writeJSONString(OS, E.PassName);
+    OS << ", \"arg\": ";
+    writeJSONString(OS, E.PassArg);
+    OS << ", \"instance\": " << E.Instance << ",\n      ";
+    switch (E.Kind) {
+    case PassReportRegion::FunctionUnit: OS << "\"function\": "; break;
+    case PassReportRegion::SCCUnit:      OS << "\"scc\": "; break;
+    case PassReportRegion::ModuleUnit:   OS << "\"module\": "; break;
+    }
+    writeJSONString(OS, E.Unit);
+    OS << ", \"runs\": " << E.Runs
+       << format(", \"wall\": %.6f, \"user\": %.6f, \"system\": %.6f",
+                 E.Time.getWallTime(), E.Time.getUserTime(),
+                 E.Time.getSystemTime())
+       << ", \"peak_rss_growth\": " << E.PeakRSSGrowth
+       << ",\n      \"statistics\": [";
+    for (unsigned j = 0, je = E.Stats.size(); j != je; ++j) {
+      OS << (j ? ", " : "") << "{ \"group\": ";
+      writeJSONString(OS, E.Stats[j].first->getName());
+      OS << ", \"desc\": ";
+      writeJSONString(OS, E.Stats[j].first->getDesc());
+      OS << ", \"value\": " << E.Stats[j].second << " }";
+    }
+    OS << "] }";
+  }
+  OS << "\n  ],\n  \"peak_rss\": "
+     << (uint64_t)sys::Process::GetPeakResidentSetSize() << "\n}\n";
+}
+
+PassReportInfo::~PassReportInfo() {
+  // Write to a temporary file next to the report and rename it, so that
+  // readers never see a partially written report.
+  int FD;
+  SmallString<128> TempPath;
+  if (error_code EC = sys::fs::createUniqueFile(Filename + "-%%%%%%.tmp", FD,
+                                                TempPath)) {
+    errs() << "Error creating pass report '" << Filename << "': "
+           << EC.message() << '\n';
+    return;
+  }
+  {
+    raw_fd_ostream OS(FD, true);
+    writeReport(OS);
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      errs() << "Error writing pass report '" << Filename << "'\n";
+      bool Existed;
+      sys::fs::remove(TempPath.str(), Existed);
+      return;
+    }
+  }
+  if (error_code EC = sys::fs::rename(TempPath.str(), Filename)) {
+    errs() << "Error writing pass report '" << Filename << "': "
+           << EC.message() << '\n';
+    bool Existed;
+    sys::fs::remove(TempPath.str(), Existed);
+  }
+}
+
 //===----------------------------------------------------------------------===//
 // PMStack implementation
 //
@@ -16,6 +16,31 @@ using namespace llvm;
 MCDisassembler::~MCDisassembler() {
 }
 
+unsigned MCDisassembler::decodeRegion(const MemoryObject &Region,
+                                      uint64_t Start, uint64_t End,
+                                      std::vector<DecodedInst> &Insts) const {
+  unsigned NumInvalid = 0;
+  uint64_t Size;
+
+  for (uint64_t Address = Start; Address < End; Address += Size) {
+    Insts.push_back(DecodedInst());
+    DecodedInst &DI = Insts.back();
+
+    DI.Address = Address;
+    DI.Status = getInstruction(DI.Inst, Size, Region, Address, nulls(),
+                               nulls());
+    if (DI.Status == Fail) {
+      ++NumInvalid;
+      // skip illegible bytes
+      if (Size == 0)
+        Size = 1;
+    }
+    DI.Size = Size;
+  }
+
+  return NumInvalid;
+}
+
 void
 MCDisassembler::setupForSymbolicDisassembly(
     LLVMOpInfoCallback GetOpInfo,
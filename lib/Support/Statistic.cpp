@@ -44,6 +44,8 @@ Enabled(
     "stats",
     cl::desc("Enable statistics output from program (available with Asserts)"));
 
+/// Tracked - Register statistics even if they are not printed.
+static bool Tracked = false;
 
 namespace {
 /// StatisticInfo - This class is used in a ManagedStatic so that it is created
@@ -53,6 +55,7 @@ class StatisticInfo {
   std::vector<const Statistic*> Stats;
   friend void llvm::PrintStatistics();
   friend void llvm::PrintStatistics(raw_ostream &OS);
+  friend void llvm::GetStatistics(std::vector<const Statistic*> &Stats);
 public:
   ~StatisticInfo();
 
@@ -72,7 +75,7 @@ void Statistic::RegisterStatistic() {
   // printed.
   sys::SmartScopedLock<true> Writer(*StatLock);
   if (!Initialized) {
-    if (Enabled)
+    if (Enabled || Tracked)
       StatInfo->addStatistic(this);
 
     TsanHappensBefore(this);
@@ -111,6 +114,15 @@ bool llvm::AreStatisticsEnabled() {
   return Enabled;
 }
 
+void llvm::TrackStatistics() {
+  Tracked = true;
+}
+
+void llvm::GetStatistics(std::vector<const Statistic*> &Stats) {
+  sys::SmartScopedLock<true> Reader(*StatLock);
+  Stats = StatInfo->Stats;
+}
+
 void llvm::PrintStatistics(raw_ostream &OS) {
   StatisticInfo &Stats = *StatInfo;
 
@@ -148,7 +160,7 @@ void llvm::PrintStatistics() {
   StatisticInfo &Stats = *StatInfo;
 
   // Statistics not enabled?
-  if (Stats.Stats.empty()) return;
+  if (!Enabled || Stats.Stats.empty()) return;
 
   // Get the stream to write to.
   raw_ostream &OutStream = *CreateInfoOutputFile();
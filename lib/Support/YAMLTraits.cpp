@@ -14,6 +14,7 @@
 #include "llvm/Support/Format.h"
 #include "llvm/Support/YAMLParser.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <cstring>
 #include <cctype>
 using namespace llvm;
@@ -47,6 +48,7 @@ Input::Input(StringRef InputContent,
              void *DiagHandlerCtxt)
   : IO(Ctxt),
     Strm(new Stream(InputContent, SrcMgr)),
+    TopNode(NULL),
     CurrentNode(NULL) {
   if (DiagHandler)
     SrcMgr.setDiagHandler(DiagHandler, DiagHandlerCtxt);
@@ -64,6 +66,8 @@ error_code Input::error() {
 void Input::HNode::anchor() {}
 void Input::EmptyHNode::anchor() {}
 void Input::ScalarHNode::anchor() {}
+void Input::MapHNode::anchor() {}
+void Input::SequenceHNode::anchor() {}
 
 bool Input::outputting() const {
   return false;
@@ -83,8 +87,10 @@ bool Input::setCurrentDocument() {
       ++DocIterator;
       return setCurrentDocument();
     }
-    TopNode.reset(this->createHNodes(N));
-    CurrentNode = TopNode.get();
+    // The HNodes of the previous document are not needed anymore.
+    HNodeAllocator.Reset();
+    TopNode = this->createHNodes(N);
+    CurrentNode = TopNode;
     return true;
   }
   return false;
@@ -110,7 +116,8 @@ void Input::beginMapping() {
   // CurrentNode can be null if the document is empty.
   MapHNode *MN = dyn_cast_or_null<MapHNode>(CurrentNode);
   if (MN) {
-    MN->ValidKeys.clear();
+    for (unsigned i = 0; i < MN->NumEntries; ++i)
+      MN->Entries[i].Used = false;
   }
 }
 
@@ -133,8 +140,7 @@ bool Input::preflightKey(const char *Key, bool Required, bool, bool &UseDefault,
     setError(CurrentNode, "not a mapping");
     return false;
   }
-  MN->ValidKeys.push_back(Key);
-  HNode *Value = MN->Mapping[Key];
+  HNode *Value = MN->lookup(Key);
   if (!Value) {
     if (Required)
       setError(CurrentNode, Twine("missing required key '") + Key + "'");
@@ -158,10 +164,10 @@ void Input::endMapping() {
   MapHNode *MN = dyn_cast_or_null<MapHNode>(CurrentNode);
   if (!MN)
     return;
-  for (MapHNode::NameToNode::iterator i = MN->Mapping.begin(),
-       End = MN->Mapping.end(); i != End; ++i) {
-    if (!MN->isValidKey(i->first())) {
-      setError(i->second, Twine("unknown key '") + i->first() + "'");
+  for (unsigned i = 0; i < MN->NumEntries; ++i) {
+    if (!MN->Entries[i].Used) {
+      setError(MN->Entries[i].Value,
+               Twine("unknown key '") + MN->Entries[i].Key + "'");
       break;
     }
   }
@@ -169,7 +175,7 @@ void Input::endMapping() {
 
 unsigned Input::beginSequence() {
   if (SequenceHNode *SQ = dyn_cast<SequenceHNode>(CurrentNode)) {
-    return SQ->Entries.size();
+    return SQ->NumEntries;
   }
   return 0;
 }
@@ -194,7 +200,7 @@ void Input::postflightElement(void *SaveInfo) {
 
 unsigned Input::beginFlowSequence() {
   if (SequenceHNode *SQ = dyn_cast<SequenceHNode>(CurrentNode)) {
-    return SQ->Entries.size();
+    return SQ->NumEntries;
   }
   return 0;
 }
@@ -242,7 +248,7 @@ void Input::endEnumScalar() {
 bool Input::beginBitSetScalar(bool &DoClear) {
   BitValuesUsed.clear();
   if (SequenceHNode *SQ = dyn_cast<SequenceHNode>(CurrentNode)) {
-    BitValuesUsed.insert(BitValuesUsed.begin(), SQ->Entries.size(), false);
+    BitValuesUsed.insert(BitValuesUsed.begin(), SQ->NumEntries, false);
   } else {
     setError(CurrentNode, "expected sequence of bit values");
   }
@@ -254,10 +260,8 @@ bool Input::bitSetMatch(const char *Str, bool) {
   if (EC)
     return false;
   if (SequenceHNode *SQ = dyn_cast<SequenceHNode>(CurrentNode)) {
-    unsigned Index = 0;
-    for (std::vector<HNode *>::iterator i = SQ->Entries.begin(),
-         End = SQ->Entries.end(); i != End; ++i) {
-      if (ScalarHNode *SN = dyn_cast<ScalarHNode>(*i)) {
+    for (unsigned Index = 0; Index < SQ->NumEntries; ++Index) {
+      if (ScalarHNode *SN = dyn_cast<ScalarHNode>(SQ->Entries[Index])) {
         if (SN->value().equals(Str)) {
           BitValuesUsed[Index] = true;
           return true;
@@ -265,7 +269,6 @@ bool Input::bitSetMatch(const char *Str, bool) {
       } else {
         setError(CurrentNode, "unexpected scalar in sequence of bit values");
       }
-      ++Index;
     }
   } else {
     setError(CurrentNode, "expected sequence of bit values");
@@ -277,8 +280,8 @@ void Input::endBitSetScalar() {
   if (EC)
     return;
   if (SequenceHNode *SQ = dyn_cast<SequenceHNode>(CurrentNode)) {
-    assert(BitValuesUsed.size() == SQ->Entries.size());
-    for (unsigned i = 0; i < SQ->Entries.size(); ++i) {
+    assert(BitValuesUsed.size() == SQ->NumEntries);
+    for (unsigned i = 0; i < SQ->NumEntries; ++i) {
       if (!BitValuesUsed[i]) {
         setError(SQ->Entries[i], "unknown bit value");
         return;
@@ -316,19 +319,25 @@ Input::HNode *Input::createHNodes(Node *N) {
       memcpy(Buf, &StringStorage[0], Len);
       KeyStr = StringRef(Buf, Len);
     }
-    return new ScalarHNode(N, KeyStr);
+    return new (HNodeAllocator.Allocate<ScalarHNode>()) ScalarHNode(N, KeyStr);
   } else if (SequenceNode *SQ = dyn_cast<SequenceNode>(N)) {
-    SequenceHNode *SQHNode = new SequenceHNode(N);
+    SequenceHNode *SQHNode =
+      new (HNodeAllocator.Allocate<SequenceHNode>()) SequenceHNode(N);
+    SmallVector<HNode*, 16> Entries;
     for (SequenceNode::iterator i = SQ->begin(), End = SQ->end(); i != End;
          ++i) {
       HNode *Entry = this->createHNodes(i);
       if (EC)
         break;
-      SQHNode->Entries.push_back(Entry);
+      Entries.push_back(Entry);
     }
+    SQHNode->NumEntries = Entries.size();
+    SQHNode->Entries = HNodeAllocator.Allocate<HNode*>(Entries.size());
+    std::copy(Entries.begin(), Entries.end(), SQHNode->Entries);
     return SQHNode;
   } else if (MappingNode *Map = dyn_cast<MappingNode>(N)) {
-    MapHNode *mapHNode = new MapHNode(N);
+    MapHNode *mapHNode = new (HNodeAllocator.Allocate<MapHNode>()) MapHNode(N);
+    SmallVector<MapHNode::Entry, 8> Entries;
     for (MappingNode::iterator i = Map->begin(), End = Map->end(); i != End;
          ++i) {
       ScalarNode *KeyScalar = dyn_cast<ScalarNode>(i->getKey());
@@ -344,24 +353,31 @@ Input::HNode *Input::createHNodes(Node *N) {
       HNode *ValueHNode = this->createHNodes(i->getValue());
       if (EC)
         break;
-      mapHNode->Mapping[KeyStr] = ValueHNode;
+      MapHNode::Entry E = { KeyStr, ValueHNode, false };
+      Entries.push_back(E);
     }
+    mapHNode->NumEntries = Entries.size();
+    mapHNode->Entries =
+      HNodeAllocator.Allocate<MapHNode::Entry>(Entries.size());
+    std::copy(Entries.begin(), Entries.end(), mapHNode->Entries);
     return mapHNode;
   } else if (isa<NullNode>(N)) {
-    return new EmptyHNode(N);
+    return new (HNodeAllocator.Allocate<EmptyHNode>()) EmptyHNode(N);
   } else {
     setError(N, "unknown node kind");
     return NULL;
   }
 }
 
-bool Input::MapHNode::isValidKey(StringRef Key) {
-  for (SmallVectorImpl<const char *>::iterator i = ValidKeys.begin(),
-       End = ValidKeys.end(); i != End; ++i) {
-    if (Key.equals(*i))
-      return true;
+Input::HNode *Input::MapHNode::lookup(StringRef Key) {
+  HNode *Value = NULL;
+  for (unsigned i = 0; i < NumEntries; ++i) {
+    if (Entries[i].Key == Key) {
+      Entries[i].Used = true;
+      Value = Entries[i].Value;
+    }
   }
-  return false;
+  return Value;
 }
 
 void Input::setError(const Twine &Message) {
@@ -372,20 +388,6 @@ bool Input::canElideEmptySequence() {
   return false;
 }
 
-Input::MapHNode::~MapHNode() {
-  for (MapHNode::NameToNode::iterator i = Mapping.begin(), End = Mapping.end();
-                                                                i != End; ++i) {
-    delete i->second;
-  }
-}
-
-Input::SequenceHNode::~SequenceHNode() {
-  for (std::vector<HNode*>::iterator i = Entries.begin(), End = Entries.end();
-                                                                i != End; ++i) {
-    delete *i;
-  }
-}
-
 
 
 //===----------------------------------------------------------------------===//
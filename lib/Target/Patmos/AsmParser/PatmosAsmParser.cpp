@@ -373,9 +373,12 @@ MatchAndEmitInstruction(SMLoc IDLoc, unsigned &Opcode,
       MCOperand &MCO = Inst.getOperand( ImmOpNo );
 
       if (MCO.isExpr()) {
-        // If we have an expression, use ALUl, but only if this is
-        // not a bundled op
-        if (HasALUlVariant(Inst.getOpcode(), ALUlOpcode) && !InBundle) {
+        // If we have an expression outside of a bundle, emit the ALUi
+        // version and let the assembler backend relax it to ALUl if the
+        // value is not known or does not fit. If the expression is the last
+        // op of a bundle, use ALUl (and fail on the bundle size).
+        if (HasALUlVariant(Inst.getOpcode(), ALUlOpcode) && !InBundle &&
+            BundleCounter) {
           Inst.setOpcode(ALUlOpcode);
           // ALUl counts as two operations
           BundleCounter++;
@@ -14,6 +14,7 @@
 #include "Patmos.h"
 #include "PatmosSubtarget.h"
 #include "MCTargetDesc/PatmosBaseInfo.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/MC/MCDisassembler.h"
 #include "llvm/MC/MCFixedLenDisassembler.h"
 #include "llvm/Support/MemoryObject.h"
@@ -33,6 +34,27 @@ typedef MCDisassembler::DecodeStatus DecodeStatus;
 /// PatmosDisassembler - a disassembler class for Patmos.
 class PatmosDisassembler : public MCDisassembler {
   MCInstrInfo *MII;
+
+  /// CachedInst - the decoding result of an instruction word or of an ALUl
+  /// word pair. Decoding does not depend on the address of the instruction,
+  /// so cached instructions are copied as they are.
+  struct CachedInst {
+    MCInst Inst;
+    /// Size - the number of bytes consumed, 8 with status Fail for a bundled
+    /// word that needs to be decoded as ALUl instruction.
+    uint64_t Size;
+    DecodeStatus Status;
+  };
+
+  typedef DenseMap<uint64_t, CachedInst> DecodeCacheMap;
+
+  /// DecodeCache - decoded instructions, keyed by the instruction word, or
+  /// by the two words of ALUl instructions with the bundle bit set.
+  mutable DecodeCacheMap DecodeCache;
+
+  /// Uncached - holds the result for keys reserved by the DenseMap.
+  mutable CachedInst Uncached;
+
 public:
   /// Constructor     - Initializes the disassembler.
   ///
@@ -53,13 +75,34 @@ public:
                               raw_ostream &vStream,
                               raw_ostream &cStream) const;
 
+  /// decodeRegion - See MCDisassembler. Reads the whole region at once and
+  /// decodes the words using the decode cache.
+  unsigned decodeRegion(const MemoryObject &region,
+                        uint64_t start, uint64_t end,
+                        std::vector<DecodedInst> &insts) const;
+
 private:
 
+  /// getCacheEntry - get the cache entry for a key, or null if the key has
+  /// not been decoded yet.
+  CachedInst *getCacheEntry(uint64_t Key, bool &IsNew) const;
+
+  /// decode32 - decode a single instruction word, including the bundle bit.
+  const CachedInst &decode32(uint32_t Insn) const;
+
+  /// decode64 - decode a bundled instruction word and the following word as
+  /// ALUl instruction.
+  const CachedInst &decode64(uint32_t Insn, uint32_t InsnL) const;
+
   /// adjustSignedImm - convert immediates to signed by sign-extend if necessary
   void adjustSignedImm(MCInst &instr) const;
 
 };
 
+/// MaxDecodeCacheSize - the number of cached instructions after which the
+/// decode cache is flushed.
+static const unsigned MaxDecodeCacheSize = 1 << 18;
+
 // We could use the information from PatmosGenRegisterInfo.inc here,
 // but this would require linking to PatmosMCTargetDesc and providing
 // static functions there to access those structs.
@@ -120,6 +163,81 @@ static DecodeStatus readInstruction32(const MemoryObject &region,
   return MCDisassembler::Success;
 }
 
+PatmosDisassembler::CachedInst *
+PatmosDisassembler::getCacheEntry(uint64_t Key, bool &IsNew) const {
+  // The empty and tombstone keys cannot be stored in the map.
+  if (Key >= DenseMapInfo<uint64_t>::getTombstoneKey()) {
+    Uncached.Inst.clear();
+    IsNew = true;
+    return &Uncached;
+  }
+
+  if (DecodeCache.size() >= MaxDecodeCacheSize) {
+    DecodeCache.clear();
+  }
+
+  std::pair<DecodeCacheMap::iterator, bool> Entry =
+                           DecodeCache.insert(std::make_pair(Key, CachedInst()));
+  IsNew = Entry.second;
+  return &Entry.first->second;
+}
+
+const PatmosDisassembler::CachedInst &
+PatmosDisassembler::decode32(uint32_t Insn) const {
+  bool IsNew;
+  CachedInst *CI = getCacheEntry(Insn, IsNew);
+  if (!IsNew)
+    return *CI;
+
+  bool isBundled = (Insn >> 31);
+
+  // TODO we could check the opcode for ALUl instruction format to avoid calling decode32 in that case
+
+  // Calling the auto-generated decoder function.
+  CI->Status = decodeInstruction(DecoderTablePatmos32, CI->Inst,
+                                 Insn & ~(1U << 31), 0, this, STI);
+  CI->Size = 4;
+
+  if (CI->Status == MCDisassembler::Fail) {
+    // Try decoding as 64bit ALUl instruction
+    if (isBundled) CI->Size = 8;
+    return *CI;
+  }
+
+  // handle bundled instructions by adding a special operand
+  CI->Inst.addOperand(MCOperand::CreateImm(isBundled));
+
+  adjustSignedImm(CI->Inst);
+
+  return *CI;
+}
+
+const PatmosDisassembler::CachedInst &
+PatmosDisassembler::decode64(uint32_t Insn, uint32_t InsnL) const {
+  // Bundle-bit is set for ALUl format, combine instruction opcode and
+  // immediate
+  uint64_t Insn64 = ((uint64_t)Insn << 32) | InsnL;
+
+  bool IsNew;
+  CachedInst *CI = getCacheEntry(Insn64, IsNew);
+  if (!IsNew)
+    return *CI;
+
+  CI->Status = decodeInstruction(DecoderTablePatmos64, CI->Inst, Insn64, 0,
+                                 this, STI);
+  CI->Size = 8;
+
+  if (CI->Status == MCDisassembler::Fail)
+    return *CI;
+
+  // If we have a 64bit instruction, do not mark instruction as bundled
+  CI->Inst.addOperand(MCOperand::CreateImm(false));
+
+  adjustSignedImm(CI->Inst);
+
+  return *CI;
+}
+
 DecodeStatus
 PatmosDisassembler::getInstruction(MCInst &instr,
                                  uint64_t &Size,
@@ -135,17 +253,10 @@ PatmosDisassembler::getInstruction(MCInst &instr,
   if (Result == MCDisassembler::Fail)
     return MCDisassembler::Fail;
 
-  bool isBundled = (Insn >> 31);
-  Insn &= ~(1<<31);
+  const CachedInst *CI = &decode32(Insn);
 
-  // TODO we could check the opcode for ALUl instruction format to avoid calling decode32 in that case
-
-  // Calling the auto-generated decoder function.
-  Result = decodeInstruction(DecoderTablePatmos32, instr, Insn, Address, this, STI);
-
-  // Try decoding as 64bit ALUl instruction
-  if (Result == MCDisassembler::Fail) {
-    if (!isBundled) return MCDisassembler::Fail;
+  if (CI->Status == MCDisassembler::Fail) {
+    if (CI->Size != 8) return MCDisassembler::Fail;
 
     uint32_t InsnL;
 
@@ -154,23 +265,76 @@ PatmosDisassembler::getInstruction(MCInst &instr,
       return MCDisassembler::Fail;
     }
 
-    // Set bundle-bit for ALUl format, combine instruction opcode and immediate
-    uint64_t Insn64 = (1ULL << 63) | ((uint64_t)Insn << 32) | InsnL;
-
-    Result = decodeInstruction(DecoderTablePatmos64, instr, Insn64, Address, this, STI);
-    if (Result == MCDisassembler::Fail)
+    CI = &decode64(Insn, InsnL);
+    if (CI->Status == MCDisassembler::Fail)
       return MCDisassembler::Fail;
+  }
+
+  instr = CI->Inst;
 
-    // If we have a 64bit instruction, do not mark instruction as bundled
-    isBundled = false;
+  return CI->Status;
+}
+
+unsigned PatmosDisassembler::decodeRegion(const MemoryObject &Region,
+                                          uint64_t Start, uint64_t End,
+                                          std::vector<DecodedInst> &Insts) const
+{
+  if (End <= Start)
+    return 0;
+
+  std::vector<uint8_t> Bytes(End - Start);
+  if (Region.readBytes(Start, End - Start, &Bytes[0]) == -1) {
+    // Let getInstruction deal with the end of the region.
+    return MCDisassembler::decodeRegion(Region, Start, End, Insts);
   }
 
-  // handle bundled instructions by adding a special operand
-  instr.addOperand(MCOperand::CreateImm(isBundled));
+  unsigned NumInvalid = 0;
+  uint64_t NumBytes = Bytes.size();
+
+  Insts.reserve(Insts.size() + NumBytes / 4);
 
-  adjustSignedImm(instr);
+  uint64_t Offset = 0;
+  while (Offset < NumBytes) {
+    Insts.push_back(DecodedInst());
+    DecodedInst &DI = Insts.back();
+    DI.Address = Start + Offset;
+
+    if (Offset + 4 > NumBytes) {
+      // Trailing bytes, no complete instruction word left.
+      DI.Status = MCDisassembler::Fail;
+      DI.Size = 1;
+      ++NumInvalid;
+      ++Offset;
+      continue;
+    }
+
+    // Encoded as a big-endian 32-bit word in the stream.
+    const uint8_t *P = &Bytes[Offset];
+    uint32_t Insn = (P[0] << 24) | (P[1] << 16) | (P[2] << 8) | P[3];
+
+    const CachedInst *CI = &decode32(Insn);
+    uint64_t Size = 4;
+
+    if (CI->Status == MCDisassembler::Fail && CI->Size == 8 &&
+        Offset + 8 <= NumBytes)
+    {
+      P += 4;
+      uint32_t InsnL = (P[0] << 24) | (P[1] << 16) | (P[2] << 8) | P[3];
+      CI = &decode64(Insn, InsnL);
+      Size = 8;
+    }
+
+    DI.Status = CI->Status;
+    DI.Size = Size;
+    if (CI->Status == MCDisassembler::Fail) {
+      ++NumInvalid;
+    } else {
+      DI.Inst = CI->Inst;
+    }
+    Offset += Size;
+  }
 
-  return Result;
+  return NumInvalid;
 }
 
 void PatmosDisassembler::adjustSignedImm(MCInst &instr) const {
@@ -12,13 +12,19 @@
 //===----------------------------------------------------------------------===//
 //
 
+#define DEBUG_TYPE "patmos-asm-backend"
+#include "PatmosInstrInfo.h"
 #include "PatmosFixupKinds.h"
+#include "MCTargetDesc/PatmosBaseInfo.h"
 #include "MCTargetDesc/PatmosMCTargetDesc.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/MC/MCAsmBackend.h"
 #include "llvm/MC/MCAssembler.h"
 #include "llvm/MC/MCDirectives.h"
 #include "llvm/MC/MCELFObjectWriter.h"
 #include "llvm/MC/MCFixupKindInfo.h"
+#include "llvm/MC/MCInstrInfo.h"
 #include "llvm/MC/MCObjectWriter.h"
 #include "llvm/MC/MCSubtargetInfo.h"
 #include "llvm/MC/MCValue.h"
@@ -28,10 +34,13 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/ELF.h"
+#include "llvm/Support/TargetRegistry.h"
 
 using namespace llvm;
 using namespace Patmos;
 
+STATISTIC(NumRelaxed, "Number of ALUi instructions relaxed to ALUl");
+
 // Prepare value for the target space for it
 static unsigned adjustFixupValue(unsigned Kind, uint64_t Value) {
 
@@ -56,9 +65,11 @@ namespace {
 class PatmosAsmBackend : public MCAsmBackend {
   Triple::OSType OSType;
 
+  OwningPtr<const MCInstrInfo> MCII;
+
 public:
   PatmosAsmBackend(const Target &T,  Triple::OSType _OSType)
-    :MCAsmBackend(), OSType(_OSType) {}
+    :MCAsmBackend(), OSType(_OSType), MCII(T.createMCInstrInfo()) {}
 
   MCObjectWriter *createObjectWriter(raw_ostream &OS) const {
     return createPatmosELFObjectWriter(OS, OSType);
@@ -165,23 +176,43 @@ public:
   /// MayNeedRelaxation - Check whether the given instruction may need
   /// relaxation.
   ///
+  /// The assembler emits ALUi instructions with symbolic immediates in the
+  /// short format if they are not bundled (ALUl instructions cannot be
+  /// bundled), and we widen them to ALUl here if the value does not fit.
+  /// Only the first instruction of a bundle has the bundle bit set, but the
+  /// assembler never emits a symbolic ALUi as last instruction of a bundle.
+  ///
   /// \param Inst - The instruction to test.
   bool mayNeedRelaxation(const MCInst &Inst) const {
-    // TODO return true for small immediates (?)
-    return false;
+    const MCInstrDesc &MID = MCII->get(Inst.getOpcode());
+    if ((MID.TSFlags & PatmosII::FormMask) != PatmosII::FrmALUi ||
+        !hasPatmosImmediate(MID.TSFlags))
+      return false;
+
+    // Bundled instructions must not be relaxed
+    if (Inst.getOperand(Inst.getNumOperands()-1).getImm() > 0)
+      return false;
+
+    unsigned ALUlOpcode;
+    unsigned ImmOpNo = getPatmosImmediateOpNo(MID.TSFlags);
+    return Inst.getOperand(ImmOpNo).isExpr() &&
+           HasALUlVariant(Inst.getOpcode(), ALUlOpcode);
   }
 
   /// fixupNeedsRelaxation - Target specific predicate for whether a given
   /// fixup requires the associated instruction to be relaxed.
+  /// This is only called for fixups that have been resolved by the
+  /// assembler, all other fixups always need relaxation.
   bool fixupNeedsRelaxation(const MCFixup &Fixup,
                             uint64_t Value,
                             const MCRelaxableFragment *DF,
                             const MCAsmLayout &Layout) const
   {
+    assert(Fixup.getKind() == (MCFixupKind)FK_Patmos_abs_ALUi &&
+           "Unexpected fixup kind in relaxable instruction");
 
-    // TODO check for branch/call immediate
-    assert(0 && "RelaxInstruction() unimplemented");
-    return false;
+    // ALUi immediates are unsigned
+    return !isUInt<12>(Value);
   }
 
   /// RelaxInstruction - Relax the instruction in the given fragment
@@ -191,7 +222,14 @@ public:
   /// as the output.
   /// \parm Res [output] - On return, the relaxed instruction.
   void relaxInstruction(const MCInst &Inst, MCInst &Res) const {
-    // TODO relax small immediates (?)
+    unsigned ALUlOpcode;
+    if (!HasALUlVariant(Inst.getOpcode(), ALUlOpcode))
+      llvm_unreachable("relaxInstruction() called for unrelaxable opcode");
+
+    // ALUi and ALUl instructions have the same operands
+    Res = Inst;
+    Res.setOpcode(ALUlOpcode);
+    ++NumRelaxed;
   }
 
   /// @}
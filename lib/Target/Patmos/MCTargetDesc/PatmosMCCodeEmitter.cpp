@@ -85,7 +85,6 @@ public:
                            SmallVectorImpl<MCFixup> &Fixups) const;
 
   void addSymbolRefFixups(const MCInst &MI, const MCOperand& MO,
-                                          const MCSymbolRefExpr* Expr,
                                           SmallVectorImpl<MCFixup> &Fixups) const;
 
 }; // class PatmosMCCodeEmitter
@@ -181,28 +180,20 @@ PatmosMCCodeEmitter::getImmediateEncoding(const MCInst &MI, const MCOperand& MO,
   const MCExpr *Expr = MO.getExpr();
   MCExpr::ExprKind Kind = Expr->getKind();
 
-  if (Kind == MCExpr::Binary) {
-    const MCBinaryExpr* BinOp = static_cast<const MCBinaryExpr*>(Expr);
-    Expr = BinOp->getLHS();
-    Kind = Expr->getKind();
-
-    // TODO handle Symbol - Constant? Handle Symbol - Symbol ?
-
-    llvm_unreachable("Binary expressions are currently not supported.");
-  }
-
   if (Kind == MCExpr::Constant) {
     // TODO do we need this?? Emit as immediate
     llvm_unreachable("Constant symbols not yet implemented.");
   }
 
-  if (Kind != MCExpr::SymbolRef) {
+  if (Kind != MCExpr::SymbolRef && Kind != MCExpr::Binary) {
     // TODO do we need to support Unary, Target or even more
     llvm_unreachable("Unsupported expression type.");
   }
 
-  // This adds the whole expression as fixup, not just the symbol part
-  addSymbolRefFixups(MI, MO, cast<MCSymbolRefExpr>(Expr), Fixups);
+  // This adds the whole expression as fixup, not just the symbol part.
+  // Binary expressions (symbol offsets, label differences) are evaluated by
+  // the assembler, or emitted as relocation with an addend.
+  addSymbolRefFixups(MI, MO, Fixups);
 
   // All of the information is in the fixup.
   return 0;
@@ -210,7 +201,6 @@ PatmosMCCodeEmitter::getImmediateEncoding(const MCInst &MI, const MCOperand& MO,
 
 void
 PatmosMCCodeEmitter::addSymbolRefFixups(const MCInst &MI, const MCOperand& MO,
-                                        const MCSymbolRefExpr* Expr,
                                         SmallVectorImpl<MCFixup> &Fixups) const
 {
   using namespace Patmos;
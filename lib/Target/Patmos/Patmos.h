@@ -24,6 +24,7 @@ namespace llvm {
   class PatmosTargetMachine;
   class FunctionPass;
   class ModulePass;
+  class ImmutablePass;
   class formatted_raw_ostream;
   class PassRegistry;
 
@@ -33,6 +34,7 @@ namespace llvm {
   void initializePatmosPMLProfileImportPasS(PassRegistry&);
 
   FunctionPass *createPatmosISelDag(PatmosTargetMachine &TM);
+  ModulePass   *createPatmosSPSelectPass();
   ModulePass   *createPatmosSPClonePass();
   ModulePass   *createPatmosSPMarkPass(PatmosTargetMachine &tm);
   FunctionPass *createPatmosSinglePathInfoPass(const PatmosTargetMachine &tm);
@@ -41,6 +43,8 @@ namespace llvm {
   FunctionPass *createPatmosDelaySlotFillerPass(const PatmosTargetMachine &tm,
                                                 bool ForceDisable);
   FunctionPass *createPatmosFunctionSplitterPass(PatmosTargetMachine &tm);
+  ModulePass   *createPatmosMethodCacheAnalysisPass(
+                                               const PatmosTargetMachine &tm);
   FunctionPass *createPatmosDelaySlotKillerPass(PatmosTargetMachine &tm);
   FunctionPass *createPatmosExportPass(PatmosTargetMachine &TM,
                                        std::string& Filename,
@@ -58,6 +62,9 @@ namespace llvm {
   ModulePass *createPatmosStackCacheAnalysis(const PatmosTargetMachine &tm);
   ModulePass *createPatmosStackCacheAnalysisInfo(const PatmosTargetMachine &tm);
 
+  ImmutablePass *createPatmosTargetTransformInfoPass(
+                                              const PatmosTargetMachine *TM);
+
   extern char &PatmosPostRASchedulerID;
 } // end namespace llvm;
 
@@ -9,10 +9,18 @@
 //
 // This pass imports a PML file with annotated aiT analysis results,
 // scans them for memory accesses with unknown (large) address ranges
-// and rewrites the memory instructions to bypassed loads.
+// and rewrites the memory instructions to bypassed loads and stores.
 // The rationale is to avoid destroying the state of the data cache by
 // unanalyzable accesses, such that the analysis becomes more precise.
 //
+// Loops in which most data cache accesses are unpredictable (e.g., loops
+// streaming over large arrays) are rewritten as a whole, so that the
+// remaining accesses of the loop do not thrash the cache either.
+//
+// Only loads are rewritten by default: the data cache is write-through,
+// so bypassed loads always see the value in memory, whereas a bypassed
+// store would leave a stale line behind for later cached loads.
+//
 //===----------------------------------------------------------------------===//
 
 #define DEBUG_TYPE "patmos-bypass-from-pml"
@@ -21,6 +29,7 @@
 #include "PatmosTargetMachine.h"
 #include "llvm/CodeGen/MachineFunctionPass.h"
 #include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineLoopInfo.h"
 #include "llvm/CodeGen/PMLImport.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetInstrInfo.h"
@@ -39,6 +48,8 @@
 using namespace llvm;
 
 STATISTIC( Rewritten, "Number of instructions rewritten to bypass");
+STATISTIC( RewrittenStores, "Number of stores rewritten to bypass");
+STATISTIC( RewrittenLoops, "Number of loops rewritten to bypass");
 
 
 static cl::opt<bool> EnableBypassFromPML(
@@ -55,6 +66,23 @@ static cl::opt<int> BypassRangeThreshold(
     cl::desc("Bypass if a range is wider than 2^THRESHOLD"),
     cl::Hidden, cl::Optional);
 
+// A bypassed store does not update a line that is already cached, so a
+// later cached load of the same address reads the stale value. Only
+// enable this if no cached load can alias a rewritten store.
+static cl::opt<bool> BypassStores(
+    "mpatmos-bypass-stores",
+    cl::init(false),
+    cl::desc("Also rewrite stores to unpredictable addresses to bypass "
+             "the cache (unsafe if cached loads may alias them)"),
+    cl::Hidden);
+
+static cl::opt<unsigned> BypassLoopRatio(
+    "mpatmos-bypass-loop-ratio",
+    cl::init(50),
+    cl::desc("Bypass all data cache accesses of a loop if at least RATIO "
+             "percent of them are unpredictable (0 = disable)"),
+    cl::Hidden, cl::Optional);
+
 namespace {
 
 
@@ -63,20 +91,37 @@ namespace {
     /// Pass ID
     static char ID;
 
-    /// bypassCacheLoads - Rewrite the loads in a given MBB for which
-    /// there exist value facts classifiying the load as load
-    /// from an unpredictable address
-    bool bypassCacheLoads(MachineBasicBlock &MBB, PMLQuery *Q,
-                          PMLQuery::ValueFactList &MemFacts);
+    typedef SmallPtrSet<MachineInstr*, 32> InstrSet;
+
+    /// collectUnpredictable - Collect the memory accesses in a given MBB
+    /// for which there exist value facts classifiying the access as
+    /// access to an unpredictable address
+    void collectUnpredictable(MachineBasicBlock &MBB, PMLQuery *Q,
+                              PMLQuery::ValueFactList &MemFacts,
+                              InstrSet &Unpredictable);
+
+    /// bypassLoop - Rewrite all data cache accesses of a loop if enough
+    /// of them are unpredictable, otherwise try its subloops.
+    bool bypassLoop(MachineLoop *L, InstrSet &Unpredictable);
 
 
     /// hasLargeRange - Returns true if at least one range of the
     /// value fact is above a certain threshold
     bool hasLargeRange(const yaml::ValueFact *VF) const;
 
-    //
-    /// rewriteInstruction - Rewrite a diven instruction to bypass the cache
-    /// NB: only applies to load instructions for now
+    /// getMemInstr - Get the memory access of an instruction or bundle
+    MachineInstr *getMemInstr(MachineInstr *MI) const;
+
+    /// isCacheAccess - Returns true if the instruction (or bundle) is a
+    /// load or store through the data cache
+    bool isCacheAccess(MachineInstr *MI) const;
+
+    /// isBypassable - Returns true if the instruction (or bundle) is a
+    /// data cache access that may be rewritten to bypass the cache
+    bool isBypassable(MachineInstr *MI) const;
+
+    /// rewriteInstruction - Rewrite a given data cache access to bypass the
+    /// cache
     bool rewriteInstruction(MachineInstr &MI);
 
   public:
@@ -101,6 +146,7 @@ namespace {
 
     void getAnalysisUsage(AnalysisUsage &AU) const {
       AU.addRequired<PMLImport>();
+      AU.addRequired<MachineLoopInfo>();
       AU.setPreservesAll();
       MachineFunctionPass::getAnalysisUsage(AU);
     }
@@ -136,32 +182,73 @@ bool PatmosBypassFromPML::hasLargeRange(const yaml::ValueFact *VF) const {
 }
 
 
+MachineInstr *PatmosBypassFromPML::getMemInstr(MachineInstr *MI) const {
+  if (!MI->isBundle()) return MI;
+
+  // the memory access does not need to be the first bundled instruction
+  MachineBasicBlock::instr_iterator II = MI; ++II;
+  MachineBasicBlock::instr_iterator IE = MI->getParent()->instr_end();
+  while (II != IE && II->isInsideBundle()) {
+    if (II->mayLoad() || II->mayStore()) return II;
+    ++II;
+  }
+  return MI;
+}
+
+
+bool PatmosBypassFromPML::isCacheAccess(MachineInstr *MI) const {
+  MachineInstr *MemMI = getMemInstr(MI);
+  // inline asm, calls and pseudos may touch memory, but are no typed
+  // memory accesses; getMemType does not know about them
+  if (MemMI->isInlineAsm() || MemMI->isCall() || TII->isPseudo(MemMI))
+    return false;
+  if (!MemMI->mayLoad() && !MemMI->mayStore())
+    return false;
+  return TII->getMemType(MemMI) == PatmosII::MEM_C;
+}
+
+
+bool PatmosBypassFromPML::isBypassable(MachineInstr *MI) const {
+  if (!isCacheAccess(MI)) return false;
+  // stores stay cached unless requested, so they must not count towards
+  // the unpredictable accesses of a loop either
+  return BypassStores || !getMemInstr(MI)->mayStore();
+}
+
+
 bool PatmosBypassFromPML::rewriteInstruction(MachineInstr &MI) {
+  MachineInstr *MemMI = getMemInstr(&MI);
+  bool IsStore = false;
   unsigned opc = 0;
-  switch (MI.getOpcode()) {
+  switch (MemMI->getOpcode()) {
     case Patmos::LWC:  opc = Patmos::LWM;  break;
     case Patmos::LHC:  opc = Patmos::LHM;  break;
     case Patmos::LBC:  opc = Patmos::LBM;  break;
     case Patmos::LHUC: opc = Patmos::LHUM; break;
     case Patmos::LBUC: opc = Patmos::LBUM; break;
+    case Patmos::SWC:  opc = Patmos::SWM; IsStore = true; break;
+    case Patmos::SHC:  opc = Patmos::SHM; IsStore = true; break;
+    case Patmos::SBC:  opc = Patmos::SBM; IsStore = true; break;
     default: /*ignore*/;
   }
 
+  if (IsStore && !BypassStores) return false;
+
   if (opc) {
-    DEBUG( dbgs() << "  - rewrite: " << MI );
-    MI.setDesc(TII->get(opc));
+    DEBUG( dbgs() << "  - rewrite: " << *MemMI );
+    MemMI->setDesc(TII->get(opc));
     Rewritten++; // bump stats
+    if (IsStore) RewrittenStores++;
     return true;
   }
   return false;
 }
 
 
-bool PatmosBypassFromPML::bypassCacheLoads(MachineBasicBlock &MBB,
-    PMLQuery *Q, PMLQuery::ValueFactList &MemFacts) {
+void PatmosBypassFromPML::collectUnpredictable(MachineBasicBlock &MBB,
+    PMLQuery *Q, PMLQuery::ValueFactList &MemFacts, InstrSet &Unpredictable) {
 
   SmallPtrSet<const yaml::ProgramPoint *, 32> RewritePPs;
-  bool changed = false;
 
   // go through all VFs and check if they contain large ranges
   // - if so, put VF->PP into a set
@@ -188,19 +275,56 @@ bool PatmosBypassFromPML::bypassCacheLoads(MachineBasicBlock &MBB,
   }
 
   // for each MachineInstr keep counting the mem instrs
-  // - if it is an index in the set, rewrite the instruction
+  // - if it is an index in the set, mark the instruction
   uint64_t memidx = 0;
   for (MachineBasicBlock::iterator MI = MBB.begin(), ME = MBB.end();
       MI != ME; ++MI) {
     if (MI->mayLoad() || MI->mayStore()) {
       if (MemInstrLabels.count(memidx)) {
-        changed |= rewriteInstruction(*MI);
+        Unpredictable.insert(MI);
       }
       memidx++;
     }
   }
+}
 
-  return changed;
+
+bool PatmosBypassFromPML::bypassLoop(MachineLoop *L,
+                                     InstrSet &Unpredictable) {
+  // count the data cache accesses of the loop, including subloops
+  SmallVector<MachineInstr*, 32> CacheAccesses;
+  unsigned NumUnpredictable = 0;
+  for (MachineLoop::block_iterator BI = L->block_begin(),
+       BE = L->block_end(); BI != BE; ++BI) {
+    for (MachineBasicBlock::iterator MI = (*BI)->begin(), ME = (*BI)->end();
+         MI != ME; ++MI) {
+      if (!isBypassable(MI)) continue;
+      CacheAccesses.push_back(MI);
+      if (Unpredictable.count(MI)) NumUnpredictable++;
+    }
+  }
+
+  if (NumUnpredictable == 0) return false;
+
+  if (NumUnpredictable * 100 < BypassLoopRatio * CacheAccesses.size()) {
+    bool Changed = false;
+    for (MachineLoop::iterator I = L->begin(), E = L->end(); I != E; ++I) {
+      Changed |= bypassLoop(*I, Unpredictable);
+    }
+    return Changed;
+  }
+
+  DEBUG( dbgs() << "  Loop at MBB#" << L->getHeader()->getNumber() << ": "
+                << NumUnpredictable << " of " << CacheAccesses.size()
+                << " accesses unpredictable\n" );
+
+  bool Changed = false;
+  for (unsigned i = 0, e = CacheAccesses.size(); i != e; i++) {
+    Changed |= rewriteInstruction(*CacheAccesses[i]);
+    Unpredictable.erase(CacheAccesses[i]);
+  }
+  if (Changed) RewrittenLoops++;
+  return Changed;
 }
 
 
@@ -213,25 +337,42 @@ bool PatmosBypassFromPML::runOnMachineFunction(MachineFunction &MF) {
 
   bool Changed = false;
 
-  PMLQuery::ValueFactsMap LoadFacts;
+  PMLQuery::ValueFactsMap MemFacts;
 
-  if (Query && Query->getMemFacts(MF, LoadFacts)) {
+  if (Query && Query->getMemFacts(MF, MemFacts)) {
 
     DEBUG( dbgs() << "[BypassFromPML] "
         << MF.getFunction()->getName() << "\n");
 
+    InstrSet Unpredictable;
     for (MachineFunction::iterator FI = MF.begin(), FE = MF.end();
         FI != FE; ++FI) {
-      PMLQuery::ValueFactList &VFL = Query->getBBMemFacts(LoadFacts, *FI);
+      PMLQuery::ValueFactList &VFL = Query->getBBMemFacts(MemFacts, *FI);
       if (!VFL.empty()) {
+        collectUnpredictable(*FI, Query, VFL, Unpredictable);
+      }
+    }
 
-        DEBUG( dbgs() << "  MBB#" << FI->getNumber() << "\n" );
-        Changed |= bypassCacheLoads(*FI, Query, VFL);
+    // rewrite streaming loops as a whole
+    if (BypassLoopRatio > 0) {
+      MachineLoopInfo &MLI = getAnalysis<MachineLoopInfo>();
+      for (MachineLoopInfo::iterator I = MLI.begin(), E = MLI.end();
+           I != E; ++I) {
+        Changed |= bypassLoop(*I, Unpredictable);
       }
+    }
 
+    // rewrite the remaining single accesses, in instruction order
+    for (MachineFunction::iterator FI = MF.begin(), FE = MF.end();
+        FI != FE; ++FI) {
+      for (MachineBasicBlock::iterator MI = FI->begin(), ME = FI->end();
+          MI != ME; ++MI) {
+        if (!Unpredictable.count(MI)) continue;
+        DEBUG( dbgs() << "  MBB#" << FI->getNumber() << "\n" );
+        Changed |= rewriteInstruction(*MI);
+      }
     }
-    delete Query;
   }
+  delete Query;
   return Changed;
 }
-
@@ -1,4 +1,4 @@
-//===-- PatmosDelaySlotFiller.cpp - Patmos delay slot filler --------------===//
+//===-- PatmosEnsureAlignment.cpp - Patmos alignment of code --------------===//
 //
 //                     The LLVM Compiler Infrastructure
 //
@@ -9,37 +9,143 @@
 //
 // This pass ensures the alignment of functions, subfunctions and basic blocks.
 //
+// The padding in front of a subfunction is emitted after the end of the
+// previous method cache region and is never loaded into the method cache.
+// The padding in front of aligned basic blocks however is part of the region
+// and wastes cache space and transfer bandwidth. To minimize this padding,
+// the chains of fallthrough blocks inside a region are reordered, such that
+// the padding needed by the start of each chain is as small as possible.
+//
 //===----------------------------------------------------------------------===//
 
+#define DEBUG_TYPE "patmos-ensure-alignment"
+
 #include "Patmos.h"
+#include "PatmosInstrInfo.h"
 #include "PatmosMachineFunctionInfo.h"
 #include "PatmosTargetMachine.h"
 #include "PatmosSubtarget.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/CodeGen/MachineFunction.h"
 #include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineModuleInfo.h"
+#include "llvm/IR/Module.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 using namespace llvm;
 
+STATISTIC(RegionPadding, "Bytes of alignment padding inside method cache "
+                         "regions");
+STATISTIC(SubfunctionPadding, "Bytes of alignment padding between "
+                              "subfunctions");
+STATISTIC(PaddingSaved, "Bytes of alignment padding saved by reordering "
+                        "blocks");
+
+static cl::opt<bool> DisablePaddingReorder(
+  "mpatmos-disable-padding-reorder",
+  cl::init(false),
+  cl::desc("Do not reorder blocks to minimize alignment padding."),
+  cl::Hidden);
+
+namespace llvm {
+  // Defined in PatmosFunctionSplitter.cpp, padding statistics are appended
+  // to the splitter statistics.
+  extern cl::opt<std::string> PatmosSplitterStatsFile;
+}
+
 namespace {
 
   class PatmosEnsureAlignment : public MachineFunctionPass {
   private:
+    const PatmosInstrInfo &PII;
+
     unsigned MinSubfunctionAlignment;
 
     unsigned MinBasicBlockAlignment;
 
+    bool HasMethodCache;
+
     static char ID;
+
+    /// A sequence of blocks that may fall through to each other.
+    struct Chain {
+      MachineBasicBlock *First;
+      MachineBasicBlock *Last;
+      /// Alignment and size of the blocks in the chain.
+      SmallVector<std::pair<unsigned, unsigned>, 4> Blocks;
+    };
+
+    typedef SmallVector<Chain, 16> ChainList;
+
+    unsigned getBlockAlign(const PatmosMachineFunctionInfo *PMFI,
+                           const MachineBasicBlock *MBB) const {
+      unsigned Align = MinBasicBlockAlignment;
+      if (PMFI->isMethodCacheRegionEntry(MBB) ||
+          &MBB->getParent()->front() == MBB) {
+        Align = MinSubfunctionAlignment;
+      }
+      return 1u << std::max(Align, MBB->getAlignment());
+    }
+
+    unsigned getBBSize(MachineBasicBlock *MBB) const {
+      unsigned Size = 0;
+      for (MachineBasicBlock::instr_iterator i = MBB->instr_begin(),
+           ie = MBB->instr_end(); i != ie; ++i) {
+        if (i->isBundle()) continue;
+        Size += PII.getInstrSize(i);
+      }
+      return Size;
+    }
+
+    static unsigned getPadding(unsigned Offset, unsigned Align) {
+      return Align > 1 ? (Align - Offset % Align) % Align : 0;
+    }
+
+    /// getChainPadding - Get the padding of the chain if it starts at the
+    /// given offset, and update the offset to the end of the chain.
+    static unsigned getChainPadding(const Chain &C, unsigned &Offset) {
+      unsigned Padding = 0;
+      for (unsigned i = 0, e = C.Blocks.size(); i != e; i++) {
+        unsigned BlockPadding = getPadding(Offset, C.Blocks[i].first);
+        Offset += BlockPadding + C.Blocks[i].second;
+        Padding += BlockPadding;
+      }
+      return Padding;
+    }
+
+    /// computePadding - Compute the padding in the current layout of the
+    /// function, inside regions and in front of subfunctions.
+    void computePadding(MachineFunction &MF,
+                        const PatmosMachineFunctionInfo *PMFI,
+                        unsigned &InRegion, unsigned &BetweenRegions);
+
+    /// reorderRegion - Reorder the chains of a region to minimize padding.
+    /// Returns the number of bytes saved.
+    unsigned reorderRegion(ChainList &Chains, unsigned StartOffset);
+
+    /// minimizePadding - Reorder chains of fallthrough blocks in all regions
+    /// of the function. Returns the number of bytes saved.
+    unsigned minimizePadding(MachineFunction &MF,
+                             const PatmosMachineFunctionInfo *PMFI);
+
+    void writeStats(MachineFunction &MF, unsigned InRegion,
+                    unsigned BetweenRegions, unsigned Saved);
+
   public:
 
     PatmosEnsureAlignment(PatmosTargetMachine &tm)
-      : MachineFunctionPass(ID)
+      : MachineFunctionPass(ID),
+        PII(*static_cast<const PatmosInstrInfo*>(tm.getInstrInfo()))
     {
       const PatmosSubtarget *PST = tm.getSubtargetImpl();
 
       MinSubfunctionAlignment = PST->getMinSubfunctionAlignment();
       MinBasicBlockAlignment = PST->getMinBasicBlockAlignment();
+      HasMethodCache = PST->hasMethodCache();
     }
 
     virtual const char *getPassName() const {
@@ -57,6 +163,13 @@ namespace {
         Changed = true;
       }
 
+      // Basic block padding is only needed with basic block alignment.
+      unsigned Saved = 0;
+      if (!DisablePaddingReorder && MinBasicBlockAlignment > 2) {
+        Saved = minimizePadding(MF, PMFI);
+        Changed |= Saved > 0;
+      }
+
       // insert NOPs after other instructions, if necessary
       for (MachineFunction::iterator i = MF.begin(), ie = MF.end();
            i != ie; ++i)
@@ -74,6 +187,16 @@ namespace {
         }
       }
 
+      unsigned InRegion, BetweenRegions;
+      computePadding(MF, PMFI, InRegion, BetweenRegions);
+      RegionPadding += InRegion;
+      SubfunctionPadding += BetweenRegions;
+      PaddingSaved += Saved;
+
+      if (HasMethodCache && !PatmosSplitterStatsFile.empty()) {
+        writeStats(MF, InRegion, BetweenRegions, Saved);
+      }
+
       return Changed;
     }
   };
@@ -81,7 +204,158 @@ namespace {
   char PatmosEnsureAlignment::ID = 0;
 } // end of anonymous namespace
 
+void PatmosEnsureAlignment::computePadding(MachineFunction &MF,
+                                     const PatmosMachineFunctionInfo *PMFI,
+                                     unsigned &InRegion,
+                                     unsigned &BetweenRegions)
+{
+  InRegion = 0;
+  BetweenRegions = 0;
+
+  // The function start is aligned, relative offsets are sufficient.
+  unsigned Offset = 0;
+  for (MachineFunction::iterator i = MF.begin(), ie = MF.end(); i != ie; ++i)
+  {
+    unsigned Padding = getPadding(Offset, getBlockAlign(PMFI, i));
+    if (i == MF.begin() || PMFI->isMethodCacheRegionEntry(i)) {
+      // the padding is followed by the size word of the subfunction
+      BetweenRegions += Padding;
+      Offset += 4;
+    } else {
+      InRegion += Padding;
+    }
+    Offset += Padding + getBBSize(i);
+  }
+}
+
+unsigned PatmosEnsureAlignment::reorderRegion(ChainList &Chains,
+                                              unsigned StartOffset)
+{
+  // The first chain contains the region entry, the last chain might fall
+  // through to the next region. Only the chains in between can be moved.
+  if (Chains.size() < 3) return 0;
+
+  unsigned Offset = StartOffset;
+  unsigned OldPadding = 0;
+  for (unsigned i = 0, e = Chains.size(); i != e; i++) {
+    OldPadding += getChainPadding(Chains[i], Offset);
+  }
+
+  // Greedily append the chain with the smallest padding at the current
+  // offset, prefer the original order on ties.
+  ChainList Order;
+  Order.push_back(Chains.front());
+  SmallVector<bool, 16> Placed(Chains.size(), false);
+  Offset = StartOffset;
+  unsigned NewPadding = getChainPadding(Chains.front(), Offset);
+  for (unsigned n = 2, e = Chains.size(); n < e; n++) {
+    unsigned Best = 0, BestPadding = 0;
+    for (unsigned i = 1; i + 1 < e; i++) {
+      if (Placed[i]) continue;
+      unsigned End = Offset;
+      unsigned Padding = getChainPadding(Chains[i], End);
+      if (!Best || Padding < BestPadding) {
+        Best = i;
+        BestPadding = Padding;
+      }
+    }
+    Placed[Best] = true;
+    Order.push_back(Chains[Best]);
+    NewPadding += getChainPadding(Chains[Best], Offset);
+  }
+  Order.push_back(Chains.back());
+  NewPadding += getChainPadding(Chains.back(), Offset);
+
+  if (NewPadding >= OldPadding) return 0;
+
+  // Apply the new order
+  for (unsigned i = 1, e = Order.size(); i != e; i++) {
+    MachineBasicBlock *Prev = Order[i-1].Last;
+    MachineBasicBlock *MBB = Order[i].First;
+    MachineBasicBlock *End = Order[i].Last;
+    while (true) {
+      MachineBasicBlock *Next = MBB->getNextNode();
+      MBB->moveAfter(Prev);
+      if (MBB == End) break;
+      Prev = MBB;
+      MBB = Next;
+    }
+  }
+
+  return OldPadding - NewPadding;
+}
+
+unsigned PatmosEnsureAlignment::minimizePadding(MachineFunction &MF,
+                                        const PatmosMachineFunctionInfo *PMFI)
+{
+  unsigned Saved = 0;
+  unsigned Offset = 0;
+
+  ChainList Chains;
+  unsigned RegionStart = 0;
+
+  for (MachineFunction::iterator i = MF.begin(), ie = MF.end(); i != ie; )
+  {
+    MachineBasicBlock *MBB = i;
+    bool IsRegionEntry = i == MF.begin() || PMFI->isMethodCacheRegionEntry(i);
+
+    if (IsRegionEntry) {
+      // Reorder the previous region, this does not change the order of
+      // blocks we have not visited yet.
+      if (!Chains.empty()) {
+        unsigned RegionSaved = reorderRegion(Chains, RegionStart);
+        Offset -= RegionSaved;
+        Saved += RegionSaved;
+      }
+      Chains.clear();
+      Offset += getPadding(Offset, getBlockAlign(PMFI, MBB)) + 4;
+      RegionStart = Offset;
+    }
+
+    // collect a chain of blocks that may fall through to each other
+    // the entry block directly follows the size word of the region
+    Chains.push_back(Chain());
+    Chain &C = Chains.back();
+    C.First = MBB;
+    while (true) {
+      unsigned Align = (MachineBasicBlock*)i == MBB && IsRegionEntry ?
+                       1 : getBlockAlign(PMFI, i);
+      C.Blocks.push_back(std::make_pair(Align, getBBSize(i)));
+      C.Last = i;
+      ++i;
+      if (i == ie || PMFI->isMethodCacheRegionEntry(i) ||
+          !PII.mayFallthrough(*C.Last))
+        break;
+    }
+
+    getChainPadding(C, Offset);
+  }
+  if (!Chains.empty()) Saved += reorderRegion(Chains, RegionStart);
+
+  DEBUG(if (Saved) dbgs() << "[EnsureAlignment] " << MF.getName()
+                          << ": saved " << Saved << " bytes of padding\n");
+  return Saved;
+}
+
+void PatmosEnsureAlignment::writeStats(MachineFunction &MF,
+                                       unsigned InRegion,
+                                       unsigned BetweenRegions,
+                                       unsigned Saved)
+{
+  std::string err;
+  raw_fd_ostream f(PatmosSplitterStatsFile.c_str(), err, sys::fs::F_Append);
+
+  // <module>, <function>, "pad", <region padding>, <subfunction padding>,
+  // <saved padding>
+  f << "\"" << MF.getMMI().getModule()->getModuleIdentifier() << "\", ";
+  f << "\"" << MF.getName() << "\", ";
+  f << "\"pad\", ";
+  f << InRegion << ", " << BetweenRegions << ", " << Saved;
+  f << "\n";
+
+  f.close();
+}
+
 FunctionPass *llvm::createPatmosEnsureAlignmentPass(PatmosTargetMachine &tm) {
   return new PatmosEnsureAlignment(tm);
 }
-
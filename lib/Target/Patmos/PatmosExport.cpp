@@ -297,6 +297,10 @@ namespace llvm {
                                    const MachineInstr *Instr,
                                    bool BundledWithPred);
 
+    virtual void exportMemInstruction(MachineFunction &MF,
+                                      yaml::MachineInstruction *I,
+                                      const MachineInstr *Instr);
+
     /// exportArgumentRegisterMapping
     /// see below for implementation
     virtual void exportArgumentRegisterMapping(
@@ -581,6 +585,31 @@ namespace llvm {
     }
 
 
+    void PatmosMachineExport::
+    exportMemInstruction(MachineFunction &MF,
+                         yaml::MachineInstruction *I,
+                         const MachineInstr *Instr) {
+      PMLMachineExport::exportMemInstruction(MF, I, Instr);
+
+      // Predicated accesses are only performed if the guard holds, cache
+      // analyses must treat them as accesses that may not happen.
+      const PatmosInstrInfo *PII =
+        static_cast<const PatmosInstrInfo*>(TM.getInstrInfo());
+      if (!PII->isPredicated(Instr))
+        return;
+
+      int i = Instr->findFirstPredOperandIdx();
+      unsigned PReg = Instr->getOperand(i).getReg();
+      bool Negated = Instr->getOperand(i + 1).getImm();
+      if (PReg == Patmos::NoRegister)
+        PReg = Patmos::P0;
+
+      // we prefer the name of the register as is printed in assembly
+      std::string Guard = Negated ? "!" : "";
+      Guard += PatmosInstPrinter::getRegisterName(PReg);
+      I->Guard = yaml::Name(Guard);
+    }
+
     void PatmosMachineExport::exportSubfunctions(MachineFunction &MF,
                                                  yaml::MachineFunction *PMF)
     {
@@ -128,11 +128,16 @@ static cl::opt<int> PreferSCCSize(
     cl::desc("Preferred maximum size for SCC subfunctions, defaults to "
              "mpatmos-preferred-subfunction-size if 0. (default: 0)"));
 
-static cl::opt<int> MaxSubfunctionSize(
-    "mpatmos-max-subfunction-size",
-    cl::init(1024),
-    cl::desc("Maximum size of subfunctions after function splitting, defaults "
-             "to the method cache size if set to 0. (default: 1024)"));
+namespace llvm {
+  /// PatmosMaxSubfunctionSize - Maximum subfunction size, also used by
+  /// PatmosTargetTransformInfo to limit inlining and unrolling.
+  cl::opt<int> PatmosMaxSubfunctionSize(
+      "mpatmos-max-subfunction-size",
+      cl::init(1024),
+      cl::desc("Maximum size of subfunctions after function splitting, "
+               "defaults to the method cache size if set to 0. "
+               "(default: 1024)"));
+}
 
 static cl::opt<bool> SplitCallBlocks(
     "mpatmos-split-call-blocks",
@@ -146,10 +151,14 @@ static cl::opt<bool> EnableShowCFGs(
   cl::desc("Show CFGs after the Patmos function splitter."),
   cl::Hidden);
 
-static cl::opt<std::string> StatsFile(
-    "mpatmos-function-splitter-stats",
-    cl::desc("Write splitting statistics to the given file"),
-    cl::Hidden);
+namespace llvm {
+  /// PatmosSplitterStatsFile - Statistics file, also used by
+  /// PatmosEnsureAlignment to append the alignment padding of the functions.
+  cl::opt<std::string> PatmosSplitterStatsFile(
+      "mpatmos-function-splitter-stats",
+      cl::desc("Write splitting statistics to the given file"),
+      cl::Hidden);
+}
 
 static cl::opt<bool> AppendStatsFile(
     "mpatmos-function-splitter-stats-append",
@@ -2173,9 +2182,10 @@ namespace llvm {
     }
 
     virtual bool doInitialization(Module &)  {
-      if (!StatsFile.empty() && !AppendStatsFile && sys::fs::exists(StatsFile))
+      if (!PatmosSplitterStatsFile.empty() && !AppendStatsFile &&
+          sys::fs::exists(PatmosSplitterStatsFile))
       {
-        sys::fs::remove(StatsFile.c_str());
+        sys::fs::remove(PatmosSplitterStatsFile.c_str());
       }
       return false;
     }
@@ -2186,7 +2196,8 @@ namespace llvm {
       if (DisableFunctionSplitter)
         return false;
 
-      unsigned max_subfunc_size   = MaxSubfunctionSize  ? MaxSubfunctionSize
+      unsigned max_subfunc_size   = PatmosMaxSubfunctionSize ?
+                                                     PatmosMaxSubfunctionSize
                                                      : STC.getMethodCacheSize();
       max_subfunc_size = std::min(max_subfunc_size, STC.getMethodCacheSize());
 
@@ -2227,7 +2238,7 @@ namespace llvm {
       // splitting needed?
       if (total_size > prefer_subfunc_size) {
 
-        bool CollectStats = !StatsFile.empty();
+        bool CollectStats = !PatmosSplitterStatsFile.empty();
         TimeRecord Time;
 
         if (CollectStats) Time -= TimeRecord::getCurrentTime(true);
@@ -2249,7 +2260,7 @@ namespace llvm {
         if (CollectStats) {
           Time += TimeRecord::getCurrentTime(false);
 
-          writeStats(StatsFile, MF, G, order, total_size, Time);
+          writeStats(PatmosSplitterStatsFile, MF, G, order, total_size, Time);
         }
 
         SplitFunctions++;
@@ -24,6 +24,8 @@
 #include "llvm/CodeGen/MachineRegisterInfo.h"
 #include "llvm/CodeGen/PseudoSourceValue.h"
 #include "llvm/MC/MCSectionELF.h"
+#include "llvm/Support/BranchProbability.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ELF.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/TargetRegistry.h"
@@ -37,6 +39,14 @@
 
 using namespace llvm;
 
+/// IfCvtUseCriticality - Option to weight paths by their WCET criticality
+/// from PML when deciding about if-conversion.
+static cl::opt<bool> IfCvtUseCriticality("mpatmos-ifcvt-criticality",
+  cl::init(false),
+  cl::desc("Weight paths by their imported PML criticality in the "
+           "if-conversion cost model."),
+  cl::Hidden);
+
 PatmosInstrInfo::PatmosInstrInfo(PatmosTargetMachine &tm)
   : PatmosGenInstrInfo(Patmos::ADJCALLSTACKDOWN, Patmos::ADJCALLSTACKUP),
     PTM(tm), RI(tm, *this), PST(*tm.getSubtargetImpl()) {}
@@ -792,6 +802,200 @@ bool PatmosInstrInfo::mayStall(const MachineBasicBlock &MBB) const {
   return false;
 }
 
+unsigned PatmosInstrInfo::getBranchCycles(const MachineBasicBlock *MBB) const
+{
+  unsigned Delay = PST.getCFLDelaySlotCycles(true);
+
+  // Non-delayed branches always stall for the delay slot cycles.
+  if (!MBB || PST.getCFLType() == PatmosSubtarget::CFL_NON_DELAYED)
+    return 1 + Delay;
+
+  // Registers the branch depends on, their definitions cannot be moved into
+  // the delay slots.
+  SmallSet<unsigned, 16> BranchDeps;
+  MachineBasicBlock::const_iterator I = MBB->getFirstTerminator();
+  for (MachineBasicBlock::const_iterator T = I; T != MBB->end(); ++T) {
+    for (unsigned i = 0; i < T->getNumOperands(); i++) {
+      const MachineOperand &MO = T->getOperand(i);
+      if (MO.isReg() && MO.isUse() && MO.getReg())
+        BranchDeps.insert(MO.getReg());
+    }
+  }
+
+  // Estimate the number of delay slot cycles the scheduler can fill with
+  // instructions preceding the branch; unfilled slots are wasted in any CFL
+  // mode, either as NOPs or as stall cycles of non-delayed branches.
+  unsigned Filled = 0;
+  while (I != MBB->begin() && Filled < Delay) {
+    --I;
+    if (isPseudo(I)) continue;
+    if (I->isCall() || I->isInlineAsm() || I->hasUnmodeledSideEffects())
+      break;
+
+    bool IsBranchDep = false;
+    for (unsigned i = 0; i < I->getNumOperands(); i++) {
+      const MachineOperand &MO = I->getOperand(i);
+      if (MO.isReg() && MO.isDef() && BranchDeps.count(MO.getReg()))
+        IsBranchDep = true;
+    }
+    if (!IsBranchDep) {
+      Filled++;
+      continue;
+    }
+
+    for (unsigned i = 0; i < I->getNumOperands(); i++) {
+      const MachineOperand &MO = I->getOperand(i);
+      if (MO.isReg() && MO.isUse() && MO.getReg())
+        BranchDeps.insert(MO.getReg());
+    }
+  }
+
+  return 1 + Delay - Filled;
+}
+
+unsigned
+PatmosInstrInfo::getDualIssueCycles(const MachineBasicBlock &MBB) const
+{
+  if (!PST.enableBundling(PTM.getOptLevel()))
+    return 0;
+
+  // Greedily pair each instruction with its successor if the successor can be
+  // issued in the second slot and does not depend on the first instruction.
+  unsigned Pairs = 0;
+  const MachineInstr *First = 0;
+  for (MachineBasicBlock::const_iterator I = MBB.begin(),
+       E = MBB.getFirstTerminator(); I != E; ++I)
+  {
+    if (isPseudo(I)) continue;
+
+    if (First && getIssueWidth(I) == 1 && canIssueInSlot(I, 1)) {
+      bool Depends = false;
+      for (unsigned i = 0; i < First->getNumOperands(); i++) {
+        const MachineOperand &MO = First->getOperand(i);
+        if (MO.isReg() && MO.isDef() && MO.getReg() &&
+            (I->readsRegister(MO.getReg(), &RI) ||
+             I->modifiesRegister(MO.getReg(), &RI)))
+        {
+          Depends = true;
+        }
+      }
+      if (!Depends) {
+        Pairs++;
+        First = 0;
+        continue;
+      }
+    }
+
+    First = getIssueWidth(I) == 1 ? &*I : 0;
+  }
+
+  return Pairs;
+}
+
+double PatmosInstrInfo::getPathWeight(MachineBasicBlock &MBB,
+                                   const BranchProbability &Probability) const
+{
+  double Weight = (double)Probability.getNumerator() /
+                  Probability.getDenominator();
+
+  if (IfCvtUseCriticality) {
+    PatmosMachineFunctionInfo *PMFI =
+                           MBB.getParent()->getInfo<PatmosMachineFunctionInfo>();
+    double Criticality = PMFI->getAnalysisInfo().getCriticality(&MBB);
+    // A block on the worst-case path is always executed in the WCET bound.
+    if (Criticality > Weight)
+      Weight = Criticality;
+  }
+
+  return Weight;
+}
+
+bool PatmosInstrInfo::isProfitableToIfCvt(MachineBasicBlock &MBB,
+                                   unsigned NumCycles, unsigned ExtraPredCycles,
+                                   const BranchProbability &Probability) const
+{
+  const MCInstrDesc &MCID = prior(MBB.end())->getDesc();
+  if (MCID.isReturn() || MCID.isCall())
+    return false;
+
+  // Predicated memory accesses are exported with their guard to PML, but
+  // we do not predicate code that may fill the method cache.
+  if (mayFillMethodCache(MBB))
+    return false;
+
+  // The branch into MBB is placed at the end of its single predecessor.
+  const MachineBasicBlock *Head = MBB.pred_size() == 1 ? *MBB.pred_begin() : 0;
+
+  unsigned Cycles = NumCycles - std::min(NumCycles, getDualIssueCycles(MBB));
+
+  double Branched = getBranchCycles(Head) +
+                    getPathWeight(MBB, Probability) * Cycles;
+  double Predicated = Cycles + ExtraPredCycles;
+
+  return Predicated <= Branched;
+}
+
+bool PatmosInstrInfo::isProfitableToIfCvt(MachineBasicBlock &TMBB,
+                                   unsigned NumTCycles, unsigned ExtraTCycles,
+                                   MachineBasicBlock &FMBB,
+                                   unsigned NumFCycles, unsigned ExtraFCycles,
+                                   const BranchProbability &Probability) const
+{
+  const MCInstrDesc &TMCID = prior(TMBB.end())->getDesc();
+  if (TMCID.isReturn() || TMCID.isCall())
+    return false;
+  const MCInstrDesc &FMCID = prior(FMBB.end())->getDesc();
+  if (FMCID.isReturn() || FMCID.isCall())
+    return false;
+
+  // Predicated memory accesses are exported with their guard to PML, but
+  // we do not predicate code that may fill the method cache.
+  if (mayFillMethodCache(TMBB) || mayFillMethodCache(FMBB))
+    return false;
+
+  const MachineBasicBlock *Head = TMBB.pred_size() == 1 ?
+                                  *TMBB.pred_begin() : 0;
+
+  unsigned TCycles = NumTCycles - std::min(NumTCycles,
+                                           getDualIssueCycles(TMBB));
+  unsigned FCycles = NumFCycles - std::min(NumFCycles,
+                                           getDualIssueCycles(FMBB));
+
+  // One of the paths needs a branch over the other path to the join block.
+  double Branched = getBranchCycles(Head) +
+       getPathWeight(TMBB, Probability) * (TCycles + getBranchCycles(&TMBB)) +
+       getPathWeight(FMBB, Probability.getCompl()) * FCycles;
+  double Predicated = TCycles + ExtraTCycles + FCycles + ExtraFCycles;
+
+  return Predicated <= Branched;
+}
+
+bool PatmosInstrInfo::isProfitableToDupForIfCvt(MachineBasicBlock &MBB,
+                                   unsigned NumCycles,
+                                   const BranchProbability &Probability) const
+{
+  const MCInstrDesc &MCID = prior(MBB.end())->getDesc();
+  if (MCID.isReturn() || MCID.isCall())
+    return false;
+
+  // The duplicated instructions are executed on both paths, this must not
+  // cost more than the branch that is removed.
+  return NumCycles <= getBranchCycles(0);
+}
+
+bool PatmosInstrInfo::mayFillMethodCache(const MachineBasicBlock &MBB) const {
+  for (MachineBasicBlock::const_instr_iterator it = MBB.instr_begin(),
+       ie = MBB.instr_end(); it != ie; it++)
+  {
+    if (it->isBundle() || it->isInlineAsm()) continue;
+    // All stalling instructions besides data accesses are calls, returns
+    // and branches with cache fill.
+    if (mayStall(it) && !it->mayLoad() && !it->mayStore())
+      return true;
+  }
+  return false;
+}
+
 bool PatmosInstrInfo::canRemoveFromSchedule(MachineBasicBlock &MBB,
                                     const MachineBasicBlock::iterator &II) const
 {
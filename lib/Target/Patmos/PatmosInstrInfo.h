@@ -275,6 +275,11 @@ public:
   /// miss and stall the CPU. Not checking for instruction fetch related stalls.
   bool mayStall(const MachineBasicBlock &MBB) const;
 
+  /// mayFillMethodCache - return true if the MBB contains instructions that
+  /// might stall due to a method cache fill, i.e., calls, returns or
+  /// branches with cache fill.
+  bool mayFillMethodCache(const MachineBasicBlock &MBB) const;
+
   /// canRemoveFromSchedule - check if the given instruction can be removed
   /// without creating any hazards to surrounding instructions.
   bool canRemoveFromSchedule(MachineBasicBlock &MBB,
@@ -414,18 +419,7 @@ public:
   virtual
   bool isProfitableToIfCvt(MachineBasicBlock &MBB, unsigned NumCycles,
                            unsigned ExtraPredCycles,
-                           const BranchProbability &Probability) const {
-
-    const MCInstrDesc &MCID = prior(MBB.end())->getDesc();
-    if (MCID.isReturn() || MCID.isCall())
-      return false;
-    if (NumCycles > 8)
-      return false;
-
-    // We do not handle predicated instructions that may stall the pipeline
-    // properly in the cache analyses, so we do not convert them for now.
-    return !mayStall(MBB);
-  }
+                           const BranchProbability &Probability) const;
 
   /// isProfitableToIfCvt - Second variant of isProfitableToIfCvt, this one
   /// checks for the case where two basic blocks from true and false path
@@ -438,20 +432,7 @@ public:
                       unsigned NumTCycles, unsigned ExtraTCycles,
                       MachineBasicBlock &FMBB,
                       unsigned NumFCycles, unsigned ExtraFCycles,
-                      const BranchProbability &Probability) const {
-    const MCInstrDesc &TMCID = prior(TMBB.end())->getDesc();
-    if (TMCID.isReturn() || TMCID.isCall())
-      return false;
-    const MCInstrDesc &FMCID = prior(FMBB.end())->getDesc();
-    if (FMCID.isReturn() || FMCID.isCall())
-      return false;
-    if ((NumTCycles + NumFCycles) > 16)
-      return false;
-
-    // We do not handle predicated instructions that may stall the pipeline
-    // properly in the cache analyses, so we do not convert them for now.
-    return !mayStall(TMBB) && !mayStall(FMBB);
-  }
+                      const BranchProbability &Probability) const;
 
   /// isProfitableToDupForIfCvt - Return true if it's profitable for
   /// if-converter to duplicate instructions of specified accumulated
@@ -461,12 +442,25 @@ public:
   /// will be properly predicted.
   virtual bool
   isProfitableToDupForIfCvt(MachineBasicBlock &MBB, unsigned NumCycles,
-                            const BranchProbability &Probability) const {
-    const MCInstrDesc &MCID = prior(MBB.end())->getDesc();
-    if (MCID.isReturn() || MCID.isCall())
-      return false;
-    return NumCycles <= 4;
-  }
+                            const BranchProbability &Probability) const;
+
+private:
+
+  /// getBranchCycles - Get the number of cycles a local branch at the end of
+  /// MBB costs, including the delay slots that cannot be filled with
+  /// instructions from MBB. If MBB is null, no delay slot is filled.
+  unsigned getBranchCycles(const MachineBasicBlock *MBB) const;
+
+  /// getDualIssueCycles - Get the number of cycles saved by issuing
+  /// independent instructions of MBB in the second slot.
+  unsigned getDualIssueCycles(const MachineBasicBlock &MBB) const;
+
+  /// getPathWeight - Get the weight of the execution time of MBB when
+  /// comparing branching and predicated code, i.e., the probability that
+  /// MBB is executed, or its WCET criticality if that is higher and
+  /// criticalities should be used.
+  double getPathWeight(MachineBasicBlock &MBB,
+                       const BranchProbability &Probability) const;
 
 }; // PatmosInstrInfo
 
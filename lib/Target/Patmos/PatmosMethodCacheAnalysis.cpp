@@ -0,0 +1,377 @@
+//===-- PatmosMethodCacheAnalysis.cpp - Method cache miss prediction ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass predicts the number of method cache misses of the program after
+// the function splitter has formed the method cache regions (subfunctions).
+//
+// The method cache is simulated as a FIFO cache over variable-sized regions,
+// on an abstract execution trace along the worst-case path starting at the
+// program entry. Blocks that are not executed on the worst-case path (i.e.,
+// that have an imported frequency of zero) are skipped. Every loop is
+// simulated for its average number of iterations per entry, as derived from
+// the imported block frequencies (e.g., the WCET frequencies), or for a fixed
+// number of iterations if no frequency is known. Recursive calls are not
+// followed.
+//
+// The FIFO method cache allocates regions by their size only, so the result
+// does not depend on the placement of the functions and subfunctions.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "patmos-method-cache-analysis"
+
+#include "Patmos.h"
+#include "PatmosCallGraphBuilder.h"
+#include "PatmosInstrInfo.h"
+#include "PatmosMachineFunctionInfo.h"
+#include "PatmosTargetMachine.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/CodeGen/MachineDominators.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineLoopInfo.h"
+#include "llvm/CodeGen/MachineModuleInfo.h"
+#include "llvm/CodeGen/MachineModulePass.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <deque>
+
+using namespace llvm;
+
+STATISTIC(NumAccesses, "Simulated method cache accesses");
+STATISTIC(NumMisses,   "Predicted method cache misses");
+
+static cl::opt<unsigned> LoopIterations(
+  "mpatmos-mc-loop-iterations",
+  cl::init(10),
+  cl::desc("Iterations of loops without frequency information in the method "
+           "cache miss prediction (default: 10)"),
+  cl::Hidden);
+
+static cl::opt<unsigned> MaxTraceLength(
+  "mpatmos-mc-max-trace",
+  cl::init(1 << 20),
+  cl::desc("Maximum number of subfunction accesses simulated to predict "
+           "method cache misses (default: 1M)"),
+  cl::Hidden);
+
+namespace {
+
+  /// An element of a function or loop body, either a basic block or a
+  /// nested loop.
+  struct ScopeItem {
+    MachineBasicBlock *MBB;
+    MachineLoop *Loop;
+  };
+
+  typedef std::vector<ScopeItem> ScopeItems;
+
+  /// The loop nest of a function, with the bodies in reverse post order.
+  struct FunctionScopes {
+    LoopInfoBase<MachineBasicBlock, MachineLoop> LI;
+    ScopeItems Body;
+    DenseMap<const MachineLoop*, ScopeItems> LoopBodies;
+    DenseMap<const MachineLoop*, uint64_t> Iterations;
+  };
+
+  class PatmosMethodCacheAnalysis : public MachineModulePass {
+  private:
+    const PatmosTargetMachine &PTM;
+
+    const PatmosInstrInfo &PII;
+
+    /// The sizes of all method cache regions.
+    std::vector<unsigned> RegionSizes;
+
+    /// The region of each basic block.
+    DenseMap<const MachineBasicBlock*, unsigned> BlockRegion;
+
+    /// The loop nests of the simulated functions.
+    DenseMap<const MachineFunction*, FunctionScopes*> Scopes;
+
+    /// FIFO method cache state.
+    std::deque<unsigned> Cache;
+    BitVector Cached;
+    unsigned CacheFill;
+    uint64_t Accesses;
+    uint64_t Misses;
+    bool Truncated;
+
+    /// getBlockSize - Return the code size of a basic block.
+    unsigned getBlockSize(const MachineBasicBlock *MBB) const {
+      unsigned Size = 0;
+      for (MachineBasicBlock::const_instr_iterator I = MBB->instr_begin(),
+           E = MBB->instr_end(); I != E; ++I)
+        Size += PII.getInstrSize(I);
+      return Size;
+    }
+
+    /// getFrequency - Return the imported frequency of a block, or -1 if the
+    /// frequency is unknown.
+    static int64_t getFrequency(MachineBasicBlock *MBB) {
+      PatmosMachineFunctionInfo *PMFI =
+        MBB->getParent()->getInfo<PatmosMachineFunctionInfo>();
+      return PMFI->getAnalysisInfo().getFrequency(MBB);
+    }
+
+    /// collectRegions - Split the function into its method cache regions.
+    void collectRegions(MachineFunction *MF);
+
+    /// getScopes - Return the loop nest of a function.
+    FunctionScopes &getScopes(MachineFunction *MF);
+
+    /// getIterations - Return the number of iterations per entry of a loop.
+    uint64_t getIterations(MachineLoop *L) const;
+
+    /// access - Access a region in the simulated method cache.
+    void access(unsigned R);
+
+    void simulateFunction(MCGNode *N, SmallPtrSet<MCGNode*, 16> &Active);
+
+    void simulateScope(const ScopeItems &Items, uint64_t Iterations,
+                       FunctionScopes &FS, MCGNode *N, unsigned &Current,
+                       SmallPtrSet<MCGNode*, 16> &Active);
+
+    void simulateBlock(MachineBasicBlock *MBB, MCGNode *N, unsigned &Current,
+                       SmallPtrSet<MCGNode*, 16> &Active);
+
+  public:
+    static char ID;
+
+    PatmosMethodCacheAnalysis(const PatmosTargetMachine &tm)
+      : MachineModulePass(ID), PTM(tm), PII(*tm.getInstrInfo()),
+        CacheFill(0), Accesses(0), Misses(0), Truncated(false)
+    {
+      initializePatmosCallGraphBuilderPass(*PassRegistry::getPassRegistry());
+    }
+
+    virtual const char *getPassName() const {
+      return "Patmos Method Cache Analysis";
+    }
+
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+      AU.addRequired<MachineModuleInfo>();
+      AU.addRequired<PatmosCallGraphBuilder>();
+      AU.setPreservesAll();
+      MachineModulePass::getAnalysisUsage(AU);
+    }
+
+    virtual bool runOnMachineModule(const Module &M);
+  };
+
+  char PatmosMethodCacheAnalysis::ID = 0;
+}
+
+ModulePass *llvm::createPatmosMethodCacheAnalysisPass(
+                                               const PatmosTargetMachine &tm) {
+  return new PatmosMethodCacheAnalysis(tm);
+}
+
+void PatmosMethodCacheAnalysis::collectRegions(MachineFunction *MF) {
+  PatmosMachineFunctionInfo *PMFI = MF->getInfo<PatmosMachineFunctionInfo>();
+
+  for (MachineFunction::iterator I = MF->begin(), E = MF->end(); I != E; ++I) {
+    if (I == MF->begin() || PMFI->isMethodCacheRegionEntry(I))
+      RegionSizes.push_back(0);
+    RegionSizes.back() += getBlockSize(I);
+    BlockRegion[I] = RegionSizes.size() - 1;
+  }
+}
+
+FunctionScopes &PatmosMethodCacheAnalysis::getScopes(MachineFunction *MF) {
+  FunctionScopes *&FS = Scopes[MF];
+  if (FS)
+    return *FS;
+
+  FS = new FunctionScopes();
+  MachineDominatorTree MDT;
+  MDT.runOnMachineFunction(*MF);
+  FS->LI.Analyze(MDT.getBase());
+
+  // Every block goes to the body of its innermost loop, every loop to the
+  // body of its parent, at the position of its header.
+  ReversePostOrderTraversal<MachineFunction*> RPOT(MF);
+  for (ReversePostOrderTraversal<MachineFunction*>::rpo_iterator
+       I = RPOT.begin(), E = RPOT.end(); I != E; ++I) {
+    MachineBasicBlock *MBB = *I;
+    MachineLoop *L = FS->LI.getLoopFor(MBB);
+    ScopeItem Item = { MBB, 0 };
+    if (L && L->getHeader() == MBB) {
+      FS->LoopBodies[L].push_back(Item);
+      FS->Iterations[L] = getIterations(L);
+      Item.MBB = 0;
+      Item.Loop = L;
+      L = L->getParentLoop();
+    }
+    (L ? FS->LoopBodies[L] : FS->Body).push_back(Item);
+  }
+  return *FS;
+}
+
+uint64_t PatmosMethodCacheAnalysis::getIterations(MachineLoop *L) const {
+  MachineBasicBlock *Header = L->getHeader();
+  int64_t HeaderFreq = getFrequency(Header);
+  if (HeaderFreq < 0)
+    return LoopIterations;
+
+  // The frequencies are summed up over all entries of the loop
+  int64_t Entries = 0;
+  for (MachineBasicBlock::pred_iterator P = Header->pred_begin(),
+       PE = Header->pred_end(); P != PE; ++P) {
+    if (L->contains(*P))
+      continue;
+    int64_t Freq = getFrequency(*P);
+    if (Freq < 0)
+      return LoopIterations;
+    Entries += Freq;
+  }
+  Entries = std::min(Entries, HeaderFreq);
+  if (Entries == 0)
+    return 1;
+  return std::max<int64_t>((HeaderFreq + Entries - 1) / Entries, 1);
+}
+
+void PatmosMethodCacheAnalysis::access(unsigned R) {
+  Accesses++;
+  if (Cached.test(R))
+    return;
+
+  Misses++;
+  Cache.push_back(R);
+  Cached.set(R);
+  CacheFill += RegionSizes[R];
+  unsigned CacheSize = PTM.getSubtargetImpl()->getMethodCacheSize();
+  while (CacheFill > CacheSize && Cache.size() > 1) {
+    CacheFill -= RegionSizes[Cache.front()];
+    Cached.reset(Cache.front());
+    Cache.pop_front();
+  }
+}
+
+void PatmosMethodCacheAnalysis::simulateBlock(MachineBasicBlock *MBB,
+                                              MCGNode *N, unsigned &Current,
+                                              SmallPtrSet<MCGNode*, 16> &Active)
+{
+  // Skip blocks that are not on the worst-case path
+  if (getFrequency(MBB) == 0)
+    return;
+
+  if (BlockRegion[MBB] != Current) {
+    Current = BlockRegion[MBB];
+    access(Current);
+  }
+
+  for (MachineBasicBlock::instr_iterator MI = MBB->instr_begin(),
+       ME = MBB->instr_end(); MI != ME; ++MI) {
+    if (!MI->isCall())
+      continue;
+    MCGSite *Site = N->findSite(MI);
+    if (!Site || Site->getCallee()->isUnknown() ||
+        Active.count(Site->getCallee()))
+      continue;
+
+    simulateFunction(Site->getCallee(), Active);
+    // The return reloads the caller's region
+    access(Current);
+  }
+}
+
+void PatmosMethodCacheAnalysis::simulateScope(const ScopeItems &Items,
+                                              uint64_t Iterations,
+                                              FunctionScopes &FS, MCGNode *N,
+                                              unsigned &Current,
+                                              SmallPtrSet<MCGNode*, 16> &Active)
+{
+  for (uint64_t i = 0; i != Iterations; ++i) {
+    if (Accesses >= MaxTraceLength) {
+      Truncated = true;
+      return;
+    }
+
+    std::deque<unsigned> CacheBefore(Cache);
+    unsigned CurrentBefore = Current;
+    uint64_t AccessesBefore = Accesses;
+    uint64_t MissesBefore = Misses;
+
+    for (unsigned j = 0, je = Items.size(); j != je; ++j) {
+      if (Items[j].Loop)
+        simulateScope(FS.LoopBodies[Items[j].Loop],
+                      FS.Iterations[Items[j].Loop], FS, N, Current, Active);
+      else
+        simulateBlock(Items[j].MBB, N, Current, Active);
+    }
+
+    // The FIFO cache only changes on misses, so once an iteration leaves the
+    // cache as it found it, all remaining iterations behave the same way.
+    if (!Truncated && Current == CurrentBefore && Cache == CacheBefore) {
+      uint64_t Remaining = Iterations - i - 1;
+      Accesses += Remaining * (Accesses - AccessesBefore);
+      Misses += Remaining * (Misses - MissesBefore);
+      return;
+    }
+  }
+}
+
+void PatmosMethodCacheAnalysis::simulateFunction(MCGNode *N,
+                                             SmallPtrSet<MCGNode*, 16> &Active)
+{
+  MachineFunction *MF = N->getMF();
+  FunctionScopes &FS = getScopes(MF);
+  Active.insert(N);
+
+  unsigned Current = BlockRegion[&MF->front()];
+  access(Current);
+  simulateScope(FS.Body, 1, FS, N, Current, Active);
+
+  Active.erase(N);
+}
+
+bool PatmosMethodCacheAnalysis::runOnMachineModule(const Module &M) {
+  MachineModuleInfo &MMI = getAnalysis<MachineModuleInfo>();
+  MCallGraph &MCG = *getAnalysis<PatmosCallGraphBuilder>().getCallGraph();
+
+  for (Module::const_iterator F = M.begin(), FE = M.end(); F != FE; ++F) {
+    if (MachineFunction *MF = MMI.getMachineFunction(F))
+      collectRegions(MF);
+  }
+
+  Cached.resize(RegionSizes.size());
+
+  MCGNode *Entry = MCG.getEntryNode();
+  if (!Entry)
+    Entry = MCG.getNode("main");
+  if (Entry && !Entry->isUnknown()) {
+    SmallPtrSet<MCGNode*, 16> Active;
+    simulateFunction(Entry, Active);
+
+    DEBUG(dbgs() << "Method cache: " << Misses << " misses in " << Accesses
+                 << " subfunction accesses"
+                 << (Truncated ? " (trace truncated)" : "") << "\n");
+    NumAccesses += Accesses;
+    NumMisses += Misses;
+  }
+
+  DeleteContainerSeconds(Scopes);
+  RegionSizes.clear();
+  BlockRegion.clear();
+  Cache.clear();
+  Cached.clear();
+  CacheFill = 0;
+  Accesses = 0;
+  Misses = 0;
+  Truncated = false;
+  return false;
+}
@@ -24,6 +24,7 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
 #include <map>
 #include <set>
 #include <cmath>
@@ -87,6 +88,7 @@ bool PatmosPMLProfileImport::runOnMachineFunction(MachineFunction &MF)
   if (!PI.isAvailable()) return false;
 
   PI.loadCriticalityMap();
+  PI.loadFrequencyMap();
 
   PatmosMachineFunctionInfo &PMFI = *MF.getInfo<PatmosMachineFunctionInfo>();
   PatmosAnalysisInfo &PAI = PMFI.getAnalysisInfo();
@@ -94,6 +96,21 @@ bool PatmosPMLProfileImport::runOnMachineFunction(MachineFunction &MF)
   MachineBranchProbabilityInfo &MBPI =
                                 getAnalysis<MachineBranchProbabilityInfo>();
 
+  // Observed edge frequencies (e.g., from edge profiling) replace the
+  // criticalities and WCET frequencies as edge weights. Scale them down so
+  // that they fit into the 32 bit edge weights.
+  bool UseObservedFreq = PI.hasFrequencies();
+  uint64_t MaxFreq = 0;
+  if (UseObservedFreq) {
+    for (MachineFunction::iterator it = MF.begin(), ie = MF.end(); it != ie;
+         it++)
+    {
+      MaxFreq = std::max(MaxFreq, (uint64_t)std::max(PI.getFrequency(&*it),
+                                                     (int64_t)0));
+    }
+  }
+  uint64_t FreqScale = MaxFreq / (UINT32_MAX / 2) + 1;
+
   for (MachineFunction::iterator it = MF.begin(), ie = MF.end(); it != ie; it++)
   {
     MachineBasicBlock *MBB = &*it;
@@ -101,8 +118,9 @@ bool PatmosPMLProfileImport::runOnMachineFunction(MachineFunction &MF)
     double Crit = PI.getCriticalty(MBB);
     PAI.setCriticality(MBB, Crit);
 
-    uint64_t Freq = PI.getWCETFrequency(MBB);
-    PAI.setFrequency(MBB, Freq);
+    int64_t Freq = PI.getWCETFrequency(MBB);
+    if (Freq >= 0)
+      PAI.setFrequency(MBB, Freq);
 
     /// Set edge probabilities based on frequency or criticality of edges
     for (MachineBasicBlock::succ_iterator succ = MBB->succ_begin(),
@@ -111,7 +129,16 @@ bool PatmosPMLProfileImport::runOnMachineFunction(MachineFunction &MF)
       MachineBasicBlock *ToMBB = *succ;
 
       uint32_t Weight;
-      if (UseCritEdgeWeight) {
+      int64_t ObservedFreq = -1;
+      if (UseObservedFreq) {
+        ObservedFreq = PI.getFrequency(MBB, ToMBB, -1);
+      }
+
+      if (ObservedFreq >= 0) {
+        // Never-taken edges still get a tiny weight, a zero weight is treated
+        // as unknown by the branch probability info.
+        Weight = std::max(ObservedFreq / FreqScale, (uint64_t)1);
+      } else if (UseCritEdgeWeight) {
         Weight = round(PI.getCriticalty(MBB, ToMBB, 1.0) * 10000.0);
       } else {
         Weight = PI.getWCETFrequency(MBB, ToMBB, 0);
@@ -0,0 +1,366 @@
+//===-- PatmosSPSelect.cpp - Select functions for single-path code --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass selects single-path roots automatically, if enabled with
+// -mpatmos-singlepath-auto. Selected functions are marked with the "sp-root"
+// attribute and are converted by the following single-path passes. The pass
+// runs whenever single-path code is generated; without
+// -mpatmos-singlepath-auto, the candidates are only counted and reported.
+//
+// A function is selected if its control flow mostly does not depend on input
+// data, according to the InputDependenceAnalysis, and if the estimated
+// overhead of executing all of its code is low. The estimate compares the
+// instructions of the function (and of its callees, which are converted as
+// well) with the instructions on the longest acyclic path through it. Loop
+// bounds are unknown at this point, so each block is counted once.
+//
+// Functions that cannot be converted are never selected, i.e., functions
+// that (transitively) contain indirect or recursive calls or call functions
+// not defined in the module.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "patmos-singlepath"
+
+#include "Patmos.h"
+#include "PatmosSinglePathInfo.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/InputDependenceAnalysis.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InlineAsm.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/Support/CFG.h"
+#include "llvm/Support/CallSite.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+STATISTIC(NumSPSelected, "Number of functions selected for single-path code");
+STATISTIC(NumSPCandidates, "Number of functions considered for single-path "
+                           "code");
+
+static cl::opt<unsigned> MaxInputDependent(
+    "mpatmos-singlepath-auto-max-input-dep",
+    cl::init(50),
+    cl::desc("Maximum percentage of input-dependent branches of functions "
+             "selected for single-path code (default: 50)"),
+    cl::Hidden);
+
+static cl::opt<unsigned> MaxOverhead(
+    "mpatmos-singlepath-auto-max-overhead",
+    cl::init(25),
+    cl::desc("Maximum estimated overhead in percent of functions selected "
+             "for single-path code (default: 25)"),
+    cl::Hidden);
+
+static cl::opt<std::string> ReportFile(
+    "mpatmos-singlepath-auto-report",
+    cl::desc("Write the selected single-path functions and their estimated "
+             "overhead to the given file"),
+    cl::Hidden);
+
+namespace {
+
+class PatmosSPSelect : public ModulePass {
+private:
+
+  /// Information about a function, including its callees.
+  struct FunctionInfo {
+    enum StateType { Unvisited, Visiting, Done };
+
+    StateType State;
+
+    /// Reason why the function cannot be converted, or null.
+    const char *NotConvertible;
+
+    /// Number of conditional branches in the function.
+    unsigned Branches;
+
+    /// Number of conditional branches depending on input data.
+    unsigned InputDependent;
+
+    /// Instructions on the longest acyclic path, including callees.
+    uint64_t PathCost;
+
+    /// Instructions executed by the single-path version, including callees.
+    uint64_t SPCost;
+
+    FunctionInfo() : State(Unvisited), NotConvertible(0), Branches(0),
+                     InputDependent(0), PathCost(0), SPCost(0) {}
+
+    unsigned getOverhead() const {
+      if (!PathCost) return 0;
+      return (unsigned)((SPCost - PathCost) * 100 / PathCost);
+    }
+  };
+
+  typedef DenseMap<const Function*, FunctionInfo> FunctionInfoMap;
+
+  FunctionInfoMap Infos;
+
+  /// analyze - Compute the information of a function and its callees.
+  FunctionInfo &analyze(Function *F);
+
+  /// countBranches - Count the (input-dependent) conditional branches.
+  void countBranches(Function *F, unsigned &Branches,
+                     unsigned &InputDependent);
+
+  /// computeCosts - Compute the path and single-path costs of a function,
+  /// the callees must have been analyzed before.
+  void computeCosts(Function *F, FunctionInfo &FI);
+
+  /// isSelected - Check the selection criteria, set Reason if not selected.
+  bool isSelected(const FunctionInfo &FI, const char *&Reason) const;
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+
+  PatmosSPSelect() : ModulePass(ID) {
+    initializeInputDependenceAnalysisPass(*PassRegistry::getPassRegistry());
+  }
+
+  /// getPassName - Return the pass' name.
+  virtual const char *getPassName() const {
+    return "Patmos Single-Path Select (bitcode)";
+  }
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+    AU.addRequired<InputDependenceAnalysis>();
+  }
+
+  virtual bool runOnModule(Module &M);
+};
+
+} // end anonymous namespace
+
+char PatmosSPSelect::ID = 0;
+
+ModulePass *llvm::createPatmosSPSelectPass() {
+  return new PatmosSPSelect();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool PatmosSPSelect::runOnModule(Module &M) {
+  DEBUG( dbgs() << "[Single-Path] Select functions for single-path code\n" );
+
+  OwningPtr<raw_fd_ostream> Report;
+  if (!ReportFile.empty()) {
+    std::string ErrorInfo;
+    Report.reset(new raw_fd_ostream(ReportFile.c_str(), ErrorInfo,
+                                    sys::fs::F_None));
+    if (!ErrorInfo.empty()) {
+      errs() << "Error opening '" << ReportFile << "': " << ErrorInfo << "\n";
+      Report.reset();
+    } else {
+      // <function>, <branches>, <input-dependent branches>, <path cost>,
+      // <single-path cost>, <overhead %>, <decision>
+      *Report << "\"function\", \"branches\", \"input-dependent\", "
+                 "\"path-cost\", \"sp-cost\", \"overhead\", \"decision\"\n";
+    }
+  }
+
+  bool Changed = false;
+  for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I) {
+    Function *F = I;
+    if (F->isDeclaration() || F->hasFnAttribute("sp-root"))
+      continue;
+
+    NumSPCandidates++;
+
+    FunctionInfo &FI = analyze(F);
+
+    const char *Reason = 0;
+    bool Selected = isSelected(FI, Reason);
+
+    DEBUG( dbgs() << "  " << F->getName() << ": " << FI.InputDependent << "/"
+                  << FI.Branches << " input-dependent branches, overhead "
+                  << FI.getOverhead() << "%, "
+                  << (Selected ? "selected" : Reason) << "\n" );
+
+    if (Report) {
+      *Report << "\"" << F->getName() << "\", " << FI.Branches << ", "
+              << FI.InputDependent << ", " << FI.PathCost << ", "
+              << FI.SPCost << ", " << FI.getOverhead() << ", \""
+              << (Selected ? "selected" : Reason) << "\"\n";
+    }
+
+    if (Selected) {
+      NumSPSelected++;
+      if (PatmosSinglePathInfo::isAutoSelect()) {
+        F->addFnAttr("sp-root");
+        Changed = true;
+      }
+    }
+  }
+
+  Infos.clear();
+  return Changed;
+}
+
+bool PatmosSPSelect::isSelected(const FunctionInfo &FI,
+                                const char *&Reason) const {
+  if (FI.NotConvertible) {
+    Reason = FI.NotConvertible;
+    return false;
+  }
+  // Functions without input-dependent branches have a single path anyway
+  if (FI.InputDependent == 0) {
+    Reason = "no input-dependent branches";
+    return false;
+  }
+  if (FI.InputDependent * 100 > FI.Branches * MaxInputDependent) {
+    Reason = "too many input-dependent branches";
+    return false;
+  }
+  if (FI.getOverhead() > MaxOverhead) {
+    Reason = "overhead too high";
+    return false;
+  }
+  return true;
+}
+
+PatmosSPSelect::FunctionInfo &PatmosSPSelect::analyze(Function *F) {
+  if (Infos[F].State != FunctionInfo::Unvisited)
+    return Infos[F];
+
+  // The map grows while the callees are analyzed, do not keep references to
+  // its entries until all callees are done.
+  Infos[F].State = FunctionInfo::Visiting;
+
+  const char *NotConvertible = 0;
+  if (F->isVarArg())
+    NotConvertible = "variadic function";
+
+  // Count the branches before analyzing the callees, which requires the
+  // input dependence of other functions.
+  unsigned Branches, InputDependent;
+  countBranches(F, Branches, InputDependent);
+
+  for (Function::iterator BB = F->begin(), BE = F->end(); BB != BE; ++BB) {
+    for (BasicBlock::iterator I = BB->begin(), IE = BB->end(); I != IE; ++I) {
+      CallSite CS(I);
+      if (!CS || isa<IntrinsicInst>(I) || isa<InlineAsm>(CS.getCalledValue()))
+        continue;
+
+      Function *Callee = CS.getCalledFunction();
+      if (!Callee) {
+        NotConvertible = "indirect call";
+        continue;
+      }
+      if (Callee->isDeclaration()) {
+        NotConvertible = "calls external function";
+        continue;
+      }
+
+      if (Infos[Callee].State == FunctionInfo::Visiting) {
+        NotConvertible = "recursive call";
+        continue;
+      }
+      if (analyze(Callee).NotConvertible && !NotConvertible)
+        NotConvertible = "calls non-convertible function";
+    }
+  }
+
+  FunctionInfo &FI = Infos[F];
+  FI.NotConvertible = NotConvertible;
+  FI.Branches = Branches;
+  FI.InputDependent = InputDependent;
+  computeCosts(F, FI);
+  FI.State = FunctionInfo::Done;
+  return FI;
+}
+
+void PatmosSPSelect::countBranches(Function *F, unsigned &Branches,
+                                   unsigned &InputDependent) {
+  InputDependenceInfo &IDI =
+    getAnalysis<InputDependenceAnalysis>().getInfo(*F);
+
+  Branches = InputDependent = 0;
+  for (Function::iterator BB = F->begin(), BE = F->end(); BB != BE; ++BB) {
+    if (BB->getTerminator()->getNumSuccessors() < 2)
+      continue;
+    Branches++;
+    if (IDI.isInputDependentBranch(BB))
+      InputDependent++;
+  }
+}
+
+void PatmosSPSelect::computeCosts(Function *F, FunctionInfo &FI) {
+  // Block costs on the normal path and in the single-path version
+  DenseMap<const BasicBlock*, uint64_t> BlockCost, BlockSPCost;
+  for (Function::iterator BB = F->begin(), BE = F->end(); BB != BE; ++BB) {
+    uint64_t Cost = 0, SPCost = 0;
+    for (BasicBlock::iterator I = BB->begin(), IE = BB->end(); I != IE; ++I) {
+      if (isa<PHINode>(I) || isa<DbgInfoIntrinsic>(I))
+        continue;
+      Cost++;
+      SPCost++;
+      CallSite CS(I);
+      Function *Callee = CS ? CS.getCalledFunction() : 0;
+      FunctionInfoMap::const_iterator CI = Infos.find(Callee);
+      if (Callee && CI != Infos.end()) {
+        Cost += CI->second.PathCost;
+        SPCost += CI->second.SPCost;
+      }
+    }
+    BlockCost[BB] = Cost;
+    BlockSPCost[BB] = SPCost;
+    FI.SPCost += SPCost;
+  }
+
+  // Compute a post order of the CFG, ignoring back edges, by an iterative
+  // depth first search.
+  SmallVector<const BasicBlock*, 32> PostOrder;
+  SmallPtrSet<const BasicBlock*, 32> Visited;
+  SmallVector<std::pair<const BasicBlock*, succ_const_iterator>, 32> Stack;
+  const BasicBlock *Entry = &F->getEntryBlock();
+  Visited.insert(Entry);
+  Stack.push_back(std::make_pair(Entry, succ_begin(Entry)));
+  while (!Stack.empty()) {
+    const BasicBlock *BB = Stack.back().first;
+    succ_const_iterator &SI = Stack.back().second;
+    if (SI != succ_end(BB)) {
+      const BasicBlock *Succ = *SI++;
+      if (Visited.insert(Succ))
+        Stack.push_back(std::make_pair(Succ, succ_begin(Succ)));
+    } else {
+      PostOrder.push_back(BB);
+      Stack.pop_back();
+    }
+  }
+
+  // The longest path to the exit, in post order all successors that are not
+  // reached via back edges have been visited before.
+  DenseMap<const BasicBlock*, uint64_t> LongestPath;
+  for (unsigned i = 0, e = PostOrder.size(); i != e; i++) {
+    const BasicBlock *BB = PostOrder[i];
+    uint64_t Longest = 0;
+    for (succ_const_iterator SI = succ_begin(BB), SE = succ_end(BB);
+         SI != SE; ++SI) {
+      DenseMap<const BasicBlock*, uint64_t>::iterator LP = LongestPath.find(*SI);
+      // skip back edges
+      if (LP != LongestPath.end())
+        Longest = std::max(Longest, LP->second);
+    }
+    LongestPath[BB] = Longest + BlockCost[BB];
+  }
+  FI.PathCost = LongestPath[Entry];
+}
@@ -47,6 +47,14 @@ static cl::list<std::string> SPRootList(
     cl::desc("Entry functions for which single-path code is generated"),
     cl::CommaSeparated);
 
+/// SPAutoSelect - Option to select single-path roots automatically, in
+///                addition to the roots given by SPRootList.
+static cl::opt<bool> SPAutoSelect(
+    "mpatmos-singlepath-auto",
+    cl::init(false),
+    cl::desc("Select functions with little input-dependent control flow "
+             "for single-path code generation"));
+
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -63,7 +71,11 @@ llvm::createPatmosSinglePathInfoPass(const PatmosTargetMachine &tm) {
 
 
 bool PatmosSinglePathInfo::isEnabled() {
-  return !SPRootList.empty();
+  return !SPRootList.empty() || SPAutoSelect;
+}
+
+bool PatmosSinglePathInfo::isAutoSelect() {
+  return SPAutoSelect;
 }
 
 bool PatmosSinglePathInfo::isConverting(const MachineFunction &MF) {
@@ -83,9 +83,14 @@ namespace llvm {
       static char ID;
 
       /// isEnabled - Return true if there are functions specified to
-      /// to be converted to single-path code.
+      /// to be converted to single-path code, or if they are to be selected
+      /// automatically.
       static bool isEnabled();
 
+      /// isAutoSelect - Return true if single-path roots are to be selected
+      /// automatically, based on the input dependence of the functions.
+      static bool isAutoSelect();
+
       /// isEnabled - Return true if a particular function is specified to
       /// to be converted to single-path code.
       static bool isEnabled(const MachineFunction &MF);
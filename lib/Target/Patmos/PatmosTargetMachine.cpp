@@ -45,6 +45,10 @@ static ScheduleDAGInstrs *createPatmosVLIWMachineSched(MachineSchedContext *C) {
   return PS;
 }
 
+namespace llvm {
+  extern cl::opt<std::string> PatmosSplitterStatsFile;
+}
+
 static MachineSchedRegistry
 SchedCustomRegistry("patmos", "Run Patmos's custom scheduler",
                     createPatmosVLIWMachineSched);
@@ -58,11 +62,25 @@ namespace {
     cl::init(false),
     cl::desc("Enable the Patmos stack cache analysis."),
     cl::Hidden);
+  /// EnableMethodCacheAnalysis - Option to predict the method cache misses
+  /// along the worst-case path.
+  static cl::opt<bool> EnableMethodCacheAnalysis(
+    "mpatmos-enable-method-cache-analysis",
+    cl::init(false),
+    cl::desc("Enable the Patmos method cache miss prediction."),
+    cl::Hidden);
   static cl::opt<bool> DisableIfConverter(
       "mpatmos-disable-ifcvt",
       cl::init(false),
       cl::desc("Disable if-converter for Patmos."),
       cl::Hidden);
+  /// SampleProfile - Sample profile providing the branch weights for block
+  /// placement and if-conversion.
+  static cl::opt<std::string> SampleProfile(
+    "mpatmos-sample-profile",
+    cl::desc("Load branch weights from a sample profile (e.g., created by "
+             "llvm-sample-profile)."),
+    cl::value_desc("filename"));
 
   /// Patmos Code Generator Pass Configuration Options.
   class PatmosPassConfig : public TargetPassConfig {
@@ -96,6 +114,15 @@ namespace {
       return createPatmosVLIWMachineSched(C);
     }
 
+    virtual void addIRPasses() {
+      // Load the profile before the IR is modified, so that the debug
+      // locations still match the profile.
+      if (!SampleProfile.empty())
+        addPass(createSampleProfileLoaderPass(SampleProfile));
+
+      TargetPassConfig::addIRPasses();
+    }
+
     virtual bool addInstSelector() {
       addPass(createPatmosISelDag(getPatmosTargetMachine()));
       return false;
@@ -111,6 +138,12 @@ namespace {
         // Single-path transformation currently cannot deal with
         // switch/jumptables -> lower them to ITEs
         addPass(createLowerSwitchPass());
+        // The input dependence analysis requires canonical loops. The
+        // candidates are also analyzed if only the given roots are converted,
+        // for the statistics and -mpatmos-singlepath-auto-report.
+        addPass(createLoopSimplifyPass());
+        addPass(createLCSSAPass());
+        addPass(createPatmosSPSelectPass());
         addPass(createPatmosSPClonePass());
         return true;
       }
@@ -205,6 +238,11 @@ namespace {
 
       if (getPatmosSubtarget().hasMethodCache()) {
         addPass(createPatmosFunctionSplitterPass(getPatmosTargetMachine()));
+
+        if (EnableMethodCacheAnalysis) {
+          addPass(createPatmosMethodCacheAnalysisPass(
+                                                  getPatmosTargetMachine()));
+        }
       }
 
       addPass(createPatmosDelaySlotKillerPass(getPatmosTargetMachine()));
@@ -267,3 +305,21 @@ PatmosTargetMachine::PatmosTargetMachine(const Target &T,
 TargetPassConfig *PatmosTargetMachine::createPassConfig(PassManagerBase &PM) {
   return new PatmosPassConfig(this, PM);
 }
+
+void PatmosTargetMachine::addAnalysisPasses(PassManagerBase &PM) {
+  // Add first the target-independent BasicTTI pass, then our Patmos pass. This
+  // allows the Patmos pass to delegate to the target independent layer when
+  // appropriate.
+  PM.add(createBasicTargetTransformInfoPass(this));
+  PM.add(createPatmosTargetTransformInfoPass(this));
+}
+
+bool PatmosTargetMachine::supportsModulePartitioning() const {
+  // The splitter statistics file is shared by all functions of the module
+  return supportsFunctionAtATimeCodeGen() && PatmosSplitterStatsFile.empty();
+}
+
+bool PatmosTargetMachine::supportsFunctionAtATimeCodeGen() const {
+  return !PatmosSinglePathInfo::isEnabled() && !EnableStackCacheAnalysis &&
+         !EnableMethodCacheAnalysis;
+}
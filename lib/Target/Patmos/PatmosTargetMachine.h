@@ -71,6 +71,18 @@ public:
   /// addPassToEmitX methods for generating a pipeline of CodeGen passes.
   virtual TargetPassConfig *createPassConfig(PassManagerBase &PM);
 
+  /// addAnalysisPasses - Register the Patmos TTI on top of the basic TTI.
+  virtual void addAnalysisPasses(PassManagerBase &PM);
+
+  /// supportsModulePartitioning - The single-path transformation, the
+  /// stack cache analysis and the function layout work on the whole call
+  /// graph.
+  virtual bool supportsModulePartitioning() const;
+
+  /// supportsFunctionAtATimeCodeGen - The single-path transformation, the
+  /// stack cache analysis and the function layout are module passes.
+  virtual bool supportsFunctionAtATimeCodeGen() const;
+
 }; // PatmosTargetMachine.
 
 } // end namespace llvm
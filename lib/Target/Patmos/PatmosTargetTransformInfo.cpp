@@ -0,0 +1,201 @@
+//===-- PatmosTargetTransformInfo.cpp - Patmos specific TTI pass ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file implements a TargetTransformInfo analysis pass specific to the
+/// Patmos target machine. It provides the capacity of the method cache and an
+/// estimate of the encoded code size, so that the inliner and the loop
+/// unroller keep loops small enough to fit into the method cache without
+/// being split into several subfunctions by the PatmosFunctionSplitter.
+///
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "patmostti"
+#include "Patmos.h"
+#include "PatmosTargetMachine.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/Support/CallSite.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
+#include <algorithm>
+using namespace llvm;
+
+// Declare the pass initialization routine locally as target-specific passes
+// don't have a target-wide initialization entry point, and so we rely on the
+// pass constructor initialization.
+namespace llvm {
+void initializePatmosTTIPass(PassRegistry &);
+
+extern cl::opt<int> PatmosMaxSubfunctionSize;
+}
+
+static cl::opt<bool> DisableCacheAwareTTI(
+  "mpatmos-disable-cache-aware-opt",
+  cl::init(false),
+  cl::desc("Do not limit inlining and unrolling to the method cache size."),
+  cl::Hidden);
+
+namespace {
+
+class PatmosTTI : public ImmutablePass, public TargetTransformInfo {
+  const PatmosSubtarget *ST;
+
+  /// Get the size and the number of non-free instructions of the blocks in
+  /// [Begin, End).
+  template<typename IterT>
+  void getBlocksSize(IterT Begin, IterT End, unsigned &Size,
+                     unsigned &NumInsts) const {
+    for (IterT I = Begin; I != End; ++I) {
+      for (BasicBlock::const_iterator II = (*I)->begin(), IE = (*I)->end();
+           II != IE; ++II) {
+        unsigned InstSize = getCodeSize(II);
+        if (InstSize) {
+          Size += InstSize;
+          NumInsts++;
+        }
+      }
+    }
+  }
+
+public:
+  PatmosTTI() : ImmutablePass(ID), ST(0) {
+    llvm_unreachable("This pass cannot be directly constructed");
+  }
+
+  PatmosTTI(const PatmosTargetMachine *TM)
+      : ImmutablePass(ID), ST(TM->getSubtargetImpl()) {
+    initializePatmosTTIPass(*PassRegistry::getPassRegistry());
+  }
+
+  virtual void initializePass() {
+    pushTTIStack(this);
+  }
+
+  virtual void finalizePass() {
+    popTTIStack();
+  }
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+    TargetTransformInfo::getAnalysisUsage(AU);
+  }
+
+  static char ID;
+
+  virtual void *getAdjustedAnalysisPointer(const void *ID) {
+    if (ID == &TargetTransformInfo::ID)
+      return (TargetTransformInfo*)this;
+    return this;
+  }
+
+  /// \name Scalar TTI Implementations
+  /// @{
+
+  virtual unsigned getCodeCacheSize() const;
+
+  virtual unsigned getCodeSize(const User *U) const;
+
+  virtual void getUnrollingPreferences(Loop *L, UnrollingPreferences &UP) const;
+
+  /// @}
+};
+
+} // end anonymous namespace
+
+INITIALIZE_AG_PASS(PatmosTTI, TargetTransformInfo, "patmostti",
+                   "Patmos Target Transform Info", true, true, false)
+char PatmosTTI::ID = 0;
+
+ImmutablePass *
+llvm::createPatmosTargetTransformInfoPass(const PatmosTargetMachine *TM) {
+  return new PatmosTTI(TM);
+}
+
+unsigned PatmosTTI::getCodeCacheSize() const {
+  if (DisableCacheAwareTTI || !ST->hasMethodCache())
+    return 0;
+
+  // Code larger than the maximum subfunction size is split by the
+  // PatmosFunctionSplitter, a loop has to fit into a single subfunction.
+  unsigned CacheSize = ST->getMethodCacheSize();
+  if (PatmosMaxSubfunctionSize > 0)
+    CacheSize = std::min(CacheSize, (unsigned)PatmosMaxSubfunctionSize);
+  return CacheSize;
+}
+
+unsigned PatmosTTI::getCodeSize(const User *U) const {
+  unsigned Cost = TopTTI->getUserCost(U);
+  if (Cost == TCC_Free)
+    return 0;
+
+  unsigned Size = Cost * 4;
+
+  // Constants that do not fit into the unsigned 12 bit immediate of the
+  // short ALU format require the 64 bit long format. Adding or subtracting
+  // a negative constant is selected to the opposite operation.
+  unsigned Opcode = Operator::getOpcode(U);
+  bool Negatable = Opcode == Instruction::Add || Opcode == Instruction::Sub;
+  for (unsigned i = 0, e = U->getNumOperands(); i != e; ++i) {
+    const ConstantInt *CI = dyn_cast<ConstantInt>(U->getOperand(i));
+    if (!CI || CI->getBitWidth() > 64)
+      continue;
+    if (isUInt<12>(CI->getZExtValue()))
+      continue;
+    if (Negatable && i == 1 && isUInt<12>(-(uint64_t)CI->getSExtValue()))
+      continue;
+    Size += 4;
+  }
+
+  // The delay slots of calls are rarely filled, count them as NOPs.
+  ImmutableCallSite CS(U);
+  if (CS && !isa<IntrinsicInst>(U))
+    Size += ST->getCFLDelaySlotCycles(false) * 4;
+
+  return Size;
+}
+
+void PatmosTTI::getUnrollingPreferences(Loop *L,
+                                        UnrollingPreferences &UP) const {
+  unsigned CacheSize = getCodeCacheSize();
+  if (!CacheSize)
+    return;
+
+  // Unrolling L also grows all loops containing L. The outermost loop is the
+  // largest one, keep it inside the method cache.
+  Loop *Outer = L;
+  while (Outer->getParentLoop())
+    Outer = Outer->getParentLoop();
+
+  unsigned LoopSize = 0, LoopInsts = 0;
+  getBlocksSize(L->block_begin(), L->block_end(), LoopSize, LoopInsts);
+
+  unsigned OuterSize = 0, OuterInsts = 0;
+  getBlocksSize(Outer->block_begin(), Outer->block_end(), OuterSize,
+                OuterInsts);
+
+  // If the loop nest does not fit anyway, there is nothing to keep.
+  if (!LoopSize || OuterSize > CacheSize)
+    return;
+
+  // The unroller compares the size of the unrolled loop in instructions
+  // against the threshold, so convert the available space into instructions
+  // using the average instruction size of the loop.
+  unsigned Available = CacheSize - (OuterSize - LoopSize);
+  unsigned MaxInsts = (uint64_t)Available * LoopInsts / LoopSize;
+
+  DEBUG(dbgs() << "PatmosTTI: loop " << L->getHeader()->getName()
+               << " size " << LoopSize << ", outermost loop size "
+               << OuterSize << ", unroll threshold " << MaxInsts << "\n");
+
+  UP.Threshold = std::min(UP.Threshold, MaxInsts);
+  UP.OptSizeThreshold = std::min(UP.OptSizeThreshold, MaxInsts);
+}
@@ -55,6 +55,9 @@ TargetMachine::TargetMachine(const Target &T,
     MCUseLoc(true),
     MCUseCFI(true),
     MCUseDwarfDirectory(false),
+    ModulePartition(false),
+    FirstFunctionNumber(0),
+    FirstTempSymbolID(0),
     Options(Options) {
 }
 
@@ -111,6 +111,9 @@ PassManagerBuilder::addInitialAliasAnalysisPasses(PassManagerBase &PM) const {
 }
 
 void PassManagerBuilder::populateFunctionPassManager(FunctionPassManager &FPM) {
+  if (!SampleProfileFile.empty())
+    FPM.add(createSampleProfileLoaderPass(SampleProfileFile));
+
   addExtensionsToPM(EP_EarlyAsPossible, FPM);
 
   // Add LibraryInfo if we have some.
@@ -132,6 +135,9 @@ void PassManagerBuilder::populateFunctionPassManager(FunctionPassManager &FPM) {
 // used by the clang frontend during Patmos builds
 void PassManagerBuilder::populateFPMBaseline(FunctionPassManager &FPM) {
   // as in populateFunctionPassManager()
+  if (!SampleProfileFile.empty())
+    FPM.add(createSampleProfileLoaderPass(SampleProfileFile));
+
   addInitialAliasAnalysisPasses(FPM);
 
   // skip createCFGSimplificationPass(), SROA as populateFunctionPassManager()
@@ -148,6 +154,23 @@ void PassManagerBuilder::populateFPMBaseline(FunctionPassManager &FPM) {
   FPM.add(createAggressiveDCEPass());
 }
 
+// used for optimized, WCET analyzed Patmos builds
+void PassManagerBuilder::populateFPMAnalyzable(FunctionPassManager &FPM) {
+  populateFPMBaseline(FPM);
+
+  // Rotation and unrolling update the llvm.loopbound annotations, LICM does
+  // not move them.
+  FPM.add(createLoopRotatePass());
+  FPM.add(createLICMPass());
+  if (!DisableUnrollLoops)
+    FPM.add(createLoopUnrollPass());
+
+  // GVN and the cleanup do not change the loop structure.
+  FPM.add(createGVNPass());
+  FPM.add(createInstructionCombiningPass());
+  FPM.add(createAggressiveDCEPass());
+}
+
 void PassManagerBuilder::populateModulePassManager(PassManagerBase &MPM) {
   // If all optimizations are disabled, just run the always-inline pass.
   if (OptLevel == 0) {
@@ -0,0 +1,381 @@
+//===- PMLEdgeProfiling.cpp - Insert edge counters for PML profiles -------===//
+//
+//                      The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass instruments the program with edge counters that can be collected
+// on the target at full speed and converted to a PML profile by the
+// llvm-pml-profile tool.
+//
+// Only the edges that are not on a maximum spanning tree of the CFG (extended
+// by a virtual node for the function entry and exit) get a counter; the counts
+// of the tree edges are derived from flow conservation. The edges are weighted
+// by the static block frequency estimate, so counters are placed on the less
+// frequently executed edges.
+//
+// The counters are stored in a single block, either in the global variable
+// __pml_edge_profile_counters or at a fixed address (e.g., in the scratchpad
+// memory, which is cleared on entry of the program by
+// __pml_edge_profile_clear). The layout of the block and the edges are
+// written to a notes file, which is needed to convert a dump of the counter
+// block into a profile.
+//
+// The counts are only consistent if every function that is entered also
+// returns, i.e., the program must not exit from within a nested call.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "insert-pml-edge-profiling"
+
+#include "llvm/Transforms/Instrumentation.h"
+#include "MaximumSpanningTree.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/PML.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CFG.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include <algorithm>
+#include <set>
+#include <vector>
+using namespace llvm;
+
+STATISTIC(NumEdgesProfiled, "Number of CFG edges of instrumented functions");
+STATISTIC(NumCounters,      "Number of edge counters inserted");
+STATISTIC(NumEdgesSplit,    "Number of critical edges split for counters");
+
+static cl::opt<std::string>
+NotesFile("pml-edge-profile-notes",
+          cl::desc("Write the layout of the edge counters to this file "
+                   "(default: edge-profile.yml)"),
+          cl::init("edge-profile.yml"));
+
+static cl::opt<unsigned>
+CounterBits("pml-edge-profile-counter-bits",
+            cl::desc("Width of the edge counters in bits, 32 or 64 "
+                     "(default: 32)"),
+            cl::init(32));
+
+static cl::opt<unsigned>
+CounterAddrSpace("pml-edge-profile-addrspace",
+                 cl::desc("Address space of the edge counters, e.g., 1 for "
+                          "the Patmos scratchpad (default: 0)"),
+                 cl::init(0));
+
+static cl::opt<unsigned long long>
+CounterBase("pml-edge-profile-base",
+            cl::desc("Place the edge counters at this address instead of "
+                     "a global variable"),
+            cl::init(0));
+
+static cl::opt<std::string>
+ProfileEntry("pml-edge-profile-entry",
+             cl::desc("Clear the edge counters at a fixed address on entry "
+                      "of this function (default: main)"),
+             cl::init("main"));
+
+namespace {
+  typedef MaximumSpanningTree<BasicBlock> MST;
+
+  /// An edge of the extended CFG and its counter.
+  struct ProfiledEdge {
+    BasicBlock *Src;
+    BasicBlock *Dst;
+    int64_t Counter;
+
+    ProfiledEdge(BasicBlock *S, BasicBlock *D) : Src(S), Dst(D), Counter(-1) {}
+  };
+
+  typedef std::vector<ProfiledEdge> EdgeList;
+
+  class PMLEdgeProfiler : public ModulePass {
+  public:
+    static char ID;
+
+    PMLEdgeProfiler() : ModulePass(ID) {
+      initializePMLEdgeProfilerPass(*PassRegistry::getPassRegistry());
+    }
+
+    virtual const char *getPassName() const {
+      return "PML Edge Profiler";
+    }
+
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+      AU.addRequired<BlockFrequencyInfo>();
+    }
+
+    virtual bool runOnModule(Module &M);
+
+  private:
+    /// Check if the edges of F can be instrumented and named in the notes.
+    bool canInstrument(const Function &F) const;
+
+    /// Collect the edges of F, and assign counters to all edges that are not
+    /// on the maximum spanning tree.
+    void selectEdges(Function &F, EdgeList &Edges, uint64_t &NextCounter);
+
+    /// Insert the counter increment for an edge.
+    void instrumentEdge(const ProfiledEdge &E, Value *Counters);
+
+    /// Create the function that clears the counter block.
+    Function *createClearFunction(Module &M, Value *Counters,
+                                  uint64_t NumCounters);
+  };
+}
+
+char PMLEdgeProfiler::ID = 0;
+INITIALIZE_PASS_BEGIN(PMLEdgeProfiler, "insert-pml-edge-profiling",
+                "Insert edge counters for PML profiles", false, false)
+INITIALIZE_PASS_DEPENDENCY(BlockFrequencyInfo)
+INITIALIZE_PASS_END(PMLEdgeProfiler, "insert-pml-edge-profiling",
+                "Insert edge counters for PML profiles", false, false)
+
+ModulePass *llvm::createPMLEdgeProfilerPass() {
+  return new PMLEdgeProfiler();
+}
+
+bool PMLEdgeProfiler::canInstrument(const Function &F) const {
+  for (Function::const_iterator BB = F.begin(), BE = F.end(); BB != BE; ++BB) {
+    // The notes refer to the blocks by name.
+    if (!BB->hasName()) {
+      errs() << "warning: not profiling function " << F.getName()
+             << " with unnamed basic blocks\n";
+      return false;
+    }
+    // The edges of indirect branches and invokes cannot be split.
+    const TerminatorInst *TI = BB->getTerminator();
+    if (isa<IndirectBrInst>(TI) || isa<InvokeInst>(TI)) {
+      errs() << "warning: not profiling function " << F.getName()
+             << " with indirect branches or invokes\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+void PMLEdgeProfiler::selectEdges(Function &F, EdgeList &Edges,
+                                  uint64_t &NextCounter) {
+  BlockFrequencyInfo &BFI = getAnalysis<BlockFrequencyInfo>(F);
+
+  // Collect the edges, including the virtual edges entering and leaving the
+  // function. Multiple edges between the same blocks are a single edge.
+  MST::EdgeWeights Weights;
+  for (Function::iterator BB = F.begin(), BE = F.end(); BB != BE; ++BB) {
+    double Freq = BFI.getBlockFreq(BB).getFrequency();
+
+    if (&*BB == &F.getEntryBlock()) {
+      Edges.push_back(ProfiledEdge(0, BB));
+      Weights.push_back(std::make_pair(MST::Edge(0, BB), Freq));
+    }
+
+    SmallPtrSet<BasicBlock*, 8> Visited;
+    for (succ_iterator SI = succ_begin(BB), SE = succ_end(BB); SI != SE; ++SI){
+      if (!Visited.insert(*SI)) continue;
+
+      // The frequency of an edge is bounded by the frequencies of its
+      // blocks, and equal to one of them unless the edge is critical.
+      double Weight = std::min(Freq,
+                       (double)BFI.getBlockFreq(*SI).getFrequency());
+
+      Edges.push_back(ProfiledEdge(BB, *SI));
+      Weights.push_back(std::make_pair(MST::Edge(BB, *SI), Weight));
+    }
+
+    if (succ_begin(BB) == succ_end(BB)) {
+      Edges.push_back(ProfiledEdge(BB, 0));
+      Weights.push_back(std::make_pair(MST::Edge(BB, 0), Freq));
+    }
+  }
+
+  MST Tree(Weights);
+  std::set<MST::Edge> TreeEdges(Tree.begin(), Tree.end());
+
+  for (EdgeList::iterator it = Edges.begin(), ie = Edges.end(); it != ie; ++it){
+    if (TreeEdges.count(MST::Edge(it->Src, it->Dst))) continue;
+    it->Counter = NextCounter++;
+    NumCounters++;
+  }
+  NumEdgesProfiled += Edges.size();
+}
+
+/// Get the number of distinct blocks in a sequence of blocks.
+template<typename IterT>
+static unsigned getNumDistinct(IterT Begin, IterT End) {
+  SmallPtrSet<BasicBlock*, 8> Blocks;
+  for (IterT it = Begin; it != End; ++it)
+    Blocks.insert(*it);
+  return Blocks.size();
+}
+
+void PMLEdgeProfiler::instrumentEdge(const ProfiledEdge &E, Value *Counters) {
+  Instruction *InsertPt;
+  if (!E.Src) {
+    // The entry block is executed once per call, count at its end so that the
+    // counters are cleared before they are used in the profile entry.
+    InsertPt = E.Dst->getTerminator();
+  } else if (!E.Dst ||
+             getNumDistinct(succ_begin(E.Src), succ_end(E.Src)) == 1) {
+    InsertPt = E.Src->getTerminator();
+  } else if (getNumDistinct(pred_begin(E.Dst), pred_end(E.Dst)) == 1) {
+    InsertPt = E.Dst->getFirstInsertionPt();
+  } else {
+    TerminatorInst *TI = E.Src->getTerminator();
+    unsigned SuccNum = 0;
+    while (TI->getSuccessor(SuccNum) != E.Dst)
+      SuccNum++;
+    BasicBlock *Split = SplitCriticalEdge(TI, SuccNum, this, true);
+    assert(Split && "Failed to split critical edge");
+    NumEdgesSplit++;
+    InsertPt = Split->getTerminator();
+  }
+
+  IRBuilder<> Builder(InsertPt);
+  Value *Counter = Builder.CreateConstInBoundsGEP2_64(Counters, 0, E.Counter);
+  Value *Count = Builder.CreateLoad(Counter);
+  Count = Builder.CreateAdd(Count, ConstantInt::get(Count->getType(), 1));
+  Builder.CreateStore(Count, Counter);
+}
+
+Function *PMLEdgeProfiler::createClearFunction(Module &M, Value *Counters,
+                                               uint64_t NumCounters) {
+  LLVMContext &C = M.getContext();
+  FunctionType *FTy = FunctionType::get(Type::getVoidTy(C), false);
+  Function *F = Function::Create(FTy, GlobalValue::ExternalLinkage,
+                                 "__pml_edge_profile_clear", &M);
+  F->addFnAttr(Attribute::NoInline);
+
+  BasicBlock *Entry = BasicBlock::Create(C, "entry", F);
+  BasicBlock *Loop = BasicBlock::Create(C, "loop", F);
+  BasicBlock *Exit = BasicBlock::Create(C, "exit", F);
+
+  IRBuilder<> Builder(Entry);
+  Builder.CreateBr(Loop);
+
+  Builder.SetInsertPoint(Loop);
+  PHINode *Idx = Builder.CreatePHI(Builder.getInt32Ty(), 2, "idx");
+  Idx->addIncoming(Builder.getInt32(0), Entry);
+  Value *Idxs[] = { Builder.getInt32(0), Idx };
+  Value *Counter = Builder.CreateInBoundsGEP(Counters, Idxs);
+  Type *CounterTy = cast<PointerType>(Counter->getType())->getElementType();
+  Builder.CreateStore(ConstantInt::get(CounterTy, 0), Counter, true);
+  Value *Next = Builder.CreateAdd(Idx, Builder.getInt32(1));
+  Idx->addIncoming(Next, Loop);
+  Builder.CreateCondBr(Builder.CreateICmpULT(Next,
+                                             Builder.getInt32(NumCounters)),
+                       Loop, Exit);
+
+  Builder.SetInsertPoint(Exit);
+  Builder.CreateRetVoid();
+  return F;
+}
+
+bool PMLEdgeProfiler::runOnModule(Module &M) {
+  if (CounterBits != 32 && CounterBits != 64)
+    report_fatal_error("PMLEdgeProfiler: counters must have 32 or 64 bits");
+
+  // Select the counters of all functions before changing the CFG.
+  std::vector<std::pair<Function*, EdgeList> > Functions;
+  uint64_t NextCounter = 0;
+  for (Module::iterator F = M.begin(), FE = M.end(); F != FE; ++F) {
+    if (F->isDeclaration() || !canInstrument(*F)) continue;
+    Functions.push_back(std::make_pair(F, EdgeList()));
+    selectEdges(*F, Functions.back().second, NextCounter);
+  }
+
+  DataLayout DL(&M);
+  LLVMContext &C = M.getContext();
+  Type *CounterTy = IntegerType::get(C, CounterBits);
+
+  yaml::EdgeProfileNotes Notes;
+  Notes.TargetTriple = M.getTargetTriple();
+  Notes.CounterSize = CounterBits / 8;
+  Notes.BigEndian = DL.isBigEndian();
+  Notes.NumCounters = NextCounter;
+
+  if (NextCounter) {
+    ArrayType *BlockTy = ArrayType::get(CounterTy, NextCounter);
+
+    Value *Counters;
+    if (CounterBase.getNumOccurrences()) {
+      Constant *Addr = ConstantInt::get(DL.getIntPtrType(C, CounterAddrSpace),
+                                        CounterBase);
+      Counters = ConstantExpr::getIntToPtr(Addr,
+                                   PointerType::get(BlockTy, CounterAddrSpace));
+
+      Function *Entry = M.getFunction(ProfileEntry);
+      if (!Entry || Entry->isDeclaration())
+        report_fatal_error("PMLEdgeProfiler: profile entry function " +
+                           ProfileEntry + " not found");
+      Function *Clear = createClearFunction(M, Counters, NextCounter);
+      CallInst::Create(Clear, "", Entry->getEntryBlock().getFirstInsertionPt());
+    } else {
+      Counters = new GlobalVariable(M, BlockTy, false,
+                                    GlobalValue::ExternalLinkage,
+                                    Constant::getNullValue(BlockTy),
+                                    "__pml_edge_profile_counters", 0,
+                                    GlobalVariable::NotThreadLocal,
+                                    CounterAddrSpace);
+    }
+
+    // Export the size of the counter block for the runtime dumping it.
+    new GlobalVariable(M, Type::getInt32Ty(C), true,
+                       GlobalValue::ExternalLinkage,
+                       ConstantInt::get(Type::getInt32Ty(C),
+                                        NextCounter * Notes.CounterSize),
+                       "__pml_edge_profile_size");
+
+    for (unsigned i = 0, e = Functions.size(); i != e; ++i) {
+      EdgeList &Edges = Functions[i].second;
+      for (EdgeList::iterator it = Edges.begin(), ie = Edges.end(); it != ie;
+           ++it) {
+        if (it->Counter >= 0)
+          instrumentEdge(*it, Counters);
+      }
+    }
+  }
+
+  // Write the notes
+  for (unsigned i = 0, e = Functions.size(); i != e; ++i) {
+    yaml::EdgeProfileFunction *PF =
+      new yaml::EdgeProfileFunction(Functions[i].first->getName());
+    Notes.Functions.push_back(PF);
+
+    EdgeList &Edges = Functions[i].second;
+    for (EdgeList::iterator it = Edges.begin(), ie = Edges.end(); it != ie;
+         ++it) {
+      yaml::EdgeProfileEdge *E = PF->addEdge(new yaml::EdgeProfileEdge(
+                          it->Src ? it->Src->getName() : StringRef(""),
+                          it->Dst ? it->Dst->getName() : StringRef("")));
+      E->Counter = it->Counter;
+    }
+  }
+
+  std::string ErrorInfo;
+  tool_output_file Out(NotesFile.c_str(), ErrorInfo);
+  if (!ErrorInfo.empty())
+    report_fatal_error("PMLEdgeProfiler: " + ErrorInfo);
+  yaml::Output YOut(Out.os());
+  YOut << Notes;
+  Out.keep();
+
+  DEBUG(dbgs() << "PMLEdgeProfiler: " << NextCounter << " counters for "
+               << NumEdgesProfiled << " edges\n");
+
+  return NextCounter > 0;
+}
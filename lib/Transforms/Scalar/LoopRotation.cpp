@@ -26,6 +26,7 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
 #include "llvm/Transforms/Utils/Local.h"
+#include "llvm/Transforms/Utils/LoopUtils.h"
 #include "llvm/Transforms/Utils/SSAUpdater.h"
 #include "llvm/Transforms/Utils/ValueMapper.h"
 using namespace llvm;
@@ -371,6 +372,17 @@ bool LoopRotate::rotateLoop(Loop *L, bool SimplifiedLatch) {
       continue;
     }
 
+    // Move loop bounds to the new header instead, a copy in the preheader
+    // would bound the enclosing loop. If the loop can only be left from the
+    // original header, the new header is executed once less.
+    if (IntrinsicInst *II = dyn_cast<IntrinsicInst>(Inst))
+      if (II->getIntrinsicID() == Intrinsic::loopbound) {
+        II->moveBefore(NewHeader->getFirstInsertionPt());
+        if (L->getExitingBlock() == OrigHeader)
+          peelLoopBound(II);
+        continue;
+      }
+
     // Otherwise, create a duplicate of the instruction.
     Instruction *C = Inst->clone();
 
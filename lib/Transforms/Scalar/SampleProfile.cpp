@@ -28,6 +28,7 @@
 #include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/DebugInfo.h"
 #include "llvm/DebugInfo/DIContext.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
@@ -231,7 +232,7 @@ protected:
   OwningPtr<SampleProfile> Profiler;
 
   /// \brief Name of the profile file to load.
-  StringRef Filename;
+  std::string Filename;
 };
 }
 
@@ -363,7 +364,7 @@ void SampleProfile::loadText() {
 /// look up the samples collected for \p Inst using \p BodySamples.
 ///
 /// \param Inst Instruction to query.
-/// \param FirstLineno Line number of the first instruction in the function.
+/// \param FirstLineno Line number of the function's declaration.
 /// \param BodySamples Map of relative source line locations to samples.
 ///
 /// \returns The profiled weight of I.
@@ -379,8 +380,7 @@ uint32_t SampleProfile::getInstWeight(Instruction &Inst, unsigned FirstLineno,
 /// instructions in B.
 ///
 /// \param B The basic block to query.
-/// \param FirstLineno The line number for the first line in the
-///     function holding B.
+/// \param FirstLineno The declaration line of the function holding B.
 /// \param BodySamples The map containing all the samples collected in that
 ///     function.
 ///
@@ -406,6 +406,34 @@ uint32_t SampleProfile::computeBlockWeight(BasicBlock *B, unsigned FirstLineno,
   return Weight;
 }
 
+/// \brief Get the line number at which \p F is declared.
+///
+/// Sample profiles record line offsets relative to the DW_AT_decl_line of
+/// the function, which is the line of its DISubprogram. The subprogram is
+/// found through the scope of the first instruction with a location; the
+/// inlined-at chain is followed so that inlined code does not yield the
+/// callee's subprogram. If no subprogram is found, the line of the first
+/// instruction is used instead.
+///
+/// \param F The function to query.
+///
+/// \returns The line number of the declaration of \p F.
+static unsigned getFunctionLineno(Function &F) {
+  LLVMContext &Ctx = F.getContext();
+  for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+    DebugLoc DL = I->getDebugLoc();
+    if (DL.isUnknown())
+      continue;
+    while (MDNode *IA = DL.getInlinedAt(Ctx))
+      DL = DebugLoc::getFromDILocation(IA);
+    DISubprogram SP = getDISubprogram(DL.getScope(Ctx));
+    if (SP.isSubprogram() && SP.getLineNumber())
+      return SP.getLineNumber();
+    break;
+  }
+  return inst_begin(F)->getDebugLoc().getLine();
+}
+
 /// \brief Generate branch weight metadata for all branches in \p F.
 ///
 /// For every branch instruction B in \p F, we compute the weight of the
@@ -423,7 +451,7 @@ uint32_t SampleProfile::computeBlockWeight(BasicBlock *B, unsigned FirstLineno,
 bool SampleProfile::emitAnnotations(Function &F) {
   bool Changed = false;
   FunctionProfile &FProfile = Profiles[F.getName()];
-  unsigned FirstLineno = inst_begin(F)->getDebugLoc().getLine();
+  unsigned FirstLineno = getFunctionLineno(F);
   MDBuilder MDB(F.getContext());
 
   // Clear the block weights cache.
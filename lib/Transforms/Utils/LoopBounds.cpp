@@ -0,0 +1,82 @@
+//===- LoopBounds.cpp - Maintain llvm.loopbound annotations ---------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements utilities to keep the llvm.loopbound annotations valid
+// when loops are transformed. An annotation bounds the innermost loop
+// containing it: llvm.loopbound(min, max) states that the header of the loop
+// is executed at least min+1 and at most max+1 times per entry of the loop.
+// The annotations are exported as flow facts for the WCET analysis.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "loop-bounds"
+#include "llvm/Transforms/Utils/LoopUtils.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+void llvm::getLoopBounds(Loop *L, LoopInfo *LI,
+                         SmallVectorImpl<IntrinsicInst*> &Bounds) {
+  for (Loop::block_iterator BI = L->block_begin(), BE = L->block_end();
+       BI != BE; ++BI) {
+    if (LI->getLoopFor(*BI) != L)
+      continue;
+    for (BasicBlock::iterator I = (*BI)->begin(), E = (*BI)->end(); I != E;
+         ++I) {
+      IntrinsicInst *II = dyn_cast<IntrinsicInst>(I);
+      if (II && II->getIntrinsicID() == Intrinsic::loopbound)
+        Bounds.push_back(II);
+    }
+  }
+}
+
+/// getHeaderCounts - Get the minimum and maximum number of header executions
+/// of a loop bound. Returns false if the bound is not constant.
+static bool getHeaderCounts(IntrinsicInst *Bound, uint64_t &Min,
+                            uint64_t &Max) {
+  ConstantInt *MinC = dyn_cast<ConstantInt>(Bound->getArgOperand(0));
+  ConstantInt *MaxC = dyn_cast<ConstantInt>(Bound->getArgOperand(1));
+  if (!MinC || !MaxC)
+    return false;
+  Min = MinC->getZExtValue() + 1;
+  Max = MaxC->getZExtValue() + 1;
+  return true;
+}
+
+/// setHeaderCounts - Set the minimum and maximum number of header executions
+/// of a loop bound.
+static void setHeaderCounts(IntrinsicInst *Bound, uint64_t Min,
+                            uint64_t Max) {
+  Type *Ty = Bound->getArgOperand(0)->getType();
+  Bound->setArgOperand(0, ConstantInt::get(Ty, Min ? Min - 1 : 0));
+  Bound->setArgOperand(1, ConstantInt::get(Ty, Max ? Max - 1 : 0));
+  DEBUG(dbgs() << "Updated loop bound: " << *Bound << "\n");
+}
+
+void llvm::unrollLoopBound(IntrinsicInst *Bound, unsigned Count) {
+  uint64_t Min, Max;
+  if (!getHeaderCounts(Bound, Min, Max)) {
+    // The bound cannot be rewritten, so it is no longer valid.
+    Bound->eraseFromParent();
+    return;
+  }
+  // The last iteration of the unrolled loop may leave early.
+  setHeaderCounts(Bound, Min / Count, (Max + Count - 1) / Count);
+}
+
+void llvm::peelLoopBound(IntrinsicInst *Bound) {
+  uint64_t Min, Max;
+  if (!getHeaderCounts(Bound, Min, Max))
+    return;
+  setHeaderCounts(Bound, Min - 1, Max - 1);
+}
@@ -24,10 +24,12 @@
 #include "llvm/Analysis/LoopPass.h"
 #include "llvm/Analysis/ScalarEvolution.h"
 #include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
 #include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/LoopUtils.h"
 #include "llvm/Transforms/Utils/Local.h"
 #include "llvm/Transforms/Utils/SimplifyIndVar.h"
 using namespace llvm;
@@ -267,6 +269,11 @@ bool llvm::UnrollLoop(Loop *L, unsigned Count, unsigned TripCount,
   LoopBlocksDFS::RPOIterator BlockBegin = DFS.beginRPO();
   LoopBlocksDFS::RPOIterator BlockEnd = DFS.endRPO();
 
+  // The loop bounds are not copied, the bounds of the first iteration are
+  // updated for the unrolled loop below.
+  SmallVector<IntrinsicInst*, 2> Bounds;
+  getLoopBounds(L, LI, Bounds);
+
   for (unsigned It = 1; It != Count; ++It) {
     std::vector<BasicBlock*> NewBlocks;
 
@@ -275,6 +282,12 @@ bool llvm::UnrollLoop(Loop *L, unsigned Count, unsigned TripCount,
       BasicBlock *New = CloneBasicBlock(*BB, VMap, "." + Twine(It));
       Header->getParent()->getBasicBlockList().push_back(New);
 
+      for (unsigned i = 0, e = Bounds.size(); i != e; ++i)
+        if (Value *NewBound = VMap.lookup(Bounds[i])) {
+          VMap.erase(Bounds[i]);
+          cast<Instruction>(NewBound)->eraseFromParent();
+        }
+
       // Loop over all of the PHI nodes in the block, changing them to use the
       // incoming values from the previous block.
       if (*BB == Header)
@@ -327,6 +340,15 @@ bool llvm::UnrollLoop(Loop *L, unsigned Count, unsigned TripCount,
         ::RemapInstruction(I, LastValueMap);
   }
 
+  // A completely unrolled loop needs no bound, the remaining bound would
+  // bound the enclosing loop.
+  for (unsigned i = 0, e = Bounds.size(); i != e; ++i) {
+    if (CompletelyUnroll)
+      Bounds[i]->eraseFromParent();
+    else
+      unrollLoopBound(Bounds[i], Count);
+  }
+
   // Loop over the PHI nodes in the original block, setting incoming values.
   for (unsigned i = 0, e = OrigPHINode.size(); i != e; ++i) {
     PHINode *PN = OrigPHINode[i];
@@ -29,10 +29,12 @@
 #include "llvm/Analysis/ScalarEvolution.h"
 #include "llvm/Analysis/ScalarEvolutionExpander.h"
 #include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
 #include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/LoopUtils.h"
 #include <algorithm>
 
 using namespace llvm;
@@ -308,6 +310,11 @@ bool llvm::UnrollRuntimeLoopProlog(Loop *L, unsigned Count, LoopInfo *LI,
   LoopBlocksDFS LoopBlocks(L);
   LoopBlocks.perform(LI);
 
+  // The prolog is not a loop, so it must not contain copies of the loop
+  // bounds. Otherwise they would bound the enclosing loop.
+  SmallVector<IntrinsicInst*, 2> Bounds;
+  getLoopBounds(L, LI, Bounds);
+
   //
   // For each extra loop iteration, create a copy of the loop's basic blocks
   // and generate a condition that branches to the copy depending on the
@@ -363,6 +370,10 @@ bool llvm::UnrollRuntimeLoopProlog(Loop *L, unsigned Count, LoopInfo *LI,
                          RF_NoModuleLevelChanges|RF_IgnoreMissingEntries);
       }
     }
+
+    for (unsigned i = 0, e = Bounds.size(); i != e; ++i)
+      if (Value *NewBound = VMap.lookup(Bounds[i]))
+        cast<Instruction>(NewBound)->eraseFromParent();
   }
 
   // Connect the prolog code to the original loop and update the
@@ -0,0 +1,107 @@
+; RUN: opt < %s -loop-simplify -lcssa | opt -analyze -pidda | FileCheck %s
+; RUN: opt < %s -loop-simplify -lcssa | opt -analyze -pidda -pidda-demo -stats -o %t 2>&1 | FileCheck %s -check-prefix=STATS
+; REQUIRES: asserts
+
+; The results are kept per function, the functions are analyzed once although
+; both the demo pass and the printer query all of them.
+; STATS: 3 pidda - Number of functions analyzed
+
+@limit = constant i32 3
+
+; CHECK: Input dependence of function 'loops':
+; CHECK-NEXT:  branch 'first': input-independent
+; CHECK-NEXT:  branch 'second': input-dependent
+; CHECK-NEXT:  branch 'join': input-dependent
+; CHECK-NEXT:  branch 'cond': input-independent
+define i32 @loops(i32 %n) {
+entry:
+  br label %first
+
+; Two top-level loops, the second is bounded by the argument
+first:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %first.latch ]
+  %i.next = add i32 %i, 1
+  %first.cmp = icmp slt i32 %i.next, 10
+  br i1 %first.cmp, label %first.latch, label %mid
+
+first.latch:
+  br label %first
+
+mid:
+  br label %second
+
+second:
+  %j = phi i32 [ 0, %mid ], [ %j.next, %second.latch ]
+  %j.next = add i32 %j, 1
+  %second.cmp = icmp slt i32 %j.next, %n
+  br i1 %second.cmp, label %second.latch, label %join
+
+second.latch:
+  br label %second
+
+; The value of %k depends on the input-dependent exit of the second loop (eta)
+join:
+  %k = phi i32 [ %j.next, %second ]
+  %k.cmp = icmp sgt i32 %k, 5
+  br i1 %k.cmp, label %cond, label %exit
+
+cond:
+  %sel = icmp eq i32 %i.next, 10
+  br i1 %sel, label %exit, label %other
+
+other:
+  br label %exit
+
+exit:
+  %r = phi i32 [ 0, %join ], [ 1, %cond ], [ 2, %other ]
+  ret i32 %r
+}
+
+; Loads from constant globals do not depend on input data. The value of %r
+; is selected by an input-dependent branch (gamma).
+; CHECK: Input dependence of function 'constant':
+; CHECK-NEXT:  branch 'entry': input-independent
+; CHECK-NEXT:  branch 'then': input-dependent
+; CHECK-NEXT:  branch 'merge': input-dependent
+define i32 @constant(i32* %p) {
+entry:
+  %c = load i32* @limit
+  %c.cmp = icmp eq i32 %c, 3
+  br i1 %c.cmp, label %then, label %merge
+
+then:
+  %v = load i32* %p
+  %v.cmp = icmp eq i32 %v, 0
+  br i1 %v.cmp, label %merge, label %else
+
+else:
+  br label %merge
+
+merge:
+  %r = phi i32 [ 0, %entry ], [ 1, %then ], [ 2, %else ]
+  %r.cmp = icmp eq i32 %r, 1
+  br i1 %r.cmp, label %exit, label %last
+
+last:
+  br label %exit
+
+exit:
+  %s = phi i32 [ 0, %merge ], [ %r, %last ]
+  ret i32 %s
+}
+
+; CHECK: Input dependence of function 'caller':
+; CHECK-NEXT:  branch 'entry': input-dependent
+define i32 @caller() {
+entry:
+  %x = call i32 @constant(i32* null)
+  %x.cmp = icmp eq i32 %x, 0
+  br i1 %x.cmp, label %exit, label %other
+
+other:
+  br label %exit
+
+exit:
+  %r = phi i32 [ 0, %entry ], [ 1, %other ]
+  ret i32 %r
+}
@@ -0,0 +1,69 @@
+; RUN: llc -mtriple=patmos-unknown-unknown-elf %s -mserialize=%t.pml \
+; RUN:   -mserialize-all -o /dev/null
+; RUN: llc -mtriple=patmos-unknown-unknown-elf %s -mimport-pml=%t.pml \
+; RUN:   -mimport-pml=%S/Inputs/bypass-from-pml.pml \
+; RUN:   -mpatmos-enable-bypass-from-pml -o - | FileCheck %s
+; RUN: llc -mtriple=patmos-unknown-unknown-elf %s -mimport-pml=%t.pml \
+; RUN:   -mimport-pml=%S/Inputs/bypass-from-pml.pml \
+; RUN:   -mpatmos-enable-bypass-from-pml -mpatmos-bypass-stores -o - \
+; RUN:   | FileCheck %s -check-prefix=STORES
+
+; The value facts mark the store in @stores and the second load in @loads
+; as accesses to unpredictable addresses.
+
+; Stores stay cached by default, so they do not make the loop a streaming
+; loop either.
+; CHECK-LABEL: stores:
+; CHECK: lwc
+; CHECK: swc
+; STORES-LABEL: stores:
+; STORES: lwm
+; STORES: swm
+define void @stores(i32* %a, i32* %b, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %inc, %loop ]
+  %pa = getelementptr i32* %a, i32 %i
+  %v = load i32* %pa
+  %pb = getelementptr i32* %b, i32 %v
+  store i32 %i, i32* %pb
+  %inc = add i32 %i, 1
+  %cmp = icmp slt i32 %inc, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret void
+}
+
+; Half of the loads are unpredictable, so all loads of the loop bypass the
+; cache. When stores are bypassed as well, the store counts too, and only
+; the unpredictable load is rewritten.
+; CHECK-LABEL: loads:
+; CHECK: lwm
+; CHECK: lwm
+; CHECK: swc
+; STORES-LABEL: loads:
+; STORES: lwc
+; STORES: lwm
+; STORES: swc
+define void @loads(i32* %a, i32* %b, i32* %c, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %inc, %loop ]
+  %pa = getelementptr i32* %a, i32 %i
+  %v = load i32* %pa
+  %pb = getelementptr i32* %b, i32 %v
+  %w = load i32* %pb
+  %pc = getelementptr i32* %c, i32 %i
+  store i32 %w, i32* %pc
+  %inc = add i32 %i, 1
+  %cmp = icmp slt i32 %inc, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret void
+}
@@ -0,0 +1,67 @@
+; RUN: llc < %s -mtriple=patmos-unknown-unknown-elf \
+; RUN:   -mpatmos-basicblock-align=16 -mpatmos-function-splitter-stats=%t.csv \
+; RUN:   | FileCheck %s
+; RUN: FileCheck %s -check-prefix=REGION < %t.csv
+; RUN: llc < %s -mtriple=patmos-unknown-unknown-elf \
+; RUN:   -mpatmos-basicblock-align=16 -mpatmos-preferred-subfunction-size=16 \
+; RUN:   -mpatmos-function-splitter-stats=%t.split.csv -o /dev/null
+; RUN: FileCheck %s -check-prefix=SPLIT < %t.split.csv
+; RUN: llc < %s -mtriple=patmos-unknown-unknown-elf \
+; RUN:   -mpatmos-function-splitter-stats=%t.none.csv -o /dev/null
+; RUN: FileCheck %s -check-prefix=NONE < %t.none.csv
+
+; All basic blocks are aligned, the entry block directly follows the size
+; word of the function.
+; CHECK:      .align 16
+; CHECK:      .fstart f, .Ltmp0-f, 16
+; CHECK-NEXT: f:
+; CHECK:      brnd .LBB0_3
+; CHECK-NEXT: .align 16
+; CHECK:      brnd .LBB0_2
+; CHECK-NEXT: .align 16
+; CHECK:      add $r1 = $r1, 3
+; CHECK-NEXT: .align 16
+; CHECK-NEXT: .LBB0_3:
+; CHECK:      .align 16
+; CHECK-NEXT: .LBB0_2:
+
+; The blocks of the single region are padded with 8 and 12 bytes. All blocks
+; have the same alignment, so reordering them cannot save padding.
+; REGION: "f", "pad", 20, 0, 0
+
+; With one region per block, the padding is emitted between the regions and
+; is not loaded into the method cache.
+; SPLIT: "f", "pad", 0, 32, 0
+
+; Without basic block alignment, there is no padding inside the function.
+; NONE: "f", "pad", 0, 0, 0
+
+define i32 @f(i32 %x, i32 %y) {
+entry:
+  %c = icmp eq i32 %x, 0
+  br i1 %c, label %small, label %test
+
+test:
+  %d = icmp eq i32 %y, 0
+  br i1 %d, label %large, label %medium
+
+small:
+  %s = add i32 %x, 1
+  br label %exit
+
+medium:
+  %m1 = mul i32 %x, %y
+  %m2 = add i32 %m1, 3
+  br label %exit
+
+large:
+  %l1 = mul i32 %x, %x
+  %l2 = mul i32 %l1, %y
+  %l3 = xor i32 %l2, 7
+  %l4 = sub i32 %l3, %y
+  br label %exit
+
+exit:
+  %r = phi i32 [ %s, %small ], [ %m2, %medium ], [ %l4, %large ]
+  ret i32 %r
+}
@@ -0,0 +1,47 @@
+; RUN: llvm-as < %s > %t.bc
+; RUN: llc -mtriple=patmos-unknown-unknown-elf %t.bc -o %t.s
+; RUN: llc -mtriple=patmos-unknown-unknown-elf -lazy-materialize %t.bc \
+; RUN:   -o %t.lazy.s 2> %t.err
+; RUN: count 0 < %t.err
+; RUN: diff %t.s %t.lazy.s
+; RUN: FileCheck %s < %t.lazy.s
+
+; Without warnings, the code is generated one function at a time. Local
+; functions keep their linkage for calls that are emitted after their bodies
+; have been released again.
+
+; CHECK: .Lpriv:
+; CHECK: intern:
+; CHECK-NOT: .globl intern
+; CHECK: f:
+; CHECK: call{{(nd)?}} .Lpriv
+; CHECK: call{{(nd)?}} intern
+; CHECK: g:
+; CHECK: call{{(nd)?}} intern
+; CHECK: call{{(nd)?}} .Lpriv
+
+define private i32 @priv(i32 %a) noinline {
+entry:
+  %r = mul i32 %a, %a
+  ret i32 %r
+}
+
+define internal i32 @intern(i32 %a) noinline {
+entry:
+  %r = add i32 %a, 7
+  ret i32 %r
+}
+
+define i32 @f(i32 %a) {
+entry:
+  %x = call i32 @priv(i32 %a)
+  %y = call i32 @intern(i32 %x)
+  ret i32 %y
+}
+
+define i32 @g(i32 %a) {
+entry:
+  %x = call i32 @intern(i32 %a)
+  %y = call i32 @priv(i32 %x)
+  ret i32 %y
+}
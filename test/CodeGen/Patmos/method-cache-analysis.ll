@@ -0,0 +1,220 @@
+; REQUIRES: asserts
+; RUN: llc -mtriple=patmos-unknown-unknown-elf %s -mpatmos-disable-ifcvt \
+; RUN:   -mpatmos-enable-method-cache-analysis -mpatmos-method-cache-size=700 \
+; RUN:   -stats -o /dev/null 2>&1 | FileCheck %s -check-prefix=NOFREQ
+; RUN: llc -mtriple=patmos-unknown-unknown-elf %s -mpatmos-disable-ifcvt \
+; RUN:   -mserialize=%t.pml -o /dev/null
+; RUN: llc -mtriple=patmos-unknown-unknown-elf %s -mpatmos-disable-ifcvt \
+; RUN:   -mimport-pml=%t.pml -mimport-pml=%S/Inputs/method-cache-timing.pml \
+; RUN:   -mpatmos-enable-method-cache-analysis -mpatmos-method-cache-size=700 \
+; RUN:   -stats -o /dev/null 2>&1 | FileCheck %s -check-prefix=WCET
+
+; @f and @g do not fit into the method cache together with @main.
+
+; Without frequencies, both branches are simulated for 10 iterations, and
+; @f and @g evict each other.
+; NOFREQ: 31 patmos-method-cache-analysis - Predicted method cache misses
+; NOFREQ: 41 patmos-method-cache-analysis - Simulated method cache accesses
+
+; On the worst-case path, the loop runs 100 times and only calls @f, so
+; only the first accesses of @main and @f miss.
+; WCET:   2 patmos-method-cache-analysis - Predicted method cache misses
+; WCET: 201 patmos-method-cache-analysis - Simulated method cache accesses
+
+define void @f(i32* %a) noinline {
+entry:
+  %v0 = load volatile i32* %a
+  store volatile i32 %v0, i32* %a
+  %v1 = load volatile i32* %a
+  store volatile i32 %v1, i32* %a
+  %v2 = load volatile i32* %a
+  store volatile i32 %v2, i32* %a
+  %v3 = load volatile i32* %a
+  store volatile i32 %v3, i32* %a
+  %v4 = load volatile i32* %a
+  store volatile i32 %v4, i32* %a
+  %v5 = load volatile i32* %a
+  store volatile i32 %v5, i32* %a
+  %v6 = load volatile i32* %a
+  store volatile i32 %v6, i32* %a
+  %v7 = load volatile i32* %a
+  store volatile i32 %v7, i32* %a
+  %v8 = load volatile i32* %a
+  store volatile i32 %v8, i32* %a
+  %v9 = load volatile i32* %a
+  store volatile i32 %v9, i32* %a
+  %v10 = load volatile i32* %a
+  store volatile i32 %v10, i32* %a
+  %v11 = load volatile i32* %a
+  store volatile i32 %v11, i32* %a
+  %v12 = load volatile i32* %a
+  store volatile i32 %v12, i32* %a
+  %v13 = load volatile i32* %a
+  store volatile i32 %v13, i32* %a
+  %v14 = load volatile i32* %a
+  store volatile i32 %v14, i32* %a
+  %v15 = load volatile i32* %a
+  store volatile i32 %v15, i32* %a
+  %v16 = load volatile i32* %a
+  store volatile i32 %v16, i32* %a
+  %v17 = load volatile i32* %a
+  store volatile i32 %v17, i32* %a
+  %v18 = load volatile i32* %a
+  store volatile i32 %v18, i32* %a
+  %v19 = load volatile i32* %a
+  store volatile i32 %v19, i32* %a
+  %v20 = load volatile i32* %a
+  store volatile i32 %v20, i32* %a
+  %v21 = load volatile i32* %a
+  store volatile i32 %v21, i32* %a
+  %v22 = load volatile i32* %a
+  store volatile i32 %v22, i32* %a
+  %v23 = load volatile i32* %a
+  store volatile i32 %v23, i32* %a
+  %v24 = load volatile i32* %a
+  store volatile i32 %v24, i32* %a
+  %v25 = load volatile i32* %a
+  store volatile i32 %v25, i32* %a
+  %v26 = load volatile i32* %a
+  store volatile i32 %v26, i32* %a
+  %v27 = load volatile i32* %a
+  store volatile i32 %v27, i32* %a
+  %v28 = load volatile i32* %a
+  store volatile i32 %v28, i32* %a
+  %v29 = load volatile i32* %a
+  store volatile i32 %v29, i32* %a
+  %v30 = load volatile i32* %a
+  store volatile i32 %v30, i32* %a
+  %v31 = load volatile i32* %a
+  store volatile i32 %v31, i32* %a
+  %v32 = load volatile i32* %a
+  store volatile i32 %v32, i32* %a
+  %v33 = load volatile i32* %a
+  store volatile i32 %v33, i32* %a
+  %v34 = load volatile i32* %a
+  store volatile i32 %v34, i32* %a
+  %v35 = load volatile i32* %a
+  store volatile i32 %v35, i32* %a
+  %v36 = load volatile i32* %a
+  store volatile i32 %v36, i32* %a
+  %v37 = load volatile i32* %a
+  store volatile i32 %v37, i32* %a
+  %v38 = load volatile i32* %a
+  store volatile i32 %v38, i32* %a
+  %v39 = load volatile i32* %a
+  store volatile i32 %v39, i32* %a
+  ret void
+}
+
+define void @g(i32* %a) noinline {
+entry:
+  %v0 = load volatile i32* %a
+  store volatile i32 %v0, i32* %a
+  %v1 = load volatile i32* %a
+  store volatile i32 %v1, i32* %a
+  %v2 = load volatile i32* %a
+  store volatile i32 %v2, i32* %a
+  %v3 = load volatile i32* %a
+  store volatile i32 %v3, i32* %a
+  %v4 = load volatile i32* %a
+  store volatile i32 %v4, i32* %a
+  %v5 = load volatile i32* %a
+  store volatile i32 %v5, i32* %a
+  %v6 = load volatile i32* %a
+  store volatile i32 %v6, i32* %a
+  %v7 = load volatile i32* %a
+  store volatile i32 %v7, i32* %a
+  %v8 = load volatile i32* %a
+  store volatile i32 %v8, i32* %a
+  %v9 = load volatile i32* %a
+  store volatile i32 %v9, i32* %a
+  %v10 = load volatile i32* %a
+  store volatile i32 %v10, i32* %a
+  %v11 = load volatile i32* %a
+  store volatile i32 %v11, i32* %a
+  %v12 = load volatile i32* %a
+  store volatile i32 %v12, i32* %a
+  %v13 = load volatile i32* %a
+  store volatile i32 %v13, i32* %a
+  %v14 = load volatile i32* %a
+  store volatile i32 %v14, i32* %a
+  %v15 = load volatile i32* %a
+  store volatile i32 %v15, i32* %a
+  %v16 = load volatile i32* %a
+  store volatile i32 %v16, i32* %a
+  %v17 = load volatile i32* %a
+  store volatile i32 %v17, i32* %a
+  %v18 = load volatile i32* %a
+  store volatile i32 %v18, i32* %a
+  %v19 = load volatile i32* %a
+  store volatile i32 %v19, i32* %a
+  %v20 = load volatile i32* %a
+  store volatile i32 %v20, i32* %a
+  %v21 = load volatile i32* %a
+  store volatile i32 %v21, i32* %a
+  %v22 = load volatile i32* %a
+  store volatile i32 %v22, i32* %a
+  %v23 = load volatile i32* %a
+  store volatile i32 %v23, i32* %a
+  %v24 = load volatile i32* %a
+  store volatile i32 %v24, i32* %a
+  %v25 = load volatile i32* %a
+  store volatile i32 %v25, i32* %a
+  %v26 = load volatile i32* %a
+  store volatile i32 %v26, i32* %a
+  %v27 = load volatile i32* %a
+  store volatile i32 %v27, i32* %a
+  %v28 = load volatile i32* %a
+  store volatile i32 %v28, i32* %a
+  %v29 = load volatile i32* %a
+  store volatile i32 %v29, i32* %a
+  %v30 = load volatile i32* %a
+  store volatile i32 %v30, i32* %a
+  %v31 = load volatile i32* %a
+  store volatile i32 %v31, i32* %a
+  %v32 = load volatile i32* %a
+  store volatile i32 %v32, i32* %a
+  %v33 = load volatile i32* %a
+  store volatile i32 %v33, i32* %a
+  %v34 = load volatile i32* %a
+  store volatile i32 %v34, i32* %a
+  %v35 = load volatile i32* %a
+  store volatile i32 %v35, i32* %a
+  %v36 = load volatile i32* %a
+  store volatile i32 %v36, i32* %a
+  %v37 = load volatile i32* %a
+  store volatile i32 %v37, i32* %a
+  %v38 = load volatile i32* %a
+  store volatile i32 %v38, i32* %a
+  %v39 = load volatile i32* %a
+  store volatile i32 %v39, i32* %a
+  ret void
+}
+
+define i32 @main() {
+entry:
+  %a = alloca i32
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %inc, %latch ]
+  %v = load volatile i32* %a
+  %c = icmp eq i32 %v, 0
+  br i1 %c, label %then, label %else
+
+then:
+  call void @f(i32* %a)
+  br label %latch
+
+else:
+  call void @g(i32* %a)
+  br label %latch
+
+latch:
+  %inc = add i32 %i, 1
+  %cmp = icmp slt i32 %inc, 100
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret i32 0
+}
@@ -0,0 +1,109 @@
+; Check that -parallel-codegen produces the same code and PML as a serial
+; compilation. By size, the first worker compiles first and second, the
+; second worker compiles main.
+;
+; RUN: llc < %s -mtriple=patmos-unknown-unknown-elf -o %t.s \
+; RUN:     -mserialize=%t.pml
+; RUN: llc < %s -mtriple=patmos-unknown-unknown-elf -parallel-codegen=2 \
+; RUN:     -o %t.par.s -mserialize=%t.par.pml
+; RUN: FileCheck %s -check-prefix=SERIAL < %t.s
+; RUN: FileCheck %s -check-prefix=PAR < %t.par.s
+; RUN: not grep .L.str %t.par.s
+;
+; The machine code is identical.
+; RUN: llvm-mc -triple=patmos-unknown-unknown-elf -filetype=obj %t.s -o %t.o
+; RUN: llvm-objdump -d %t.o > %t.dis
+; RUN: llvm-mc -triple=patmos-unknown-unknown-elf -filetype=obj %t.par.s \
+; RUN:     -o %t.o
+; RUN: llvm-objdump -d %t.o > %t.par.dis
+; RUN: diff %t.dis %t.par.dis
+;
+; The merged PML stream describes the same program.
+; RUN: FileCheck %s -check-prefix=PML < %t.par.pml
+; RUN: llvm-pml-wcet %t.pml %p/Inputs/parallel-codegen.pml \
+; RUN:     | FileCheck %s -check-prefix=WCET
+; RUN: llvm-pml-wcet %t.par.pml %p/Inputs/parallel-codegen.pml \
+; RUN:     | FileCheck %s -check-prefix=WCET
+
+; The private string is defined by the first worker and referenced by the
+; second one, so it becomes internal. Global variables are only emitted by
+; the first worker.
+; SERIAL:    li $r1 = .L.str
+; SERIAL:    .L.str:
+; PAR-LABEL: first:
+; PAR-LABEL: second:
+; PAR:       .str:
+; PAR:       counter:
+; PAR:       table:
+; PAR-LABEL: main:
+; PAR:       li $r1 = .str
+; PAR-NOT:   .str:
+; PAR-NOT:   counter:
+; PAR-NOT:   table:
+
+; Each worker appends its own PML documents, with the same function numbers
+; as the serial compilation.
+; PML:      machine-functions:
+; PML-NEXT:   - name: 0
+; PML-NEXT:     level: machinecode
+; PML-NEXT:     mapsto: first
+; PML:        - name: 1
+; PML-NEXT:     level: machinecode
+; PML-NEXT:     mapsto: second
+; PML:      bitcode-functions:
+; PML-NEXT:   - name: first
+; PML:        - name: second
+; PML:      flowfacts:
+; PML:        rhs: 10
+; PML:      machine-functions:
+; PML-NEXT:   - name: 2
+; PML-NEXT:     level: machinecode
+; PML-NEXT:     mapsto: main
+; PML:      bitcode-functions:
+; PML-NEXT:   - name: main
+
+; Both give the same WCET bound.
+; WCET:      origin: ipet
+; WCET-NEXT: level: machinecode
+; WCET-NEXT: scope:
+; WCET-NEXT:   function: 2
+; WCET-NEXT: cycles: 107
+
+@.str = private unnamed_addr constant [4 x i8] c"abc\00"
+@counter = global i32 0
+@table = internal global [2 x i32] [i32 1, i32 2]
+
+define i32 @first(i32 %x) {
+entry:
+  %a = add i32 %x, 3
+  store i32 %a, i32* @counter
+  ret i32 %a
+}
+
+define i32 @second(i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  %q = getelementptr [2 x i32]* @table, i32 0, i32 1
+  %v = load i32* %q
+  %s.next = add i32 %s, %v
+  %i.next = add i32 %i, 1
+  %c = icmp slt i32 %i.next, 10
+  br i1 %c, label %loop, label %exit
+
+exit:
+  %r = call i32 @first(i32 %s.next)
+  ret i32 %r
+}
+
+define i32 @main() {
+entry:
+  %p = getelementptr [4 x i8]* @.str, i32 0, i32 1
+  %c = load i8* %p
+  %e = zext i8 %c to i32
+  %r = call i32 @second(i32 %e)
+  ret i32 %r
+}
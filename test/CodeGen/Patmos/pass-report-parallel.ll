@@ -0,0 +1,26 @@
+; RUN: rm -f %t.json %t.json.0 %t.json.1
+; RUN: llc < %s -mtriple=patmos-unknown-unknown-elf -parallel-codegen=2 \
+; RUN:     -pass-report=%t.json -o /dev/null
+; RUN: FileCheck %s -check-prefix=PART0 < %t.json.0
+; RUN: FileCheck %s -check-prefix=PART1 < %t.json.1
+; RUN: not ls %t.json
+
+; Each worker writes the report of its own partition.
+; PART0:     "function": "first"
+; PART0-NOT: "function": "second"
+; PART1-NOT: "function": "first"
+; PART1:     "function": "second"
+
+define i32 @first(i32 %x) {
+entry:
+  %a = mul i32 %x, %x
+  %b = add i32 %a, 3
+  ret i32 %b
+}
+
+define i32 @second(i32 %x) {
+entry:
+  %a = mul i32 %x, 7
+  %b = sub i32 %a, %x
+  ret i32 %b
+}
@@ -0,0 +1,50 @@
+; REQUIRES: platin
+; RUN: llc -mtriple=patmos-unknown-unknown-elf %s -mserialize=%t.pml -o /dev/null
+; RUN: %platin transform -i %t.pml --transform-action=down \
+; RUN:   --analysis-entry=main --flow-fact-input=llvm.bc \
+; RUN:   --flow-fact-output=llvm.mc --accept-corrected-rgs -o %t.mc.pml
+; RUN: FileCheck %s < %t.mc.pml
+
+; The parametric bound of @sum and its instantiations at the two calls in
+; @main are transformed down to machine code. The call-site contexts refer
+; to the machine-code call instructions.
+
+; CHECK: flowfacts:
+; CHECK:      rhs: r4
+; CHECK-NEXT: origin: llvm.mc
+; CHECK:      context:
+; CHECK-NEXT: - callsite: 1/0/{{[0-9]+}}
+; CHECK:      rhs: '10'
+; CHECK-NEXT: origin: llvm.mc
+; CHECK:      context:
+; CHECK-NEXT: - callsite: 1/0/{{[0-9]+}}
+; CHECK:      rhs: '20'
+; CHECK-NEXT: origin: llvm.mc
+
+define internal i32 @sum(i32* %a, i32 %n) noinline {
+entry:
+  %c0 = icmp sgt i32 %n, 0
+  br i1 %c0, label %for.body, label %for.end
+
+for.body:
+  %i = phi i32 [ 0, %entry ], [ %inc, %for.body ]
+  %s = phi i32 [ 0, %entry ], [ %add, %for.body ]
+  %p = getelementptr i32* %a, i32 %i
+  %v = load i32* %p
+  %add = add i32 %s, %v
+  %inc = add nsw i32 %i, 1
+  %cmp = icmp slt i32 %inc, %n
+  br i1 %cmp, label %for.body, label %for.end
+
+for.end:
+  %r = phi i32 [ 0, %entry ], [ %add, %for.body ]
+  ret i32 %r
+}
+
+define i32 @main(i32* %a) {
+entry:
+  %x = call i32 @sum(i32* %a, i32 10)
+  %y = call i32 @sum(i32* %a, i32 20)
+  %z = add i32 %x, %y
+  ret i32 %z
+}
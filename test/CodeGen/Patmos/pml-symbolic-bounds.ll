@@ -0,0 +1,222 @@
+; RUN: llc -mtriple=patmos-unknown-unknown-elf %s -mserialize=%t.pml \
+; RUN:   -mserialize-all -o /dev/null
+; RUN: FileCheck %s < %t.pml
+; RUN: llc -mtriple=patmos-unknown-unknown-elf %s -mserialize=%t.part.pml \
+; RUN:   -mserialize-all -parallel-codegen=2 -o /dev/null
+; RUN: FileCheck %s -check-prefix=PART < %t.part.pml
+
+; Loop bounds over arguments are exported as parametric flow facts, and
+; instantiated for the calls with constant arguments.
+
+; CHECK: flowfacts:
+; CHECK:      function: sum
+; CHECK:      block: for.body
+; CHECK:      rhs: '%n'
+; CHECK:      block: loop
+; CHECK:      rhs: '(1 + ((-1 + %n) /u 2))'
+
+; CHECK:      context:
+; CHECK-NEXT:   - callsite: small/entry/0
+; CHECK:      rhs: 10
+; The bound is evaluated at i32, where -1 + %n wraps around for n = 0.
+; CHECK:      context:
+; CHECK-NEXT:   - callsite: small/entry/1
+; CHECK:      rhs: 2147483648
+; CHECK:      context:
+; CHECK-NEXT:   - callsite: small/entry/2
+; CHECK:      rhs: 5
+; CHECK:      context:
+; CHECK-NEXT:   - callsite: other/entry/0
+; CHECK:      rhs: 20
+
+; @sum is internal and all its calls are seen, so the largest bound also
+; holds without a context.
+; CHECK:      scope:
+; CHECK-NEXT:   function: sum
+; CHECK-NEXT:   loop: for.body
+; CHECK-NEXT: lhs:
+; CHECK:      rhs: 20
+; CHECK-NEXT: level: bitcode
+
+; A partition does not see the calls of the other partitions, so only the
+; call-site facts are exported.
+; PART:     callsite: small/entry/0
+; PART:     rhs: 10
+; PART-NOT: rhs: 20
+
+define internal i32 @sum(i32* %a, i32 %n) noinline {
+entry:
+  %c0 = icmp sgt i32 %n, 0
+  br i1 %c0, label %for.body, label %for.end
+
+for.body:
+  %i = phi i32 [ 0, %entry ], [ %inc, %for.body ]
+  %s = phi i32 [ 0, %entry ], [ %add, %for.body ]
+  %p = getelementptr i32* %a, i32 %i
+  %v = load i32* %p
+  %add = add i32 %s, %v
+  %inc = add nsw i32 %i, 1
+  %cmp = icmp slt i32 %inc, %n
+  br i1 %cmp, label %for.body, label %for.end
+
+for.end:
+  %r = phi i32 [ 0, %entry ], [ %add, %for.body ]
+  ret i32 %r
+}
+
+define void @step2(i32* %a, i32 %n) noinline {
+entry:
+  %c0 = icmp ne i32 %n, 0
+  br i1 %c0, label %loop, label %exit
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %inc, %loop ]
+  %p = getelementptr i32* %a, i32 %i
+  store i32 0, i32* %p
+  %inc = add nuw i32 %i, 2
+  %cmp = icmp ult i32 %inc, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret void
+}
+
+define i32 @small(i32* %a) {
+entry:
+  %x = call i32 @sum(i32* %a, i32 10)
+  call void @step2(i32* %a, i32 0)
+  call void @step2(i32* %a, i32 9)
+  ret i32 %x
+}
+
+; Moves @other into a second partition with -parallel-codegen=2.
+define void @filler(i32* %a) {
+entry:
+  %v0 = load volatile i32* %a
+  store volatile i32 %v0, i32* %a
+  %v1 = load volatile i32* %a
+  store volatile i32 %v1, i32* %a
+  %v2 = load volatile i32* %a
+  store volatile i32 %v2, i32* %a
+  %v3 = load volatile i32* %a
+  store volatile i32 %v3, i32* %a
+  %v4 = load volatile i32* %a
+  store volatile i32 %v4, i32* %a
+  %v5 = load volatile i32* %a
+  store volatile i32 %v5, i32* %a
+  %v6 = load volatile i32* %a
+  store volatile i32 %v6, i32* %a
+  %v7 = load volatile i32* %a
+  store volatile i32 %v7, i32* %a
+  %v8 = load volatile i32* %a
+  store volatile i32 %v8, i32* %a
+  %v9 = load volatile i32* %a
+  store volatile i32 %v9, i32* %a
+  %v10 = load volatile i32* %a
+  store volatile i32 %v10, i32* %a
+  %v11 = load volatile i32* %a
+  store volatile i32 %v11, i32* %a
+  %v12 = load volatile i32* %a
+  store volatile i32 %v12, i32* %a
+  %v13 = load volatile i32* %a
+  store volatile i32 %v13, i32* %a
+  %v14 = load volatile i32* %a
+  store volatile i32 %v14, i32* %a
+  %v15 = load volatile i32* %a
+  store volatile i32 %v15, i32* %a
+  %v16 = load volatile i32* %a
+  store volatile i32 %v16, i32* %a
+  %v17 = load volatile i32* %a
+  store volatile i32 %v17, i32* %a
+  %v18 = load volatile i32* %a
+  store volatile i32 %v18, i32* %a
+  %v19 = load volatile i32* %a
+  store volatile i32 %v19, i32* %a
+  %v20 = load volatile i32* %a
+  store volatile i32 %v20, i32* %a
+  %v21 = load volatile i32* %a
+  store volatile i32 %v21, i32* %a
+  %v22 = load volatile i32* %a
+  store volatile i32 %v22, i32* %a
+  %v23 = load volatile i32* %a
+  store volatile i32 %v23, i32* %a
+  %v24 = load volatile i32* %a
+  store volatile i32 %v24, i32* %a
+  %v25 = load volatile i32* %a
+  store volatile i32 %v25, i32* %a
+  %v26 = load volatile i32* %a
+  store volatile i32 %v26, i32* %a
+  %v27 = load volatile i32* %a
+  store volatile i32 %v27, i32* %a
+  %v28 = load volatile i32* %a
+  store volatile i32 %v28, i32* %a
+  %v29 = load volatile i32* %a
+  store volatile i32 %v29, i32* %a
+  %v30 = load volatile i32* %a
+  store volatile i32 %v30, i32* %a
+  %v31 = load volatile i32* %a
+  store volatile i32 %v31, i32* %a
+  %v32 = load volatile i32* %a
+  store volatile i32 %v32, i32* %a
+  %v33 = load volatile i32* %a
+  store volatile i32 %v33, i32* %a
+  %v34 = load volatile i32* %a
+  store volatile i32 %v34, i32* %a
+  %v35 = load volatile i32* %a
+  store volatile i32 %v35, i32* %a
+  %v36 = load volatile i32* %a
+  store volatile i32 %v36, i32* %a
+  %v37 = load volatile i32* %a
+  store volatile i32 %v37, i32* %a
+  %v38 = load volatile i32* %a
+  store volatile i32 %v38, i32* %a
+  %v39 = load volatile i32* %a
+  store volatile i32 %v39, i32* %a
+  %v40 = load volatile i32* %a
+  store volatile i32 %v40, i32* %a
+  %v41 = load volatile i32* %a
+  store volatile i32 %v41, i32* %a
+  %v42 = load volatile i32* %a
+  store volatile i32 %v42, i32* %a
+  %v43 = load volatile i32* %a
+  store volatile i32 %v43, i32* %a
+  %v44 = load volatile i32* %a
+  store volatile i32 %v44, i32* %a
+  %v45 = load volatile i32* %a
+  store volatile i32 %v45, i32* %a
+  %v46 = load volatile i32* %a
+  store volatile i32 %v46, i32* %a
+  %v47 = load volatile i32* %a
+  store volatile i32 %v47, i32* %a
+  %v48 = load volatile i32* %a
+  store volatile i32 %v48, i32* %a
+  %v49 = load volatile i32* %a
+  store volatile i32 %v49, i32* %a
+  %v50 = load volatile i32* %a
+  store volatile i32 %v50, i32* %a
+  %v51 = load volatile i32* %a
+  store volatile i32 %v51, i32* %a
+  %v52 = load volatile i32* %a
+  store volatile i32 %v52, i32* %a
+  %v53 = load volatile i32* %a
+  store volatile i32 %v53, i32* %a
+  %v54 = load volatile i32* %a
+  store volatile i32 %v54, i32* %a
+  %v55 = load volatile i32* %a
+  store volatile i32 %v55, i32* %a
+  %v56 = load volatile i32* %a
+  store volatile i32 %v56, i32* %a
+  %v57 = load volatile i32* %a
+  store volatile i32 %v57, i32* %a
+  %v58 = load volatile i32* %a
+  store volatile i32 %v58, i32* %a
+  %v59 = load volatile i32* %a
+  store volatile i32 %v59, i32* %a
+  ret void
+}
+
+define i32 @other(i32* %a) {
+entry:
+  %x = call i32 @sum(i32* %a, i32 20)
+  ret i32 %x
+}
@@ -0,0 +1,147 @@
+; RUN: llc < %s -mtriple=patmos-unknown-unknown-elf -mpatmos-singlepath-auto \
+; RUN:   -mpatmos-singlepath-auto-report=%t.csv | FileCheck %s -check-prefix=AUTO
+; RUN: FileCheck %s -check-prefix=REPORT < %t.csv
+; RUN: llc < %s -mtriple=patmos-unknown-unknown-elf \
+; RUN:   -mpatmos-singlepath=independent \
+; RUN:   -mpatmos-singlepath-auto-report=%t.roots.csv \
+; RUN:   | FileCheck %s -check-prefix=ROOTS
+; RUN: FileCheck %s -check-prefix=REPORT < %t.roots.csv
+
+; Only the balanced function is selected, its input-dependent branch is
+; converted to predicated code.
+; AUTO-LABEL: balanced:
+; AUTO: pand
+; AUTO-LABEL: independent:
+; AUTO-NOT: pand
+; AUTO-LABEL: expensive:
+; AUTO-NOT: pand
+; AUTO-LABEL: dependent:
+; AUTO-NOT: pand
+; AUTO-LABEL: calls_external:
+; AUTO-NOT: pand
+
+; REPORT: "function", "branches", "input-dependent", "path-cost", "sp-cost", "overhead", "decision"
+; REPORT-NEXT: "balanced", 2, 1, 10, 12, 20, "selected"
+; REPORT-NEXT: "independent", 1, 0, 6, 6, 0, "no input-dependent branches"
+; REPORT-NEXT: "expensive", 2, 1, 14, 21, 50, "overhead too high"
+; REPORT-NEXT: "dependent", 1, 1, 5, 5, 0, "too many input-dependent branches"
+; REPORT-NEXT: "calls_external", 1, 1, 5, 5, 0, "calls external function"
+
+; Without -mpatmos-singlepath-auto, the candidates are only reported.
+; ROOTS-NOT: pand
+
+; A loop with a constant bound and a balanced input-dependent branch
+define i32 @balanced(i32 %x) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %acc = phi i32 [ 0, %entry ], [ %acc.next, %latch ]
+  %c = icmp sgt i32 %x, %i
+  br i1 %c, label %then, label %else
+
+then:
+  %a = add i32 %acc, %i
+  br label %latch
+
+else:
+  %b = sub i32 %acc, %i
+  br label %latch
+
+latch:
+  %acc.next = phi i32 [ %a, %then ], [ %b, %else ]
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, 8
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 %acc.next
+}
+
+; The control flow does not depend on the argument
+define i32 @independent(i32 %x) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %acc = phi i32 [ %x, %entry ], [ %acc.next, %loop ]
+  %acc.next = mul i32 %acc, 3
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, 8
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 %acc.next
+}
+
+; Both sides of the input-dependent branch are expensive
+define i32 @expensive(i32 %x) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %acc = phi i32 [ 0, %entry ], [ %acc.next, %latch ]
+  %c = icmp sgt i32 %x, %i
+  br i1 %c, label %then, label %else
+
+then:
+  %a1 = mul i32 %acc, %x
+  %a2 = xor i32 %a1, %i
+  %a3 = mul i32 %a2, %a1
+  %a4 = add i32 %a3, %x
+  %a5 = mul i32 %a4, %a2
+  %a6 = xor i32 %a5, %a3
+  br label %latch
+
+else:
+  %b1 = sub i32 %acc, %x
+  %b2 = or i32 %b1, %i
+  %b3 = mul i32 %b2, %b1
+  %b4 = sub i32 %b3, %x
+  %b5 = mul i32 %b4, %b2
+  %b6 = and i32 %b5, %b3
+  br label %latch
+
+latch:
+  %acc.next = phi i32 [ %a6, %then ], [ %b6, %else ]
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, 8
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 %acc.next
+}
+
+; The only branch depends on the argument
+define i32 @dependent(i32 %x) {
+entry:
+  %c = icmp sgt i32 %x, 0
+  br i1 %c, label %then, label %exit
+
+then:
+  %a = mul i32 %x, 3
+  br label %exit
+
+exit:
+  %p = phi i32 [ %a, %then ], [ 0, %entry ]
+  ret i32 %p
+}
+
+declare i32 @external(i32)
+
+define i32 @calls_external(i32 %x) {
+entry:
+  %c = icmp sgt i32 %x, 0
+  br i1 %c, label %then, label %exit
+
+then:
+  %r = call i32 @external(i32 %x)
+  br label %exit
+
+exit:
+  %p = phi i32 [ %r, %then ], [ 0, %entry ]
+  ret i32 %p
+}
@@ -0,0 +1,71 @@
+; RUN: %lli -force-interpreter=true -interpreter-flow-facts=%t.pml %s
+; RUN: FileCheck %s < %t.pml
+; RUN: %lli -force-interpreter=true -interpreter-flow-facts=%t2.pml \
+; RUN:     -interpreter-flow-facts-origin=test.bc %s
+; RUN: FileCheck %s -check-prefix=ORIGIN < %t2.pml
+
+; The loop of @sum is entered twice, with 5 and 3 header executions.
+; CHECK:      flowfacts:
+; CHECK:        - scope:
+; CHECK-NEXT:       function: sum
+; CHECK-NEXT:       loop: header
+; CHECK:            block: header
+; CHECK-NEXT:     op: less-equal
+; CHECK-NEXT:     rhs: 5
+; CHECK-NEXT:     level: bitcode
+; CHECK-NEXT:     origin: trace.bc
+
+; The failure branch of @main is never executed.
+; CHECK:        - scope:
+; CHECK-NEXT:       function: main
+; CHECK:            function: main
+; CHECK-NEXT:       block: fail
+; CHECK-NEXT:     op: less-equal
+; CHECK-NEXT:     rhs: 0
+
+; CHECK:      timing:
+; CHECK:            block: header
+; CHECK:          frequency: 8
+; CHECK:            edgesource: header
+; CHECK-NEXT:       edgetarget: body
+; CHECK:          frequency: 6
+; CHECK:            edgesource: entry
+; CHECK-NEXT:       edgetarget: fail
+; CHECK:          frequency: 0
+
+; ORIGIN: origin: test.bc
+; ORIGIN-NOT: origin: trace.bc
+
+define i32 @sum(i32 %n) {
+entry:
+  br label %header
+
+header:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %body ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %body ]
+  %cmp = icmp slt i32 %i, %n
+  br i1 %cmp, label %body, label %exit
+
+body:
+  %s.next = add i32 %s, %i
+  %i.next = add i32 %i, 1
+  br label %header
+
+exit:
+  ret i32 %s
+}
+
+define i32 @main() {
+entry:
+  %a = call i32 @sum(i32 4)
+  %b = call i32 @sum(i32 2)
+  %c = add i32 %a, %b
+  %bad = icmp ne i32 %c, 7
+  br i1 %bad, label %fail, label %ok
+
+fail:
+  ret i32 1
+
+ok:
+  ret i32 0
+}
@@ -0,0 +1,109 @@
+; RUN: opt < %s -insert-pml-edge-profiling -pml-edge-profile-notes=%t.yml -S \
+; RUN:     | FileCheck %s
+; RUN: FileCheck %s -check-prefix=NOTES < %t.yml
+; RUN: opt < %s -insert-pml-edge-profiling -pml-edge-profile-notes=%t.yml \
+; RUN:     -pml-edge-profile-base=4096 -pml-edge-profile-addrspace=1 -S \
+; RUN:     | FileCheck %s -check-prefix=BASE
+
+; The extended CFG of @f has 6 nodes (including the virtual entry/exit node)
+; and 8 edges, so 3 edges are not on the spanning tree and get a counter.
+; The self loop can never be part of the tree. @main has two edges between
+; the virtual node and its only block, one of them is counted.
+
+; CHECK: @__pml_edge_profile_counters = global [4 x i32] zeroinitializer
+; CHECK: @__pml_edge_profile_size = constant i32 16
+
+; The entry edge is counted at the end of the entry block.
+; CHECK-LABEL: define i32 @f(
+; CHECK:      entry:
+; CHECK-NEXT:   [[C0:%[0-9]+]] = load i32* getelementptr inbounds ([4 x i32]* @__pml_edge_profile_counters, i64 0, i64 0)
+; CHECK-NEXT:   [[C0N:%[0-9]+]] = add i32 [[C0]], 1
+; CHECK-NEXT:   store i32 [[C0N]], i32* getelementptr inbounds ([4 x i32]* @__pml_edge_profile_counters, i64 0, i64 0)
+; CHECK-NEXT:   br label %loop
+
+; The critical self loop edge is split.
+; CHECK:      loop:
+; CHECK:        br i1 %c, label %loop.loop_crit_edge, label %check
+; CHECK:      loop.loop_crit_edge:
+; CHECK-NEXT:   load i32* getelementptr inbounds ([4 x i32]* @__pml_edge_profile_counters, i64 0, i64 1)
+; CHECK:        br label %loop
+
+; Tree edges are not instrumented.
+; CHECK:      check:
+; CHECK-NEXT:   br i1 %d, label %then, label %exit
+; CHECK:      then:
+; CHECK-NEXT:   load i32* getelementptr inbounds ([4 x i32]* @__pml_edge_profile_counters, i64 0, i64 2)
+; CHECK:      exit:
+; CHECK-NEXT:   %r = phi
+; CHECK-NEXT:   ret i32 %r
+
+; CHECK-LABEL: define i32 @main(
+; CHECK:        call i32 @f(
+; CHECK-NEXT:   load i32* getelementptr inbounds ([4 x i32]* @__pml_edge_profile_counters, i64 0, i64 3)
+
+; NOTES:      counter-size: 4
+; NOTES-NEXT: big-endian: true
+; NOTES-NEXT: counters: 4
+; NOTES-NEXT: functions:
+; NOTES-NEXT:   - name: f
+; NOTES-NEXT:     edges:
+; NOTES-NEXT:       - target: entry
+; NOTES-NEXT:         counter: 0
+; NOTES-NEXT:       - source: entry
+; NOTES-NEXT:         target: loop
+; NOTES-NEXT:       - source: loop
+; NOTES-NEXT:         target: loop
+; NOTES-NEXT:         counter: 1
+; NOTES-NEXT:       - source: loop
+; NOTES-NEXT:         target: check
+; NOTES-NEXT:       - source: check
+; NOTES-NEXT:         target: then
+; NOTES-NEXT:       - source: check
+; NOTES-NEXT:         target: exit
+; NOTES-NEXT:       - source: then
+; NOTES-NEXT:         target: exit
+; NOTES-NEXT:         counter: 2
+; NOTES-NEXT:       - source: exit
+; NOTES-NEXT:   - name: main
+; NOTES-NEXT:     edges:
+; NOTES-NEXT:       - target: entry
+; NOTES-NEXT:         counter: 3
+; NOTES-NEXT:       - source: entry
+; NOTES-NEXT: ...
+
+; Counters at a fixed address are cleared on entry of main.
+; BASE-NOT: @__pml_edge_profile_counters
+; BASE: load i32 addrspace(1)* getelementptr inbounds ([4 x i32] addrspace(1)* inttoptr (i64 4096 to [4 x i32] addrspace(1)*), i64 0, i64 0)
+; BASE-LABEL: define i32 @main(
+; BASE-NEXT: entry:
+; BASE-NEXT:   call void @__pml_edge_profile_clear()
+; BASE-LABEL: define void @__pml_edge_profile_clear()
+; BASE:   store volatile i32 0
+; BASE:   icmp ult i32 {{%.*}}, 4
+
+define i32 @f(i32 %n, i1 %d) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %i.next = add i32 %i, 1
+  %c = icmp slt i32 %i.next, %n
+  br i1 %c, label %loop, label %check
+
+check:
+  br i1 %d, label %then, label %exit
+
+then:
+  br label %exit
+
+exit:
+  %r = phi i32 [ %i.next, %check ], [ 0, %then ]
+  ret i32 %r
+}
+
+define i32 @main() {
+entry:
+  %r = call i32 @f(i32 10, i1 true)
+  ret i32 %r
+}
@@ -0,0 +1,27 @@
+# Repeated instruction words are decoded from the decode cache. Check that
+# cached words keep their bundle bit and ALUl immediates.
+# RUN: llvm-mc -triple=patmos-unknown-unknown-elf -filetype=obj %s -o - \
+# RUN:   | llvm-objdump -d - | FileCheck %s
+
+# CHECK: 0: 02 02 32 00 add $r1 = $r3, $r4
+# CHECK-NEXT: 4: 87 c2 10 00 00 03 0d 40 add $r1 = $r1, 200000
+# CHECK-NEXT: c: 02 02 32 00 add $r1 = $r3, $r4
+# CHECK-NEXT: 10: 87 c2 10 00 00 03 0d 40 add $r1 = $r1, 200000
+# CHECK-NEXT: 18: 87 c2 10 00 ff ff ff f6 add $r1 = $r1, -10
+# CHECK-NEXT: 20: 82 02 32 00 { add $r1 = $r3, $r4
+# CHECK-NEXT: 24: 02 04 32 01 sub $r2 = $r3, $r4 }
+# CHECK-NEXT: 28: 02 02 32 00 add $r1 = $r3, $r4
+# CHECK-NEXT: 2c: 02 04 32 01 sub $r2 = $r3, $r4
+# CHECK-NEXT: 30: 87 c2 10 00 ff ff ff f6 add $r1 = $r1, -10
+
+	.text
+f:
+	add	$r1 = $r3, $r4
+	add	$r1 = $r1, 200000
+	add	$r1 = $r3, $r4
+	add	$r1 = $r1, 200000
+	add	$r1 = $r1, -10
+	{ add $r1 = $r3, $r4 ; sub $r2 = $r3, $r4 }
+	add	$r1 = $r3, $r4
+	sub	$r2 = $r3, $r4
+	add	$r1 = $r1, -10
@@ -0,0 +1,32 @@
+# llvm-objdump decodes the Patmos symbols as a whole with decodeRegion.
+# Check that the symbols are split correctly, that an ALUl instruction
+# right before the next symbol is decoded, and that trailing bytes are
+# reported as invalid.
+# RUN: llvm-mc -triple=patmos-unknown-unknown-elf -filetype=obj %s -o %t.o
+# RUN: llvm-objdump -d %t.o 2> %t.err | FileCheck %s
+# RUN: FileCheck %s -check-prefix=ERR < %t.err
+
+# CHECK: f:
+# CHECK-NEXT: 0: 02 02 32 00 add $r1 = $r3, $r4
+# CHECK-NEXT: 4: 87 c2 10 00 00 03 0d 40 add $r1 = $r1, 200000
+# CHECK: g:
+# CHECK-NEXT: c: 02 04 32 01 sub $r2 = $r3, $r4
+# CHECK-NEXT: 10: 87 c2 10 00 ff ff ff f6 add $r1 = $r1, -10
+# CHECK: h:
+# CHECK-NEXT: 18: 02 02 32 00 add $r1 = $r3, $r4
+# CHECK-NOT: {{.}}
+
+# ERR: warning: invalid instruction encoding
+# ERR-NEXT: warning: invalid instruction encoding
+# ERR-NOT: warning
+
+	.text
+f:
+	add	$r1 = $r3, $r4
+	add	$r1 = $r1, 200000
+g:
+	sub	$r2 = $r3, $r4
+	add	$r1 = $r1, -10
+h:
+	add	$r1 = $r3, $r4
+	.byte	1, 2
@@ -0,0 +1,42 @@
+# ALUi instructions with symbolic immediates are relaxed to ALUl when the
+# value is not known or does not fit into 12 bits, unless they are bundled.
+# RUN: llvm-mc -triple=patmos-unknown-unknown-elf -filetype=obj %s -o %t.o
+# RUN: llvm-objdump -d %t.o | FileCheck %s
+# RUN: llvm-readobj -r %t.o | FileCheck %s -check-prefix=RELOC
+
+# Symbols resolved by the linker get the long format.
+# CHECK: f:
+# CHECK-NEXT: 0: 87 c2 10 00 00 00 00 00 add $r1 = $r1, 0
+# CHECK-NEXT: 8: 87 c4 20 00 00 00 00 00 add $r2 = $r2, 0
+
+# A label difference below 4096 stays short.
+# CHECK-NEXT: 10: 00 06 30 1c add $r3 = $r3, 28
+
+# Bundled instructions are never relaxed.
+# CHECK-NEXT: 14: 80 08 40 00 { mov $r4 = $r4
+# CHECK-NEXT: 18: 00 0a 50 01 add $r5 = $r5, 1 }
+
+# A label difference of 4096 or more is relaxed.
+# CHECK: h:
+# CHECK-NEXT: 1c: 87 cc 60 00 00 00 10 24 add $r6 = $r6, 4132
+
+# RELOC:      Section (2) .rel.text {
+# RELOC-NEXT:   0x0 R_PATMOS_ALUL_ABS far 0x0
+# RELOC-NEXT:   0x8 R_PATMOS_ALUL_ABS ext 0x0
+# RELOC-NEXT:   0x14 R_PATMOS_ALUI_ABS ext 0x0
+# RELOC-NEXT: }
+
+	.text
+f:
+	add	$r1 = $r1, far
+	add	$r2 = $r2, ext
+	add	$r3 = $r3, h - f
+	{ add	$r4 = $r4, ext ; add $r5 = $r5, 1 }
+h:
+	add	$r6 = $r6, g - f
+	.space	4096
+g:
+
+	.data
+far:
+	.word	0
@@ -0,0 +1,43 @@
+; RUN: opt < %s -Oanalyzable -S | FileCheck %s
+
+; The analyzable pipeline keeps the loop and its bound. The loop is rotated,
+; so the bound moves to the new header, the former loop body, and the header
+; executes one time less per entry.
+
+; CHECK-LABEL: @sum(
+; CHECK: entry:
+; CHECK: br i1 %{{.*}}, label %[[PH:.*]], label %exit
+; CHECK: [[PH]]:
+; CHECK: br label %[[HEADER:.*]]
+; CHECK: [[HEADER]]:
+; CHECK-NEXT: phi i32
+; CHECK-NEXT: phi i32
+; CHECK-NEXT: call void @llvm.loopbound(i32 0, i32 99)
+; CHECK: load i32*
+; CHECK: br i1 %{{.*}}, label %[[HEADER]], label
+; CHECK-NOT: llvm.loopbound(
+; CHECK: ret i32
+
+declare void @llvm.loopbound(i32, i32)
+
+define i32 @sum(i32* %a, i32 %n) {
+entry:
+  br label %header
+
+header:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %body ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %body ]
+  call void @llvm.loopbound(i32 0, i32 100)
+  %cmp = icmp slt i32 %i, %n
+  br i1 %cmp, label %body, label %exit
+
+body:
+  %p = getelementptr i32* %a, i32 %i
+  %v = load i32* %p
+  %s.next = add i32 %s, %v
+  %i.next = add i32 %i, 1
+  br label %header
+
+exit:
+  ret i32 %s
+}
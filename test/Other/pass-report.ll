@@ -0,0 +1,41 @@
+; RUN: opt < %s -inline -instcombine -pass-report=%t.json -disable-output
+; RUN: FileCheck %s < %t.json
+; RUN: opt < %s -insert-pml-edge-profiling -pml-edge-profile-notes=%t.yml \
+; RUN:     -pass-report=%t.fly.json -disable-output
+; RUN: FileCheck %s -check-prefix=FLY < %t.fly.json
+; REQUIRES: asserts
+
+; Call graph SCC passes are reported per SCC, function passes per function.
+; CHECK:      "pass": "Function Integration/Inlining", "arg": "inline", "instance": [[INL:[0-9]+]],
+; CHECK-NEXT: "scc": "callee", "runs": 1, "wall": {{[0-9.]+}}, "user": {{[0-9.]+}}, "system": {{[0-9.]+}}, "peak_rss_growth": {{[0-9]+}},
+; CHECK-NEXT: "statistics": [] },
+; CHECK:      "pass": "Combine redundant instructions", "arg": "instcombine",
+; CHECK-NEXT: "function": "callee", "runs": 1,
+; CHECK:      "pass": "Function Integration/Inlining", "arg": "inline", "instance": [[INL]],
+; CHECK-NEXT: "scc": "caller", "runs": 1,
+; CHECK-NEXT: "statistics": [{{.*}}{ "group": "inline", "desc": "Number of functions inlined", "value": 1 }
+; CHECK:      "pass": "Combine redundant instructions", "arg": "instcombine",
+; CHECK-NEXT: "function": "caller", "runs": 1,
+; CHECK:      "peak_rss": {{[0-9]+}}
+; CHECK-NEXT: }
+
+; Function analyses run on the fly for a module pass are reported per
+; function, before the module pass that requires them.
+; FLY:      "pass": "Block Frequency Analysis", "arg": "block-freq",
+; FLY-NEXT: "function": "callee", "runs": 1,
+; FLY:      "pass": "Block Frequency Analysis", "arg": "block-freq",
+; FLY-NEXT: "function": "caller", "runs": 1,
+; FLY:      "pass": "PML Edge Profiler", "arg": "insert-pml-edge-profiling",
+; FLY-NEXT: "module": "<stdin>", "runs": 1,
+
+define internal i32 @callee(i32 %x) {
+entry:
+  %a = add i32 %x, 1
+  ret i32 %a
+}
+
+define i32 @caller(i32 %x) {
+entry:
+  %r = call i32 @callee(i32 %x)
+  ret i32 %r
+}
@@ -0,0 +1,67 @@
+; RUN: opt < %s -S -inline -mpatmos-method-cache-size=36 | FileCheck %s
+; RUN: opt < %s -S -inline -mpatmos-method-cache-size=36 \
+; RUN:     -mpatmos-disable-cache-aware-opt | FileCheck %s -check-prefix=NOLIMIT
+
+; The loops of both callers fit into the 36 byte method cache. Inlining
+; @small keeps the loop inside the cache, because all of its constants fit
+; into the short ALU immediate (the negative one is subtracted instead).
+; The constants of @large need the long format, inlining it would grow the
+; loop beyond the cache.
+
+; CHECK-LABEL: @caller_small(
+; CHECK-NOT: call
+; CHECK: ret i32
+; CHECK-LABEL: @caller_large(
+; CHECK: call i32 @large(
+
+; NOLIMIT-NOT: call i32
+
+target triple = "patmos-unknown-unknown-elf"
+
+define internal i32 @small(i32 %x) {
+entry:
+  %a = add i32 %x, 4000
+  %b = xor i32 %a, 4001
+  %c = add i32 %b, -4002
+  %d = and i32 %c, 4003
+  ret i32 %d
+}
+
+define internal i32 @large(i32 %x) {
+entry:
+  %a = add i32 %x, 5000
+  %b = xor i32 %a, 5001
+  %c = add i32 %b, -5002
+  %d = and i32 %c, 5003
+  ret i32 %d
+}
+
+define i32 @caller_small(i32* %p, i32 %n) {
+entry:
+  br label %loop
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  %v = call i32 @small(i32 %i)
+  %s.next = add i32 %s, %v
+  %i.next = add i32 %i, 1
+  %c = icmp slt i32 %i.next, %n
+  br i1 %c, label %loop, label %exit
+exit:
+  ret i32 %s.next
+}
+
+define i32 @caller_large(i32* %p, i32 %n) {
+entry:
+  br label %loop
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  %v = call i32 @large(i32 %i)
+  %s.next = add i32 %s, %v
+  %i.next = add i32 %i, 1
+  %c = icmp slt i32 %i.next, %n
+  br i1 %c, label %loop, label %exit
+exit:
+  ret i32 %s.next
+}
@@ -0,0 +1,34 @@
+; RUN: opt < %s -S -loop-rotate | FileCheck %s
+
+; The loop bound is moved to the new header, which is executed once less than
+; the original header.
+
+declare void @llvm.loopbound(i32, i32)
+declare void @use(i32)
+
+; CHECK: @f
+; CHECK: entry:
+; CHECK-NOT: llvm.loopbound
+; CHECK: for.body:
+; CHECK-NEXT: phi
+; CHECK-NEXT: call void @llvm.loopbound(i32 0, i32 99)
+; CHECK-NOT: llvm.loopbound
+; CHECK: ret void
+define void @f(i32 %n) {
+entry:
+  br label %for.cond
+
+for.cond:
+  %i = phi i32 [ 0, %entry ], [ %inc, %for.body ]
+  call void @llvm.loopbound(i32 0, i32 100)
+  %cmp = icmp slt i32 %i, %n
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  call void @use(i32 %i)
+  %inc = add i32 %i, 1
+  br label %for.cond
+
+for.end:
+  ret void
+}
@@ -0,0 +1,55 @@
+; RUN: opt < %s -S -loop-unroll -unroll-count=4 | FileCheck %s
+; RUN: opt < %s -S -loop-unroll -unroll-runtime -unroll-count=4 | FileCheck %s -check-prefix=RUNTIME
+; RUN: opt < %s -S -loop-unroll | FileCheck %s -check-prefix=FULL
+
+; Loop bounds are divided by the unroll count and not copied into the
+; unrolled iterations or the prolog of runtime unrolling.
+
+declare void @llvm.loopbound(i32, i32)
+
+; CHECK: @partial
+; CHECK: call void @llvm.loopbound(i32 0, i32 25)
+; CHECK-NOT: llvm.loopbound
+; CHECK: ret void
+; RUNTIME: @partial
+; RUNTIME: h:
+; RUNTIME-NEXT: phi
+; RUNTIME-NEXT: call void @llvm.loopbound(i32 0, i32 25)
+; RUNTIME-NOT: llvm.loopbound
+; RUNTIME: ret void
+define void @partial(i32* %a, i32 %n) {
+entry:
+  br label %h
+
+h:
+  %i = phi i32 [ 0, %entry ], [ %i1, %h ]
+  call void @llvm.loopbound(i32 0, i32 100)
+  %p = getelementptr i32* %a, i32 %i
+  store i32 %i, i32* %p
+  %i1 = add i32 %i, 1
+  %cmp = icmp slt i32 %i1, %n
+  br i1 %cmp, label %h, label %exit
+
+exit:
+  ret void
+}
+
+; FULL: @full
+; FULL-NOT: llvm.loopbound
+; FULL: ret void
+define void @full(i32* %a) {
+entry:
+  br label %h
+
+h:
+  %i = phi i32 [ 0, %entry ], [ %i1, %h ]
+  call void @llvm.loopbound(i32 3, i32 3)
+  %p = getelementptr i32* %a, i32 %i
+  store i32 %i, i32* %p
+  %i1 = add i32 %i, 1
+  %cmp = icmp slt i32 %i1, 4
+  br i1 %cmp, label %h, label %exit
+
+exit:
+  ret void
+}
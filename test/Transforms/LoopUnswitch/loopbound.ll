@@ -0,0 +1,50 @@
+; RUN: opt < %s -S -loop-unswitch | FileCheck %s
+
+; The loop is unswitched on the invariant condition %c despite its loop bound.
+; Both versions of the loop keep the bound of the original loop.
+
+declare void @llvm.loopbound(i32, i32)
+declare void @a(i32)
+declare void @b(i32)
+
+; CHECK: @f
+; CHECK: entry:
+; CHECK-NOT: llvm.loopbound
+; CHECK: br i1 %c
+; CHECK: h.us:
+; CHECK-NEXT: phi
+; CHECK-NEXT: call void @llvm.loopbound(i32 0, i32 100)
+; CHECK-NOT: llvm.loopbound
+; CHECK: {{^}}h:
+; CHECK-NEXT: phi
+; CHECK-NEXT: call void @llvm.loopbound(i32 0, i32 100)
+; CHECK-NOT: llvm.loopbound
+; CHECK: ret void
+define void @f(i32 %n, i1 %c) {
+entry:
+  br label %h
+
+h:
+  %i = phi i32 [ 0, %entry ], [ %inc, %latch ]
+  call void @llvm.loopbound(i32 0, i32 100)
+  %cmp = icmp slt i32 %i, %n
+  br i1 %cmp, label %body, label %exit
+
+body:
+  br i1 %c, label %then, label %else
+
+then:
+  call void @a(i32 %i)
+  br label %latch
+
+else:
+  call void @b(i32 %i)
+  br label %latch
+
+latch:
+  %inc = add i32 %i, 1
+  br label %h
+
+exit:
+  ret void
+}
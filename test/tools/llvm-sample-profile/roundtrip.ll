@@ -0,0 +1,76 @@
+; Compile a Patmos object with debug information, convert a list of sampled
+; PCs into a text sample profile and read the profile back with the loader.
+; The line offsets are relative to the subprogram line (1 for scale), not to
+; the first instruction (line 2 in the binary, line 3 in the IR). The object
+; is not linked, so the addresses in the debug information are resolved with
+; R_PATMOS_ABS_32 relocations.
+
+; RUN: llc -O0 -mtriple=patmos-unknown-unknown-elf -filetype=obj %s -o %t.o
+; RUN: llvm-sample-profile %t.o -trace %S/Inputs/scale.pcs -o %t.prof
+; RUN: FileCheck %s -check-prefix=PROF < %t.prof
+; RUN: opt < %s -sample-profile -sample-profile-file=%t.prof -S | FileCheck %s
+
+; PROF:      symbol table
+; PROF-NEXT: 2
+; PROF-NEXT: id
+; PROF-NEXT: scale
+; PROF-NEXT: id:3:3:1
+; PROF-NEXT: 1: 3
+; PROF-NEXT: scale:14:1:4
+; PROF-NEXT: 2: 1
+; PROF-NEXT: 3: 2
+; PROF-NEXT: 4: 9
+; PROF-NEXT: 5: 2
+
+; Original C code for this test case:
+;
+; int scale(int x)
+; {
+;   if (x > 10)
+;     return x * 3;
+;   return x;
+; }
+;
+; int id(int x) { return x; }
+
+define i32 @id(i32 %x) {
+entry:
+  ret i32 %x, !dbg !15
+}
+
+define i32 @scale(i32 %x) {
+entry:
+  %cmp = icmp sgt i32 %x, 10, !dbg !12
+  br i1 %cmp, label %if.then, label %return, !dbg !12
+; CHECK: br i1 %cmp, label %if.then, label %return, !dbg !{{[0-9]+}}, !prof ![[WEIGHTS:[0-9]+]]
+
+if.then:
+  %mul = mul nsw i32 %x, 3, !dbg !13
+  br label %return, !dbg !13
+
+return:
+  %retval = phi i32 [ %mul, %if.then ], [ %x, %entry ]
+  ret i32 %retval, !dbg !14
+}
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!11, !16}
+
+!0 = metadata !{i32 786449, metadata !1, i32 12, metadata !"clang version 3.4", i1 true, metadata !"", i32 0, metadata !2, metadata !2, metadata !3, metadata !2, metadata !2, metadata !""} ; [ DW_TAG_compile_unit ] [./scale.c] [DW_LANG_C99]
+!1 = metadata !{metadata !"scale.c", metadata !"."}
+!2 = metadata !{i32 0}
+!3 = metadata !{metadata !4, metadata !10}
+!4 = metadata !{i32 786478, metadata !1, metadata !5, metadata !"scale", metadata !"scale", metadata !"", i32 1, metadata !6, i1 false, i1 true, i32 0, i32 0, null, i32 256, i1 true, i32 (i32)* @scale, null, null, metadata !2, i32 2} ; [ DW_TAG_subprogram ] [line 1] [def] [scope 2] [scale]
+!5 = metadata !{i32 786473, metadata !1}          ; [ DW_TAG_file_type ] [./scale.c]
+!6 = metadata !{i32 786453, i32 0, null, metadata !"", i32 0, i64 0, i64 0, i64 0, i32 0, null, metadata !7, i32 0, null, null, null} ; [ DW_TAG_subroutine_type ] [line 0, size 0, align 0, offset 0] [from ]
+!7 = metadata !{metadata !8, metadata !8}
+!8 = metadata !{i32 786468, null, null, metadata !"int", i32 0, i64 32, i64 32, i64 0, i32 0, i32 5} ; [ DW_TAG_base_type ] [int] [line 0, size 32, align 32, offset 0, enc DW_ATE_signed]
+!10 = metadata !{i32 786478, metadata !1, metadata !5, metadata !"id", metadata !"id", metadata !"", i32 8, metadata !6, i1 false, i1 true, i32 0, i32 0, null, i32 256, i1 true, i32 (i32)* @id, null, null, metadata !2, i32 8} ; [ DW_TAG_subprogram ] [line 8] [def] [id]
+!11 = metadata !{i32 2, metadata !"Dwarf Version", i32 2}
+!12 = metadata !{i32 3, i32 0, metadata !4, null}
+!13 = metadata !{i32 4, i32 0, metadata !4, null}
+!14 = metadata !{i32 5, i32 0, metadata !4, null}
+!15 = metadata !{i32 8, i32 0, metadata !10, null}
+!16 = metadata !{i32 1, metadata !"Debug Info Version", i32 1}
+
+; CHECK: ![[WEIGHTS]] = metadata !{metadata !"branch_weights", i32 9, i32 2}
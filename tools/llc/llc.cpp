@@ -15,11 +15,15 @@
 
 
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Assembly/PrintModulePass.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/CodeGen/LinkAllAsmWriterComponents.h"
 #include "llvm/CodeGen/LinkAllCodegenComponents.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IRReader/IRReader.h"
@@ -28,9 +32,11 @@
 #include "llvm/PassManager.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FormattedStream.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PluginLoader.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
@@ -41,6 +47,10 @@
 #include "llvm/Target/TargetLibraryInfo.h"
 #include "llvm/Target/TargetMachine.h"
 #include <memory>
+#ifdef LLVM_ON_UNIX
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 using namespace llvm;
 
 // General options for llc.  Other pass-specific options are specified
@@ -78,7 +88,22 @@ DisableSimplifyLibCalls("disable-simplify-libcalls",
                         cl::desc("Disable simplify-libcalls"),
                         cl::init(false));
 
+static cl::opt<bool>
+LazyMaterialize("lazy-materialize",
+                cl::desc("Read function bodies of bitcode input on demand "
+                         "and release them once their code has been "
+                         "emitted"));
+
+static cl::opt<unsigned>
+ParallelCodeGen("parallel-codegen", cl::init(0), cl::value_desc("N"),
+                cl::desc("Split the module into N partitions and generate "
+                         "code for them in parallel worker processes "
+                         "(assembly output only)"));
+
 static int compileModule(char**, LLVMContext&);
+static bool compilePartitions(const char *, TargetMachine &, Module *, int &);
+static bool isStringOptionSet(const char *Name);
+static void runFunctionAtATime(FunctionPassManager &FPM, Module *M);
 
 // GetFileNameRoot - Helper function to get the basename of a filename.
 static inline std::string
@@ -211,7 +236,10 @@ static int compileModule(char **argv, LLVMContext &Context) {
 
   // If user just wants to list available options, skip module loading
   if (!SkipModule) {
-    M.reset(ParseIRFile(InputFilename, Err, Context));
+    if (LazyMaterialize)
+      M.reset(getLazyIRFileModule(InputFilename, Err, Context));
+    else
+      M.reset(ParseIRFile(InputFilename, Err, Context));
     mod = M.get();
     if (mod == 0) {
       Err.print(argv[0], errs());
@@ -305,13 +333,52 @@ static int compileModule(char **argv, LLVMContext &Context) {
       TheTriple.isMacOSXVersionLT(10, 6))
     Target.setMCUseLoc(false);
 
+  // Generate code one function at a time if the function bodies are read on
+  // demand, unless the code generator or the options need the whole module.
+  bool FunctionAtATime = false;
+  if (LazyMaterialize) {
+    const char *Reason = 0;
+    if (!Target.supportsFunctionAtATimeCodeGen())
+      Reason = "the code generator requires the whole module";
+    else if (isStringOptionSet("mserialize") ||
+             isStringOptionSet("mpreemit-bitcode"))
+      Reason = "PML and bitcode export require the whole module";
+    else if (!StopAfter.empty())
+      Reason = "-stop-after prints the whole module";
+    else if (ParallelCodeGen > 1)
+      Reason = "-parallel-codegen partitions the whole module";
+
+    if (Reason) {
+      errs() << argv[0] << ": warning: reading the whole module, "
+             << Reason << "\n";
+      std::string ErrorInfo;
+      if (mod->MaterializeAllPermanently(&ErrorInfo)) {
+        errs() << argv[0] << ": bitcode didn't read correctly.\n";
+        errs() << "Reason: " << ErrorInfo << "\n";
+        return 1;
+      }
+    } else
+      FunctionAtATime = true;
+  }
+
+  // Compile partitions of the module in worker processes, if requested. The
+  // workers continue below with their partition of the module.
+  if (ParallelCodeGen > 1) {
+    int RetVal;
+    if (compilePartitions(argv[0], Target, mod, RetVal))
+      return RetVal;
+  }
+
   // Figure out where we are going to send the output.
   OwningPtr<tool_output_file> Out
     (GetOutputStream(TheTarget->getName(), TheTriple.getOS(), argv[0]));
   if (!Out) return 1;
 
   // Build up all of the passes that we want to do to the module.
-  PassManager PM;
+  PassManager MPM;
+  FunctionPassManager FPM(mod);
+  PassManagerBase &PM = FunctionAtATime ? static_cast<PassManagerBase&>(FPM)
+                                        : MPM;
 
   // Add an appropriate TargetLibraryInfo pass for the module's triple.
   TargetLibraryInfo *TLI = new TargetLibraryInfo(TheTriple);
@@ -373,7 +440,10 @@ static int compileModule(char **argv, LLVMContext &Context) {
     // Before executing passes, print the final values of the LLVM options.
     cl::PrintOptionValues();
 
-    PM.run(*mod);
+    if (FunctionAtATime)
+      runFunctionAtATime(FPM, mod);
+    else
+      MPM.run(*mod);
   }
 
   // Declare success.
@@ -381,3 +451,259 @@ static int compileModule(char **argv, LLVMContext &Context) {
 
   return 0;
 }
+
+/// runFunctionAtATime - Generate code for the functions of the module in
+/// order, reading each function body just before and releasing it right
+/// after its code has been emitted.
+static void runFunctionAtATime(FunctionPassManager &FPM, Module *M) {
+  FPM.doInitialization();
+  for (Module::iterator F = M->begin(), E = M->end(); F != E; ++F) {
+    if (F->isDeclaration() && !F->isMaterializable())
+      continue;
+    FPM.run(*F);
+    // Keeps the body if it cannot be read again, e.g., if the address of one
+    // of its blocks is taken. Dropping the body resets the linkage to
+    // external, but later calls must still see a local function.
+    GlobalValue::LinkageTypes Linkage = F->getLinkage();
+    GlobalValue::VisibilityTypes Visibility = F->getVisibility();
+    F->Dematerialize();
+    F->setLinkage(Linkage);
+    F->setVisibility(Visibility);
+  }
+  FPM.doFinalization();
+}
+
+/// isStringOptionSet - Check whether a string option defined in one of the
+/// libraries is set.
+static bool isStringOptionSet(const char *Name) {
+  StringMap<cl::Option*> Opts;
+  cl::getRegisteredOptions(Opts);
+  cl::opt<std::string> *Opt =
+    static_cast<cl::opt<std::string>*>(Opts.lookup(Name));
+  return Opt && !Opt->empty();
+}
+
+/// Reduce the module to the functions in [Begin, End) of the defined
+/// functions. Global variables are only defined in the first partition.
+static void reduceToPartition(Module *M, ArrayRef<Function*> Functions,
+                              unsigned Begin, unsigned End) {
+  for (unsigned i = 0, e = Functions.size(); i != e; ++i) {
+    if (i < Begin || i >= End)
+      Functions[i]->deleteBody();
+  }
+  if (Begin == 0)
+    return;
+
+  std::vector<GlobalVariable*> Appending;
+  for (Module::global_iterator I = M->global_begin(), E = M->global_end();
+       I != E; ++I) {
+    if (I->hasAppendingLinkage())
+      Appending.push_back(I);
+    else if (!I->isDeclaration()) {
+      I->setInitializer(0);
+      I->setLinkage(GlobalValue::ExternalLinkage);
+    }
+  }
+  // llvm.used, llvm.global_ctors, ... are emitted by the first partition
+  for (unsigned i = 0, e = Appending.size(); i != e; ++i)
+    Appending[i]->eraseFromParent();
+
+  M->setModuleInlineAsm("");
+  if (NamedMDNode *Idents = M->getNamedMetadata("llvm.ident"))
+    M->eraseNamedMetadata(Idents);
+}
+
+/// Append the contents of a partition output file to a stream.
+static bool appendFile(const char *ProgName, StringRef Path,
+                       raw_ostream &OS) {
+  OwningPtr<MemoryBuffer> Buffer;
+  if (error_code ec = MemoryBuffer::getFile(Path, Buffer)) {
+    errs() << ProgName << ": reading " << Path << ": " << ec.message() << "\n";
+    return false;
+  }
+  OS << Buffer->getBuffer();
+  return true;
+}
+
+/// compilePartitions - Split the defined functions of the module into
+/// contiguous partitions of about the same size and compile them in forked
+/// worker processes. The workers emit assembly into temporary files, which
+/// are concatenated in partition order, so the output does not depend on
+/// the scheduling of the workers. Labels do not clash, as each worker
+/// numbers its machine functions and temporaries from a different base.
+/// PML exports of the partitions are concatenated to a PML stream. Pass
+/// reports are written by each worker, to <report>.<partition>.
+///
+/// Returns true in the parent process if the module has been compiled, with
+/// the exit code in RetVal. Returns false if the module cannot be compiled
+/// in partitions, and in the worker processes, where the module has been
+/// reduced to the partition and the output redirected to the partition file.
+static bool compilePartitions(const char *ProgName, TargetMachine &Target,
+                              Module *M, int &RetVal) {
+#ifdef LLVM_ON_UNIX
+  StringMap<cl::Option*> Opts;
+  cl::getRegisteredOptions(Opts);
+  cl::opt<std::string> *Serialize =
+    static_cast<cl::opt<std::string>*>(Opts["mserialize"]);
+  cl::opt<bool> *SerializeAll =
+    static_cast<cl::opt<bool>*>(Opts["mserialize-all"]);
+  cl::opt<std::string> *PassReport =
+    static_cast<cl::opt<std::string>*>(Opts["pass-report"]);
+
+  const char *Reason = 0;
+  if (FileType != TargetMachine::CGFT_AssemblyFile)
+    Reason = "only assembly output is supported";
+  else if (!Target.supportsModulePartitioning())
+    Reason = "the code generator requires the whole module";
+  else if (M->getNamedMetadata("llvm.dbg.cu"))
+    Reason = "debug information is not supported";
+  else if (!M->alias_empty())
+    Reason = "aliases are not supported";
+  else if (TimeCompilations > 1 || !StartAfter.empty() || !StopAfter.empty())
+    Reason = "partial or repeated compilation is not supported";
+  else if (isStringOptionSet("mpreemit-bitcode"))
+    Reason = "-mpreemit-bitcode is not supported";
+  if (Reason) {
+    errs() << ProgName << ": warning: ignoring -parallel-codegen, "
+           << Reason << "\n";
+    return false;
+  }
+
+  std::vector<Function*> Functions;
+  uint64_t TotalSize = 0;
+  for (Module::iterator F = M->begin(), FE = M->end(); F != FE; ++F) {
+    if (F->isDeclaration())
+      continue;
+    Functions.push_back(F);
+    for (Function::iterator BB = F->begin(), BE = F->end(); BB != BE; ++BB)
+      TotalSize += BB->size();
+  }
+
+  // Split into contiguous partitions, based on the number of instructions
+  unsigned NumPartitions = std::min<unsigned>(ParallelCodeGen, 256);
+  std::vector<unsigned> Begins(1, 0);
+  uint64_t Size = 0;
+  for (unsigned i = 0, e = Functions.size(); i != e; ++i) {
+    if (Begins.size() < NumPartitions &&
+        Size >= TotalSize * Begins.size() / NumPartitions)
+      Begins.push_back(i);
+    for (Function::iterator BB = Functions[i]->begin(),
+         BE = Functions[i]->end(); BB != BE; ++BB)
+      Size += BB->size();
+  }
+  NumPartitions = Begins.size();
+  Begins.push_back(Functions.size());
+  if (NumPartitions < 2)
+    return false;
+
+  // Private symbols are only visible in the partition emitting them, but
+  // all partitions end up in the same assembly file
+  for (Module::iterator I = M->begin(), E = M->end(); I != E; ++I)
+    if (I->hasPrivateLinkage())
+      I->setLinkage(GlobalValue::InternalLinkage);
+  for (Module::global_iterator I = M->global_begin(), E = M->global_end();
+       I != E; ++I)
+    if (I->hasPrivateLinkage())
+      I->setLinkage(GlobalValue::InternalLinkage);
+
+  std::string PMLFile = Serialize ? Serialize->getValue() : "";
+  std::vector<std::string> AsmFiles, PMLFiles;
+  for (unsigned p = 0; p < NumPartitions; ++p) {
+    SmallString<128> Path;
+    if (error_code ec = sys::fs::createTemporaryFile("llc-part", "s", Path)) {
+      errs() << ProgName << ": creating temporary file: " << ec.message()
+             << "\n";
+      RetVal = 1;
+      return true;
+    }
+    AsmFiles.push_back(Path.str());
+    if (!PMLFile.empty()) {
+      if (error_code ec = sys::fs::createTemporaryFile("llc-part", "pml",
+                                                       Path)) {
+        errs() << ProgName << ": creating temporary file: " << ec.message()
+               << "\n";
+        RetVal = 1;
+        return true;
+      }
+      PMLFiles.push_back(Path.str());
+    }
+  }
+
+  outs().flush();
+  errs().flush();
+
+  std::vector<pid_t> Workers;
+  for (unsigned p = 0; p < NumPartitions; ++p) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      reduceToPartition(M, Functions, Begins[p], Begins[p+1]);
+      Target.setPartitionNumbering(Begins[p], p << 24);
+      OutputFilename = AsmFiles[p];
+      if (!PMLFile.empty()) {
+        // The roots might be in a different partition
+        Serialize->setValue(PMLFiles[p]);
+        SerializeAll->setValue(true);
+      }
+      // Each worker writes its own pass report
+      if (PassReport && !PassReport->empty())
+        PassReport->setValue(PassReport->getValue() + "." + utostr(p));
+      return false;
+    }
+    if (pid < 0) {
+      errs() << ProgName << ": cannot create worker process\n";
+      break;
+    }
+    Workers.push_back(pid);
+  }
+
+  RetVal = Workers.size() == NumPartitions ? 0 : 1;
+  for (unsigned p = 0; p < Workers.size(); ++p) {
+    int Status;
+    if (waitpid(Workers[p], &Status, 0) != Workers[p] ||
+        !WIFEXITED(Status) || WEXITSTATUS(Status) != 0) {
+      errs() << ProgName << ": code generation for partition " << p
+             << " failed\n";
+      RetVal = 1;
+    }
+  }
+
+  if (RetVal == 0) {
+    OwningPtr<tool_output_file> Out
+      (GetOutputStream(Target.getTarget().getName(),
+                       Triple(M->getTargetTriple()).getOS(), ProgName));
+    if (!Out)
+      RetVal = 1;
+    for (unsigned p = 0; RetVal == 0 && p < NumPartitions; ++p)
+      if (!appendFile(ProgName, AsmFiles[p], Out->os()))
+        RetVal = 1;
+
+    if (RetVal == 0 && !PMLFile.empty()) {
+      std::string Error;
+      tool_output_file PMLOut(PMLFile.c_str(), Error);
+      if (!Error.empty()) {
+        errs() << ProgName << ": " << Error << "\n";
+        RetVal = 1;
+      }
+      for (unsigned p = 0; RetVal == 0 && p < NumPartitions; ++p)
+        if (!appendFile(ProgName, PMLFiles[p], PMLOut.os()))
+          RetVal = 1;
+      if (RetVal == 0)
+        PMLOut.keep();
+    }
+    if (RetVal == 0)
+      Out->keep();
+  }
+
+  for (unsigned p = 0; p < NumPartitions; ++p) {
+    bool Existed;
+    sys::fs::remove(AsmFiles[p], Existed);
+    if (!PMLFile.empty())
+      sys::fs::remove(PMLFiles[p], Existed);
+  }
+  return true;
+#else
+  errs() << ProgName << ": warning: ignoring -parallel-codegen, "
+         << "worker processes are not supported on this host\n";
+  return false;
+#endif
+}
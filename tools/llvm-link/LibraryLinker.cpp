@@ -21,7 +21,8 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/system_error.h"
-#include "llvm/ADT/SetOperations.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/Bitcode/Archive.h"
 #include <memory>
 #include <set>
@@ -273,6 +274,41 @@ GetAllUndefinedSymbols(Module *M, std::set<std::string> &UndefinedSymbols) {
       ++I; // Keep this symbol in the undefined symbols list
 }
 
+/// GetNewReferencedSymbols - collects the names of the symbols that are
+/// declared in an LLVM module and that have not been seen before.
+///
+/// Inputs:
+///  M - The module in which to find the referenced symbols.
+///
+/// Outputs:
+///  SeenSymbols - The interned names of all symbols seen so far, the new
+///                symbols are added.
+///  NewSymbols - The new symbols are appended, the names are owned by
+///               SeenSymbols.
+///
+static void AddNewSymbol(StringRef Name, StringSet<> &SeenSymbols,
+                         SmallVectorImpl<StringRef> &NewSymbols) {
+  // StringSet marks inserted entries with '+'.
+  StringMapEntry<char> &Entry = SeenSymbols.GetOrCreateValue(Name);
+  if (Entry.getValue() != '+') {
+    Entry.setValue('+');
+    NewSymbols.push_back(Entry.getKey());
+  }
+}
+
+static void
+GetNewReferencedSymbols(Module *M, StringSet<> &SeenSymbols,
+                        SmallVectorImpl<StringRef> &NewSymbols) {
+  for (Module::iterator I = M->begin(), E = M->end(); I != E; ++I)
+    if (I->hasName() && I->isDeclaration())
+      AddNewSymbol(I->getName(), SeenSymbols, NewSymbols);
+
+  for (Module::global_iterator I = M->global_begin(), E = M->global_end();
+       I != E; ++I)
+    if (I->hasName() && I->isDeclaration())
+      AddNewSymbol(I->getName(), SeenSymbols, NewSymbols);
+}
+
 /// LinkInArchive - opens an archive library and link in all objects which
 /// provide symbols that are currently undefined.
 ///
@@ -317,18 +353,21 @@ LibraryLinker::linkInArchive(const std::string &Filename, bool &is_native) {
   }
   is_native = false;
 
-  // Save a set of symbols that are not defined by the archive. Since we're
-  // entering a loop, there's no point searching for these multiple times. This
-  // variable is used to "set_subtract" from the set of undefined symbols.
-  std::set<std::string> NotDefinedByArchive;
-
-  // Save the current set of undefined symbols, because we may have to make
-  // multiple passes over the archive:
-  std::set<std::string> CurrentlyUndefinedSymbols;
-
-  do {
-    CurrentlyUndefinedSymbols = UndefinedSymbols;
-
+  // Each symbol is searched in the archive only once: either the archive
+  // defines it and the defining module is linked in, or the archive does not
+  // define it. The names of all searched symbols are interned here.
+  StringSet<> SearchedSymbols;
+  for (std::set<std::string>::iterator I = UndefinedSymbols.begin(),
+       E = UndefinedSymbols.end(); I != E; ++I)
+    SearchedSymbols.insert(*I);
+
+  // UndefinedSymbols is the worklist of symbols that have not been searched
+  // yet. Instead of recomputing the undefined symbols of the whole program
+  // after each round, only the symbols referenced by the newly linked modules
+  // are added.
+  SmallVector<StringRef, 64> NewReferences;
+  bool IndexWritten = false;
+  while (!UndefinedSymbols.empty()) {
     // Find the modules we need to link into the target module.  Note that arch
     // keeps ownership of these modules and may return the same Module* from a
     // subsequent call.
@@ -337,18 +376,31 @@ LibraryLinker::linkInArchive(const std::string &Filename, bool &is_native) {
       return error("Cannot find symbols in '" + Filename +
                    "': " + ErrMsg);
 
+    // Save the symbol table if it had to be built from the archive members,
+    // so the next link does not need to read all members again.
+    if ((Flags & WriteSymbolIndex) && !IndexWritten &&
+        arch->hasScannedSymbolTable() && !arch->getSymbolTable().empty()) {
+      std::string IndexErrMsg;
+      if (arch->writeSymbolIndex(&IndexErrMsg))
+        verbose("Not writing symbol index: " + IndexErrMsg);
+      else
+        verbose("Wrote symbol index '" +
+                Archive::getSymbolIndexPath(Filename) + "'");
+      IndexWritten = true;
+    }
+
+    // Any symbols remaining in UndefinedSymbols after
+    // findModulesDefiningSymbols are ones that the archive does not define.
+    // They have been searched already, so simply drop them.
+    UndefinedSymbols.clear();
+
     // If we didn't find any more modules to link this time, we are done
     // searching this archive.
     if (Modules.empty())
       break;
 
-    // Any symbols remaining in UndefinedSymbols after
-    // findModulesDefiningSymbols are ones that the archive does not define. So
-    // we add them to the NotDefinedByArchive variable now.
-    NotDefinedByArchive.insert(UndefinedSymbols.begin(),
-        UndefinedSymbols.end());
-
     // Loop over all the Modules that we got back from the archive
+    NewReferences.clear();
     for (SmallVectorImpl<Module*>::iterator I=Modules.begin(), E=Modules.end();
          I != E; ++I) {
 
@@ -361,29 +413,27 @@ LibraryLinker::linkInArchive(const std::string &Filename, bool &is_native) {
 
         verbose("  Linking in module: " + aModule->getModuleIdentifier());
 
+        // Remember the symbols the module references before linking it in
+        // destroys it.
+        GetNewReferencedSymbols(aModule, SearchedSymbols, NewReferences);
+
         // Link it in
         if (linkInModule(aModule, &moduleErrorMsg))
           return error("Cannot link in module '" +
                        aModule->getModuleIdentifier() + "': " + moduleErrorMsg);
       } 
     }
-    
-    // Get the undefined symbols from the aggregate module. This recomputes the
-    // symbols we still need after the new modules have been linked in.
-    GetAllUndefinedSymbols(getModule(), UndefinedSymbols);
-
-    // At this point we have two sets of undefined symbols: UndefinedSymbols
-    // which holds the undefined symbols from all the modules, and
-    // NotDefinedByArchive which holds symbols we know the archive doesn't
-    // define. There's no point searching for symbols that we won't find in the
-    // archive so we subtract these sets.
-    set_subtract(UndefinedSymbols, NotDefinedByArchive);
-
-    // If there's no symbols left, no point in continuing to search the
-    // archive.
-    if (UndefinedSymbols.empty())
-      break;
-  } while (CurrentlyUndefinedSymbols != UndefinedSymbols);
+
+    // Only search for the new references that are still not defined by the
+    // program.
+    Module *M = getModule();
+    for (SmallVectorImpl<StringRef>::iterator I = NewReferences.begin(),
+         E = NewReferences.end(); I != E; ++I) {
+      GlobalValue *GV = M->getNamedValue(*I);
+      if (GV && GV->isDeclaration())
+        UndefinedSymbols.insert(*I);
+    }
+  }
 
   return false;
 }
@@ -49,7 +49,9 @@ class LibraryLinker : public Linker {
     enum ControlFlags {
       Verbose       = 1, ///< Print to stderr what steps the linker is taking
       QuietWarnings = 2, ///< Don't print warnings to stderr.
-      QuietErrors   = 4  ///< Don't print errors to stderr.
+      QuietErrors   = 4, ///< Don't print errors to stderr.
+      WriteSymbolIndex = 8 ///< Save symbol tables built from archive members
+                           ///< in a symbol index next to the archive.
     };
   
   /// @}
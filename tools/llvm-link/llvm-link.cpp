@@ -83,6 +83,11 @@ static cl::opt<bool>
 NoStdLib("nostdlib",
          cl::desc("Only search directories specified on the command line."));
 
+static cl::opt<bool>
+ArchiveSymbolIndex("archive-symbol-index", cl::init(false),
+  cl::desc("Save the symbol tables of bitcode archives without LLVM symbol "
+           "table in a symbol index file next to the archive"));
+
 static bool isFileType(const std::string &FileName, sys::fs::file_magic type)
 {
   sys::fs::file_magic result;
@@ -116,9 +121,12 @@ int main(int argc, char **argv) {
     L.addSystemPaths();
   }
 
-  if (Verbose) {
-    L.setFlags(LibraryLinker::Verbose);
-  }
+  unsigned Flags = 0;
+  if (Verbose)
+    Flags |= LibraryLinker::Verbose;
+  if (ArchiveSymbolIndex)
+    Flags |= LibraryLinker::WriteSymbolIndex;
+  L.setFlags(Flags);
 
   // Link in modules, archives, and libraries
   std::vector<std::string>::const_iterator FileIt = InputFilenames.begin();
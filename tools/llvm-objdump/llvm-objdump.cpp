@@ -461,6 +461,10 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
     OwningPtr<const MCSubtargetInfo> STI(
       TheTarget->createMCSubtargetInfo(TripleName, "", FeaturesStr));
 
+    // The Patmos disassembler emits no comments, so whole symbols are decoded
+    // at once through its decode cache.
+    bool DecodeRegions = Triple(TripleName).getArch() == Triple::patmos;
+
     SmallString<40> Comments;
     raw_svector_ostream CommentStream(Comments);
 
@@ -504,12 +508,32 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
         raw_ostream &DebugOut = nulls();
 #endif
 
+      // End stops one byte short of the next symbol, but the last
+      // instruction may use the bytes up to the next symbol.
+      std::vector<MCDisassembler::DecodedInst> Decoded;
+      if (DecodeRegions) {
+        uint64_t RegionEnd = si == se - 1 ? SectSize : Symbols[si + 1].first;
+        DisAsm->decodeRegion(memoryObject, SectionAddr + Start,
+                             SectionAddr + RegionEnd, Decoded);
+      }
+      unsigned NextDecoded = 0;
+
       for (Index = Start; Index < End; Index += Size) {
         MCInst Inst;
+        MCDisassembler::DecodeStatus S;
+
+        if (NextDecoded < Decoded.size()) {
+          const MCDisassembler::DecodedInst &DI = Decoded[NextDecoded++];
+          Inst = DI.Inst;
+          Size = DI.Size;
+          S = DI.Status;
+        } else {
+          S = DisAsm->getInstruction(Inst, Size, memoryObject,
+                                     SectionAddr + Index,
+                                     DebugOut, CommentStream);
+        }
 
-        if (DisAsm->getInstruction(Inst, Size, memoryObject,
-                                   SectionAddr + Index,
-                                   DebugOut, CommentStream)) {
+        if (S) {
           outs() << format("%8" PRIx64 ":", SectionAddr + Index);
           if (!NoShowRawInsn) {
             outs() << "\t";
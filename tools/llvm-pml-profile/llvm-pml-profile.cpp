@@ -0,0 +1,299 @@
+//===-- llvm-pml-profile.cpp - Convert edge profiles to PML ---------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This tool reads the notes written by the PML edge profiling instrumentation
+// (-insert-pml-edge-profiling) and one or more dumps of the counter block of
+// instrumented runs, and generates a PML timing entry carrying the observed
+// execution frequency of every bitcode block and edge.
+//
+// Only the edges not part of the maximum spanning tree selected by the
+// instrumentation have counters. The counts of the remaining edges are
+// derived from flow conservation, by repeatedly solving the single unknown
+// edge of a block. The counts of several dumps are summed up.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/PML.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+#include <cstdlib>
+#include <vector>
+
+using namespace llvm;
+
+static cl::list<std::string>
+CounterFiles(cl::Positional, cl::desc("<counter dumps>"), cl::OneOrMore);
+
+static cl::opt<std::string>
+NotesFile("notes", cl::desc("Edge profile notes written by the "
+                            "instrumentation"),
+          cl::value_desc("filename"), cl::Required);
+
+static cl::opt<std::string>
+OutputFilename("o", cl::desc("Output PML file (default: stdout)"),
+               cl::value_desc("filename"), cl::init("-"));
+
+static cl::opt<std::string>
+AnalysisEntry("analysis-entry", cl::desc("Function used as scope of the "
+                                         "profile (default: main)"),
+              cl::init("main"));
+
+static cl::opt<unsigned long long>
+ObservedCycles("cycles", cl::desc("Observed execution time of the profiled "
+                                  "runs in cycles"), cl::init(0));
+
+static cl::opt<std::string>
+ProfileOrigin("origin", cl::desc("Origin of the generated profile "
+                                 "(default: profile)"),
+              cl::init("profile"));
+
+static const char *ToolName;
+
+static void printErrorMessages(const SMDiagnostic &Diag, void *) {
+  Diag.print(ToolName, errs(), true);
+}
+
+LLVM_ATTRIBUTE_NORETURN static void fail(const Twine &Msg) {
+  errs() << ToolName << ": " << Msg << "\n";
+  exit(1);
+}
+
+static void warn(const Twine &Msg) {
+  errs() << ToolName << ": warning: " << Msg << "\n";
+}
+
+/// Add the counters of a dump to Counts.
+static void readCounters(StringRef Filename, const yaml::EdgeProfileNotes &N,
+                         std::vector<uint64_t> &Counts) {
+  OwningPtr<MemoryBuffer> Buf;
+  if (error_code ec = MemoryBuffer::getFileOrSTDIN(Filename, Buf))
+    fail("error reading '" + Filename + "': " + ec.message());
+
+  unsigned Size = N.CounterSize;
+  if (Buf->getBufferSize() < N.NumCounters * Size)
+    fail("counter dump '" + Filename + "' is too small, expected " +
+         Twine(N.NumCounters * Size) + " bytes");
+
+  const unsigned char *Data =
+    reinterpret_cast<const unsigned char*>(Buf->getBufferStart());
+  for (uint64_t i = 0; i != N.NumCounters; ++i) {
+    const unsigned char *C = Data + i * Size;
+    uint64_t Value = 0;
+    for (unsigned b = 0; b != Size; ++b) {
+      unsigned Byte = N.BigEndian ? b : Size - b - 1;
+      Value = (Value << 8) | C[Byte];
+    }
+    Counts[i] += Value;
+  }
+}
+
+namespace {
+
+  /// An edge of a function, with its count once known.
+  struct FlowEdge {
+    yaml::EdgeProfileEdge *E;
+    unsigned Source, Target;
+    int64_t Count;
+    bool Known;
+  };
+
+  /// Derives the counts of all edges of a function from its counters.
+  class FlowSolver {
+    yaml::EdgeProfileFunction &F;
+    /// Blocks of the function, the virtual block at index 0.
+    StringMap<unsigned> BlockIndex;
+    std::vector<StringRef> Blocks;
+    std::vector<FlowEdge> Edges;
+    /// Incident edges of each block.
+    std::vector<std::vector<unsigned> > Incident;
+
+    unsigned getBlock(StringRef Name) {
+      StringMap<unsigned>::iterator I = BlockIndex.find(Name);
+      if (I != BlockIndex.end())
+        return I->second;
+      unsigned Idx = Blocks.size();
+      BlockIndex[Name] = Idx;
+      Blocks.push_back(Name);
+      Incident.push_back(std::vector<unsigned>());
+      return Idx;
+    }
+
+    /// Solve the only unknown edge incident to B, if there is one.
+    bool solveBlock(unsigned B);
+
+  public:
+    FlowSolver(yaml::EdgeProfileFunction &f) : F(f) {
+      getBlock("");
+    }
+
+    void solve(const std::vector<uint64_t> &Counts);
+
+    void exportProfile(yaml::Timing &T);
+  };
+
+}
+
+bool FlowSolver::solveBlock(unsigned B) {
+  int64_t In = 0, Out = 0;
+  int Unknown = -1;
+  for (unsigned i = 0, e = Incident[B].size(); i != e; ++i) {
+    FlowEdge &FE = Edges[Incident[B][i]];
+    // Self loops do not contribute to the balance of the block.
+    if (FE.Source == FE.Target)
+      continue;
+    if (!FE.Known) {
+      if (Unknown >= 0)
+        return false;
+      Unknown = Incident[B][i];
+      continue;
+    }
+    if (FE.Target == B) In += FE.Count;
+    else                Out += FE.Count;
+  }
+  if (Unknown < 0)
+    return false;
+
+  FlowEdge &FE = Edges[Unknown];
+  FE.Count = FE.Target == B ? Out - In : In - Out;
+  FE.Known = true;
+  if (FE.Count < 0) {
+    warn("inconsistent counts for edge " + Blocks[FE.Source] + " -> " +
+         Blocks[FE.Target] + " of function '" + F.FunctionName.getName() +
+         "'");
+    FE.Count = 0;
+  }
+  return true;
+}
+
+void FlowSolver::solve(const std::vector<uint64_t> &Counts) {
+  for (unsigned i = 0, e = F.Edges.size(); i != e; ++i) {
+    yaml::EdgeProfileEdge *E = F.Edges[i];
+    FlowEdge FE;
+    FE.E = E;
+    FE.Source = getBlock(E->Source.getName());
+    FE.Target = getBlock(E->Target.getName());
+    FE.Known = E->hasCounter();
+    FE.Count = 0;
+    if (FE.Known) {
+      if ((uint64_t)E->Counter >= Counts.size())
+        fail("invalid counter index in function '" +
+             F.FunctionName.getName() + "'");
+      FE.Count = Counts[E->Counter];
+    }
+    Incident[FE.Source].push_back(Edges.size());
+    if (FE.Target != FE.Source)
+      Incident[FE.Target].push_back(Edges.size());
+    Edges.push_back(FE);
+  }
+
+  // The unknown edges form a spanning tree, solve it from its leaves.
+  bool Changed = true;
+  while (Changed) {
+    Changed = false;
+    for (unsigned B = 0, e = Blocks.size(); B != e; ++B)
+      Changed |= solveBlock(B);
+  }
+
+  for (unsigned i = 0, e = Edges.size(); i != e; ++i) {
+    if (!Edges[i].Known) {
+      warn("count of edge " + Blocks[Edges[i].Source] + " -> " +
+           Blocks[Edges[i].Target] + " of function '" +
+           F.FunctionName.getName() + "' is undetermined");
+      Edges[i].Known = true;
+    }
+  }
+}
+
+void FlowSolver::exportProfile(yaml::Timing &T) {
+  std::vector<int64_t> BlockCounts(Blocks.size(), 0);
+  for (unsigned i = 0, e = Edges.size(); i != e; ++i) {
+    const FlowEdge &FE = Edges[i];
+    BlockCounts[FE.Target] += FE.Count;
+
+    if (FE.Source == 0 || FE.Target == 0)
+      continue;
+    yaml::ProgramPoint *PP = yaml::ProgramPoint::CreateFunction(F.FunctionName);
+    PP->EdgeSource = FE.E->Source;
+    PP->EdgeTarget = FE.E->Target;
+    yaml::ProfileEntry *P = new yaml::ProfileEntry();
+    P->setReference(PP);
+    P->Frequency = FE.Count;
+    T.Profile.push_back(P);
+  }
+
+  for (unsigned B = 1, e = Blocks.size(); B != e; ++B) {
+    yaml::ProfileEntry *P = new yaml::ProfileEntry();
+    P->setReference(yaml::ProgramPoint::CreateBlock(F.FunctionName,
+                                                    yaml::Name(Blocks[B])));
+    P->Frequency = BlockCounts[B];
+    T.Profile.push_back(P);
+  }
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+
+  llvm_shutdown_obj Y;  // Call llvm_shutdown() on exit.
+  cl::ParseCommandLineOptions(argc, argv,
+                              "PML edge profile conversion\n");
+  ToolName = argv[0];
+
+  // Keep the buffer alive, the notes reference its strings.
+  OwningPtr<MemoryBuffer> NotesBuf;
+  if (error_code ec = MemoryBuffer::getFileOrSTDIN(NotesFile, NotesBuf))
+    fail("error reading '" + NotesFile + "': " + ec.message());
+
+  yaml::EdgeProfileNotes Notes;
+  yaml::Input Input(NotesBuf->getBuffer(), NULL, printErrorMessages);
+  Input >> Notes;
+  if (Input.error())
+    fail("error parsing edge profile notes '" + NotesFile + "'");
+  if (Notes.CounterSize == 0 || Notes.CounterSize > 8)
+    fail("unsupported counter size " + Twine(Notes.CounterSize));
+
+  std::vector<uint64_t> Counts(Notes.NumCounters, 0);
+  for (unsigned i = 0, e = CounterFiles.size(); i != e; ++i)
+    readCounters(CounterFiles[i], Notes, Counts);
+
+  yaml::PMLDoc OutDoc(Notes.TargetTriple);
+  yaml::Timing *T = new yaml::Timing(yaml::level_bitcode);
+  T->Origin = ProfileOrigin;
+  T->ScopeRef = new yaml::Scope(yaml::Name(AnalysisEntry));
+  T->Cycles = ObservedCycles;
+  OutDoc.Timings.push_back(T);
+
+  for (unsigned i = 0, e = Notes.Functions.size(); i != e; ++i) {
+    FlowSolver FS(*Notes.Functions[i]);
+    FS.solve(Counts);
+    FS.exportProfile(*T);
+  }
+
+  std::string ErrorInfo;
+  tool_output_file Out(OutputFilename.c_str(), ErrorInfo);
+  if (!ErrorInfo.empty()) fail(ErrorInfo);
+  {
+    yaml::Output YOut(Out.os());
+    yaml::PMLDoc *DocPtr = &OutDoc;
+    YOut << DocPtr;
+  }
+  Out.keep();
+
+  return 0;
+}
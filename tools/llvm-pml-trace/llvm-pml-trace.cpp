@@ -0,0 +1,879 @@
+//===-- llvm-pml-trace.cpp - Extract flow facts from simulator traces -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This tool reads the machine-code representation of a program from PML and
+// a simulator trace of the form 'PC CYCLES INSTRUCTIONS' (as produced by
+// pasim --debug-fmt=trace), and generates the same flow-fact hypotheses as
+// the global recorder of platin's analyze-trace tool (loop bounds,
+// infeasible blocks and indirect call targets), plus the observed execution
+// time of the analysis entry.
+//
+// Instead of publishing an event per instruction, all relevant addresses are
+// collected into a single table indexed by the program counter, so most trace
+// lines are skipped after a single array lookup.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/PML.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace llvm;
+
+static cl::list<std::string>
+PMLFiles(cl::Positional, cl::desc("<input PML files>"), cl::OneOrMore);
+
+static cl::opt<std::string>
+TraceFile("trace", cl::desc("Simulator trace file (default: stdin)"),
+          cl::value_desc("filename"), cl::init("-"));
+
+static cl::opt<std::string>
+BinaryFile("binary", cl::desc("Read missing block addresses from this ELF "
+                              "file"),
+           cl::value_desc("filename"));
+
+static cl::opt<std::string>
+OutputFilename("o", cl::desc("Output PML file (default: stdout)"),
+               cl::value_desc("filename"), cl::init("-"));
+
+static cl::opt<std::string>
+TraceEntry("trace-entry", cl::desc("Label of the function where tracing "
+                                   "starts (default: main)"),
+           cl::init("main"));
+
+static cl::opt<std::string>
+AnalysisEntry("analysis-entry", cl::desc("Label of the function flow facts "
+                                         "are generated for (default: main)"),
+              cl::init("main"));
+
+static cl::opt<std::string>
+FactOrigin("flow-fact-output", cl::desc("Origin of the generated flow facts "
+                                        "(default: trace)"),
+           cl::init("trace"));
+
+static cl::opt<unsigned long long>
+MaxCycles("max-cycles", cl::desc("Consider only the first N cycles of the "
+                                 "trace"), cl::init(0));
+
+static cl::opt<unsigned long long>
+MaxInstructions("max-instructions", cl::desc("Consider only the first N "
+                                             "instructions of the trace"),
+                cl::init(0));
+
+static cl::opt<unsigned>
+MaxTargetTraces("max-target-traces", cl::desc("Maximum number of executions "
+                                              "of the trace entry to analyze"),
+                cl::init(0));
+
+static cl::opt<bool>
+PrintStats("stats", cl::desc("Print trace statistics to stderr"),
+           cl::init(false));
+
+static const char *ToolName;
+
+static void printErrorMessages(const SMDiagnostic &Diag, void *) {
+  Diag.print(ToolName, errs(), true);
+}
+
+LLVM_ATTRIBUTE_NORETURN static void fail(const Twine &Msg) {
+  errs() << ToolName << ": " << Msg << "\n";
+  exit(1);
+}
+
+namespace {
+
+  /// Static information about a machine function of the PML file.
+  struct TraceFunction {
+    yaml::MachineFunction *MF;
+    StringRef Label;
+    uint64_t Address;
+    unsigned FirstBlock;
+    unsigned NumBlocks;
+  };
+
+  /// Static information about a machine block.
+  struct TraceBlock {
+    yaml::MachineBlock *MB;
+    unsigned Function;
+    uint64_t Address;
+    bool IsEmpty;
+    bool IsLoopHeader;
+    /// Headers of the loops containing this block, outermost first.
+    SmallVector<unsigned, 4> Loops;
+    SmallVector<unsigned, 2> Successors;
+
+    unsigned getLoopNest() const { return Loops.size(); }
+  };
+
+  /// A call or return instruction.
+  struct TraceBranch {
+    unsigned Block;
+    yaml::MachineInstruction *MI;
+    unsigned DelaySlots;
+    /// Return only: address of the instruction that would be executed after
+    /// the delay slots if the return is not taken (predicated), or 0.
+    uint64_t Fallthrough;
+    /// Call only: true if the callees are not known statically.
+    bool Unresolved;
+    unsigned NumStaticCallees;
+  };
+
+  /// Events triggered at an address.
+  struct Watchpoint {
+    int Block, Call, Return;
+    Watchpoint() : Block(-1), Call(-1), Return(-1) {}
+  };
+
+  /// Reads the simulator trace in large chunks and parses it by hand; this is
+  /// where most of the time is spent for long traces.
+  class TraceReader {
+    FILE *F;
+    std::vector<char> Buf;
+    size_t Pos, End;
+    bool Eof;
+    uint64_t Line;
+
+    bool fill() {
+      if (Eof) return false;
+      char *B = &Buf[0];
+      if (Pos < End) memmove(B, B + Pos, End - Pos);
+      End -= Pos;
+      Pos = 0;
+      size_t N = fread(B + End, 1, Buf.size() - End, F);
+      if (N == 0) Eof = true;
+      End += N;
+      return N != 0;
+    }
+
+    /// Make sure that the buffer holds a complete line at Pos.
+    bool ensureLine() {
+      while (true) {
+        if (Pos < End && memchr(&Buf[0] + Pos, '\n', End - Pos) != 0)
+          return true;
+        if (!fill()) return Pos < End;
+      }
+    }
+
+  public:
+    TraceReader(FILE *f)
+    : F(f), Buf(1 << 20), Pos(0), End(0), Eof(false), Line(0) {}
+
+    uint64_t getNumLines() const { return Line; }
+
+    /// Parse the next 'PC CYCLES INSTRUCTIONS' line. Return false at the end
+    /// of the trace.
+    bool next(uint64_t &PC, uint64_t &Cycles, uint64_t &Instrs) {
+      while (true) {
+        if (!ensureLine()) return false;
+        // skip empty lines
+        if (Buf[Pos] == '\n') { Pos++; continue; }
+        break;
+      }
+      Line++;
+      const char *P = &Buf[Pos];
+      const char *E = &Buf[0] + End;
+      PC = Cycles = Instrs = 0;
+
+      for (; P != E && isxdigit(*P); ++P) {
+        char C = *P;
+        PC = PC * 16 + (C <= '9' ? C - '0' : (C | 0x20) - 'a' + 10);
+      }
+      while (P != E && *P == ' ') ++P;
+      for (; P != E && *P >= '0' && *P <= '9'; ++P)
+        Cycles = Cycles * 10 + (*P - '0');
+      while (P != E && *P == ' ') ++P;
+      for (; P != E && *P >= '0' && *P <= '9'; ++P)
+        Instrs = Instrs * 10 + (*P - '0');
+      while (P != E && *P == '\r') ++P;
+
+      if (P != E && *P != '\n') {
+        const char *LE = P;
+        while (LE != E && *LE != '\n') ++LE;
+        fail("bad trace line " + Twine(Line) + ": '" +
+             StringRef(&Buf[Pos], LE - &Buf[Pos]) + "'");
+      }
+      Pos = P - &Buf[0] + (P != E ? 1 : 0);
+      return true;
+    }
+  };
+
+  /// Replays the trace on the PML machine code and records the observations
+  /// of platin's global recorder: loop header bounds, executed blocks and
+  /// functions, and indirect call targets.
+  class TraceAnalysis {
+    yaml::PMLDoc &Doc;
+
+    std::vector<TraceFunction> Functions;
+    std::vector<TraceBlock> Blocks;
+    std::vector<TraceBranch> Calls;
+    std::vector<TraceBranch> Returns;
+
+    /// Watchpoints, indexed by (PC - TextBase) / 4 (Patmos instructions are
+    /// word-aligned). Entries are indices into Watchpoints plus one.
+    std::vector<uint32_t> WPTable;
+    std::vector<Watchpoint> Watchpoints;
+    uint64_t TextBase;
+
+    /// Empty (zero-size) blocks preceding the block at the key address.
+    DenseMap<uint64_t, SmallVector<unsigned, 2> > EmptyBlocks;
+
+    unsigned ProgramEntry, Entry;
+
+    // Recorder state
+    bool Running;
+    unsigned Runs;
+    unsigned RecorderDepth;
+    uint64_t StartCycles;
+    uint64_t MinCycles, MaxCyclesSeen;
+    std::vector<bool> ExecutedBlocks;
+    std::vector<bool> ExecutedFunctions;
+    std::vector<uint64_t> LoopCount;
+    std::vector<uint64_t> LoopBound;
+    std::vector<SmallVector<unsigned, 2> > CallTargets;
+
+    // Monitor state
+    std::vector<unsigned> CallStack;
+    std::vector<unsigned> LoopStack;
+    int CurrentFunction;
+    int LastBlock;
+    uint64_t CurCycles;
+
+  public:
+    TraceAnalysis(yaml::PMLDoc &doc)
+    : Doc(doc), TextBase(0), ProgramEntry(0), Entry(0), Running(false),
+      Runs(0), RecorderDepth(0), StartCycles(0), MinCycles(UINT64_MAX),
+      MaxCyclesSeen(0), CurrentFunction(-1), LastBlock(-1), CurCycles(0) {}
+
+    void assignAddresses(StringRef ELF);
+
+    void buildIndex();
+
+    void run(TraceReader &Trace);
+
+    unsigned getRuns() const { return Runs; }
+
+    void exportFacts(yaml::PMLDoc &Out);
+
+  private:
+    int findFunction(StringRef Label) const;
+
+    void addWatch(uint64_t Addr, int Watchpoint::*Kind, unsigned Idx);
+
+    const Watchpoint *lookup(uint64_t PC) const {
+      uint64_t Off = PC - TextBase;
+      if (PC < TextBase || (Off >> 2) >= WPTable.size()) return 0;
+      uint32_t I = WPTable[Off >> 2];
+      return I ? &Watchpoints[I - 1] : 0;
+    }
+
+    void handleBlock(unsigned B, int &PendingCall);
+    void handleLoopHeader(unsigned B);
+    bool handleReturn(unsigned R);
+    void exitLoopsDownTo(unsigned Nest);
+
+    // Recorder events
+    void onFunction(unsigned Callee, int CallSite);
+    void onBlock(unsigned B);
+    void onLoopEnter(unsigned Header);
+    void onLoopCont(unsigned Header);
+    void onLoopExit(unsigned Header);
+    void onReturn(bool EmptyCallStack);
+    void stopRun();
+  };
+}
+
+int TraceAnalysis::findFunction(StringRef Label) const {
+  for (unsigned i = 0, e = Functions.size(); i != e; ++i) {
+    if (Functions[i].Label == Label) return i;
+  }
+  return -1;
+}
+
+/// Fill in missing block and instruction addresses from the symbol table of
+/// the binary, using the same heuristic as platin's extract-symbols tool.
+void TraceAnalysis::assignAddresses(StringRef ELF) {
+  OwningPtr<object::ObjectFile> Obj(object::ObjectFile::createObjectFile(ELF));
+  if (!Obj) fail("could not open binary '" + ELF + "'");
+
+  StringMap<uint64_t> Symbols;
+  error_code ec;
+  for (object::symbol_iterator I = Obj->begin_symbols(),
+       E = Obj->end_symbols(); I != E; I.increment(ec)) {
+    if (ec) fail("could not read symbols of '" + ELF + "'");
+    StringRef Name;
+    uint64_t Addr;
+    if (I->getName(Name) || I->getAddress(Addr)) continue;
+    if (Addr == object::UnknownAddressOrSize) continue;
+    Symbols[Name] = Addr;
+  }
+
+  for (std::vector<yaml::MachineFunction*>::iterator
+       i = Doc.MachineFunctions.begin(), ie = Doc.MachineFunctions.end();
+       i != ie; ++i) {
+    yaml::MachineFunction *MF = *i;
+    StringMap<uint64_t>::iterator S = Symbols.find(MF->MapsTo.getName());
+    if (S == Symbols.end()) continue;
+    uint64_t Addr = S->second;
+
+    for (unsigned b = 0, be = MF->Blocks.size(); b != be; ++b) {
+      yaml::MachineBlock *MB = MF->Blocks[b];
+      std::string Label = (".LBB" + MF->FunctionName.getName() + "_" +
+                           MB->BlockName.getName()).str();
+      // Subfunction emission might insert code between blocks, so prefer
+      // block symbols over accumulated instruction sizes.
+      S = Symbols.find(Label);
+      if (S != Symbols.end()) Addr = S->second;
+      if (MB->Address < 0) MB->Address = Addr;
+      for (unsigned n = 0, ne = MB->Instructions.size(); n != ne; ++n) {
+        yaml::MachineInstruction *MI = MB->Instructions[n];
+        if (MI->Address < 0) MI->Address = Addr;
+        Addr += MI->Size;
+      }
+    }
+  }
+}
+
+void TraceAnalysis::addWatch(uint64_t Addr, int Watchpoint::*Kind,
+                             unsigned Idx) {
+  if (Addr & 3) fail("unaligned watchpoint address " + Twine(Addr));
+  uint64_t Slot = (Addr - TextBase) >> 2;
+  if (WPTable[Slot] == 0) {
+    Watchpoints.push_back(Watchpoint());
+    WPTable[Slot] = Watchpoints.size();
+  }
+  Watchpoint &WP = Watchpoints[WPTable[Slot] - 1];
+  if (WP.*Kind != -1)
+    fail("duplicate watchpoint at address " + Twine(Addr));
+  WP.*Kind = Idx;
+}
+
+void TraceAnalysis::buildIndex() {
+  uint64_t Lo = UINT64_MAX, Hi = 0;
+
+  // Collect functions and blocks
+  for (std::vector<yaml::MachineFunction*>::iterator
+       i = Doc.MachineFunctions.begin(), ie = Doc.MachineFunctions.end();
+       i != ie; ++i) {
+    yaml::MachineFunction *MF = *i;
+    if (MF->Blocks.empty()) continue;
+
+    TraceFunction TF;
+    TF.MF = MF;
+    TF.Label = MF->MapsTo.empty() ? MF->FunctionName.getName()
+                                  : MF->MapsTo.getName();
+    TF.FirstBlock = Blocks.size();
+    TF.NumBlocks = MF->Blocks.size();
+    if (MF->Blocks.front()->Address < 0)
+      fail("no address for machine function " + TF.Label + "; run platin "
+           "extract-symbols or use -binary");
+    TF.Address = MF->Blocks.front()->Address;
+    unsigned FIdx = Functions.size();
+    Functions.push_back(TF);
+
+    StringMap<unsigned> BlockByName;
+    for (unsigned b = 0, be = MF->Blocks.size(); b != be; ++b) {
+      yaml::MachineBlock *MB = MF->Blocks[b];
+      BlockByName[MB->BlockName.getName()] = TF.FirstBlock + b;
+
+      TraceBlock TB;
+      TB.MB = MB;
+      TB.Function = FIdx;
+      TB.Address = MB->Address;
+      TB.IsEmpty = MB->Instructions.empty();
+      TB.IsLoopHeader = !MB->Loops.empty() &&
+                        MB->Loops.front() == MB->BlockName;
+      Blocks.push_back(TB);
+
+      if (MB->Address < 0)
+        fail("no address for block " + MB->BlockName.getName() + " in " +
+             TF.Label);
+      Lo = std::min(Lo, (uint64_t)MB->Address);
+      Hi = std::max(Hi, (uint64_t)MB->Address);
+      for (unsigned n = 0, ne = MB->Instructions.size(); n != ne; ++n) {
+        int64_t A = MB->Instructions[n]->Address;
+        if (A >= 0) Hi = std::max(Hi, (uint64_t)A);
+      }
+    }
+
+    // Resolve loops and successors by name
+    for (unsigned b = 0, be = MF->Blocks.size(); b != be; ++b) {
+      yaml::MachineBlock *MB = MF->Blocks[b];
+      TraceBlock &TB = Blocks[TF.FirstBlock + b];
+      for (std::vector<yaml::Name>::reverse_iterator
+           l = MB->Loops.rbegin(), le = MB->Loops.rend(); l != le; ++l) {
+        StringMap<unsigned>::iterator H = BlockByName.find(l->getName());
+        if (H == BlockByName.end())
+          fail("unknown loop header " + l->getName() + " in " + TF.Label);
+        TB.Loops.push_back(H->second);
+      }
+      for (std::vector<yaml::Name>::iterator
+           s = MB->Successors.begin(), se = MB->Successors.end(); s != se;
+           ++s) {
+        StringMap<unsigned>::iterator S = BlockByName.find(s->getName());
+        if (S != BlockByName.end()) TB.Successors.push_back(S->second);
+      }
+    }
+  }
+
+  int PE = findFunction(TraceEntry);
+  if (PE < 0)
+    fail("could not find trace entry function '" + TraceEntry + "'");
+  int AE = findFunction(AnalysisEntry);
+  if (AE < 0)
+    fail("could not find analysis entry function '" + AnalysisEntry + "'");
+  ProgramEntry = PE;
+  Entry = AE;
+
+  TextBase = Lo & ~3ULL;
+  WPTable.assign(((Hi - TextBase) >> 2) + 1, 0);
+
+  // Create watchpoints for block starts, calls and returns
+  for (unsigned f = 0, fe = Functions.size(); f != fe; ++f) {
+    TraceFunction &TF = Functions[f];
+    for (unsigned b = TF.FirstBlock, be = b + TF.NumBlocks; b != be; ++b) {
+      TraceBlock &TB = Blocks[b];
+      if (TB.IsEmpty) {
+        EmptyBlocks[TB.Address].push_back(b);
+        continue;
+      }
+      addWatch(TB.Address, &Watchpoint::Block, b);
+
+      yaml::MachineBlock::InstrList &Ins = TB.MB->Instructions;
+      for (unsigned n = 0, ne = Ins.size(); n != ne; ++n) {
+        yaml::MachineInstruction *MI = Ins[n];
+        bool IsReturn = MI->BranchType == yaml::branch_return;
+        bool IsCall = MI->hasCallees();
+        if (!IsReturn && !IsCall) continue;
+        if (MI->Address < 0)
+          fail("no address for instruction " + MI->Index.getName() +
+               " in block " + TB.MB->BlockName.getName() + " of " + TF.Label);
+
+        TraceBranch TBr;
+        TBr.Block = b;
+        TBr.MI = MI;
+        TBr.DelaySlots = MI->BranchDelaySlots;
+        TBr.Fallthrough = 0;
+        TBr.Unresolved = false;
+        TBr.NumStaticCallees = 0;
+
+        if (IsReturn) {
+          // Find the instruction after the delay slots; either in this block
+          // or in the unique successor block.
+          unsigned Blk = b, Idx = n;
+          yaml::MachineInstruction *Next = 0;
+          for (unsigned k = 0; k <= TBr.DelaySlots; k++) {
+            Next = 0;
+            if (Idx + 1 < Blocks[Blk].MB->Instructions.size()) {
+              Next = Blocks[Blk].MB->Instructions[++Idx];
+            } else if (Blocks[Blk].Successors.size() == 1) {
+              Blk = Blocks[Blk].Successors.front();
+              Idx = 0;
+              if (!Blocks[Blk].IsEmpty) Next = Blocks[Blk].MB->Instructions[0];
+            }
+            if (!Next) break;
+          }
+          if (Next && Next->Address >= 0) TBr.Fallthrough = Next->Address;
+          addWatch(MI->Address, &Watchpoint::Return, Returns.size());
+          Returns.push_back(TBr);
+        }
+        if (IsCall) {
+          for (std::vector<yaml::Name>::iterator c = MI->Callees.begin(),
+               ce = MI->Callees.end(); c != ce; ++c) {
+            if (c->getName() == "__any__") TBr.Unresolved = true;
+            else if (!c->getName().startswith("llvm."))
+              TBr.NumStaticCallees++;
+          }
+          addWatch(MI->Address, &Watchpoint::Call, Calls.size());
+          Calls.push_back(TBr);
+        }
+      }
+    }
+  }
+
+  ExecutedBlocks.assign(Blocks.size(), false);
+  ExecutedFunctions.assign(Functions.size(), false);
+  LoopCount.assign(Blocks.size(), 0);
+  LoopBound.assign(Blocks.size(), 0);
+  CallTargets.resize(Calls.size());
+}
+
+void TraceAnalysis::run(TraceReader &Trace) {
+  uint64_t Start = Functions[ProgramEntry].Address;
+  uint64_t PC, Cycles, Instrs;
+  uint64_t StartedAt = 0, Executed = 0;
+  bool Started = false, Finished = false;
+  unsigned TraceCount = 0;
+
+  // pending return: index, instruction counter, cycles at the return
+  int PendingReturn = -1;
+  uint64_t PendingReturnExec = 0;
+  int PendingCall = -1;
+
+  while (Trace.next(PC, Cycles, Instrs)) {
+    if (MaxCycles && CurCycles >= MaxCycles) break;
+    if (MaxInstructions && Executed >= MaxInstructions) break;
+
+    if (PC == Start) {
+      Started = true;
+      StartedAt = Instrs;
+    }
+    if (!Started) continue;
+    Executed = Instrs - StartedAt + 1;
+
+    const Watchpoint *WP = lookup(PC);
+    if (!WP && PendingReturn < 0) continue;
+
+    CurCycles = Cycles;
+
+    // Handle the return after its delay slots have been executed
+    if (PendingReturn >= 0 &&
+        PendingReturnExec + Returns[PendingReturn].DelaySlots + 1 == Executed)
+    {
+      // If there was no change of control-flow since the return, it was
+      // predicated and not executed. This heuristic fails only if a
+      // recursive function returns to the next instruction.
+      if (Returns[PendingReturn].Fallthrough != PC) {
+        if (!handleReturn(PendingReturn)) {
+          Finished = true;
+          TraceCount++;
+          if (MaxTargetTraces && TraceCount >= MaxTargetTraces) break;
+          Started = false;
+        }
+      }
+      PendingReturn = -1;
+    }
+    if (!WP) continue;
+
+    if (WP->Block >= 0) {
+      handleBlock(WP->Block, PendingCall);
+    }
+    if (WP->Call >= 0) {
+      if ((int)Blocks[Calls[WP->Call].Block].Function != CurrentFunction)
+        fail("call instruction does not match current function at PC " +
+             Twine(PC));
+      PendingCall = WP->Call;
+      Finished = false;
+    }
+    if (WP->Return >= 0) {
+      PendingReturn = WP->Return;
+      PendingReturnExec = Executed;
+    }
+  }
+
+  if (!Finished) {
+    errs() << ToolName << ": warning: did not observe return from program "
+           << "entry " << Functions[ProgramEntry].Label << "\n";
+    if (Running) stopRun();
+  }
+
+  if (PrintStats) {
+    errs() << "[trace] simulator trace length: " << Trace.getNumLines()
+           << "\n[trace] analysis entry executions: " << Runs << "\n";
+  }
+}
+
+void TraceAnalysis::handleBlock(unsigned B, int &PendingCall) {
+  TraceBlock &TB = Blocks[B];
+  TraceFunction &TF = Functions[TB.Function];
+
+  // function entry
+  if (TB.Address == TF.Address) {
+    if (PendingCall >= 0) {
+      CallStack.push_back(PendingCall);
+      PendingCall = -1;
+    } else if (TB.Function != ProgramEntry) {
+      fail("empty call history at entry of " + TF.Label);
+    }
+    CurrentFunction = TB.Function;
+    LoopStack.clear();
+    onFunction(TB.Function, CallStack.empty() ? -1 : (int)CallStack.back());
+  }
+
+  exitLoopsDownTo(TB.getLoopNest());
+  handleLoopHeader(B);
+
+  if ((int)TB.Function != CurrentFunction)
+    fail("current function " + (CurrentFunction < 0 ? StringRef("<none>") :
+         Functions[CurrentFunction].Label) + " does not match block " +
+         TB.MB->BlockName.getName() + " of " + TF.Label);
+
+  // Empty blocks cannot be distinguished by address; publish an empty block
+  // only if it is a successor of the last block.
+  DenseMap<uint64_t, SmallVector<unsigned, 2> >::iterator EB =
+    EmptyBlocks.find(TB.Address);
+  if (EB != EmptyBlocks.end()) {
+    for (unsigned i = 0, e = EB->second.size(); i != e; ++i) {
+      unsigned B0 = EB->second[i];
+      if (LastBlock >= 0 &&
+          std::find(Blocks[LastBlock].Successors.begin(),
+                    Blocks[LastBlock].Successors.end(), B0) ==
+          Blocks[LastBlock].Successors.end())
+        continue;
+      while (Blocks[B0].IsEmpty) {
+        onBlock(B0);
+        if (Blocks[B0].Successors.size() != 1)
+          fail("empty block may only have one successor");
+        LastBlock = B0;
+        B0 = Blocks[B0].Successors.front();
+      }
+      break;
+    }
+  }
+
+  onBlock(B);
+  LastBlock = B;
+}
+
+void TraceAnalysis::handleLoopHeader(unsigned B) {
+  TraceBlock &TB = Blocks[B];
+  if (!TB.IsLoopHeader) return;
+
+  if (TB.getLoopNest() == LoopStack.size() && LoopStack.back() != B) {
+    onLoopExit(LoopStack.back());
+    LoopStack.pop_back();
+  }
+  if (TB.getLoopNest() == LoopStack.size()) {
+    onLoopCont(B);
+  } else {
+    LoopStack.push_back(B);
+    onLoopEnter(B);
+  }
+}
+
+void TraceAnalysis::exitLoopsDownTo(unsigned Nest) {
+  while (Nest < LoopStack.size()) {
+    onLoopExit(LoopStack.back());
+    LoopStack.pop_back();
+  }
+}
+
+bool TraceAnalysis::handleReturn(unsigned R) {
+  exitLoopsDownTo(0);
+  onReturn(CallStack.empty());
+
+  unsigned Fn = Blocks[Returns[R].Block].Function;
+  if (Fn == ProgramEntry) return false;
+
+  if (CallStack.empty())
+    fail("call stack empty at return from " + Functions[Fn].Label);
+  TraceBranch &C = Calls[CallStack.back()];
+  CallStack.pop_back();
+
+  LastBlock = C.Block;
+  LoopStack.assign(Blocks[C.Block].Loops.begin(), Blocks[C.Block].Loops.end());
+  CurrentFunction = Blocks[C.Block].Function;
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Recorder
+
+void TraceAnalysis::onFunction(unsigned Callee, int CallSite) {
+  if (Running) {
+    RecorderDepth++;
+    if (CallSite >= 0) {
+      SmallVector<unsigned, 2> &Targets = CallTargets[CallSite];
+      if (std::find(Targets.begin(), Targets.end(), Callee) == Targets.end())
+        Targets.push_back(Callee);
+    }
+  } else if (Callee == Entry) {
+    Running = true;
+    Runs++;
+    RecorderDepth = 0;
+    StartCycles = CurCycles;
+  }
+  if (Running)
+    ExecutedFunctions[Callee] = true;
+}
+
+void TraceAnalysis::onBlock(unsigned B) {
+  if (Running) ExecutedBlocks[B] = true;
+}
+
+void TraceAnalysis::onLoopEnter(unsigned Header) {
+  if (Running) LoopCount[Header] = 1;
+}
+
+void TraceAnalysis::onLoopCont(unsigned Header) {
+  if (Running && LoopCount[Header]) LoopCount[Header]++;
+}
+
+void TraceAnalysis::onLoopExit(unsigned Header) {
+  if (!Running) return;
+  LoopBound[Header] = std::max(LoopBound[Header], LoopCount[Header]);
+  LoopCount[Header] = 0;
+}
+
+void TraceAnalysis::onReturn(bool EmptyCallStack) {
+  if (!Running) return;
+  if (RecorderDepth == 0) {
+    stopRun();
+  } else {
+    RecorderDepth--;
+  }
+}
+
+void TraceAnalysis::stopRun() {
+  uint64_t C = CurCycles - StartCycles;
+  MinCycles = std::min(MinCycles, C);
+  MaxCyclesSeen = std::max(MaxCyclesSeen, C);
+  std::fill(LoopCount.begin(), LoopCount.end(), 0);
+  Running = false;
+}
+
+//===----------------------------------------------------------------------===//
+// Export
+
+void TraceAnalysis::exportFacts(yaml::PMLDoc &Out) {
+  const yaml::Name &EntryName = Functions[Entry].MF->FunctionName;
+
+  yaml::Timing *T = new yaml::Timing(yaml::level_machinecode);
+  T->Origin = yaml::Name(FactOrigin);
+  T->ScopeRef = new yaml::Scope(EntryName);
+  T->Cycles = MaxCyclesSeen;
+  Out.Timings.push_back(T);
+
+  // Call targets, only if unresolved or fewer than the static receivers
+  for (unsigned c = 0, ce = Calls.size(); c != ce; ++c) {
+    TraceBranch &C = Calls[c];
+    SmallVector<unsigned, 2> &Targets = CallTargets[c];
+    if (Targets.empty()) continue;
+    if (!C.Unresolved && C.NumStaticCallees == Targets.size()) continue;
+
+    TraceBlock &TB = Blocks[C.Block];
+    yaml::FlowFact *FF = new yaml::FlowFact(yaml::level_machinecode);
+    FF->Origin = yaml::Name(FactOrigin);
+    FF->ScopeRef = new yaml::Scope(EntryName);
+    FF->addTermLHS(yaml::ProgramPoint::CreateInstruction(
+                     Functions[TB.Function].MF->FunctionName,
+                     TB.MB->BlockName, C.MI->Index), 1);
+    for (unsigned t = 0, te = Targets.size(); t != te; ++t) {
+      FF->addTermLHS(yaml::ProgramPoint::CreateFunction(
+                       Functions[Targets[t]].MF->FunctionName), -1);
+    }
+    FF->Comparison = yaml::cmp_less_equal;
+    FF->RHS = yaml::Name(0ULL);
+    Out.addFlowFact(FF);
+  }
+
+  // Infeasible blocks in executed functions
+  for (unsigned b = 0, be = Blocks.size(); b != be; ++b) {
+    TraceBlock &TB = Blocks[b];
+    if (ExecutedBlocks[b] || !ExecutedFunctions[TB.Function]) continue;
+
+    yaml::FlowFact *FF = new yaml::FlowFact(yaml::level_machinecode);
+    FF->Origin = yaml::Name(FactOrigin);
+    FF->ScopeRef = new yaml::Scope(EntryName);
+    FF->addTermLHS(yaml::ProgramPoint::CreateBlock(
+                     Functions[TB.Function].MF->FunctionName,
+                     TB.MB->BlockName), 1);
+    FF->Comparison = yaml::cmp_less_equal;
+    FF->RHS = yaml::Name(0ULL);
+    Out.addFlowFact(FF);
+  }
+
+  // Loop header bounds
+  for (unsigned b = 0, be = Blocks.size(); b != be; ++b) {
+    if (!LoopBound[b]) continue;
+    TraceBlock &TB = Blocks[b];
+    const yaml::Name &FName = Functions[TB.Function].MF->FunctionName;
+
+    yaml::FlowFact *FF = new yaml::FlowFact(yaml::level_machinecode);
+    FF->Origin = yaml::Name(FactOrigin);
+    FF->setLoopScope(FName, TB.MB->BlockName);
+    FF->addTermLHS(yaml::ProgramPoint::CreateBlock(FName, TB.MB->BlockName),
+                   1);
+    FF->Comparison = yaml::cmp_less_equal;
+    FF->RHS = yaml::Name(LoopBound[b]);
+    Out.addFlowFact(FF);
+  }
+
+  if (PrintStats) {
+    errs() << "[trace] extracted flow-fact hypotheses: "
+           << Out.FlowFacts.size() << "\n";
+  }
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+
+  llvm_shutdown_obj Y;  // Call llvm_shutdown() on exit.
+  cl::ParseCommandLineOptions(argc, argv,
+                              "PML simulator trace analysis\n");
+  ToolName = argv[0];
+
+  // Keep the buffers alive, the documents reference their strings.
+  std::vector<MemoryBuffer*> Buffers;
+  yaml::PMLDoc Doc;
+
+  for (unsigned i = 0, e = PMLFiles.size(); i != e; ++i) {
+    OwningPtr<MemoryBuffer> Buf;
+    if (error_code ec = MemoryBuffer::getFileOrSTDIN(PMLFiles[i], Buf))
+      fail("error reading '" + PMLFiles[i] + "': " + ec.message());
+
+    yaml::Input Input(Buf->getBuffer(), NULL, printErrorMessages);
+    if (!yaml::readPMLStream(Input, Doc))
+      fail("error parsing PML file '" + PMLFiles[i] + "'");
+    Buffers.push_back(Buf.take());
+  }
+
+  TraceAnalysis TA(Doc);
+  if (!BinaryFile.empty())
+    TA.assignAddresses(BinaryFile);
+  TA.buildIndex();
+
+  FILE *TraceIn = stdin;
+  if (TraceFile != "-") {
+    TraceIn = fopen(TraceFile.c_str(), "r");
+    if (!TraceIn) fail("could not open trace file '" + TraceFile + "'");
+  }
+  TraceReader Reader(TraceIn);
+  TA.run(Reader);
+  if (TraceIn != stdin) fclose(TraceIn);
+
+  if (TA.getRuns() == 0)
+    fail("analysis entry '" + AnalysisEntry + "' never executed");
+
+  yaml::PMLDoc OutDoc(Doc.TargetTriple);
+  TA.exportFacts(OutDoc);
+
+  std::string ErrorInfo;
+  tool_output_file Out(OutputFilename.c_str(), ErrorInfo);
+  if (!ErrorInfo.empty()) fail(ErrorInfo);
+  {
+    yaml::Output YOut(Out.os());
+    yaml::PMLDoc *DocPtr = &OutDoc;
+    YOut << DocPtr;
+  }
+  Out.keep();
+
+  for (unsigned i = 0, e = Buffers.size(); i != e; ++i)
+    delete Buffers[i];
+  return 0;
+}
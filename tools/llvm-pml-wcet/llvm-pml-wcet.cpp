@@ -0,0 +1,180 @@
+//===-- llvm-pml-wcet.cpp - IPET based WCET bounds from PML ---------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This tool computes a WCET bound for the machine code of a PML document,
+// using the flow facts of the document (e.g., from llvm-pml-trace or from
+// the compiler's PML export). The IPET problem is built and solved
+// in-process, see PMLIPET.h. The result is written as a PML timing entry,
+// including the worst-case edge profile.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/PML.h"
+#include "llvm/CodeGen/PMLIPET.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+#include <cstdlib>
+#include <vector>
+
+using namespace llvm;
+
+static cl::list<std::string>
+PMLFiles(cl::Positional, cl::desc("<input PML files>"), cl::OneOrMore);
+
+static cl::opt<std::string>
+OutputFilename("o", cl::desc("Output PML file (default: stdout)"),
+               cl::value_desc("filename"), cl::init("-"));
+
+static cl::opt<std::string>
+AnalysisEntry("analysis-entry", cl::desc("Label of the function to analyze "
+                                         "(default: main)"),
+              cl::init("main"));
+
+static cl::opt<std::string>
+TimingOutput("timing-output", cl::desc("Origin of the generated timing entry "
+                                       "(default: ipet)"),
+             cl::init("ipet"));
+
+static cl::list<std::string>
+FlowFactOrigins("flow-fact-origin", cl::desc("Only use flow facts from this "
+                                             "origin (default: all)"),
+                cl::CommaSeparated);
+
+static cl::opt<unsigned>
+MemAccessCycles("mem-access-cycles", cl::desc("Additional cycles of each "
+                                              "memory access"),
+                cl::init(0));
+
+static cl::opt<unsigned>
+CallReturnCycles("call-return-cycles", cl::desc("Additional cycles of each "
+                                                "call and return"),
+                 cl::init(0));
+
+static cl::opt<unsigned>
+MaxNodes("max-bb-nodes", cl::desc("Maximum number of branch and bound nodes "
+                                  "(0 = LP relaxation only)"),
+         cl::init(10000));
+
+static cl::opt<unsigned>
+MaxEntries("max-tableau-entries",
+           cl::desc("Maximum number of non-zero simplex tableau entries, "
+                    "about 16 bytes each (default: 2^25)"),
+           cl::init(1 << 25));
+
+static cl::opt<bool>
+PrintStats("ipet-stats", cl::desc("Print IPET statistics to stderr"),
+           cl::init(false));
+
+static const char *ToolName;
+
+static void printErrorMessages(const SMDiagnostic &Diag, void *) {
+  Diag.print(ToolName, errs(), true);
+}
+
+LLVM_ATTRIBUTE_NORETURN static void fail(const Twine &Msg) {
+  errs() << ToolName << ": " << Msg << "\n";
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+
+  llvm_shutdown_obj Y;  // Call llvm_shutdown() on exit.
+  cl::ParseCommandLineOptions(argc, argv, "PML IPET WCET analysis\n\n"
+    "  The IPET problem has one variable per CFG edge and call edge, and one\n"
+    "  constraint per block, call site and flow fact. It is solved with a\n"
+    "  sparse simplex, which fails if the tableau grows beyond\n"
+    "  -max-tableau-entries non-zero entries. Fractional solutions are\n"
+    "  refined by branch and bound for at most -max-bb-nodes nodes; when a\n"
+    "  limit is hit there, the (safe) LP relaxation bound is reported.\n");
+  ToolName = argv[0];
+
+  // Keep the buffers alive, the documents reference their strings.
+  std::vector<MemoryBuffer*> Buffers;
+  yaml::PMLDoc Doc;
+
+  for (unsigned i = 0, e = PMLFiles.size(); i != e; ++i) {
+    OwningPtr<MemoryBuffer> Buf;
+    if (error_code ec = MemoryBuffer::getFileOrSTDIN(PMLFiles[i], Buf))
+      fail("error reading '" + PMLFiles[i] + "': " + ec.message());
+
+    yaml::Input Input(Buf->getBuffer(), NULL, printErrorMessages);
+    if (!yaml::readPMLStream(Input, Doc))
+      fail("error parsing PML file '" + PMLFiles[i] + "'");
+    Buffers.push_back(Buf.take());
+  }
+
+  PMLIPETCostModel CM;
+  CM.MemAccessCycles = MemAccessCycles;
+  CM.CallReturnCycles = CallReturnCycles;
+
+  // The timing entry is written to a new document, the builder adds it to
+  // the document it analyzes.
+  yaml::PMLDoc OutDoc(Doc.TargetTriple);
+  OutDoc.MachineFunctions.swap(Doc.MachineFunctions);
+  OutDoc.FlowFacts.swap(Doc.FlowFacts);
+
+  std::string Error;
+  PMLIPETBuilder Builder(OutDoc, CM);
+  Builder.setFlowFactOrigins(FlowFactOrigins);
+  Builder.getLinearProgram().setMaxNodes(MaxNodes);
+  Builder.getLinearProgram().setMaxEntries(MaxEntries);
+
+  TimeRecord Start = TimeRecord::getCurrentTime(true);
+  if (!Builder.build(AnalysisEntry, Error))
+    fail(Error);
+  if (!Builder.addTiming(TimingOutput, Error))
+    fail(Error);
+  TimeRecord End = TimeRecord::getCurrentTime(false);
+
+  if (PrintStats) {
+    PMLLinearProgram &LP = Builder.getLinearProgram();
+    errs() << "[ipet] variables: " << LP.getNumVariables()
+           << ", constraints: " << LP.getNumConstraints() << "\n"
+           << "[ipet] flow facts: " << Builder.getNumFlowFacts()
+           << " used, " << Builder.getNumSkippedFlowFacts() << " skipped\n"
+           << "[ipet] simplex pivots: " << LP.getNumPivots()
+           << ", branch and bound nodes: " << LP.getNumNodes() << "\n"
+           << "[ipet] solver time: "
+           << format("%.3f", End.getWallTime() - Start.getWallTime())
+           << "s\n"
+           << "[ipet] WCET bound: " << OutDoc.Timings.back()->Cycles
+           << " cycles\n";
+  }
+
+  // Only output the result, give the analyzed program back to Doc.
+  Doc.MachineFunctions.swap(OutDoc.MachineFunctions);
+  Doc.FlowFacts.swap(OutDoc.FlowFacts);
+
+  std::string ErrorInfo;
+  tool_output_file Out(OutputFilename.c_str(), ErrorInfo);
+  if (!ErrorInfo.empty()) fail(ErrorInfo);
+  {
+    yaml::Output YOut(Out.os());
+    yaml::PMLDoc *DocPtr = &OutDoc;
+    YOut << DocPtr;
+  }
+  Out.keep();
+
+  for (unsigned i = 0, e = Buffers.size(); i != e; ++i)
+    delete Buffers[i];
+  return 0;
+}
@@ -0,0 +1,290 @@
+//===-- llvm-sample-profile.cpp - Create sample profiles from PC traces ---===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This tool converts program counter samples of a program into the text
+// format read by the -sample-profile pass. The samples are either a full
+// simulator trace of the form 'PC CYCLES INSTRUCTIONS' (as produced by
+// pasim --debug-fmt=trace), which can be reduced to periodic samples with
+// -period, or a list of PCs sampled on hardware, one per line.
+//
+// The samples are mapped to source lines using the debug information of the
+// binary. Samples of inlined code are attributed to the line of the call in
+// the function containing the code, as the profile is read before inlining.
+// Line numbers are relative to the declaration line of the function
+// (DW_AT_decl_line), which the profile loader takes from the DISubprogram of
+// the function.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/DebugInfo/DIContext.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::opt<std::string>
+BinaryFile(cl::Positional, cl::desc("<binary>"), cl::Required);
+
+static cl::opt<std::string>
+TraceFile("trace", cl::desc("Trace or PC sample file (default: stdin)"),
+          cl::value_desc("filename"), cl::init("-"));
+
+static cl::opt<std::string>
+OutputFilename("o", cl::desc("Output sample profile (default: stdout)"),
+               cl::value_desc("filename"), cl::init("-"));
+
+static cl::opt<unsigned>
+SamplePeriod("period", cl::desc("Take a sample every N cycles of the trace "
+                                "(default: 0, every line is a sample)"),
+             cl::init(0));
+
+static cl::opt<bool>
+PrintStats("stats", cl::desc("Print sample statistics to stderr"),
+           cl::init(false));
+
+static const char *ToolName;
+
+LLVM_ATTRIBUTE_NORETURN static void fail(const Twine &Msg) {
+  errs() << ToolName << ": " << Msg << "\n";
+  exit(1);
+}
+
+namespace {
+
+  /// The samples collected for a function.
+  struct FunctionSamples {
+    /// Declaration line of the function, 0 if unknown.
+    unsigned FirstLine;
+    uint64_t TotalSamples;
+    uint64_t HeadSamples;
+    std::map<unsigned, uint64_t> LineSamples;
+
+    FunctionSamples() : FirstLine(0), TotalSamples(0), HeadSamples(0) {}
+  };
+
+  /// The source location a PC is attributed to.
+  struct Location {
+    FunctionSamples *Function;
+    unsigned Line;
+    bool IsEntry;
+  };
+
+  class SampleProfileWriter {
+    OwningPtr<object::ObjectFile> Obj;
+    OwningPtr<DIContext> DICtx;
+
+    /// Addresses of the function symbols of the binary.
+    StringMap<uint64_t> FunctionAddrs;
+
+    /// Sorted by name, as the profile should not depend on the trace order.
+    std::map<std::string, FunctionSamples> Functions;
+
+    /// Locations of all PCs seen so far.
+    DenseMap<uint64_t, Location> Locations;
+
+    uint64_t NumSamples, NumUnknown;
+
+    FunctionSamples &getFunction(StringRef Name, unsigned DeclLine);
+
+    const Location &getLocation(uint64_t PC);
+
+  public:
+    SampleProfileWriter(StringRef Binary);
+
+    void addSample(uint64_t PC);
+
+    void write(raw_ostream &OS) const;
+
+    void printStats(raw_ostream &OS) const;
+  };
+
+}
+
+SampleProfileWriter::SampleProfileWriter(StringRef Binary)
+: NumSamples(0), NumUnknown(0)
+{
+  Obj.reset(object::ObjectFile::createObjectFile(Binary));
+  if (!Obj) fail("could not open binary '" + Binary + "'");
+
+  DICtx.reset(DIContext::getDWARFContext(Obj.get()));
+  if (!DICtx) fail("could not read debug information of '" + Binary + "'");
+
+  error_code ec;
+  for (object::symbol_iterator I = Obj->begin_symbols(),
+       E = Obj->end_symbols(); I != E; I.increment(ec)) {
+    if (ec) fail("could not read symbols of '" + Binary + "'");
+    object::SymbolRef::Type Type;
+    StringRef Name;
+    uint64_t Addr;
+    if (I->getType(Type) || Type != object::SymbolRef::ST_Function) continue;
+    if (I->getName(Name) || I->getAddress(Addr)) continue;
+    if (Addr == object::UnknownAddressOrSize) continue;
+    FunctionAddrs[Name] = Addr;
+  }
+}
+
+FunctionSamples &SampleProfileWriter::getFunction(StringRef Name,
+                                                  unsigned DeclLine) {
+  FunctionSamples &FS = Functions[Name];
+  if (!FS.FirstLine)
+    FS.FirstLine = DeclLine;
+  return FS;
+}
+
+const Location &SampleProfileWriter::getLocation(uint64_t PC) {
+  DenseMap<uint64_t, Location>::iterator I = Locations.find(PC);
+  if (I != Locations.end())
+    return I->second;
+
+  Location Loc;
+  Loc.Function = 0;
+  Loc.Line = 0;
+  Loc.IsEntry = false;
+
+  // The outermost frame is the function that was compiled, inner frames are
+  // inlined into it.
+  DIInliningInfo Info = DICtx->getInliningInfoForAddress(PC,
+                          DILineInfoSpecifier::FileLineInfo |
+                          DILineInfoSpecifier::FunctionName);
+  if (Info.getNumberOfFrames()) {
+    DILineInfo Frame = Info.getFrame(Info.getNumberOfFrames() - 1);
+    StringRef Name = Frame.getFunctionName();
+    if (!Name.empty() && Name != "<invalid>") {
+      Loc.Function = &getFunction(Name, Frame.getStartLine());
+      Loc.Line = Frame.getLine();
+      StringMap<uint64_t>::iterator A = FunctionAddrs.find(Name);
+      Loc.IsEntry = A != FunctionAddrs.end() && A->second == PC;
+    }
+  }
+  return Locations[PC] = Loc;
+}
+
+void SampleProfileWriter::addSample(uint64_t PC) {
+  NumSamples++;
+
+  const Location &Loc = getLocation(PC);
+  if (!Loc.Function) {
+    NumUnknown++;
+    return;
+  }
+
+  FunctionSamples &FS = *Loc.Function;
+  FS.TotalSamples++;
+  if (Loc.IsEntry)
+    FS.HeadSamples++;
+  if (Loc.Line && Loc.Line >= FS.FirstLine)
+    FS.LineSamples[Loc.Line - FS.FirstLine + 1]++;
+}
+
+void SampleProfileWriter::write(raw_ostream &OS) const {
+  OS << "symbol table\n" << Functions.size() << "\n";
+  for (std::map<std::string, FunctionSamples>::const_iterator
+       I = Functions.begin(), E = Functions.end(); I != E; ++I)
+    OS << I->first << "\n";
+
+  for (std::map<std::string, FunctionSamples>::const_iterator
+       I = Functions.begin(), E = Functions.end(); I != E; ++I) {
+    const FunctionSamples &FS = I->second;
+    OS << I->first << ":" << FS.TotalSamples << ":" << FS.HeadSamples << ":"
+       << FS.LineSamples.size() << "\n";
+    for (std::map<unsigned, uint64_t>::const_iterator
+         LI = FS.LineSamples.begin(), LE = FS.LineSamples.end(); LI != LE; ++LI)
+      OS << LI->first << ": " << LI->second << "\n";
+  }
+}
+
+void SampleProfileWriter::printStats(raw_ostream &OS) const {
+  OS << "Samples:               " << NumSamples << "\n"
+     << "Samples without lines: " << NumUnknown << "\n"
+     << "Distinct PCs:          " << Locations.size() << "\n"
+     << "Functions:             " << Functions.size() << "\n";
+}
+
+/// Parse a 'PC [CYCLES [INSTRUCTIONS]]' line, the PC in hex.
+static bool parseLine(const char *P, uint64_t &PC, uint64_t &Cycles,
+                      bool &HasCycles) {
+  while (*P == ' ' || *P == '\t') ++P;
+  if (P[0] == '0' && (P[1] == 'x' || P[1] == 'X')) P += 2;
+  if (!isxdigit(*P)) return false;
+
+  char *End;
+  PC = strtoull(P, &End, 16);
+  P = End;
+  while (*P == ' ' || *P == '\t') ++P;
+  HasCycles = isdigit(*P);
+  Cycles = HasCycles ? strtoull(P, &End, 10) : 0;
+  return true;
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+
+  llvm_shutdown_obj Y;  // Call llvm_shutdown() on exit.
+  cl::ParseCommandLineOptions(argc, argv,
+                              "PC trace to sample profile conversion\n");
+  ToolName = argv[0];
+
+  SampleProfileWriter Writer(BinaryFile);
+
+  FILE *TraceIn = stdin;
+  if (TraceFile != "-") {
+    TraceIn = fopen(TraceFile.c_str(), "r");
+    if (!TraceIn) fail("could not open trace file '" + TraceFile + "'");
+  }
+
+  char Buf[256];
+  uint64_t Line = 0, NextSample = 0;
+  while (fgets(Buf, sizeof(Buf), TraceIn)) {
+    Line++;
+    uint64_t PC, Cycles;
+    bool HasCycles;
+    if (!parseLine(Buf, PC, Cycles, HasCycles)) {
+      if (Buf[0] == '\n') continue;
+      fail("bad trace line " + Twine(Line) + ": '" +
+           StringRef(Buf).rtrim() + "'");
+    }
+
+    if (SamplePeriod) {
+      if (!HasCycles)
+        fail("-period requires a trace with cycles, line " + Twine(Line));
+      // The instruction executing when the sampling timer expires is the
+      // sample of the period.
+      if (Cycles < NextSample) continue;
+      NextSample = (Cycles / SamplePeriod + 1) * SamplePeriod;
+    }
+    Writer.addSample(PC);
+  }
+  if (TraceIn != stdin) fclose(TraceIn);
+
+  std::string ErrorInfo;
+  tool_output_file Out(OutputFilename.c_str(), ErrorInfo);
+  if (!ErrorInfo.empty()) fail(ErrorInfo);
+  Writer.write(Out.os());
+  Out.keep();
+
+  if (PrintStats)
+    Writer.printStats(errs());
+
+  return 0;
+}
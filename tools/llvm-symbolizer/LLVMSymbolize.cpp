@@ -13,6 +13,7 @@
 
 #include "LLVMSymbolize.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Config/config.h"
 #include "llvm/Object/MachO.h"
 #include "llvm/Support/Casting.h"
@@ -22,6 +23,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 
+#include <algorithm>
 #include <sstream>
 #include <stdlib.h>
 
@@ -165,6 +167,108 @@ bool ModuleInfo::symbolizeData(uint64_t ModuleOffset, std::string &Name,
                                 Size);
 }
 
+static std::string getLocationKey(const DIInliningInfo &Location) {
+  std::string Key;
+  for (uint32_t i = 0, n = Location.getNumberOfFrames(); i < n; i++) {
+    DILineInfo Frame = Location.getFrame(i);
+    Key += Frame.getFunctionName();
+    Key += '\0';
+    Key += Frame.getFileName();
+    Key += '\0';
+    Key += utostr(Frame.getLine());
+    Key += '\0';
+  }
+  return Key;
+}
+
+void ModuleInfo::addAddressRanges(AddressTable &Table, uint64_t Start,
+                                  uint64_t End, int StartLocation,
+                                  const LLVMSymbolizer::Options &Opts) const {
+  // Inlined subroutines do not necessarily start at a row of the line table.
+  // Split the range until the location at its end is that of its start,
+  // assuming that an inlined subroutine is not entirely within the range.
+  int EndLocation = StartLocation;
+  if (End - Start > 1)
+    EndLocation = Table.addLocation(symbolizeInlinedCode(End - 1, Opts));
+  if (EndLocation == StartLocation) {
+    Table.addRange(Start, StartLocation);
+    return;
+  }
+  uint64_t Mid = Start + (End - Start) / 2;
+  int MidLocation = Table.addLocation(symbolizeInlinedCode(Mid, Opts));
+  addAddressRanges(Table, Start, Mid, StartLocation, Opts);
+  addAddressRanges(Table, Mid, End, MidLocation, Opts);
+}
+
+void ModuleInfo::buildAddressTable(AddressTable &Table,
+                                   const LLVMSymbolizer::Options &Opts) const {
+  uint64_t LastEnd = 0;
+  for (SymbolMapTy::const_iterator I = Functions.begin(), E = Functions.end();
+       I != E; ++I) {
+    uint64_t Start = I->first.Addr;
+    uint64_t End = Start + I->first.Size;
+    // Skip symbols of unknown size and aliases of the previous function.
+    if (I->first.Size == 0 || (!Table.Ranges.empty() && Start < LastEnd))
+      continue;
+    LastEnd = End;
+
+    // The line changes at the rows of the line table.
+    std::vector<uint64_t> Starts(1, Start);
+    if (DebugInfoContext) {
+      DILineInfoTable Rows = DebugInfoContext->getLineInfoForAddressRange(
+          Start, I->first.Size, DILineInfoSpecifier::FileLineInfo);
+      for (unsigned r = 0, re = Rows.size(); r != re; ++r) {
+        if (Rows[r].first > Start && Rows[r].first < End)
+          Starts.push_back(Rows[r].first);
+      }
+      std::sort(Starts.begin(), Starts.end());
+      Starts.erase(std::unique(Starts.begin(), Starts.end()), Starts.end());
+    }
+    Starts.push_back(End);
+
+    for (unsigned s = 0, se = Starts.size() - 1; s != se; ++s) {
+      int Location = Table.addLocation(symbolizeInlinedCode(Starts[s], Opts));
+      addAddressRanges(Table, Starts[s], Starts[s + 1], Location, Opts);
+    }
+    Table.addRange(End, -1);
+  }
+  Table.LocationIndex.clear();
+}
+
+int AddressTable::addLocation(const DIInliningInfo &Frames) {
+  // Drop the columns, the table maps addresses to lines.
+  DIInliningInfo Location;
+  for (uint32_t i = 0, n = Frames.getNumberOfFrames(); i < n; i++) {
+    DILineInfo Frame = Frames.getFrame(i);
+    Location.addFrame(DILineInfo(Frame.getFileName(), Frame.getFunctionName(),
+                                 Frame.getLine(), 0));
+  }
+  std::pair<std::map<std::string, int>::iterator, bool> Res =
+      LocationIndex.insert(std::make_pair(getLocationKey(Location),
+                                          (int)Locations.size()));
+  if (Res.second)
+    Locations.push_back(Location);
+  return Res.first->second;
+}
+
+void AddressTable::addRange(uint64_t Start, int Location) {
+  // A function may start at the end of the previous one.
+  if (!Ranges.empty() && Ranges.back().Start == Start)
+    Ranges.pop_back();
+  if (!Ranges.empty() && Ranges.back().Location == Location)
+    return;
+  Range R = { Start, Location };
+  Ranges.push_back(R);
+}
+
+int AddressTable::lookup(uint64_t Address) const {
+  std::vector<Range>::const_iterator I =
+      std::upper_bound(Ranges.begin(), Ranges.end(), Address);
+  if (I == Ranges.begin())
+    return -1;
+  return (--I)->Location;
+}
+
 const char LLVMSymbolizer::kBadString[] = "??";
 
 std::string LLVMSymbolizer::symbolizeCode(const std::string &ModuleName,
@@ -204,7 +308,25 @@ std::string LLVMSymbolizer::symbolizeData(const std::string &ModuleName,
   return ss.str();
 }
 
+const AddressTable *
+LLVMSymbolizer::getAddressTable(const std::string &ModuleName) {
+  AddressTableMapTy::iterator I = AddressTables.find(ModuleName);
+  if (I != AddressTables.end())
+    return I->second;
+  AddressTable *Table = 0;
+  if (ModuleInfo *Info = getOrCreateModuleInfo(ModuleName)) {
+    // The function names are needed to aggregate addresses by function.
+    Options TableOpts = Opts;
+    TableOpts.PrintFunctions = true;
+    Table = new AddressTable();
+    Info->buildAddressTable(*Table, TableOpts);
+  }
+  AddressTables.insert(make_pair(ModuleName, Table));
+  return Table;
+}
+
 void LLVMSymbolizer::flush() {
+  DeleteContainerSeconds(AddressTables);
   DeleteContainerSeconds(Modules);
   DeleteContainerPointers(ParsedBinariesAndObjects);
   BinaryForPath.clear();
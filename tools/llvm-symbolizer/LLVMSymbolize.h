@@ -21,6 +21,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include <map>
 #include <string>
+#include <vector>
 
 namespace llvm {
 
@@ -30,6 +31,47 @@ namespace symbolize {
 
 class ModuleInfo;
 
+/// \brief Source locations of all functions of a module, flattened into a
+/// sorted table of address ranges. Symbolizing a large number of addresses,
+/// e.g., of a simulator trace, only needs a binary search per address then.
+/// Columns are not recorded, addresses map to lines.
+class AddressTable {
+public:
+  /// \brief Returns the index of the location of \p Address, or -1 if the
+  /// address is not within a function of the symbol table.
+  int lookup(uint64_t Address) const;
+
+  unsigned getNumLocations() const { return Locations.size(); }
+
+  /// \brief Returns a location, the innermost inlined frame first.
+  const DIInliningInfo &getLocation(unsigned Index) const {
+    return Locations[Index];
+  }
+
+private:
+  friend class ModuleInfo;
+
+  struct Range {
+    uint64_t Start;
+    // Index of the location, -1 for addresses without code.
+    int Location;
+    friend bool operator<(uint64_t Address, const Range &R) {
+      return Address < R.Start;
+    }
+  };
+  std::vector<Range> Ranges;
+  std::vector<DIInliningInfo> Locations;
+  // Index of each location by its frames, only used while building.
+  std::map<std::string, int> LocationIndex;
+
+  /// \brief Returns the index of the location of \p Frames, adding it to
+  /// the table if it is new.
+  int addLocation(const DIInliningInfo &Frames);
+  /// \brief Starts a new range at \p Start, merging it with the previous
+  /// range if possible.
+  void addRange(uint64_t Start, int Location);
+};
+
 class LLVMSymbolizer {
 public:
   struct Options {
@@ -58,6 +100,9 @@ public:
   symbolizeCode(const std::string &ModuleName, uint64_t ModuleOffset);
   std::string
   symbolizeData(const std::string &ModuleName, uint64_t ModuleOffset);
+  /// \brief Returns the address table of a module, built on first use, or
+  /// null if the module cannot be read.
+  const AddressTable *getAddressTable(const std::string &ModuleName);
   void flush();
   static std::string DemangleName(const std::string &Name);
 private:
@@ -78,6 +123,9 @@ private:
   // Owns module info objects.
   typedef std::map<std::string, ModuleInfo *> ModuleMapTy;
   ModuleMapTy Modules;
+  // Owns the address tables of the modules.
+  typedef std::map<std::string, AddressTable *> AddressTableMapTy;
+  AddressTableMapTy AddressTables;
   typedef std::map<std::string, BinaryPair> BinaryMapTy;
   BinaryMapTy BinaryForPath;
   typedef std::map<std::pair<MachOUniversalBinary *, std::string>, ObjectFile *>
@@ -98,8 +146,13 @@ public:
       uint64_t ModuleOffset, const LLVMSymbolizer::Options &Opts) const;
   bool symbolizeData(uint64_t ModuleOffset, std::string &Name, uint64_t &Start,
                      uint64_t &Size) const;
+  void buildAddressTable(AddressTable &Table,
+                         const LLVMSymbolizer::Options &Opts) const;
 
 private:
+  void addAddressRanges(AddressTable &Table, uint64_t Start, uint64_t End,
+                        int StartLocation,
+                        const LLVMSymbolizer::Options &Opts) const;
   bool getNameFromSymbolTable(SymbolRef::Type Type, uint64_t Address,
                               std::string &Name, uint64_t &Addr,
                               uint64_t &Size) const;
@@ -13,19 +13,31 @@
 // (especially AddressSanitizer and ThreadSanitizer) that can use it
 // to symbolize stack traces in their error reports.
 //
+// With -pc-stream, it reads a binary stream of code addresses of a single
+// module, e.g., a simulator trace or a PC histogram, and prints how often
+// each function and source line was hit.
+//
 //===----------------------------------------------------------------------===//
 
 #include "LLVMSymbolize.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <string>
+#include <vector>
 
 using namespace llvm;
 using namespace symbolize;
@@ -51,6 +63,27 @@ static cl::opt<std::string> ClDefaultArch("default-arch", cl::init(""),
                                           cl::desc("Default architecture "
                                                    "(for multi-arch objects)"));
 
+static cl::opt<std::string>
+ClPCStream("pc-stream", cl::init(""), cl::value_desc("module"),
+           cl::desc("Read a binary stream of code addresses of the module "
+                    "from standard input and print per-function and "
+                    "per-line histograms"));
+
+static cl::opt<unsigned>
+ClPCStreamWidth("pc-stream-width", cl::init(4),
+                cl::desc("Size of the addresses and counts of the stream "
+                         "in bytes (4 or 8)"));
+
+static cl::opt<bool>
+ClPCStreamCounts("pc-stream-counts", cl::init(false),
+                 cl::desc("Each address of the stream is followed by its "
+                          "execution count"));
+
+static cl::opt<bool>
+ClPCStreamBigEndian("pc-stream-big-endian", cl::init(false),
+                    cl::desc("The stream is big-endian (default: "
+                             "little-endian)"));
+
 static bool parseCommand(bool &IsData, std::string &ModuleName,
                          uint64_t &ModuleOffset) {
   const char *kDataCmd = "DATA ";
@@ -98,6 +131,131 @@ static bool parseCommand(bool &IsData, std::string &ModuleName,
   return true;
 }
 
+static uint64_t readStreamValue(const unsigned char *Data) {
+  uint64_t Value = 0;
+  for (unsigned b = 0; b != ClPCStreamWidth; ++b) {
+    unsigned Byte = ClPCStreamBigEndian ? b : ClPCStreamWidth - b - 1;
+    Value = (Value << 8) | Data[Byte];
+  }
+  return Value;
+}
+
+static std::string getFunctionName(DILineInfo Frame) {
+  std::string Name = Frame.getFunctionName();
+  if (Name == "<invalid>")
+    return "??";
+  return ClDemangle ? LLVMSymbolizer::DemangleName(Name) : Name;
+}
+
+static std::string getFileName(DILineInfo Frame) {
+  std::string Name = Frame.getFileName();
+  return Name == "<invalid>" ? "??" : Name;
+}
+
+typedef std::pair<uint64_t, std::string> HistogramEntry;
+
+static bool compareEntries(const HistogramEntry &A, const HistogramEntry &B) {
+  if (A.first != B.first)
+    return A.first > B.first;
+  return A.second < B.second;
+}
+
+static void printHistogram(const char *Title,
+                           std::vector<HistogramEntry> &Entries,
+                           uint64_t Total) {
+  std::sort(Entries.begin(), Entries.end(), compareEntries);
+  outs() << Title << ":\n";
+  for (unsigned i = 0, e = Entries.size(); i != e; ++i) {
+    if (!Entries[i].first)
+      break;
+    outs() << format("%12llu %6.2f%%  ", (unsigned long long)Entries[i].first,
+                     100.0 * Entries[i].first / std::max(Total, (uint64_t)1))
+           << Entries[i].second << "\n";
+  }
+}
+
+/// Symbolize the addresses of the stream on standard input with the address
+/// table of the module and print the histograms.
+static int symbolizePCStream(LLVMSymbolizer &Symbolizer,
+                             const std::string &ModuleName) {
+  if (ClPCStreamWidth != 4 && ClPCStreamWidth != 8) {
+    errs() << "llvm-symbolizer: unsupported -pc-stream-width "
+           << ClPCStreamWidth << "\n";
+    return 1;
+  }
+  const AddressTable *Table = Symbolizer.getAddressTable(ModuleName);
+  if (!Table) {
+    errs() << "llvm-symbolizer: cannot read module '" << ModuleName << "'\n";
+    return 1;
+  }
+
+  OwningPtr<MemoryBuffer> Buf;
+  if (error_code ec = MemoryBuffer::getSTDIN(Buf)) {
+    errs() << "llvm-symbolizer: cannot read address stream: " << ec.message()
+           << "\n";
+    return 1;
+  }
+  unsigned RecordSize = ClPCStreamWidth * (ClPCStreamCounts ? 2 : 1);
+  if (Buf->getBufferSize() % RecordSize)
+    errs() << "llvm-symbolizer: warning: ignoring incomplete record at the "
+              "end of the address stream\n";
+
+  std::vector<uint64_t> LocationCounts(Table->getNumLocations(), 0);
+  uint64_t Total = 0, Unknown = 0;
+  const unsigned char *Data =
+      reinterpret_cast<const unsigned char *>(Buf->getBufferStart());
+  for (size_t i = 0, e = Buf->getBufferSize() / RecordSize; i != e; ++i) {
+    const unsigned char *Record = Data + i * RecordSize;
+    uint64_t Count = ClPCStreamCounts ? readStreamValue(Record +
+                                                        ClPCStreamWidth) : 1;
+    int Location = Table->lookup(readStreamValue(Record));
+    Total += Count;
+    if (Location < 0)
+      Unknown += Count;
+    else
+      LocationCounts[Location] += Count;
+  }
+
+  // Addresses of inlined code are attributed to the inlined function.
+  // Lines are merged by their description, as the same line may be reached
+  // through different inlined frames if these are not printed.
+  StringMap<uint64_t> FunctionCounts, LineCounts;
+  for (unsigned l = 0, le = LocationCounts.size(); l != le; ++l) {
+    const DIInliningInfo &Location = Table->getLocation(l);
+    DILineInfo Frame = Location.getFrame(0);
+    FunctionCounts[getFunctionName(Frame)] += LocationCounts[l];
+
+    std::string Desc;
+    uint32_t NumFrames = ClPrintInlining ? Location.getNumberOfFrames() : 1;
+    for (uint32_t i = 0; i < NumFrames; i++) {
+      Frame = Location.getFrame(i);
+      if (i)
+        Desc += " inlined at ";
+      Desc += getFileName(Frame) + ":" + utostr(Frame.getLine());
+      if (ClPrintFunctions)
+        Desc += " (" + getFunctionName(Frame) + ")";
+    }
+    LineCounts[Desc] += LocationCounts[l];
+  }
+
+  std::vector<HistogramEntry> Functions;
+  for (StringMap<uint64_t>::iterator I = FunctionCounts.begin(),
+       E = FunctionCounts.end(); I != E; ++I)
+    Functions.push_back(HistogramEntry(I->second, I->first()));
+  if (Unknown)
+    Functions.push_back(HistogramEntry(Unknown, "??"));
+
+  outs() << "Addresses: " << Total << " (" << Unknown << " without code)\n";
+  printHistogram("Functions", Functions, Total);
+
+  std::vector<HistogramEntry> Lines;
+  for (StringMap<uint64_t>::iterator I = LineCounts.begin(),
+       E = LineCounts.end(); I != E; ++I)
+    Lines.push_back(HistogramEntry(I->second, I->first()));
+  printHistogram("Lines", Lines, Total);
+  return 0;
+}
+
 int main(int argc, char **argv) {
   // Print stack trace if we signal out.
   sys::PrintStackTraceOnErrorSignal();
@@ -109,6 +267,9 @@ int main(int argc, char **argv) {
                                ClPrintInlining, ClDemangle, ClDefaultArch);
   LLVMSymbolizer Symbolizer(Opts);
 
+  if (!ClPCStream.empty())
+    return symbolizePCStream(Symbolizer, ClPCStream);
+
   bool IsData = false;
   std::string ModuleName;
   uint64_t ModuleOffset;
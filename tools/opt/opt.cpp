@@ -91,6 +91,12 @@ StripDebug("strip-debug",
 static cl::opt<bool>
 DisableInline("disable-inlining", cl::desc("Do not run the inliner pass"));
 
+static cl::opt<std::string>
+UseSampleProfile("use-sample-profile",
+                 cl::desc("Load branch weights from this sample profile "
+                          "before the -O optimizations"),
+                 cl::value_desc("filename"));
+
 static cl::opt<bool>
 DisableOptimizations("disable-opt",
                      cl::desc("Do not run any optimization passes"));
@@ -127,6 +133,11 @@ static cl::opt<bool>
 OptLevelO3("O3",
            cl::desc("Optimization level 3. Similar to clang -O3"));
 
+static cl::opt<bool>
+OptLevelOAnalyzable("Oanalyzable",
+           cl::desc("Loop optimizations that keep loop bounds and flow facts "
+                    "analyzable. Similar to clang -O1 for Patmos"));
+
 static cl::opt<std::string>
 TargetTriple("mtriple", cl::desc("Override target triple for module"));
 
@@ -476,10 +487,29 @@ static void AddOptimizationPasses(PassManagerBase &MPM,FunctionPassManager &FPM,
   Builder.SLPVectorize =
       DisableSLPVectorization ? false : OptLevel > 1 && SizeLevel < 2;
 
+  Builder.SampleProfileFile = UseSampleProfile;
+
   Builder.populateFunctionPassManager(FPM);
   Builder.populateModulePassManager(MPM);
 }
 
+/// AddAnalyzableOptimizationPasses - This routine adds the optimization
+/// passes that keep the program analyzable for WCET analysis.
+static void AddAnalyzableOptimizationPasses(PassManagerBase &MPM,
+                                            FunctionPassManager &FPM) {
+  FPM.add(createVerifierPass());                  // Verify that input is correct
+
+  PassManagerBuilder Builder;
+  Builder.OptLevel = 0;
+  if (!DisableInline)
+    Builder.Inliner = createAlwaysInlinerPass();
+  Builder.DisableUnrollLoops = DisableLoopUnrolling;
+  Builder.SampleProfileFile = UseSampleProfile;
+
+  Builder.populateFPMAnalyzable(FPM);
+  Builder.populateModulePassManager(MPM);
+}
+
 static void AddStandardCompilePasses(PassManagerBase &PM) {
   PM.add(createVerifierPass());                  // Verify that input is correct
 
@@ -689,7 +719,8 @@ int main(int argc, char **argv) {
     TM->addAnalysisPasses(Passes);
 
   OwningPtr<FunctionPassManager> FPasses;
-  if (OptLevelO1 || OptLevelO2 || OptLevelOs || OptLevelOz || OptLevelO3) {
+  if (OptLevelO1 || OptLevelO2 || OptLevelOs || OptLevelOz || OptLevelO3 ||
+      OptLevelOAnalyzable) {
     FPasses.reset(new FunctionPassManager(M.get()));
     if (TD)
       FPasses->add(new DataLayout(*TD));
@@ -762,6 +793,12 @@ int main(int argc, char **argv) {
       OptLevelO3 = false;
     }
 
+    if (OptLevelOAnalyzable &&
+        OptLevelOAnalyzable.getPosition() < PassList.getPosition(i)) {
+      AddAnalyzableOptimizationPasses(Passes, *FPasses);
+      OptLevelOAnalyzable = false;
+    }
+
     const PassInfo *PassInf = PassList[i];
     Pass *P = 0;
     if (PassInf->getNormalCtor())
@@ -827,7 +864,11 @@ int main(int argc, char **argv) {
   if (OptLevelO3)
     AddOptimizationPasses(Passes, *FPasses, 3, 0);
 
-  if (OptLevelO1 || OptLevelO2 || OptLevelOs || OptLevelOz || OptLevelO3) {
+  if (OptLevelOAnalyzable)
+    AddAnalyzableOptimizationPasses(Passes, *FPasses);
+
+  if (OptLevelO1 || OptLevelO2 || OptLevelOs || OptLevelOz || OptLevelO3 ||
+      OptLevelOAnalyzable) {
     FPasses->doInitialization();
     for (Module::iterator F = M->begin(), E = M->end(); F != E; ++F)
       FPasses->run(*F);
@@ -382,8 +382,8 @@ class FlowFactTransformation
 
     # partition local flow-facts by entry (if possible), rest is transformed in global scope
     flowfacts_by_entry = { }
+    direct_flowfacts = []
     flowfacts.each { |ff|
-      next if ff.symbolic_bound? # skip symbolic flow facts
       transform_entry = nil
       if ff.local?
         transform_entry = ff.scope.function
@@ -394,10 +394,16 @@ class FlowFactTransformation
         end
 	next unless rs.include?(transform_entry)
       end
+      # symbolic flow facts and loop bounds in the context of a call site are
+      # only translated directly
+      if ff.symbolic_bound? || (ff.loop_bound? && ! ff.scope.context.empty?)
+        direct_flowfacts.push(ff)
+        next
+      end
       transform_entry = target_analysis_entry unless transform_entry
       (flowfacts_by_entry[transform_entry] ||= []).push(ff)
     }
-    selected_flowfacts = flowfacts_by_entry.values.flatten(1)
+    selected_flowfacts = flowfacts_by_entry.values.flatten(1) + direct_flowfacts
 
     debug(options, :transform) { "Transforming #{selected_flowfacts.length} flow facts to #{target_level}" }
 
@@ -576,7 +582,9 @@ class SymbolicBoundTransformation
     ffs = {}
     flowfacts.each { |ff|
       next unless ff.level == level_source
-      next if ff.context_sensitive?
+      # loop bounds in the context of a call site are supported
+      next if ff.lhs.any? { |t| ! t.context.empty? }
+      next unless ff.scope.context.to_a.all? { |e| e.kind_of?(CallContextEntry) }
       s,b = ff.get_loop_bound
       next unless s
       (ffs[s.programpoint.function]||=[]).push(ff)
@@ -606,7 +614,7 @@ class SymbolicBoundTransformation
         lbs_resolved.push(ff_r)
         lbs_resolved.push(ff_triangle) if ff_triangle
         loopscope, loopbound = ff_r.get_loop_bound
-        loop_bounds[loopscope.programpoint] = loopbound if loopscope
+        loop_bounds[loopscope.programpoint] = loopbound if loopscope && loopscope.context.empty?
       }
 
       # translate
@@ -632,7 +640,7 @@ class SymbolicBoundTransformation
     function = ff.scope.function
     rg_src_level    = ff.level == 'bitcode' ? :src : :dst
     rg_target_level = ff.level == 'bitcode' ? :dst : :src
-    if ff.context_sensitive?
+    if ff.lhs.any? { |t| ! t.context.empty? }
       debug(options, :transform) { "Cannot transform context-sensitive symbolic flow fact" }
       return nil
     elsif ! ff.local?
@@ -711,10 +719,39 @@ class SymbolicBoundTransformation
     }
     attrs = { 'origin' =>  options.flow_fact_output,
               'level'  =>  target_level }
-    scope_mapped = ContextRef.new(scope_ref_mapped, Context.empty)
+    context_mapped = translate_context(ff.scope.context, rg_src_level, rg_target_level)
+    unless context_mapped
+      debug(options, :transform) { "Failed to translate call-site context of #{ff}" }
+      return nil
+    end
+    scope_mapped = ContextRef.new(scope_ref_mapped, context_mapped)
     FlowFact.new(scope_mapped, TermList.new(lhs_mapped), ff.op, rhs_mapped, attrs)
   end
 
+  # translate a call-site context: the k-th call of a function in a block is
+  # mapped to the k-th call of the same function in the block it maps to
+  def translate_context(context, rg_src_level, rg_target_level)
+    return context if context.empty?
+    entries = context.to_a.map { |entry|
+      return nil unless entry.kind_of?(CallContextEntry)
+      callsite = entry.callsite
+      block = callsite.block
+      function = block.function
+      return nil unless pml.relation_graphs.has_named?(function.name, rg_src_level)
+      rg = pml.relation_graphs.by_name(function.name, rg_src_level)
+      return nil unless rg.accept?(@options)
+      ns = rg.nodes.by_basic_block(block, rg_src_level)
+      return nil if ns.length != 1 || ns.first.unmapped?
+      mapped_block = ns.first.get_block(rg_target_level)
+
+      calls = block.callsites.select { |i| i.callees == callsite.callees }
+      mapped_calls = mapped_block.callsites.select { |i| i.callees == callsite.callees }
+      return nil if calls.length != mapped_calls.length
+      CallContextEntry.new(mapped_calls[calls.index(callsite)])
+    }
+    Context.from_list(entries)
+  end
+
 
   # resolve chain of recurrences
   def resolve_chr(ff, loop_bounds)
@@ -733,6 +733,16 @@ module PML
       data['memmode'] == 'load'
     end
 
+    # predicate guarding the memory access, nil if it is always executed
+    def guard
+      data['guard']
+    end
+
+    # whether the memory access might not be executed
+    def guarded?
+      ! data['guard'].nil?
+    end
+
     def bundled?
       data['bundled']
     end
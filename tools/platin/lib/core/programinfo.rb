@@ -490,15 +490,16 @@ module PML
     pml_list(:ProfileEntry, [:reference], [])
   end
   class ProfileEntry < PMLObject
-    attr_reader :reference, :cycles, :wcetfreq, :criticality, :wcet_contribution
-    def initialize(reference, cycles, wcetfreq, wcet_contribution, criticality = nil, data = nil)
-      @reference, @cycles, @wcetfreq, @wcet_contribution, @criticality =
-       reference,  cycles,  wcetfreq,  wcet_contribution,  criticality
+    attr_reader :reference, :cycles, :wcetfreq, :criticality, :wcet_contribution, :frequency
+    def initialize(reference, cycles, wcetfreq, wcet_contribution, criticality = nil, data = nil, frequency = nil)
+      @reference, @cycles, @wcetfreq, @wcet_contribution, @criticality, @frequency =
+       reference,  cycles,  wcetfreq,  wcet_contribution,  criticality,  frequency
       set_yaml_repr(data)
     end
     def ProfileEntry.from_pml(fs, data)
       ProfileEntry.new(ContextRef.from_pml(fs,data['reference']), data['cycles'],
-                       data['wcet-frequency'], data['wcet-contribution'], data['criticality'], data)
+                       data['wcet-frequency'], data['wcet-contribution'], data['criticality'], data,
+                       data['frequency'])
     end
     def criticality=(c)
       @criticality = c
@@ -506,7 +507,8 @@ module PML
     end
     def to_pml
       { 'reference' => reference.data, 'cycles' => cycles, 'wcet-frequency' => wcetfreq,
-        'criticality' => criticality, 'wcet-contribution' => wcet_contribution }.delete_if {|k,v| v.nil? }
+        'criticality' => criticality, 'wcet-contribution' => wcet_contribution,
+        'frequency' => frequency }.delete_if {|k,v| v.nil? }
     end
     def to_s
       data
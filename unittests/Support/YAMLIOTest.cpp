@@ -961,6 +961,32 @@ TEST(YAMLIO, TestDocRead) {
 
 
 
+//
+// Test mapping the documents of a stream one at a time
+//
+struct FooBarMapCollector {
+  FooBarMapDocumentList &Docs;
+  FooBarMapCollector(FooBarMapDocumentList &docs) : Docs(docs) {}
+  void operator()(FooBarMap &Doc) { Docs.push_back(Doc); }
+};
+
+TEST(YAMLIO, TestMapDocuments) {
+  FooBarMapDocumentList docs;
+  Input yin("---\nfoo:  3\nbar:  5\n...\n"
+            "---\nbar:  7\nfoo:  6\n...\n");
+  EXPECT_TRUE(llvm::yaml::mapDocuments<FooBarMap>(yin,
+                                                  FooBarMapCollector(docs)));
+
+  EXPECT_FALSE(yin.error());
+  EXPECT_EQ(docs.size(), 2UL);
+  EXPECT_EQ(docs[0].foo, 3);
+  EXPECT_EQ(docs[0].bar, 5);
+  EXPECT_EQ(docs[1].foo, 6);
+  EXPECT_EQ(docs[1].bar, 7);
+}
+
+
+
 //
 // Test writing then reading back a sequence of mappings
 //
@@ -0,0 +1,112 @@
+#!/usr/bin/env python
+
+"""Benchmark llvm-link on a synthetic bitcode archive.
+
+Generates an archive with many bitcode members, where each member defines
+one function that calls functions of other members, and measures the time
+llvm-link needs to resolve a main module against the archive. The call
+structure determines how many rounds the archive resolution needs:
+
+  chain  member i calls member i+1 (one new member per round)
+  tree   member i calls members 2i+1 and 2i+2 (logarithmic number of rounds)
+
+Example:
+  link-bench.py --bindir build/bin --members 10000 --shape chain
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+def write_member(path, i, callees):
+  f = open(path, 'w')
+  for c in callees:
+    f.write('declare i32 @f%d(i32)\n' % c)
+  f.write('@g%d = global i32 %d\n' % (i, i))
+  f.write('define i32 @f%d(i32 %%x) {\n' % i)
+  f.write('  %%v = load i32* @g%d\n' % i)
+  f.write('  %r0 = add i32 %x, %v\n')
+  for n, c in enumerate(callees):
+    f.write('  %%c%d = call i32 @f%d(i32 %%r%d)\n' % (n, c, n))
+    f.write('  %%r%d = add i32 %%c%d, %%r%d\n' % (n + 1, n, n))
+  f.write('  ret i32 %%r%d\n' % len(callees))
+  f.write('}\n')
+  f.close()
+
+def callees_of(shape, i, members):
+  if shape == 'chain':
+    callees = [i + 1]
+  else:
+    callees = [2 * i + 1, 2 * i + 2]
+  return [c for c in callees if c < members]
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__,
+             formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('--bindir', required=True,
+                      help='directory containing llvm-as and llvm-link')
+  parser.add_argument('--members', type=int, default=10000,
+                      help='number of archive members (default: 10000)')
+  parser.add_argument('--shape', choices=['chain', 'tree'], default='tree',
+                      help='call structure of the members (default: tree)')
+  parser.add_argument('--ar', default='ar', help='archiver to use')
+  parser.add_argument('--repeat', type=int, default=3,
+                      help='number of timed links (default: 3)')
+  parser.add_argument('--keep', action='store_true',
+                      help='keep the generated files')
+  args = parser.parse_args()
+
+  llvm_as = os.path.join(args.bindir, 'llvm-as')
+  llvm_link = os.path.join(args.bindir, 'llvm-link')
+
+  work = tempfile.mkdtemp(prefix='link-bench-')
+  try:
+    sys.stderr.write('Generating %d members in %s\n' % (args.members, work))
+    members = []
+    for i in range(args.members):
+      ll = os.path.join(work, 'm%d.ll' % i)
+      bc = os.path.join(work, 'm%d.bc' % i)
+      write_member(ll, i, callees_of(args.shape, i, args.members))
+      subprocess.check_call([llvm_as, ll, '-o', bc])
+      os.remove(ll)
+      members.append(bc)
+
+    main_ll = os.path.join(work, 'main.ll')
+    main_bc = os.path.join(work, 'main.bc')
+    f = open(main_ll, 'w')
+    f.write('declare i32 @f0(i32)\n'
+            'define i32 @main() {\n'
+            '  %r = call i32 @f0(i32 0)\n'
+            '  ret i32 %r\n'
+            '}\n')
+    f.close()
+    subprocess.check_call([llvm_as, main_ll, '-o', main_bc])
+
+    # Add the members in chunks to stay below the command line limit, use
+    # the order of the names to get a realistic archive layout.
+    archive = os.path.join(work, 'libbench.a')
+    for n in range(0, len(members), 1000):
+      subprocess.check_call([args.ar, 'qS', archive] + members[n:n+1000])
+
+    out = os.path.join(work, 'out.bc')
+    times = []
+    for r in range(args.repeat):
+      start = time.time()
+      subprocess.check_call([llvm_link, main_bc, archive, '-o', out])
+      times.append(time.time() - start)
+      sys.stderr.write('  link %d: %.3fs\n' % (r + 1, times[-1]))
+
+    print('members: %d, shape: %s, link time: min %.3fs, max %.3fs' %
+          (args.members, args.shape, min(times), max(times)))
+  finally:
+    if args.keep:
+      sys.stderr.write('Keeping %s\n' % work)
+    else:
+      shutil.rmtree(work)
+
+if __name__ == '__main__':
+  main()
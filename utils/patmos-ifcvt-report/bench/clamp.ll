@@ -0,0 +1,50 @@
+; Clamp the elements of an array to a range, nested if-then-else.
+
+@data = global [128 x i32] zeroinitializer, align 4
+
+define void @clamp(i32* %p, i32 %n, i32 %lo, i32 %hi) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  call void @llvm.loopbound(i32 0, i32 128)
+  %done = icmp sge i32 %i, %n
+  br i1 %done, label %exit, label %body
+
+body:
+  %ptr = getelementptr i32* %p, i32 %i
+  %x = load i32* %ptr, align 4
+  %below = icmp slt i32 %x, %lo
+  br i1 %below, label %set.lo, label %check.hi
+
+check.hi:
+  %above = icmp sgt i32 %x, %hi
+  br i1 %above, label %set.hi, label %latch.keep
+
+set.lo:
+  store i32 %lo, i32* %ptr, align 4
+  br label %latch
+
+set.hi:
+  store i32 %hi, i32* %ptr, align 4
+  br label %latch
+
+latch.keep:
+  br label %latch
+
+latch:
+  %i.next = add i32 %i, 1
+  br label %loop
+
+exit:
+  ret void
+}
+
+define i32 @main() {
+entry:
+  call void @clamp(i32* getelementptr ([128 x i32]* @data, i32 0, i32 0), i32 128, i32 -100, i32 100)
+  ret i32 0
+}
+
+declare void @llvm.loopbound(i32, i32)
@@ -0,0 +1,58 @@
+; Bitwise CRC-32 of a buffer, the inner loop branches on the low bit.
+
+@buf = global [64 x i8] zeroinitializer, align 4
+
+define i32 @crc32(i8* %p, i32 %n) {
+entry:
+  br label %outer
+
+outer:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %outer.latch ]
+  %crc = phi i32 [ -1, %entry ], [ %crc.out, %outer.latch ]
+  call void @llvm.loopbound(i32 0, i32 64)
+  %done = icmp eq i32 %i, %n
+  br i1 %done, label %exit, label %outer.body
+
+outer.body:
+  %ptr = getelementptr i8* %p, i32 %i
+  %byte = load i8* %ptr, align 1
+  %ext = zext i8 %byte to i32
+  %crc.in = xor i32 %crc, %ext
+  br label %inner
+
+inner:
+  %j = phi i32 [ 0, %outer.body ], [ %j.next, %inner.latch ]
+  %c = phi i32 [ %crc.in, %outer.body ], [ %c.next, %inner.latch ]
+  call void @llvm.loopbound(i32 8, i32 8)
+  %lsb = and i32 %c, 1
+  %shr = lshr i32 %c, 1
+  %odd = icmp ne i32 %lsb, 0
+  br i1 %odd, label %inner.xor, label %inner.latch
+
+inner.xor:
+  %x = xor i32 %shr, -306674912
+  br label %inner.latch
+
+inner.latch:
+  %c.next = phi i32 [ %x, %inner.xor ], [ %shr, %inner ]
+  %j.next = add i32 %j, 1
+  %inner.done = icmp eq i32 %j.next, 8
+  br i1 %inner.done, label %outer.latch, label %inner
+
+outer.latch:
+  %crc.out = phi i32 [ %c.next, %inner.latch ]
+  %i.next = add i32 %i, 1
+  br label %outer
+
+exit:
+  %r = xor i32 %crc, -1
+  ret i32 %r
+}
+
+define i32 @main() {
+entry:
+  %r = call i32 @crc32(i8* getelementptr ([64 x i8]* @buf, i32 0, i32 0), i32 64)
+  ret i32 %r
+}
+
+declare void @llvm.loopbound(i32, i32)
@@ -0,0 +1,45 @@
+; Conditional table lookups, the small conditional blocks contain loads.
+
+@table = global [16 x i32] zeroinitializer, align 4
+@data = global [100 x i32] zeroinitializer, align 4
+
+define i32 @lookup(i32* %p, i32 %n, i32 %t) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %acc = phi i32 [ 0, %entry ], [ %acc.next, %latch ]
+  call void @llvm.loopbound(i32 0, i32 100)
+  %done = icmp sge i32 %i, %n
+  br i1 %done, label %exit, label %body
+
+body:
+  %ptr = getelementptr i32* %p, i32 %i
+  %x = load i32* %ptr, align 4
+  %big = icmp sgt i32 %x, %t
+  br i1 %big, label %load, label %latch
+
+load:
+  %idx = and i32 %x, 15
+  %tptr = getelementptr [16 x i32]* @table, i32 0, i32 %idx
+  %v = load i32* %tptr, align 4
+  br label %latch
+
+latch:
+  %y = phi i32 [ %v, %load ], [ %x, %body ]
+  %acc.next = add i32 %acc, %y
+  %i.next = add i32 %i, 1
+  br label %loop
+
+exit:
+  ret i32 %acc
+}
+
+define i32 @main() {
+entry:
+  %r = call i32 @lookup(i32* getelementptr ([100 x i32]* @data, i32 0, i32 0), i32 100, i32 50)
+  ret i32 %r
+}
+
+declare void @llvm.loopbound(i32, i32)
@@ -0,0 +1,67 @@
+; Minimum, maximum and sum of absolute values of an array, written with
+; branches instead of selects.
+
+@data = global [256 x i32] zeroinitializer, align 4
+
+define i32 @minmax(i32* %p, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %min = phi i32 [ 2147483647, %entry ], [ %min.next, %latch ]
+  %max = phi i32 [ -2147483648, %entry ], [ %max.next, %latch ]
+  %sum = phi i32 [ 0, %entry ], [ %sum.next, %latch ]
+  call void @llvm.loopbound(i32 0, i32 256)
+  %done = icmp sge i32 %i, %n
+  br i1 %done, label %exit, label %body
+
+body:
+  %ptr = getelementptr i32* %p, i32 %i
+  %x = load i32* %ptr, align 4
+  %lt = icmp slt i32 %x, %min
+  br i1 %lt, label %new.min, label %test.max
+
+new.min:
+  br label %test.max
+
+test.max:
+  %min.next = phi i32 [ %x, %new.min ], [ %min, %body ]
+  %gt = icmp sgt i32 %x, %max
+  br i1 %gt, label %new.max, label %test.abs
+
+new.max:
+  br label %test.abs
+
+test.abs:
+  %max.next = phi i32 [ %x, %new.max ], [ %max, %test.max ]
+  %neg = icmp slt i32 %x, 0
+  br i1 %neg, label %abs.neg, label %abs.pos
+
+abs.neg:
+  %nx = sub i32 0, %x
+  %s1 = add i32 %sum, %nx
+  br label %latch
+
+abs.pos:
+  %s2 = add i32 %sum, %x
+  br label %latch
+
+latch:
+  %sum.next = phi i32 [ %s1, %abs.neg ], [ %s2, %abs.pos ]
+  %i.next = add i32 %i, 1
+  br label %loop
+
+exit:
+  %d = sub i32 %max, %min
+  %r = add i32 %d, %sum
+  ret i32 %r
+}
+
+define i32 @main() {
+entry:
+  %r = call i32 @minmax(i32* getelementptr ([256 x i32]* @data, i32 0, i32 0), i32 256)
+  ret i32 %r
+}
+
+declare void @llvm.loopbound(i32, i32)
@@ -0,0 +1,50 @@
+; Saturating addition of two vectors, the overflow checks are triangles
+; with several instructions each.
+
+@a = global [100 x i32] zeroinitializer, align 4
+@b = global [100 x i32] zeroinitializer, align 4
+
+define void @saturate(i32* %p, i32* %q, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  call void @llvm.loopbound(i32 0, i32 100)
+  %done = icmp sge i32 %i, %n
+  br i1 %done, label %exit, label %body
+
+body:
+  %pa = getelementptr i32* %p, i32 %i
+  %pb = getelementptr i32* %q, i32 %i
+  %x = load i32* %pa, align 4
+  %y = load i32* %pb, align 4
+  %s = add i32 %x, %y
+  %xs = xor i32 %x, %s
+  %ys = xor i32 %y, %s
+  %ov = and i32 %xs, %ys
+  %isov = icmp slt i32 %ov, 0
+  br i1 %isov, label %sat, label %latch
+
+sat:
+  %sign = ashr i32 %x, 31
+  %lim = xor i32 %sign, 2147483647
+  br label %latch
+
+latch:
+  %r = phi i32 [ %lim, %sat ], [ %s, %body ]
+  store i32 %r, i32* %pa, align 4
+  %i.next = add i32 %i, 1
+  br label %loop
+
+exit:
+  ret void
+}
+
+define i32 @main() {
+entry:
+  call void @saturate(i32* getelementptr ([100 x i32]* @a, i32 0, i32 0), i32* getelementptr ([100 x i32]* @b, i32 0, i32 0), i32 100)
+  ret i32 0
+}
+
+declare void @llvm.loopbound(i32, i32)
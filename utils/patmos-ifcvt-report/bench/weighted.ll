@@ -0,0 +1,67 @@
+; Filter loop with profiled branches: a likely path with a long dependence
+; chain and an unlikely path with a short one.
+
+@data = global [200 x i32] zeroinitializer, align 4
+
+define i32 @filter(i32* %p, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %acc = phi i32 [ 0, %entry ], [ %acc.next, %latch ]
+  call void @llvm.loopbound(i32 0, i32 200)
+  %done = icmp sge i32 %i, %n
+  br i1 %done, label %exit, label %body
+
+body:
+  %ptr = getelementptr i32* %p, i32 %i
+  %x = load i32* %ptr, align 4
+  %small = icmp ult i32 %x, 1000
+  br i1 %small, label %hot, label %test.cold, !prof !0
+
+hot:
+  %h1 = mul i32 %x, 3
+  %h2 = add i32 %h1, 7
+  %h3 = xor i32 %h2, %acc
+  %h4 = shl i32 %h3, 2
+  %h5 = sub i32 %h4, %x
+  %h6 = or i32 %h5, 1
+  %h7 = add i32 %h6, %h2
+  %h8 = lshr i32 %h7, 1
+  %h9 = xor i32 %h8, %h1
+  br label %test.cold
+
+test.cold:
+  %a1 = phi i32 [ %h9, %hot ], [ %acc, %body ]
+  %odd = icmp slt i32 %x, 0
+  br i1 %odd, label %cold, label %latch, !prof !1
+
+cold:
+  %c1 = sub i32 0, %x
+  %c2 = add i32 %c1, %a1
+  %c3 = shl i32 %c2, 1
+  %c4 = xor i32 %c3, %x
+  %c5 = add i32 %c4, %c1
+  %c6 = or i32 %c5, %c2
+  br label %latch
+
+latch:
+  %acc.next = phi i32 [ %c6, %cold ], [ %a1, %test.cold ]
+  %i.next = add i32 %i, 1
+  br label %loop
+
+exit:
+  ret i32 %acc
+}
+
+define i32 @main() {
+entry:
+  %r = call i32 @filter(i32* getelementptr ([200 x i32]* @data, i32 0, i32 0), i32 200)
+  ret i32 %r
+}
+
+declare void @llvm.loopbound(i32, i32)
+
+!0 = metadata !{metadata !"branch_weights", i32 90, i32 10}
+!1 = metadata !{metadata !"branch_weights", i32 5, i32 95}
@@ -0,0 +1,150 @@
+#!/usr/bin/env python
+
+"""Report the cycle and code size deltas of the Patmos if-conversion.
+
+Compiles each input twice with llc: once with -mpatmos-disable-ifcvt as
+baseline and once with the if-converter enabled. The code size is the size
+of all code sections of the object file. The cycles are the WCET bound
+computed by llvm-pml-wcet from the PML export of llc. The loop bounds of
+the export are on bitcode level; bounds of loops whose header block maps
+to the header of the machine loop are copied to machine code level, so
+every loop of the analyzed code needs a llvm.loopbound annotation (or a
+constant trip count) and must keep its header. Requires PyYAML. Negative
+deltas are improvements.
+
+The bench/ directory next to this script contains a small benchmark set
+that is used if no inputs are given.
+
+Example:
+  patmos-ifcvt-report.py --bindir build/bin --llc-args=-mpatmos-cfl=delayed
+"""
+
+import argparse
+import glob
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import yaml
+
+TRIPLE = 'patmos-unknown-unknown-elf'
+
+def run(cmd):
+  p = subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+  out, err = p.communicate()
+  if p.returncode != 0:
+    sys.stderr.write(err.decode())
+    raise RuntimeError('command failed: %s' % ' '.join(cmd))
+  return out.decode(), err.decode()
+
+def text_size(args, obj):
+  size = 0
+  out, _ = run([os.path.join(args.bindir, 'llvm-objdump'), '-h', obj])
+  for line in out.splitlines():
+    fields = line.split()
+    # Idx Name Size Address Type...
+    if len(fields) >= 5 and fields[0].isdigit() and 'TEXT' in fields[4:]:
+      size += int(fields[2], 16)
+  return size
+
+def machine_loop_bounds(pml, out):
+  docs = [d for d in yaml.safe_load_all(open(pml)) if d]
+  mfs = [mf for d in docs for mf in d.get('machine-functions') or []]
+  bounds = {}
+  for d in docs:
+    for ff in d.get('flowfacts') or []:
+      scope = ff.get('scope') or {}
+      if ff.get('level') != 'bitcode' or 'loop' not in scope:
+        continue
+      if not isinstance(ff.get('rhs'), int) or len(ff.get('lhs', [])) != 1:
+        continue
+      pp = ff['lhs'][0]['program-point']
+      if pp.get('block') != scope['loop']:
+        continue
+      for mf in mfs:
+        if mf.get('mapsto') != scope['function']:
+          continue
+        for mb in mf.get('blocks') or []:
+          if mb.get('mapsto') == scope['loop'] and \
+             mb['name'] in (mb.get('loops') or []):
+            key = (mf['name'], mb['name'])
+            if key not in bounds or ff['rhs'] < bounds[key][0]:
+              bounds[key] = (ff['rhs'], ff['origin'])
+  # Only the tightest bound of each loop is used, the trip count of loops
+  # without a constant trip count is exported as a huge bound.
+  facts = []
+  for (f, b), (rhs, origin) in sorted(bounds.items()):
+    facts.append({'scope': {'function': f, 'loop': b}, 'op': 'less-equal',
+                  'lhs': [{'factor': 1,
+                           'program-point': {'function': f, 'block': b}}],
+                  'rhs': rhs, 'level': 'machinecode', 'origin': origin,
+                  'classification': 'loop-global'})
+  doc = {'format': docs[0]['format'], 'triple': docs[0]['triple'],
+         'flowfacts': facts}
+  with open(out, 'w') as f:
+    yaml.safe_dump(doc, f, explicit_start=True, explicit_end=True)
+
+def wcet(args, pml):
+  facts = pml + '.facts'
+  machine_loop_bounds(pml, facts)
+  _, err = run([os.path.join(args.bindir, 'llvm-pml-wcet'), '-ipet-stats',
+                '-analysis-entry', args.entry, pml, facts,
+                '-o', os.devnull])
+  m = re.search(r'WCET bound: (\d+) cycles', err)
+  if not m:
+    raise RuntimeError('no WCET bound for %s' % pml)
+  return int(m.group(1))
+
+def compile(args, f, prefix, extra):
+  obj = prefix + '.o'
+  pml = prefix + '.pml'
+  run([os.path.join(args.bindir, 'llc'), '-mtriple=' + TRIPLE,
+       '-filetype=obj', f, '-o', obj, '-mserialize=' + pml,
+       '-mserialize-roots=' + args.entry] + args.llc_args.split() + extra)
+  return wcet(args, pml), text_size(args, obj)
+
+def delta(base, new):
+  return 100.0 * (new - base) / max(base, 1)
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__,
+      formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('--bindir', default='',
+                      help='directory containing llc, llvm-objdump and '
+                           'llvm-pml-wcet')
+  parser.add_argument('--llc-args', default='',
+                      help='additional arguments for llc')
+  parser.add_argument('--entry', default='main',
+                      help='function to compute the WCET bound for')
+  parser.add_argument('inputs', nargs='*',
+                      help='LLVM IR (.ll) or bitcode files')
+  args = parser.parse_args()
+
+  inputs = args.inputs
+  if not inputs:
+    bench = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'bench')
+    inputs = sorted(glob.glob(os.path.join(bench, '*.ll')))
+
+  tmpdir = tempfile.mkdtemp(prefix='patmos-ifcvt-')
+  totals = [0, 0, 0, 0]
+  try:
+    print('%-24s %10s %10s %8s %8s %8s %8s' % ('file', 'cycles', 'ifcvt',
+          'delta', 'size', 'ifcvt', 'delta'))
+    for i, f in enumerate(inputs):
+      prefix = os.path.join(tmpdir, '%d' % i)
+      base = compile(args, f, prefix + '-base', ['-mpatmos-disable-ifcvt'])
+      new = compile(args, f, prefix + '-ifcvt', [])
+      totals = [t + v for t, v in zip(totals, base + new)]
+      print('%-24s %10d %10d %7.2f%% %8d %8d %7.2f%%' % (os.path.basename(f),
+            base[0], new[0], delta(base[0], new[0]),
+            base[1], new[1], delta(base[1], new[1])))
+    print('%-24s %10d %10d %7.2f%% %8d %8d %7.2f%%' % ('total',
+          totals[0], totals[2], delta(totals[0], totals[2]),
+          totals[1], totals[3], delta(totals[1], totals[3])))
+  finally:
+    shutil.rmtree(tmpdir)
+
+if __name__ == '__main__':
+  main()
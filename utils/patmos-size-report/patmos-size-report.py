@@ -0,0 +1,86 @@
+#!/usr/bin/env python
+
+"""Report the code size gained by relaxing Patmos immediates.
+
+Assembles each input twice with llvm-mc: once with the default relaxation,
+where instructions with symbolic immediates start in the short ALUi format
+and are only widened to ALUl if needed, and once with -mc-relax-all, which
+corresponds to always using the ALUl format. LLVM IR and bitcode inputs are
+compiled to assembly with llc first. The size of all code sections is
+reported for both variants.
+
+Example:
+  patmos-size-report.py --bindir build/bin bench/*.s bench/*.ll
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+TRIPLE = 'patmos-unknown-unknown-elf'
+
+def run(cmd):
+  p = subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+  out, err = p.communicate()
+  if p.returncode != 0:
+    sys.stderr.write(err.decode())
+    raise RuntimeError('command failed: %s' % ' '.join(cmd))
+  return out.decode()
+
+def text_size(args, obj):
+  size = 0
+  out = run([os.path.join(args.bindir, 'llvm-objdump'), '-h', obj])
+  for line in out.splitlines():
+    fields = line.split()
+    # Idx Name Size Address Type...
+    if len(fields) >= 5 and fields[0].isdigit() and 'TEXT' in fields[4:]:
+      size += int(fields[2], 16)
+  return size
+
+def assemble(args, asm, obj, relax_all):
+  cmd = [os.path.join(args.bindir, 'llvm-mc'), '-triple', TRIPLE,
+         '-filetype=obj', asm, '-o', obj]
+  if relax_all:
+    cmd.append('-mc-relax-all')
+  run(cmd)
+  return text_size(args, obj)
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__,
+      formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('--bindir', default='',
+                      help='directory containing llc, llvm-mc, llvm-objdump')
+  parser.add_argument('--llc-args', default='',
+                      help='additional arguments for llc')
+  parser.add_argument('inputs', nargs='+',
+                      help='assembly (.s), LLVM IR (.ll) or bitcode files')
+  args = parser.parse_args()
+
+  tmpdir = tempfile.mkdtemp(prefix='patmos-size-')
+  total_long = total_relaxed = 0
+  try:
+    print('%-40s %10s %10s %8s' % ('file', 'long', 'relaxed', 'saved'))
+    for i, f in enumerate(args.inputs):
+      asm = f
+      if not f.endswith('.s'):
+        asm = os.path.join(tmpdir, '%d.s' % i)
+        run([os.path.join(args.bindir, 'llc'), '-mtriple=' + TRIPLE,
+             '-filetype=asm', f, '-o', asm] + args.llc_args.split())
+      obj = os.path.join(tmpdir, '%d.o' % i)
+      size_long = assemble(args, asm, obj, True)
+      size_relaxed = assemble(args, asm, obj, False)
+      total_long += size_long
+      total_relaxed += size_relaxed
+      print('%-40s %10d %10d %7.2f%%' % (os.path.basename(f), size_long,
+            size_relaxed, 100.0 * (size_long - size_relaxed) /
+                          max(size_long, 1)))
+    print('%-40s %10d %10d %7.2f%%' % ('total', total_long, total_relaxed,
+          100.0 * (total_long - total_relaxed) / max(total_long, 1)))
+  finally:
+    shutil.rmtree(tmpdir)
+
+if __name__ == '__main__':
+  main()
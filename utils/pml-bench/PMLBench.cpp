@@ -0,0 +1,175 @@
+//===- PMLBench - Benchmark the PML import --------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This program generates PML files of different sizes and measures the time
+// of parsing them and of mapping them to the PML data structures, both into
+// a document list and by streaming the documents into a single document.
+// Use -track-memory to also report the memory used by each phase.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/PML.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/YAMLParser.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+
+using namespace llvm;
+
+static cl::opt<std::string>
+ Input(cl::Positional, cl::desc("<input PML file>"));
+
+static cl::opt<bool>
+  Verify( "verify"
+        , cl::desc(
+            "Run a quick verification useful for regression testing")
+        , cl::init(false)
+        );
+
+static cl::opt<unsigned>
+  MemoryLimitMB("memory-limit", cl::desc(
+                  "Size of the largest generated PML file in megabytes"),
+                cl::init(100));
+
+static cl::opt<unsigned>
+  FunctionsPerDoc("functions-per-doc", cl::desc(
+                    "Number of functions in each generated document"),
+                  cl::init(50));
+
+static void benchmark( llvm::TimerGroup &Group
+                     , llvm::StringRef Name
+                     , llvm::StringRef PMLText) {
+  llvm::Timer Parsing((Name + ": Parsing").str(), Group);
+  Parsing.startTimer();
+  {
+    llvm::SourceMgr SM;
+    llvm::yaml::Stream stream(PMLText, SM);
+    stream.skip();
+  }
+  Parsing.stopTimer();
+
+  size_t ListFunctions = 0, StreamFunctions = 0;
+
+  llvm::Timer DocList((Name + ": Mapping (document list)").str(), Group);
+  DocList.startTimer();
+  {
+    yaml::PMLDoc Doc;
+    yaml::Input YIn(PMLText);
+    yaml::PMLDocList Docs;
+    YIn >> Docs.YDocs;
+    if (YIn.error())
+      errs() << Name << ": error mapping the document list\n";
+    Docs.mergeInto(Doc);
+    ListFunctions = Doc.MachineFunctions.size();
+  }
+  DocList.stopTimer();
+
+  llvm::Timer Streaming((Name + ": Mapping (streaming)").str(), Group);
+  Streaming.startTimer();
+  {
+    yaml::PMLDoc Doc;
+    yaml::Input YIn(PMLText);
+    if (!yaml::readPMLStream(YIn, Doc))
+      errs() << Name << ": error mapping the document stream\n";
+    StreamFunctions = Doc.MachineFunctions.size();
+  }
+  Streaming.stopTimer();
+
+  if (ListFunctions != StreamFunctions)
+    errs() << Name << ": mismatch, " << ListFunctions << " vs. "
+           << StreamFunctions << " functions\n";
+}
+
+/// Generate a PML stream with machine functions, flow facts and timings,
+/// similar to the output of the compiler and platin.
+static std::string createPMLText(size_t MemoryMB, unsigned BlocksPerFunction) {
+  std::string PMLText;
+  llvm::raw_string_ostream Stream(PMLText);
+  size_t MemoryBytes = MemoryMB * 1024 * 1024;
+  unsigned Function = 0;
+  uint64_t Address = 0x1000;
+  while (PMLText.size() < MemoryBytes) {
+    Stream << "---\n"
+           << "format:          pml-0.1\n"
+           << "triple:          patmos-unknown-unknown-elf\n"
+           << "machine-functions:\n";
+    unsigned First = Function;
+    for (unsigned f = 0; f < FunctionsPerDoc; ++f, ++Function) {
+      Stream << "  - name:            " << Function << "\n"
+             << "    level:           machinecode\n"
+             << "    mapsto:          func" << Function << "\n"
+             << "    arguments:       \n"
+             << "      - name:            '%a'\n"
+             << "        index:           0\n"
+             << "        registers:       [ r3 ]\n"
+             << "    blocks:          \n";
+      for (unsigned b = 0; b < BlocksPerFunction; ++b) {
+        Stream << "      - name:            " << b << "\n"
+               << "        mapsto:          bb" << b << "\n"
+               << "        predecessors:    [ " << (b ? b - 1 : 0) << " ]\n"
+               << "        successors:      [ " << b + 1 << " ]\n"
+               << "        loops:           [ 1 ]\n"
+               << "        instructions:    \n";
+        for (unsigned i = 0; i < 4; ++i, Address += 4) {
+          Stream << "          - index:           " << i << "\n"
+                 << "            opcode:          LWC\n"
+                 << "            size:            4\n"
+                 << "            address:         " << Address << "\n"
+                 << "            memmode:         load\n"
+                 << "            memtype:         cache\n";
+        }
+      }
+    }
+    Stream << "flowfacts:\n";
+    for (unsigned f = First; f < Function; ++f) {
+      Stream << "  - scope:           \n"
+             << "      function:        " << f << "\n"
+             << "      loop:            1\n"
+             << "    lhs:             \n"
+             << "      - factor:          1\n"
+             << "        program-point:   \n"
+             << "          function:        " << f << "\n"
+             << "          block:           1\n"
+             << "    op:              less-equal\n"
+             << "    rhs:             100\n"
+             << "    level:           machinecode\n"
+             << "    origin:          llvm.mc\n"
+             << "    classification:  loop-global\n";
+    }
+    Stream << "...\n";
+    Stream.flush();
+  }
+  return PMLText;
+}
+
+int main(int argc, char **argv) {
+  llvm::cl::ParseCommandLineOptions(argc, argv);
+  if (Input.getNumOccurrences()) {
+    OwningPtr<MemoryBuffer> Buf;
+    if (MemoryBuffer::getFileOrSTDIN(Input, Buf))
+      return 1;
+
+    llvm::TimerGroup Group("PML import benchmark");
+    benchmark(Group, Input, Buf->getBuffer());
+  } else if (Verify) {
+    llvm::TimerGroup Group("PML import benchmark");
+    benchmark(Group, "Fast", createPMLText(1, 10));
+  } else {
+    llvm::TimerGroup Group("PML import benchmark");
+    benchmark(Group, "Small Functions", createPMLText(MemoryLimitMB, 2));
+    benchmark(Group, "Large Functions", createPMLText(MemoryLimitMB, 100));
+  }
+
+  return 0;
+}